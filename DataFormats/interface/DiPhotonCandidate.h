@@ -100,6 +100,12 @@ namespace flashgg {
             viewPho1_.MakePersistent();
             viewPho2_.MakePersistent();
         }
+        // Stores the persistent photons as changes from those of base, the diphoton this one was corrected from
+        void compactPhotons( const edm::Ptr<DiPhotonCandidate> &base )
+        {
+            viewPho1_.MakeCompact( base );
+            viewPho2_.MakeCompact( base );
+        }
 
         void setJetCollectionIndex( unsigned int val ) { jetCollectionIndex_ = val; }
         unsigned int jetCollectionIndex() const { return jetCollectionIndex_; }
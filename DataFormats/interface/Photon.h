@@ -5,6 +5,7 @@
 #include "DataFormats/PatCandidates/interface/Photon.h"
 #include "DataFormats/PatCandidates/interface/PackedGenParticle.h"
 #include "flashgg/DataFormats/interface/WeightedObject.h"
+#include "flashgg/DataFormats/interface/VertexValueMap.h"
 #include "FWCore/Utilities/interface/EDMException.h"
 
 #include <map>
@@ -56,19 +57,21 @@ namespace flashgg {
         void setpfPhoIso03Corr( float val ) {pfPhoIso03Cor_ = val;};
         void setpfNeutIso04( float val ) {pfNeutIso04_ = val;};
         void setpfNeutIso03( float val ) {pfNeutIso03_ = val;};
-        void setpfChgIso04( std::map<edm::Ptr<reco::Vertex>, float> valmap ) {  pfChgIso04_ = valmap; }; // concept: pass the pre-computed map when calling this in the producer
-        void setpfChgIso03( std::map<edm::Ptr<reco::Vertex>, float> valmap ) {  pfChgIso03_ = valmap; }; // concept: pass the pre-computed map when calling this in the producer
-        void setpfChgIso02( std::map<edm::Ptr<reco::Vertex>, float> valmap ) {  pfChgIso02_ = valmap; }; // concept: pass the pre-computed map when calling this in the producer
+        void setpfChgIso04( const VertexValueMap &valmap ) {  pfChgIso04_ = valmap; }; // concept: pass the pre-computed map when calling this in the producer
+        void setpfChgIso03( const VertexValueMap &valmap ) {  pfChgIso03_ = valmap; }; // concept: pass the pre-computed map when calling this in the producer
+        void setpfChgIso02( const VertexValueMap &valmap ) {  pfChgIso02_ = valmap; }; // concept: pass the pre-computed map when calling this in the producer
+        void setpfChgIso03WrtVtx( const edm::Ptr<reco::Vertex> &vtx, float val ) { pfChgIso03_.set( vtx, val ); } // For later updates of a single vertex
         void setpfChgIsoWrtWorstVtx04( float val ) {pfChgIsoWrtWorstVtx04_ = val;};
         void setpfChgIsoWrtWorstVtx03( float val ) {pfChgIsoWrtWorstVtx03_ = val;};
         void setpfChgIsoWrtChosenVtx02( float val ) {pfChgIsoWrtChosenVtx02_ = val;};
         void setpfChgIsoWrtChosenVtx03( float val ) {pfChgIsoWrtChosenVtx03_ = val;};
         void setESEffSigmaRR( float val ) {ESEffSigmaRR_ = val;};
-        void setPhoIdMvaD( std::map<edm::Ptr<reco::Vertex>, float> valmap ) {  phoIdMvaD_ = valmap; };  // concept: pass the pre-computed map when calling this in the producer
-        void setPhoIdMvaWrtVtx( edm::Ptr<reco::Vertex> key, float val ) { phoIdMvaD_[key] = val; } // For later updates, e.g. recomputation when vertex is already selected
+        void setPhoIdMvaD( const VertexValueMap &valmap ) {  phoIdMvaD_ = valmap; };  // concept: pass the pre-computed map when calling this in the producer
+        void setPhoIdMvaWrtVtx( const edm::Ptr<reco::Vertex> &key, float val ) { phoIdMvaD_.set( key, val ); } // For later updates, e.g. recomputation when vertex is already selected
         void updateEnergy( std::string key, float val );
         void shiftAllMvaValuesBy( float val );
         void shiftMvaValueBy( float val, edm::Ptr<reco::Vertex> vtx );
+        void shiftMvaValueByKey( float val, unsigned int vtxKey ); // throws if the vertex has no value yet
         void shiftSigmaEOverEValueBy( float val, float cutoff=0. );
         void smearSigmaEOverEValueBy( float val );
         //    void setSigEOverE(float val) { sigEOverE_ = val; };
@@ -95,9 +98,9 @@ namespace flashgg {
         float const pfPhoIso03Corr() const {return pfPhoIso03Cor_;};
         float const pfNeutIso04() const {return pfNeutIso04_;};
         float const pfNeutIso03() const {return pfNeutIso03_;};
-        std::map<edm::Ptr<reco::Vertex>, float> const pfChgIso04() const {return pfChgIso04_;};
-        std::map<edm::Ptr<reco::Vertex>, float> const pfChgIso03() const {return pfChgIso03_;};
-        std::map<edm::Ptr<reco::Vertex>, float> const pfChgIso02() const {return pfChgIso02_;};
+        const VertexValueMap &pfChgIso04() const {return pfChgIso04_;};
+        const VertexValueMap &pfChgIso03() const {return pfChgIso03_;};
+        const VertexValueMap &pfChgIso02() const {return pfChgIso02_;};
         float const pfChgIso04WrtVtx( const edm::Ptr<reco::Vertex> &vtx, bool lazy = false ) const { return findVertexFloat( vtx, pfChgIso04_, lazy ); }; // if lazy flag is true only compare key (needed since fwlite does not fill provenance info)
         float const pfChgIso03WrtVtx( const edm::Ptr<reco::Vertex> &vtx, bool lazy = false ) const { return findVertexFloat( vtx, pfChgIso03_, lazy ); }; // if lazy flag is true only compare key (needed since fwlite does not fill provenance info)
         float const pfChgIso02WrtVtx( const edm::Ptr<reco::Vertex> &vtx, bool lazy = false ) const { return findVertexFloat( vtx, pfChgIso02_, lazy ); }; // if lazy flag is true only compare key (needed since fwlite does not fill provenance info)
@@ -126,12 +129,8 @@ namespace flashgg {
             return it != extraPhotonIsolations_.end() ? it->second : 0.;
         };
 
-        void setExtraChIso( const std::string &key, std::map<edm::Ptr<reco::Vertex>, float> &val ) { extraChargedIsolations_[key] = val; };
-        std::map<edm::Ptr<reco::Vertex>, float> extraChIso( const std::string &key ) const
-        {
-            std::map<std::string, std::map<edm::Ptr<reco::Vertex>, float> >::const_iterator it = extraChargedIsolations_.find( key );
-            return it != extraChargedIsolations_.end() ? it->second : std::map<edm::Ptr<reco::Vertex>, float>();
-        };
+        void setExtraChIso( const std::string &key, const VertexValueMap &val ) { extraChargedIsolations_[key] = val; };
+        const VertexValueMap &extraChIso( const std::string &key ) const;
 
         float const extraChgIsoWrtVtx0( const std::string &key ) const  { return findVertex0Float( extraChIso( key ) ); };
         float const extraChgIsoWrtVtx( const std::string &key, const edm::Ptr<reco::Vertex> &vtx, bool lazy = false ) const { return findVertexFloat( vtx, extraChIso( key ), lazy ); };
@@ -141,7 +140,7 @@ namespace flashgg {
         float const energyAtStep( std::string key, std::string fallback="" ) const;
         float const sigEOverE() const;
 
-        std::map<edm::Ptr<reco::Vertex>, float> const phoIdMvaD() const {return phoIdMvaD_;};
+        const VertexValueMap &phoIdMvaD() const {return phoIdMvaD_;};
         float const phoIdMvaDWrtVtx( const edm::Ptr<reco::Vertex> &vtx, bool lazy = false ) const { return findVertexFloat( vtx, phoIdMvaD_, lazy ); }; // if lazy flag is true only compare key (needed since fwlite does not fill provenance info)
 
         void setMatchedGenPhoton( const edm::Ptr<pat::PackedGenParticle> pgp ) { addUserCand( "matchedGenPhoton", pgp ); };
@@ -174,9 +173,9 @@ namespace flashgg {
 
     private:
         void setEnergyAtStep( std::string key, float val ); // updateEnergy should be used from outside the class to access this
-        float const findVertexFloat( const edm::Ptr<reco::Vertex> &vtx, const std::map<edm::Ptr<reco::Vertex>, float> &mp, bool lazy ) const;
-        float const findVertex0Float( const std::map<edm::Ptr<reco::Vertex>, float> &mp ) const;
-        float const findWorstIso( const std::map<edm::Ptr<reco::Vertex>, float> &mp ) const;
+        float const findVertexFloat( const edm::Ptr<reco::Vertex> &vtx, const VertexValueMap &mp, bool lazy ) const;
+        float const findVertex0Float( const VertexValueMap &mp ) const;
+        float const findWorstIso( const VertexValueMap &mp ) const;
 
         float sipip_;
         float sieip_;
@@ -205,12 +204,12 @@ namespace flashgg {
         float pfChgIsoWrtChosenVtx03_;
         float ESEffSigmaRR_;
         float sigEOverE_;
-        std::map<edm::Ptr<reco::Vertex>, float> pfChgIso04_;
-        std::map<edm::Ptr<reco::Vertex>, float> pfChgIso03_;
-        std::map<edm::Ptr<reco::Vertex>, float> pfChgIso02_;
-        std::map<edm::Ptr<reco::Vertex>, float> phoIdMvaD_;
+        VertexValueMap pfChgIso04_;
+        VertexValueMap pfChgIso03_;
+        VertexValueMap pfChgIso02_;
+        VertexValueMap phoIdMvaD_;
         bool passElecVeto_;
-        std::map<std::string, std::map<edm::Ptr<reco::Vertex>, float> > extraChargedIsolations_;
+        std::map<std::string, VertexValueMap> extraChargedIsolations_;
         std::map<std::string, float> extraPhotonIsolations_, extraNeutralIsolations_;
     };
 }
@@ -0,0 +1,47 @@
+#ifndef FLASHgg_PhotonDelta_h
+#define FLASHgg_PhotonDelta_h
+
+#include "flashgg/DataFormats/interface/Photon.h"
+
+#include <string>
+#include <vector>
+
+namespace flashgg {
+
+    // Difference between a photon and the photon it was corrected from, limited to what the photon
+    // systematics modify: the p4, the energy error of the candidate p4 type, the userFloats, userInts
+    // and userCands, and the photon ID MVA values. Used by SinglePhotonView to store a corrected
+    // photon as a reference to its origin plus these changes.
+    class PhotonDelta
+    {
+
+    public:
+        PhotonDelta() : energyError_( 0. ) {}
+
+        // Fills the delta taking base to photon; false if photon differs from base in a way
+        // the delta cannot express (other energy corrections, removed user data, ...)
+        bool fill( const Photon &base, const Photon &photon );
+        void apply( Photon &photon ) const;
+
+    private:
+        reco::Candidate::LorentzVector p4_;
+        float energyError_;
+        std::vector<std::string> userFloatLabels_;
+        std::vector<float> userFloats_;
+        std::vector<std::string> userIntLabels_;
+        std::vector<int> userInts_;
+        std::vector<std::string> userCandLabels_;
+        std::vector<reco::CandidatePtr> userCands_;
+        std::vector<unsigned int> mvaKeys_;
+        std::vector<float> mvaValues_;
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -2,13 +2,24 @@
 #define FLASHgg_SinglePhotonView_h
 
 #include "flashgg/DataFormats/interface/Photon.h"
+#include "flashgg/DataFormats/interface/PhotonDelta.h"
 #include "DataFormats/Common/interface/Ptr.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace flashgg {
 
+    class DiPhotonCandidate;
+
+    // A photon of a diphoton, with its p4 taken from the diphoton vertex. The photon is built
+    // from the original photon on access, or stored in the view once MakePersistent() is called
+    // so that it can be modified. A persistent view can instead be made compact, keeping only a
+    // reference to the same photon in the diphoton it was corrected from plus a PhotonDelta, and
+    // rebuilding the photon from those on access: the photon systematics use this so that the
+    // shifted diphoton collections do not each store full photon copies. The diphoton collection
+    // referred to must then be kept along with the compact views.
     class SinglePhotonView
     {
 
@@ -18,9 +29,9 @@ namespace flashgg {
         typedef Photon cand_type;
         
         virtual ~SinglePhotonView() {}
-        SinglePhotonView() : hasPhoton_( 0 ) {}
-        SinglePhotonView( edm::Ptr<flashgg::Photon> pho, edm::Ptr<reco::Vertex> vtx ) : phoPtr_( pho ), vtxRef_( vtx ), hasPhoton_( 0 ), hasVtx_( 1 ) {}
-        SinglePhotonView( edm::Ptr<flashgg::Photon> pho ) : phoPtr_( pho ), hasPhoton_( 0 ), hasVtx_( 0 ) {}
+        SinglePhotonView() : hasVtx_( 0 ), baseView_( -1 ) {}
+        SinglePhotonView( edm::Ptr<flashgg::Photon> pho, edm::Ptr<reco::Vertex> vtx ) : phoPtr_( pho ), vtxRef_( vtx ), hasVtx_( 1 ), baseView_( -1 ) {}
+        SinglePhotonView( edm::Ptr<flashgg::Photon> pho ) : phoPtr_( pho ), hasVtx_( 0 ), baseView_( -1 ) {}
 
         const cand_type *photon() const;
         cand_type &getPhoton(); // You can only have a non-const pointer if you call makePersistent() first
@@ -35,18 +46,28 @@ namespace flashgg {
         float extraChIsoWrtChoosenVtx( const std::string &key ) const { MakePhoton(); return ( photon()->extraChgIsoWrtVtx( key, vtxRef_ ) ); }
 
         void MakePersistent();
+        bool isPersistent() const { return !persistVec_.empty(); }
+
+        // Replaces the stored photon by a reference to the view of base holding the same original
+        // photon plus the changes from it; false, leaving the view as it is, if that view is neither
+        // persistent nor compact or the changes cannot be expressed. MakePersistent() undoes it.
+        bool MakeCompact( const edm::Ptr<DiPhotonCandidate> &base );
+        bool isCompact() const { return ( baseView_ >= 0 ); }
 
         // DO NOT USE THIS FUNCTION UNLESS YOU HAVE A GOOD REASON AND KNOW IT WON'T CAUSE INTERNAL INCONSISTENCIES
         void replacePtr( edm::Ptr<flashgg::Photon> replacement ) { phoPtr_ = replacement; }
 
     private:
-        mutable flashgg::Photon pho_;
+        mutable std::shared_ptr<const flashgg::Photon> pho_; // built photon, shared between copies of the view
         edm::Ptr<flashgg::Photon> phoPtr_;
         edm::Ptr<reco::Vertex> vtxRef_;
-        mutable bool hasPhoton_;
         bool hasVtx_;
         bool MakePhoton() const;
+        const SinglePhotonView *baseView() const;
         std::vector<flashgg::Photon> persistVec_;
+        edm::Ptr<DiPhotonCandidate> baseDiPhoton_;
+        int baseView_; // 0 leading, 1 subleading view of baseDiPhoton_, -1 if not compact
+        PhotonDelta delta_;
     };
 }
 
@@ -0,0 +1,74 @@
+#ifndef FLASHgg_VertexValueMap_h
+#define FLASHgg_VertexValueMap_h
+
+#include "DataFormats/Common/interface/Ptr.h"
+#include "DataFormats/Provenance/interface/ProductID.h"
+#include "DataFormats/VertexReco/interface/Vertex.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace flashgg {
+
+    // Per-vertex float values (isolations, MVA outputs, ...) for vertices of a single collection.
+    // Filled in a flat array indexed by the vertex key, so that lookups are O(1) and copies are cheap.
+    // keepOnly() and the legacy conversion switch to a sorted key list when that is smaller, since
+    // the slimmed maps often keep a few vertices with large keys.
+    // Replaces std::map<edm::Ptr<reco::Vertex>, float> in the persistent objects.
+    class VertexValueMap
+    {
+
+    public:
+        VertexValueMap() {}
+        // Converts a legacy map; throws like set() if it mixes vertex collections
+        VertexValueMap( const std::map<edm::Ptr<reco::Vertex>, float> & );
+
+        void set( const edm::Ptr<reco::Vertex> &vtx, float val );
+
+        bool has( unsigned int key ) const
+        {
+            if( keys_.empty() ) { return ( key < valid_.size() && valid_[key] ); }
+            unsigned int pos = position( key );
+            return ( pos < keys_.size() && keys_[pos] == key );
+        }
+        bool has( const edm::Ptr<reco::Vertex> &vtx, bool lazy = false ) const;
+        float at( unsigned int key ) const { return values_[keys_.empty() ? key : position( key )]; } // no check, use has() first
+        float &at( unsigned int key ) { return values_[keys_.empty() ? key : position( key )]; }
+
+        // One past the largest vertex key stored; iterate over keys with has( key )
+        unsigned int size() const { return ( keys_.empty() ? values_.size() : keys_.back() + 1 ); }
+        unsigned int count() const;
+        bool empty() const { return ( count() == 0 ); }
+        void clear();
+
+        const edm::ProductID &vertexProductID() const { return vtxId_; }
+
+        void keepOnly( const std::set<edm::Ptr<reco::Vertex> > & );
+        std::map<edm::Ptr<reco::Vertex>, float> toMap() const; // keys are not dereferenceable
+
+    private:
+        // only through set(), so that vtxId_ always matches the keys
+        void setAt( unsigned int key, float val );
+        // index of key in the sorted key list, or of the first larger key
+        unsigned int position( unsigned int key ) const;
+        // switches to the key list if it takes less space than the flat array, and back
+        void compact();
+        void expand();
+
+        edm::ProductID vtxId_;
+        std::vector<float> values_;        // by key, or in the order of keys_ if that is filled
+        std::vector<unsigned char> valid_; // by key, empty if keys_ is filled
+        std::vector<unsigned int> keys_;   // sorted, only for the compacted maps
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -0,0 +1,49 @@
+#ifndef FLASHgg_WeightLabels_h
+#define FLASHgg_WeightLabels_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Process-wide table of the WeightedObject weight labels.
+//
+// A label is identified by the 32-bit FNV-1a hash of its name, so the ids are the same
+// in every process and can be stored in the objects instead of the names. The names are
+// only needed to list or pattern-match the labels: they are registered by intern() when a
+// weight is set, and by the WeightLabelTableProducer from the table stored once per run in
+// the input files. Two names with the same hash are reported as an error when registered.
+
+namespace flashgg {
+
+    class WeightLabels
+    {
+
+    public:
+        typedef uint32_t id_type;
+
+        static constexpr id_type id( const char *label )
+        {
+            id_type hash = 2166136261u;
+            for( ; *label ; ++label ) { hash = ( hash ^ ( unsigned char )( *label ) ) * 16777619u; }
+            return hash;
+        }
+        static id_type id( const std::string &label ) { return id( label.c_str() ); }
+
+        // id of label, registering its name
+        static id_type intern( const std::string &label );
+        static bool known( id_type id );
+        // name of a registered label; weight_<hex id> if it is unknown to this process
+        static const std::string &label( id_type id );
+        // names of all the registered labels, sorted
+        static std::vector<std::string> labels();
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 
+#include "flashgg/DataFormats/interface/WeightLabels.h"
+
 using namespace std;
 
 namespace flashgg {
@@ -12,23 +14,31 @@ namespace flashgg {
     {
 
     public:
+        typedef WeightLabels::id_type weight_id;
+
         WeightedObject();
         virtual ~WeightedObject();
 
-        float weight( string key ) const;
-        float centralWeight() const { return weight( central_key ); }
-        void setWeight( string key, float val );
-        void setCentralWeight( float val ) { setWeight( central_key, val ); }
-        bool hasWeight( string key ) const;
+        float weight( const string &key ) const { return weightById( WeightLabels::id( key ) ); }
+        float centralWeight() const { return weightById( central_id ); }
+        void setWeight( const string &key, float val ) { setWeightById( WeightLabels::intern( key ), val ); }
+        void setCentralWeight( float val ) { setWeightById( central_id, val ); }
+        bool hasWeight( const string &key ) const { return hasWeightById( WeightLabels::id( key ) ); }
         void includeWeights( const WeightedObject &other, bool usecentralifnotfound = true );
         void includeWeightsByLabel( const WeightedObject &other, string keyInput, bool usecentralifnotfound = true );
-        vector<string>::const_iterator weightListBegin() const { return _labels.begin(); }
-        vector<string>::const_iterator weightListEnd() const { return _labels.end(); }
+
+        // string-free access, with the ids from WeightLabels::id() or weightIds()
+        float weightById( weight_id id ) const;
+        void setWeightById( weight_id id, float val );
+        bool hasWeightById( weight_id id ) const;
+        const vector<weight_id> &weightIds() const { return _ids; }
+        // names of the weights, sorted
+        vector<string> weightLabels() const;
 
     protected:
-        vector<string> _labels;
+        vector<weight_id> _ids; // sorted
         vector<float> _weights;
-        static constexpr const char *central_key = "Central";
+        static constexpr weight_id central_id = WeightLabels::id( "Central" );
     };
 }
 
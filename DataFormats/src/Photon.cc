@@ -35,6 +35,7 @@ void Photon::ZeroVariables()
     pfChgIsoWrtChosenVtx02_ = 0.;
     ESEffSigmaRR_ = 0.;
     sigEOverE_ = 0.;
+    pfChgIso04_.clear();
     pfChgIso03_.clear();
     pfChgIso02_.clear();
     phoIdMvaD_.clear();
@@ -85,107 +86,13 @@ Photon *Photon::clone() const { return new Photon( *this ); }
 
 void Photon::removeVerticesExcept( const std::set<edm::Ptr<reco::Vertex> > &vtxPtrList )
 {
-    /*
-        std::map<edm::Ptr<reco::Vertex>, float> pfChgIso04_;
-        std::map<edm::Ptr<reco::Vertex>, float> pfChgIso03_;
-        std::map<edm::Ptr<reco::Vertex>, float> pfChgIso02_;
-        std::map<edm::Ptr<reco::Vertex>, float> phoIdMvaD_;
-        bool passElecVeto_;
-        std::map<std::string, std::map<edm::Ptr<reco::Vertex>, float> > extraChargedIsolations_;
-    */
-
-    //    std::cout << "Running removeVerticesExcept" << std::endl;
-    //    std::cout << "  Size of pfChgIso04_: " << pfChgIso04_.size() << std::endl;
-    //    std::cout << "  Size of vtxPtrList: " << vtxPtrList.size() << std::endl;
-
-    std::map<edm::Ptr<reco::Vertex>, float>::iterator map_it;
-
     for( auto extra_map_it = extraChargedIsolations_.begin() ; extra_map_it != extraChargedIsolations_.end() ; extra_map_it++ ) {
-        map_it = extra_map_it->second.begin();
-        while( map_it != extra_map_it->second.end() ) {
-            bool deleteMe = true;
-            for( auto list_it = vtxPtrList.begin() ; list_it != vtxPtrList.end() ; list_it++ ) {
-                if( *list_it == map_it->first ) {
-                    deleteMe = false;
-                    break;
-                }
-            }
-            if( deleteMe ) {
-                map_it = extra_map_it->second.erase( map_it );
-            } else {
-                map_it++;
-            }
-        }
-    }
-
-    map_it = phoIdMvaD_.begin();
-    while( map_it != phoIdMvaD_.end() ) {
-        bool deleteMe = true;
-        for( auto list_it = vtxPtrList.begin() ; list_it != vtxPtrList.end() ; list_it++ ) {
-            if( *list_it == map_it->first ) {
-                deleteMe = false;
-                break;
-            }
-        }
-        if( deleteMe ) {
-            map_it = phoIdMvaD_.erase( map_it );
-        } else {
-            map_it++;
-        }
-    }
-
-    map_it = pfChgIso04_.begin();
-    while( map_it != pfChgIso04_.end() ) {
-        bool deleteMe = true;
-        for( auto list_it = vtxPtrList.begin() ; list_it != vtxPtrList.end() ; list_it++ ) {
-            if( *list_it == map_it->first ) {
-                deleteMe = false;
-                break;
-            }
-        }
-        if( deleteMe ) {
-            map_it = pfChgIso04_.erase( map_it );
-        } else {
-            map_it++;
-        }
-    }
-
-    map_it = pfChgIso03_.begin();
-    while( map_it != pfChgIso03_.end() ) {
-        bool deleteMe = true;
-        for( auto list_it = vtxPtrList.begin() ; list_it != vtxPtrList.end() ; list_it++ ) {
-            if( *list_it == map_it->first ) {
-                deleteMe = false;
-                break;
-            }
-        }
-        if( deleteMe ) {
-            map_it = pfChgIso03_.erase( map_it );
-        } else {
-            map_it++;
-        }
-    }
-
-    map_it = pfChgIso02_.begin();
-    while( map_it != pfChgIso02_.end() ) {
-        bool deleteMe = true;
-        for( auto list_it = vtxPtrList.begin() ; list_it != vtxPtrList.end() ; list_it++ ) {
-            if( *list_it == map_it->first ) {
-                deleteMe = false;
-                break;
-            }
-        }
-        if( deleteMe ) {
-            map_it = pfChgIso02_.erase( map_it );
-        } else {
-            map_it++;
-        }
+        extra_map_it->second.keepOnly( vtxPtrList );
     }
-
-
-    //    std::cout << "  Size of pfChgIso04_: " << pfChgIso04_.size() << std::endl;
-    //    std::cout << "  Size of vtxPtrList: " << vtxPtrList.size() << std::endl;
-    //    std::cout << "End of removeVerticesExcept"<< std::endl;
+    phoIdMvaD_.keepOnly( vtxPtrList );
+    pfChgIso04_.keepOnly( vtxPtrList );
+    pfChgIso03_.keepOnly( vtxPtrList );
+    pfChgIso02_.keepOnly( vtxPtrList );
 }
 
 
@@ -209,12 +116,10 @@ bool Photon::hasEnergyAtStep( std::string key ) const
 }
 
 
-float const Photon::findVertex0Float( const std::map<edm::Ptr<reco::Vertex>, float> &mp ) const
+float const Photon::findVertex0Float( const VertexValueMap &mp ) const
 {
-    for( std::map<edm::Ptr<reco::Vertex>, float>::const_iterator it = mp.begin(); it != mp.end(); ++it ) {
-        if( it->first.key() == 0 ) {
-            return  it->second;
-        }
+    if( mp.has( 0 ) ) {
+        return mp.at( 0 );
     }
 
     throw cms::Exception( "Missing Data" ) << "could not find value for vertex 0\n";;
@@ -222,29 +127,34 @@ float const Photon::findVertex0Float( const std::map<edm::Ptr<reco::Vertex>, flo
     return 0.;
 }
 
-float const Photon::findVertexFloat( const edm::Ptr<reco::Vertex> &vtx, const std::map<edm::Ptr<reco::Vertex>, float> &mp, bool lazy ) const
+float const Photon::findVertexFloat( const edm::Ptr<reco::Vertex> &vtx, const VertexValueMap &mp, bool lazy ) const
 {
-    lazy = lazy && ( vtx.id() == edm::ProductID( 0, 0 ) );
-    for( std::map<edm::Ptr<reco::Vertex>, float>::const_iterator it = mp.begin(); it != mp.end(); ++it ) {
-        if( ( lazy && it->first.key() == vtx.key() ) || it->first == vtx ) {
-            return  it->second;
-        }
+    if( mp.has( vtx, lazy ) ) {
+        return mp.at( vtx.key() );
     }
 
+    lazy = lazy && ( vtx.id() == edm::ProductID( 0, 0 ) );
     throw cms::Exception( "Missing Data" ) << "could not find value for vertex " << vtx.key() << " " << vtx.id() << " lazy search: " << lazy <<  "\n";;
 
     return 0.;
 }
 
-float const Photon::findWorstIso( const std::map<edm::Ptr<reco::Vertex>, float> &mp ) const
+float const Photon::findWorstIso( const VertexValueMap &mp ) const
 {
     float ret = std::numeric_limits<float>::min();
-    for( auto it : mp ) {
-        ret = std::max( ret, it.second );
+    for( unsigned int key = 0 ; key < mp.size() ; key++ ) {
+        if( mp.has( key ) ) { ret = std::max( ret, mp.at( key ) ); }
     }
     return ret;
 }
 
+const VertexValueMap &Photon::extraChIso( const std::string &key ) const
+{
+    static const VertexValueMap empty;
+    auto it = extraChargedIsolations_.find( key );
+    return it != extraChargedIsolations_.end() ? it->second : empty;
+}
+
 
 void Photon::updateEnergy( std::string key, float val )
 {
@@ -263,22 +173,25 @@ void Photon::updateEnergy( std::string key, float val )
 
 // For systematics
 void Photon::shiftAllMvaValuesBy( float val ) {
-    std::vector<edm::Ptr<reco::Vertex> > keys;
-    for(auto keyval = phoIdMvaD_.begin(); keyval != phoIdMvaD_.end(); ++keyval) { 
-        keys.push_back( keyval->first );
-    }
-    for(auto key = keys.begin() ; key != keys.end() ; ++key ) {
-        phoIdMvaD_[*key] += val;
-        if (phoIdMvaD_[*key] > 1.) phoIdMvaD_[*key] = 1.;
-        if (phoIdMvaD_[*key] < -1.) phoIdMvaD_[*key] = -1.;
+    for( unsigned int key = 0 ; key < phoIdMvaD_.size() ; key++ ) {
+        if( phoIdMvaD_.has( key ) ) { shiftMvaValueByKey( val, key ); }
     }
 }
 
 
 void Photon::shiftMvaValueBy( float val, edm::Ptr<reco::Vertex> vtx ) {
-    phoIdMvaD_[vtx] += val;
-    if (phoIdMvaD_[vtx] > 1.) phoIdMvaD_[vtx] = 1.;
-    if (phoIdMvaD_[vtx] < -1.) phoIdMvaD_[vtx] = -1.;
+    if( !phoIdMvaD_.has( vtx ) ) { phoIdMvaD_.set( vtx, 0. ); }
+    shiftMvaValueByKey( val, vtx.key() );
+}
+
+void Photon::shiftMvaValueByKey( float val, unsigned int vtxKey ) {
+    if( !phoIdMvaD_.has( vtxKey ) ) {
+        throw cms::Exception( "Missing Data" ) << "no MVA value to shift for vertex " << vtxKey << ", use shiftMvaValueBy with the vertex Ptr\n";
+    }
+    float &mva = phoIdMvaD_.at( vtxKey );
+    mva += val;
+    if (mva > 1.) mva = 1.;
+    if (mva < -1.) mva = -1.;
 }
 
 //sigmaEOverE systematycs
@@ -0,0 +1,115 @@
+#include "flashgg/DataFormats/interface/PhotonDelta.h"
+
+#include <cmath>
+
+namespace flashgg {
+
+    namespace {
+        // bitwise for the purpose of the delta: NaN differs from everything, -0 from +0
+        bool sameValue( float a, float b ) { return ( a == b && std::signbit( a ) == std::signbit( b ) ); }
+    }
+
+    bool PhotonDelta::fill( const Photon &base, const Photon &photon )
+    {
+        reco::Photon::P4type type = photon.getCandidateP4type();
+        if( type != base.getCandidateP4type() || type == reco::Photon::undefined ) { return false; }
+        for( int t = reco::Photon::ecal_standard ; t <= reco::Photon::regression2 ; t++ ) {
+            reco::Photon::P4type other = reco::Photon::P4type( t );
+            if( !( photon.p4( other ) == base.p4( other ) ) ) { return false; }
+            if( !sameValue( photon.getCorrectedEnergy( other ), base.getCorrectedEnergy( other ) ) ) { return false; }
+            if( other != type && !sameValue( photon.getCorrectedEnergyError( other ), base.getCorrectedEnergyError( other ) ) ) { return false; }
+        }
+        p4_ = photon.p4();
+        energyError_ = photon.getCorrectedEnergyError( type );
+
+        // user data can only be added or overwritten, so base must have no label photon lacks
+        userFloatLabels_.clear();
+        userFloats_.clear();
+        unsigned int nShared = 0;
+        for( const auto &label : photon.userFloatNames() ) {
+            bool inBase = base.hasUserFloat( label );
+            if( inBase ) { nShared++; }
+            if( !inBase || !sameValue( photon.userFloat( label ), base.userFloat( label ) ) ) {
+                userFloatLabels_.push_back( label );
+                userFloats_.push_back( photon.userFloat( label ) );
+            }
+        }
+        if( nShared != base.userFloatNames().size() ) { return false; }
+
+        userIntLabels_.clear();
+        userInts_.clear();
+        nShared = 0;
+        for( const auto &label : photon.userIntNames() ) {
+            bool inBase = base.hasUserInt( label );
+            if( inBase ) { nShared++; }
+            if( !inBase || photon.userInt( label ) != base.userInt( label ) ) {
+                userIntLabels_.push_back( label );
+                userInts_.push_back( photon.userInt( label ) );
+            }
+        }
+        if( nShared != base.userIntNames().size() ) { return false; }
+
+        userCandLabels_.clear();
+        userCands_.clear();
+        nShared = 0;
+        for( const auto &label : photon.userCandNames() ) {
+            bool inBase = base.hasUserCand( label );
+            if( inBase ) { nShared++; }
+            if( !inBase || photon.userCand( label ) != base.userCand( label ) ) {
+                userCandLabels_.push_back( label );
+                userCands_.push_back( photon.userCand( label ) );
+            }
+        }
+        if( nShared != base.userCandNames().size() ) { return false; }
+
+        // VertexValueMap::set only adds or overwrites slots
+        const VertexValueMap &mva = photon.phoIdMvaD(), &baseMva = base.phoIdMvaD();
+        if( mva.vertexProductID() != baseMva.vertexProductID() || mva.size() < baseMva.size() ) { return false; }
+        mvaKeys_.clear();
+        mvaValues_.clear();
+        for( unsigned int key = 0 ; key < mva.size() ; key++ ) {
+            if( !mva.has( key ) ) {
+                if( baseMva.has( key ) ) { return false; }
+                continue;
+            }
+            if( !baseMva.has( key ) || !sameValue( mva.at( key ), baseMva.at( key ) ) ) {
+                mvaKeys_.push_back( key );
+                mvaValues_.push_back( mva.at( key ) );
+            }
+        }
+        // the array would not grow to an unset last slot
+        if( mva.size() > baseMva.size() && !mva.has( mva.size() - 1 ) ) { return false; }
+        return true;
+    }
+
+    void PhotonDelta::apply( Photon &photon ) const
+    {
+        reco::Photon::P4type type = photon.getCandidateP4type();
+        photon.setP4( type, photon.p4( type ), energyError_, false );
+        photon.setP4( p4_ );
+        for( unsigned int i = 0 ; i < userFloatLabels_.size() ; i++ ) {
+            photon.addUserFloat( userFloatLabels_[i], userFloats_[i], true );
+        }
+        for( unsigned int i = 0 ; i < userIntLabels_.size() ; i++ ) {
+            photon.addUserInt( userIntLabels_[i], userInts_[i], true );
+        }
+        for( unsigned int i = 0 ; i < userCandLabels_.size() ; i++ ) {
+            photon.addUserCand( userCandLabels_[i], userCands_[i], true );
+        }
+        if( !mvaKeys_.empty() ) {
+            VertexValueMap mva = photon.phoIdMvaD();
+            for( unsigned int i = 0 ; i < mvaKeys_.size() ; i++ ) {
+                mva.set( edm::Ptr<reco::Vertex>( mva.vertexProductID(), mvaKeys_[i], nullptr ), mvaValues_[i] );
+            }
+            photon.setPhoIdMvaD( mva );
+        }
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -1,11 +1,16 @@
 #include "flashgg/DataFormats/interface/SinglePhotonView.h"
+#include "flashgg/DataFormats/interface/DiPhotonCandidate.h"
 
 namespace flashgg {
 
     bool SinglePhotonView::MakePhoton() const
     {
-        if( hasPhoton_ ) {
+        if( pho_ ) {
             return false;
+        } else if( isCompact() ) {
+            auto photon = std::make_shared<flashgg::Photon>( *baseView()->photon() );
+            delta_.apply( *photon );
+            pho_ = photon;
         } else if( hasVtx_ ) {
             float vtx_X = vtxRef_->x();
             float vtx_Y = vtxRef_->y();
@@ -22,33 +27,69 @@ namespace flashgg {
             math::XYZVector p = ( direction.Unit() ) * ( phoPtr_->energy() );
             math::XYZTLorentzVector corrected_p4( p.x(), p.y(), p.z(), phoPtr_->energy() );
 
-            pho_ =  flashgg::Photon( *phoPtr_ );
-            pho_.setP4( corrected_p4 );
-            hasPhoton_ = true;
+            auto photon = std::make_shared<flashgg::Photon>( *phoPtr_ );
+            photon->setP4( corrected_p4 );
+            pho_ = photon;
         } else {
-            pho_ = flashgg::Photon( *phoPtr_ );
-            hasPhoton_ = true;
+            pho_ = std::make_shared<flashgg::Photon>( *phoPtr_ );
         }
         return true;
     }
 
+    const SinglePhotonView *SinglePhotonView::baseView() const
+    {
+        return ( baseView_ == 0 ? baseDiPhoton_->leadingView() : baseDiPhoton_->subLeadingView() );
+    }
 
     void SinglePhotonView::MakePersistent()
     {
         if( !persistVec_.size() ) {
+            bool compact = isCompact();
             MakePhoton();
-            pho_.embedSuperCluster();
-            persistVec_.push_back( pho_ );
+            persistVec_.push_back( *pho_ );
+            if( compact ) {
+                // rebuilt from a persistent photon, so the supercluster is embedded already
+                baseDiPhoton_ = edm::Ptr<DiPhotonCandidate>();
+                baseView_ = -1;
+                delta_ = PhotonDelta();
+            } else {
+                persistVec_[0].embedSuperCluster();
+            }
+            pho_.reset();
         }
     }
 
+    bool SinglePhotonView::MakeCompact( const edm::Ptr<DiPhotonCandidate> &base )
+    {
+        if( !persistVec_.size() ) { return false; }
+        int index = -1;
+        if( base->leadingView()->originalPhoton() == phoPtr_ ) {
+            index = 0;
+        } else if( base->subLeadingView()->originalPhoton() == phoPtr_ ) {
+            index = 1;
+        }
+        if( index < 0 ) { return false; }
+        const SinglePhotonView *view = ( index == 0 ? base->leadingView() : base->subLeadingView() );
+        if( !view->isPersistent() && !view->isCompact() ) { return false; }
+        if( view->vtxRef_ != vtxRef_ || view->hasVtx_ != hasVtx_ ) { return false; }
+        if( !delta_.fill( *view->photon(), persistVec_[0] ) ) {
+            delta_ = PhotonDelta();
+            return false;
+        }
+        baseDiPhoton_ = base;
+        baseView_ = index;
+        pho_ = std::make_shared<const flashgg::Photon>( std::move( persistVec_[0] ) );
+        persistVec_.clear();
+        return true;
+    }
+
     const Photon *SinglePhotonView::photon() const
     {
         if( persistVec_.size() ) {
             return &persistVec_[0];
         } else {
             MakePhoton();
-            return &pho_;
+            return pho_.get();
         }
     }
 
@@ -0,0 +1,125 @@
+#include "flashgg/DataFormats/interface/VertexValueMap.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+namespace flashgg {
+
+    VertexValueMap::VertexValueMap( const std::map<edm::Ptr<reco::Vertex>, float> &mp )
+    {
+        for( const auto &entry : mp ) { set( entry.first, entry.second ); }
+        compact();
+    }
+
+    void VertexValueMap::set( const edm::Ptr<reco::Vertex> &vtx, float val )
+    {
+        if( size() == 0 ) {
+            vtxId_ = vtx.id();
+        } else if( vtx.id() != vtxId_ ) {
+            throw cms::Exception( "Mixed Collections" ) << "VertexValueMap holds vertices from " << vtxId_ << ", cannot add vertex from " << vtx.id() << "\n";
+        }
+        setAt( vtx.key(), val );
+    }
+
+    void VertexValueMap::setAt( unsigned int key, float val )
+    {
+        if( !keys_.empty() ) { expand(); }
+        if( key >= values_.size() ) {
+            values_.resize( key + 1, 0. );
+            valid_.resize( key + 1, 0 );
+        }
+        values_[key] = val;
+        valid_[key] = 1;
+    }
+
+    unsigned int VertexValueMap::position( unsigned int key ) const
+    {
+        return std::lower_bound( keys_.begin(), keys_.end(), key ) - keys_.begin();
+    }
+
+    bool VertexValueMap::has( const edm::Ptr<reco::Vertex> &vtx, bool lazy ) const
+    {
+        // if lazy is set and the pointer has no provenance (fwlite) only the key is compared
+        lazy = lazy && ( vtx.id() == edm::ProductID( 0, 0 ) );
+        return ( ( lazy || vtx.id() == vtxId_ ) && has( vtx.key() ) );
+    }
+
+    unsigned int VertexValueMap::count() const
+    {
+        if( !keys_.empty() ) { return keys_.size(); }
+        unsigned int n = 0;
+        for( auto v : valid_ ) { n += v; }
+        return n;
+    }
+
+    void VertexValueMap::clear()
+    {
+        vtxId_ = edm::ProductID();
+        values_.clear();
+        valid_.clear();
+        keys_.clear();
+    }
+
+    void VertexValueMap::keepOnly( const std::set<edm::Ptr<reco::Vertex> > &vtxPtrList )
+    {
+        if( !keys_.empty() ) { expand(); }
+        std::vector<unsigned char> keep( valid_.size(), 0 );
+        for( auto &vtx : vtxPtrList ) {
+            if( vtx.id() == vtxId_ && vtx.key() < keep.size() ) { keep[vtx.key()] = 1; }
+        }
+        unsigned int newSize = 0;
+        for( unsigned int key = 0 ; key < valid_.size() ; key++ ) {
+            valid_[key] = valid_[key] && keep[key];
+            if( valid_[key] ) { newSize = key + 1; }
+            else { values_[key] = 0.; }
+        }
+        values_.resize( newSize );
+        valid_.resize( newSize );
+        compact();
+    }
+
+    void VertexValueMap::compact()
+    {
+        unsigned int n = count();
+        if( !keys_.empty() || n == 0 ) { return; }
+        if( n * ( sizeof( float ) + sizeof( unsigned int ) ) >= values_.size() * ( sizeof( float ) + sizeof( unsigned char ) ) ) { return; }
+        std::vector<float> values;
+        values.reserve( n );
+        keys_.reserve( n );
+        for( unsigned int key = 0 ; key < valid_.size() ; key++ ) {
+            if( valid_[key] ) {
+                keys_.push_back( key );
+                values.push_back( values_[key] );
+            }
+        }
+        values_.swap( values );
+        valid_.clear();
+    }
+
+    void VertexValueMap::expand()
+    {
+        std::vector<float> values( keys_.back() + 1, 0. );
+        valid_.assign( keys_.back() + 1, 0 );
+        for( unsigned int i = 0 ; i < keys_.size() ; i++ ) {
+            values[keys_[i]] = values_[i];
+            valid_[keys_[i]] = 1;
+        }
+        values_.swap( values );
+        keys_.clear();
+    }
+
+    std::map<edm::Ptr<reco::Vertex>, float> VertexValueMap::toMap() const
+    {
+        std::map<edm::Ptr<reco::Vertex>, float> mp;
+        for( unsigned int key = 0 ; key < size() ; key++ ) {
+            if( has( key ) ) { mp[edm::Ptr<reco::Vertex>( vtxId_, key, nullptr )] = at( key ); }
+        }
+        return mp;
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -0,0 +1,102 @@
+#include "flashgg/DataFormats/interface/WeightLabels.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace flashgg {
+
+    namespace {
+        // node-based, so the names stay in place when labels are added; the central
+        // weight is set without going through intern()
+        std::unordered_map<WeightLabels::id_type, std::string> &table()
+        {
+            static std::unordered_map<WeightLabels::id_type, std::string> names = { { WeightLabels::id( "Central" ), "Central" } };
+            return names;
+        }
+
+        // names given to the ids whose label was never registered, kept apart from table() so that
+        // registering the real label later does not clash with them
+        std::unordered_map<WeightLabels::id_type, std::string> &placeholders()
+        {
+            static std::unordered_map<WeightLabels::id_type, std::string> names;
+            return names;
+        }
+
+        std::shared_mutex &tableMutex()
+        {
+            static std::shared_mutex mutex;
+            return mutex;
+        }
+    }
+
+    WeightLabels::id_type WeightLabels::intern( const std::string &label )
+    {
+        id_type hash = id( label );
+        {
+            std::shared_lock<std::shared_mutex> lock( tableMutex() );
+            auto found = table().find( hash );
+            if( found != table().end() && found->second == label ) { return hash; }
+        }
+        std::unique_lock<std::shared_mutex> lock( tableMutex() );
+        auto inserted = table().insert( std::make_pair( hash, label ) );
+        if( inserted.first->second != label ) {
+            throw cms::Exception( "WeightLabels" ) << "weight labels " << inserted.first->second << " and " << label
+                                                   << " have the same id " << std::hex << hash;
+        }
+        return hash;
+    }
+
+    bool WeightLabels::known( id_type id )
+    {
+        std::shared_lock<std::shared_mutex> lock( tableMutex() );
+        return table().count( id ) > 0;
+    }
+
+    const std::string &WeightLabels::label( id_type id )
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock( tableMutex() );
+            auto found = table().find( id );
+            if( found != table().end() ) { return found->second; }
+            auto placeholder = placeholders().find( id );
+            if( placeholder != placeholders().end() ) { return placeholder->second; }
+        }
+        std::unique_lock<std::shared_mutex> lock( tableMutex() );
+        auto found = table().find( id );
+        if( found != table().end() ) { return found->second; }
+        if( placeholders().empty() ) {
+            edm::LogWarning( "WeightLabels" ) << "weight label id " << std::hex << id << " has no registered name,"
+                                              << " the labels of the input were not read (add flashggWeightLabels to the path);"
+                                              << " unknown labels are named weight_<id>";
+        }
+        std::ostringstream name;
+        name << "weight_" << std::hex << std::setw( 8 ) << std::setfill( '0' ) << id;
+        return placeholders().insert( std::make_pair( id, name.str() ) ).first->second;
+    }
+
+    std::vector<std::string> WeightLabels::labels()
+    {
+        std::vector<std::string> names;
+        {
+            std::shared_lock<std::shared_mutex> lock( tableMutex() );
+            for( auto &entry : table() ) { names.push_back( entry.second ); }
+        }
+        std::sort( names.begin(), names.end() );
+        return names;
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -1,4 +1,5 @@
 #include "flashgg/DataFormats/interface/WeightedObject.h"
+#include <algorithm>
 #include <iostream>
 
 namespace flashgg {
@@ -9,31 +10,39 @@ namespace flashgg {
     WeightedObject::~WeightedObject()
     {}
 
-    void WeightedObject::setWeight( string key, float val )
+    void WeightedObject::setWeightById( weight_id id, float val )
     {
-        auto found_label = std::lower_bound( _labels.begin(), _labels.end(), key );
-        if( found_label == _labels.end() || *found_label != key ) {
-            _weights.insert( _weights.begin() + std::distance( _labels.begin(), found_label ), val );
-            _labels.insert( found_label, key );
+        auto found_id = std::lower_bound( _ids.begin(), _ids.end(), id );
+        if( found_id == _ids.end() || *found_id != id ) {
+            _weights.insert( _weights.begin() + std::distance( _ids.begin(), found_id ), val );
+            _ids.insert( found_id, id );
         } else {
-            _weights[std::distance( _labels.begin(), found_label )] = val;
+            _weights[std::distance( _ids.begin(), found_id )] = val;
         }
     }
 
 
-    bool WeightedObject::hasWeight( string key ) const
+    bool WeightedObject::hasWeightById( weight_id id ) const
     {
-        auto found_label = std::lower_bound( _labels.begin(), _labels.end(), key );
-        return ( !( found_label == _labels.end() || *found_label != key ) );
+        auto found_id = std::lower_bound( _ids.begin(), _ids.end(), id );
+        return ( !( found_id == _ids.end() || *found_id != id ) );
     }
 
-    float WeightedObject::weight( string key ) const
+    float WeightedObject::weightById( weight_id id ) const
     {
-        auto found_label = std::lower_bound( _labels.begin(), _labels.end(), key );
-        if( found_label == _labels.end() || *found_label != key ) {
+        auto found_id = std::lower_bound( _ids.begin(), _ids.end(), id );
+        if( found_id == _ids.end() || *found_id != id ) {
             return 1.;
         }
-        return _weights[std::distance( _labels.begin(), found_label )];
+        return _weights[std::distance( _ids.begin(), found_id )];
+    }
+
+    vector<string> WeightedObject::weightLabels() const
+    {
+        vector<string> labels;
+        for( auto id : _ids ) { labels.push_back( WeightLabels::label( id ) ); }
+        std::sort( labels.begin(), labels.end() );
+        return labels;
     }
 
     void WeightedObject::includeWeights( const WeightedObject &other, bool usecentralifnotfound /* old behavior: false */ )
@@ -52,25 +61,49 @@ namespace flashgg {
         // used to debug this and illustrate why we need this behavior.  
 
         float initialcentralweight = centralWeight();
+        float othercentralweight = other.centralWeight();
 
-        for( auto keyIt = _labels.begin() ; keyIt != _labels.end() ; keyIt++ ) {
-            if( other.hasWeight( *keyIt ) ) {
-                setWeight( *keyIt, weight( *keyIt ) * other.weight( *keyIt ) );
-            } else {
-                if ( usecentralifnotfound ) {
-                    setWeight( *keyIt, weight( *keyIt ) * other.centralWeight() );
+        // both id lists are sorted: one merge pass, in place unless other brings new weights
+        size_t nnew = 0;
+        for( size_t i = 0, j = 0 ; j < other._ids.size() ; j++ ) {
+            while( i < _ids.size() && _ids[i] < other._ids[j] ) { i++; }
+            if( i == _ids.size() || _ids[i] != other._ids[j] ) { nnew++; }
+        }
+        if( nnew == 0 ) {
+            for( size_t i = 0, j = 0 ; i < _ids.size() ; i++ ) {
+                while( j < other._ids.size() && other._ids[j] < _ids[i] ) { j++; }
+                if( j < other._ids.size() && other._ids[j] == _ids[i] ) {
+                    _weights[i] = _weights[i] * other._weights[j];
+                } else if( usecentralifnotfound ) {
+                    _weights[i] = _weights[i] * othercentralweight;
                 }
             }
+            return;
         }
-        for( auto keyIt = other._labels.begin() ; keyIt != other._labels.end() ; keyIt++ ) {
-            if( !hasWeight( *keyIt ) ) {
-                if ( usecentralifnotfound ) {
-                    setWeight( *keyIt, initialcentralweight * other.weight( *keyIt ) );
-                } else {
-                    setWeight( *keyIt, other.weight( *keyIt ) );
-                }
+
+        vector<weight_id> ids;
+        vector<float> weights;
+        ids.reserve( _ids.size() + nnew );
+        weights.reserve( _ids.size() + nnew );
+        size_t i = 0, j = 0;
+        while( i < _ids.size() || j < other._ids.size() ) {
+            if( j == other._ids.size() || ( i < _ids.size() && _ids[i] < other._ids[j] ) ) {
+                ids.push_back( _ids[i] );
+                weights.push_back( usecentralifnotfound ? _weights[i] * othercentralweight : _weights[i] );
+                i++;
+            } else if( i == _ids.size() || other._ids[j] < _ids[i] ) {
+                ids.push_back( other._ids[j] );
+                weights.push_back( usecentralifnotfound ? initialcentralweight * other._weights[j] : other._weights[j] );
+                j++;
+            } else {
+                ids.push_back( _ids[i] );
+                weights.push_back( _weights[i] * other._weights[j] );
+                i++;
+                j++;
             }
         }
+        _ids.swap( ids );
+        _weights.swap( weights );
     }
 
     void WeightedObject::includeWeightsByLabel( const WeightedObject &other, string keyInput, bool usecentralifnotfound /* default behavior: true*/ )
@@ -92,15 +125,18 @@ namespace flashgg {
         float initialcentralweight = centralWeight();
         float othercentralweightLabel = 1.0;
         float othercentralweightObject = 1.0;
-        for( auto keyIt = other._labels.begin() ; keyIt != other._labels.end() ; keyIt++ ) {
+        const string *labelFound = 0; // if several labels match, the last one in alphabetical order is used
+        for( auto id : other._ids ) {
+            const string &key = WeightLabels::label( id );
 
-            if( *keyIt == "Central" ){
+            if( id == central_id ){
 
-                othercentralweightObject = other.weight( *keyIt );
-            } else if(keyIt->find(keyInput) != std::string::npos && keyIt->find("Central") != std::string::npos ){
+                othercentralweightObject = other.weightById( id );
+            } else if(key.find(keyInput) != std::string::npos && key.find("Central") != std::string::npos && ( !labelFound || key > *labelFound ) ){
 
-                othercentralweightLabel = other.weight( *keyIt );
+                othercentralweightLabel = other.weightById( id );
                 isWeightByLabelFound = true;
+                labelFound = &key;
             }
         }
 
@@ -111,54 +147,56 @@ namespace flashgg {
         float weightAdjustSys = othercentralweightLabel/othercentralweightObject;// non central weights are multiplied by other central weights in object, this factor will undo that extra multiplication       
 
         // multiplies weights which are present in this and other
-        for( auto keyIt = _labels.begin() ; keyIt != _labels.end() ; keyIt++ ) {
+        for( auto id : _ids ) {
+            const string &key = WeightLabels::label( id );
 
-            if( *keyIt == "Central" ) {//multiply central weight with label central weight
+            if( id == central_id ) {//multiply central weight with label central weight
 
-                setWeight( *keyIt, weight( *keyIt ) * othercentralweightLabel );
-            } else if( other.hasWeight( *keyIt ) && keyIt->find(keyInput) != std::string::npos ) {//multiply other weights that have the same label, for instance for second jet in event
+                setWeightById( id, weightById( id ) * othercentralweightLabel );
+            } else if( other.hasWeightById( id ) && key.find(keyInput) != std::string::npos ) {//multiply other weights that have the same label, for instance for second jet in event
 
-                if(keyIt->find("Central") != std::string::npos){//centralLabelWeight
-                    setWeight( *keyIt, weight( *keyIt ) * other.weight( *keyIt ) );
+                if(key.find("Central") != std::string::npos){//centralLabelWeight
+                    setWeightById( id, weightById( id ) * other.weightById( id ) );
                 } else {//systematicLabelWeight
-                    setWeight( *keyIt, weight( *keyIt ) * other.weight( *keyIt ) * weightAdjustSys);
+                    setWeightById( id, weightById( id ) * other.weightById( id ) * weightAdjustSys);
                 }
                
             } else {// for other weights with different labels
 
                 if ( usecentralifnotfound ) {
-                    setWeight( *keyIt, weight( *keyIt ) * othercentralweightLabel );
+                    setWeightById( id, weightById( id ) * othercentralweightLabel );
                 }
             }
         }
 
         //imports weights that are only in other
-        for( auto keyIt = other._labels.begin() ; keyIt != other._labels.end() ; keyIt++ ) {
+        for( auto id : other._ids ) {
+            const string &key = WeightLabels::label( id );
 
-            if( !hasWeight( *keyIt ) ) {
+            if( !hasWeightById( id ) ) {
 
-                if(*keyIt == "Central" ) {//multiply central weight with label central weight
+                if(id == central_id ) {//multiply central weight with label central weight
 
-                    setWeight( *keyIt, othercentralweightLabel );
+                    setWeightById( id, othercentralweightLabel );
 
-                } else if(keyIt->find(keyInput) != std::string::npos ){//weights with that label
+                } else if(key.find(keyInput) != std::string::npos ){//weights with that label
 
-                    if(keyIt->find("Central") != std::string::npos){//centralLabelWeight
+                    if(key.find("Central") != std::string::npos){//centralLabelWeight
 
                         if ( usecentralifnotfound ) {
-                            setWeight( *keyIt, initialcentralweight * other.weight( *keyIt ) );
+                            setWeightById( id, initialcentralweight * other.weightById( id ) );
                         } else {
-                            setWeight( *keyIt, other.weight( *keyIt ) );
+                            setWeightById( id, other.weightById( id ) );
                         }
                     } else {//systematicLabelWeight
                      
                         if ( usecentralifnotfound ) {
                      
-                            setWeight( *keyIt, initialcentralweight * other.weight( *keyIt ) * weightAdjustSys );
+                            setWeightById( id, initialcentralweight * other.weightById( id ) * weightAdjustSys );
                      
                         } else {
                      
-                            setWeight( *keyIt, other.weight( *keyIt ) * weightAdjustSys );
+                            setWeightById( id, other.weightById( id ) * weightAdjustSys );
                         }
 
                     }
@@ -19,8 +19,10 @@
 #include "flashgg/DataFormats/interface/Jet.h"
 #include "flashgg/DataFormats/interface/Met.h"
 #include "flashgg/DataFormats/interface/Photon.h"
+#include "flashgg/DataFormats/interface/PhotonDelta.h"
 #include "flashgg/DataFormats/interface/SinglePhotonView.h"
 #include "flashgg/DataFormats/interface/SingleVertexView.h"
+#include "flashgg/DataFormats/interface/VertexValueMap.h"
 #include "flashgg/DataFormats/interface/TTHHadronicTag.h"
 #include "flashgg/DataFormats/interface/TTHLeptonicTag.h"
 #include "flashgg/DataFormats/interface/THQLeptonicTag.h"
@@ -119,6 +121,7 @@ namespace  {
         edm::Ptr<reco::Vertex>                                        ptr_rec_vtx;
         std::vector<edm::Ptr<reco::Vertex> >                      vec_ptr_rec_vtx;
 
+        flashgg::PhotonDelta                                           fgg_phodelta;
         flashgg::SinglePhotonView                                      fgg_phoview;
         edm::Ptr<flashgg::SinglePhotonView>                        ptr_fgg_phoview;
         edm::Wrapper<flashgg::SinglePhotonView>                    wrp_fgg_phoview;
@@ -159,6 +162,9 @@ namespace  {
         std::pair<edm::Ptr<reco::Vertex>, float>                   pai_ptr_vtx_flo;
         std::map<std::string, std::map<edm::Ptr<reco::Vertex>, float> >  map_str_ptr_vtx_flo;
         std::pair<std::string, std::map<edm::Ptr<reco::Vertex>, float> >  pai_str_ptr_vtx_flo;
+        flashgg::VertexValueMap                                    fgg_vtx_flo;
+        std::map<std::string, flashgg::VertexValueMap>             map_str_fgg_vtx_flo;
+        std::pair<std::string, flashgg::VertexValueMap>            pai_str_fgg_vtx_flo;
         flashgg::Electron						    fgg_ele;
         edm::Ptr<flashgg::Electron> 					  ptr_fgg_ele;
         edm::Wrapper<flashgg::Electron>				  wrp_fgg_ele;
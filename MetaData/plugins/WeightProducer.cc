@@ -18,7 +18,7 @@ Description: An event counter that can store the number of events in the lumi bl
 
 // user include files
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/LuminosityBlock.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -28,7 +28,7 @@ Description: An event counter that can store the number of events in the lumi bl
 #include "DataFormats/Common/interface/Handle.h"
 #include "FWCore/Framework/interface/Event.h"
 
-class WeightProducer : public edm::EDProducer
+class WeightProducer : public edm::stream::EDProducer<>
 {
 public:
     explicit WeightProducer( const edm::ParameterSet & );
@@ -0,0 +1,164 @@
+// Compares the ParticleNet SV inference of SVFlavourONNXTagsProducer run once per secondary
+// vertex with the batched modes (one run per distinct padded length, and a single padded run),
+// for 0 to 20 SVs per event. Inputs are random, with lengths drawn between 1 and max_length.
+// Usage: bench_sv_onnx_batching [model.onnx] [preprocess.json] [nEvents=200]
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "PhysicsTools/ONNXRuntime/interface/ONNXRuntime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using namespace std;
+using namespace cms::Ort;
+
+struct InputGroup {
+    string name;
+    unsigned nvars, minLength, maxLength;
+    bool dynamic;
+};
+
+// raw inputs of one SV: [group][var][element]
+typedef vector<vector<vector<float> > > SVInputs;
+
+unsigned paddedLength( const InputGroup &group, const SVInputs &sv, unsigned igroup )
+{
+    return std::clamp( ( unsigned )sv[igroup][0].size(), group.minLength, group.maxLength );
+}
+
+// runs the SVs in svs in one batch, with the given padded length for each group
+void runBatch( const ONNXRuntime &model, const vector<InputGroup> &groups, const vector<string> &names,
+               const vector<const SVInputs *> &svs, const vector<unsigned> &lengths, vector<vector<float> > &scores )
+{
+    FloatArrays data( groups.size() );
+    vector<vector<int64_t> > shapes;
+    for( unsigned igroup = 0 ; igroup < groups.size() ; igroup++ ) {
+        for( auto sv : svs ) {
+            for( auto &var : ( *sv )[igroup] ) {
+                vector<float> padded( lengths[igroup], 0. );
+                copy( var.begin(), var.begin() + min( ( unsigned )var.size(), lengths[igroup] ), padded.begin() );
+                data[igroup].insert( data[igroup].end(), padded.begin(), padded.end() );
+            }
+        }
+        if( groups[igroup].dynamic ) { shapes.push_back( { ( int64_t )svs.size(), ( int64_t )groups[igroup].nvars, ( int64_t )lengths[igroup] } ); }
+    }
+    auto out = model.run( names, data, shapes, {}, svs.size() )[0];
+    size_t nflav = out.size() / svs.size();
+    scores.assign( svs.size(), vector<float>() );
+    for( size_t isv = 0 ; isv < svs.size() ; isv++ ) { scores[isv].assign( out.begin() + isv * nflav, out.begin() + ( isv + 1 ) * nflav ); }
+}
+
+int main( int argc, char *argv[] )
+{
+    string modelPath = ( argc > 1 ? argv[1] : edm::FileInPath( "flashgg/MicroAOD/data/ParticleNetSV/V02/model.onnx" ).fullPath() );
+    string jsonPath = ( argc > 2 ? argv[2] : edm::FileInPath( "flashgg/MicroAOD/data/ParticleNetSV/V02/preprocess_corr.json" ).fullPath() );
+    int nEvents = ( argc > 3 ? atoi( argv[3] ) : 200 );
+
+    ifstream ifs( jsonPath );
+    nlohmann::json js = nlohmann::json::parse( ifs );
+    vector<string> names;
+    js.at( "input_names" ).get_to( names );
+    vector<InputGroup> groups;
+    for( auto &name : names ) {
+        const auto &group = js.at( name );
+        InputGroup g;
+        g.name = name;
+        g.nvars = group.at( "var_names" ).size();
+        g.dynamic = !group.contains( "var_length" );
+        g.minLength = g.dynamic ? ( unsigned )group.at( "min_length" ) : ( unsigned )group.at( "var_length" );
+        g.maxLength = g.dynamic ? ( unsigned )group.at( "max_length" ) : g.minLength;
+        groups.push_back( g );
+    }
+    ONNXRuntime model( modelPath );
+
+    mt19937 rng( 12345 );
+    uniform_real_distribution<float> value( -1., 1. );
+    cout << "nSV   perSV[us/evt]   byLength[us/evt]   padded[us/evt]   maxDiff(byLength)   maxDiff(padded)" << endl;
+    for( unsigned nsv = 0 ; nsv <= 20 ; nsv++ ) {
+        double tPerSV = 0., tByLength = 0., tPadded = 0.;
+        float diffByLength = 0., diffPadded = 0.;
+        for( int ievent = 0 ; ievent < nEvents ; ievent++ ) {
+            vector<SVInputs> svs( nsv );
+            for( auto &sv : svs ) {
+                sv.resize( groups.size() );
+                for( unsigned igroup = 0 ; igroup < groups.size() ; igroup++ ) {
+                    unsigned length = uniform_int_distribution<unsigned>( 1, groups[igroup].maxLength )( rng );
+                    sv[igroup].assign( groups[igroup].nvars, vector<float>( length ) );
+                    for( auto &var : sv[igroup] ) { for( auto &x : var ) { x = value( rng ); } }
+                }
+            }
+
+            // one run per SV, as before
+            auto t0 = chrono::steady_clock::now();
+            vector<vector<float> > perSV( nsv );
+            for( unsigned isv = 0 ; isv < nsv ; isv++ ) {
+                vector<unsigned> lengths;
+                for( unsigned igroup = 0 ; igroup < groups.size() ; igroup++ ) { lengths.push_back( paddedLength( groups[igroup], svs[isv], igroup ) ); }
+                vector<vector<float> > scores;
+                runBatch( model, groups, names, { &svs[isv] }, lengths, scores );
+                perSV[isv] = scores[0];
+            }
+
+            // one run per distinct padded length
+            auto t1 = chrono::steady_clock::now();
+            vector<vector<float> > byLength( nsv );
+            map<vector<unsigned>, vector<unsigned> > batches;
+            for( unsigned isv = 0 ; isv < nsv ; isv++ ) {
+                vector<unsigned> lengths;
+                for( unsigned igroup = 0 ; igroup < groups.size() ; igroup++ ) { lengths.push_back( paddedLength( groups[igroup], svs[isv], igroup ) ); }
+                batches[lengths].push_back( isv );
+            }
+            for( auto &batch : batches ) {
+                vector<const SVInputs *> inputs;
+                for( auto isv : batch.second ) { inputs.push_back( &svs[isv] ); }
+                vector<vector<float> > scores;
+                runBatch( model, groups, names, inputs, batch.first, scores );
+                for( size_t ib = 0 ; ib < batch.second.size() ; ib++ ) { byLength[batch.second[ib]] = scores[ib]; }
+            }
+
+            // a single run, padded to the longest SV
+            auto t2 = chrono::steady_clock::now();
+            vector<vector<float> > padded;
+            if( nsv > 0 ) {
+                vector<unsigned> lengths( groups.size(), 0 );
+                vector<const SVInputs *> inputs;
+                for( auto &sv : svs ) {
+                    inputs.push_back( &sv );
+                    for( unsigned igroup = 0 ; igroup < groups.size() ; igroup++ ) { lengths[igroup] = max( lengths[igroup], paddedLength( groups[igroup], sv, igroup ) ); }
+                }
+                runBatch( model, groups, names, inputs, lengths, padded );
+            }
+            auto t3 = chrono::steady_clock::now();
+
+            tPerSV += chrono::duration<double, micro>( t1 - t0 ).count();
+            tByLength += chrono::duration<double, micro>( t2 - t1 ).count();
+            tPadded += chrono::duration<double, micro>( t3 - t2 ).count();
+            for( unsigned isv = 0 ; isv < nsv ; isv++ ) {
+                for( size_t iflav = 0 ; iflav < perSV[isv].size() ; iflav++ ) {
+                    diffByLength = max( diffByLength, fabs( perSV[isv][iflav] - byLength[isv][iflav] ) );
+                    diffPadded = max( diffPadded, fabs( perSV[isv][iflav] - padded[isv][iflav] ) );
+                }
+            }
+        }
+        cout << nsv << "   " << tPerSV / nEvents << "   " << tByLength / nEvents << "   " << tPadded / nEvents << "   "
+             << diffByLength << "   " << diffPadded << endl;
+    }
+    return 0;
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -0,0 +1,90 @@
+// Compares the vertex id BDT of LegacyVertexSelector evaluated through TMVA::Reader, one
+// vertex at a time, with the TMVAForest evaluator scoring all the vertices of a pair at once,
+// for 1 to 100 vertices. Inputs are random, in the typical ranges of the BDT variables.
+// Usage: bench_vertex_mva [weights.xml] [nPairs=2000]
+
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "flashgg/MicroAOD/interface/TMVAForest.h"
+#include "TMVA/Reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main( int argc, char *argv[] )
+{
+    string weights = ( argc > 1 ? argv[1] : edm::FileInPath( "flashgg/MicroAOD/data/TMVAClassification_BDTVtxId_SL_2016.xml" ).fullPath() );
+    int nPairs = ( argc > 2 ? atoi( argv[2] ) : 2000 );
+
+    float ptasym, ptbal, logsumpt2, pull_conv, nConv;
+    TMVA::Reader reader( "!Color:Silent" );
+    reader.AddVariable( "ptasym", &ptasym );
+    reader.AddVariable( "ptbal", &ptbal );
+    reader.AddVariable( "logsumpt2", &logsumpt2 );
+    reader.AddVariable( "limPullToConv", &pull_conv );
+    reader.AddVariable( "nConv", &nConv );
+    reader.BookMVA( "BDT", weights );
+
+    auto forest = flashgg::TMVAForest::get( weights );
+    cout << "Loaded " << forest->nTrees() << " trees from " << weights << endl;
+
+    mt19937 rng( 12345 );
+    uniform_real_distribution<float> uasym( -1., 1. ), ubal( -50., 150. ), ulog( -3., 10. ), upull( 0., 10. );
+    uniform_int_distribution<int> uconv( 0, 2 );
+
+    const vector<unsigned> multiplicities = { 1, 2, 5, 10, 20, 30, 40, 60, 80, 100 };
+    cout << "nVtx   TMVA[us/pair]   TMVAForest[us/pair]   speedup   maxDiff" << endl;
+    for( auto nvtx : multiplicities ) {
+        vector<float> rows( nvtx * 5 );
+        vector<double> scores( nvtx );
+        vector<float> reference( nvtx );
+        double tReader = 0., tForest = 0.;
+        float maxDiff = 0.;
+        for( int ipair = 0 ; ipair < nPairs ; ipair++ ) {
+            int conv = uconv( rng );
+            for( unsigned ivtx = 0 ; ivtx < nvtx ; ivtx++ ) {
+                float *row = &rows[ivtx * 5];
+                row[0] = uasym( rng );
+                row[1] = ubal( rng );
+                row[2] = ulog( rng );
+                row[3] = ( conv > 0 ? upull( rng ) : 10. );
+                row[4] = conv;
+            }
+
+            auto t0 = chrono::steady_clock::now();
+            for( unsigned ivtx = 0 ; ivtx < nvtx ; ivtx++ ) {
+                const float *row = &rows[ivtx * 5];
+                ptasym = row[0];
+                ptbal = row[1];
+                logsumpt2 = row[2];
+                pull_conv = row[3];
+                nConv = row[4];
+                reference[ivtx] = reader.EvaluateMVA( "BDT" );
+            }
+            auto t1 = chrono::steady_clock::now();
+            forest->evaluate( &rows[0], nvtx, &scores[0] );
+            auto t2 = chrono::steady_clock::now();
+
+            tReader += chrono::duration<double, micro>( t1 - t0 ).count();
+            tForest += chrono::duration<double, micro>( t2 - t1 ).count();
+            for( unsigned ivtx = 0 ; ivtx < nvtx ; ivtx++ ) { maxDiff = max( maxDiff, fabs( reference[ivtx] - ( float )scores[ivtx] ) ); }
+        }
+        cout << nvtx << "   " << tReader / nPairs << "   " << tForest / nPairs << "   " << tReader / max( tForest, 1e-9 ) << "   " << maxDiff << endl;
+    }
+    return 0;
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -0,0 +1,122 @@
+// Compares the full track x vertex dz scan of FlashggDzVertexMapProducer with the
+// z-sorted VertexZIndex lookup, as a function of the number of vertices.
+// Usage: bench_vertex_zindex [nTracks=1500] [maxDz=0.2] [nEvents=200]
+
+#include "DataFormats/VertexReco/interface/Vertex.h"
+#include "flashgg/MicroAOD/interface/VertexZIndex.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Minimal stand-in for pat::PackedCandidate with the same dz parametrisation
+struct BenchTrack {
+    double vx_, vy_, vz_, pt_, pz_, phi_;
+    double vx() const { return vx_; }
+    double vy() const { return vy_; }
+    double vz() const { return vz_; }
+    double pt() const { return pt_; }
+    double pz() const { return pz_; }
+    double phi() const { return phi_; }
+    double dz( const reco::Vertex::Point &p ) const
+    {
+        return vz_ - p.Z() - ( ( vx_ - p.X() ) * std::cos( phi_ ) + ( vy_ - p.Y() ) * std::sin( phi_ ) ) * pz_ / pt_;
+    }
+};
+
+typedef std::vector<std::pair<unsigned int, unsigned int> > Association;
+
+void associateFullScan( const vector<reco::Vertex> &vertices, const vector<BenchTrack> &tracks, double maxDz, Association &assoc )
+{
+    assoc.clear();
+    for( unsigned int i = 0 ; i < tracks.size() ; i++ ) {
+        double closestDz = maxDz;
+        unsigned int closestDzIndex = -1;
+        for( unsigned int j = 0 ; j < vertices.size() ; j++ ) {
+            double dz = fabs( tracks[i].dz( vertices[j].position() ) );
+            if( dz < closestDz ) {
+                closestDz = dz;
+                closestDzIndex = j;
+            }
+        }
+        if( closestDz < maxDz ) { assoc.emplace_back( closestDzIndex, i ); }
+    }
+}
+
+void associateZIndex( flashgg::VertexZIndex &zIndex, const vector<reco::Vertex> &vertices, const vector<BenchTrack> &tracks, double maxDz,
+                      Association &assoc )
+{
+    assoc.clear();
+    zIndex.build( vertices );
+    for( unsigned int i = 0 ; i < tracks.size() ; i++ ) {
+        double closestDz = maxDz;
+        unsigned int closestDzIndex = -1;
+        auto window = zIndex.candidatesNear( tracks[i], maxDz );
+        for( auto it = window.first ; it != window.second ; ++it ) {
+            double dz = fabs( tracks[i].dz( vertices[it->index].position() ) );
+            if( dz < closestDz || ( dz == closestDz && it->index < closestDzIndex ) ) {
+                closestDz = dz;
+                closestDzIndex = it->index;
+            }
+        }
+        if( closestDz < maxDz ) { assoc.emplace_back( closestDzIndex, i ); }
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    unsigned int nTracks = ( argc > 1 ? atoi( argv[1] ) : 1500 );
+    double maxDz = ( argc > 2 ? atof( argv[2] ) : 0.2 );
+    unsigned int nEvents = ( argc > 3 ? atoi( argv[3] ) : 200 );
+
+    std::mt19937 rng( 12345 );
+    std::normal_distribution<double> beamZ( 0., 4.5 ), beamXY( 0., 0.002 ), trackDz( 0., 0.03 ), trackEta( 0., 1.5 );
+    std::uniform_real_distribution<double> flat( 0., 1. );
+
+    cout << "nVtx   fullScan[us/evt]   zIndex[us/evt]   speedup   identical" << endl;
+    for( unsigned int nVtx : { 10u, 20u, 40u, 60u, 80u, 120u, 160u } ) {
+        vector<vector<reco::Vertex> > vertexSets( nEvents );
+        vector<vector<BenchTrack> > trackSets( nEvents );
+        for( unsigned int ev = 0 ; ev < nEvents ; ev++ ) {
+            for( unsigned int j = 0 ; j < nVtx ; j++ ) {
+                vertexSets[ev].emplace_back( reco::Vertex::Point( 0.1 + beamXY( rng ), beamXY( rng ), beamZ( rng ) ), reco::Vertex::Error() );
+            }
+            for( unsigned int i = 0 ; i < nTracks ; i++ ) {
+                const auto &pv = vertexSets[ev][rng() % nVtx].position();
+                double pt = 0.5 + 10. * flat( rng ) * flat( rng );
+                double pz = pt * std::sinh( trackEta( rng ) );
+                trackSets[ev].push_back( BenchTrack{ pv.X(), pv.Y(), pv.Z() + trackDz( rng ), pt, pz, 2 * M_PI * flat( rng ) } );
+            }
+        }
+
+        Association full, indexed;
+        flashgg::VertexZIndex zIndex;
+        bool identical = true;
+        double tFull = 0., tIndex = 0.;
+        for( unsigned int ev = 0 ; ev < nEvents ; ev++ ) {
+            auto t0 = std::chrono::steady_clock::now();
+            associateFullScan( vertexSets[ev], trackSets[ev], maxDz, full );
+            auto t1 = std::chrono::steady_clock::now();
+            associateZIndex( zIndex, vertexSets[ev], trackSets[ev], maxDz, indexed );
+            auto t2 = std::chrono::steady_clock::now();
+            tFull += std::chrono::duration<double, std::micro>( t1 - t0 ).count();
+            tIndex += std::chrono::duration<double, std::micro>( t2 - t1 ).count();
+            identical = identical && ( full == indexed );
+        }
+        tFull /= nEvents;
+        tIndex /= nEvents;
+        cout << nVtx << "\t" << tFull << "\t\t" << tIndex << "\t\t" << tFull / tIndex << "\t" << ( identical ? "yes" : "NO" ) << endl;
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -0,0 +1,95 @@
+#ifndef flashgg_CompiledObjectFunction_h
+#define flashgg_CompiledObjectFunction_h
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+#include "CommonTools/Utils/interface/StringObjectFunction.h"
+#include "FWCore/Utilities/interface/TypeID.h"
+
+namespace flashgg {
+
+    // Turns StringObjectFunction expressions into native functions through the ROOT
+    // interpreter. Compiled functions are cached process-wide, keyed on the object
+    // type and the expression, so the many dumpers sharing a variable list only
+    // compile each expression once.
+    class ExpressionCompiler
+    {
+    public:
+        typedef double ( *function_type )( const void * );
+
+        // Process-wide default for the functions built without an explicit choice,
+        // off unless FLASHGG_COMPILED_EXPRESSIONS is set. Users with their own option
+        // (e.g. the CollectionDumper "compileExpressions") pass it to the constructors.
+        static void setEnabled( bool enabled );
+        static bool enabled();
+
+        // Native version of expr acting on objects of class typeName,
+        // or 0 if it cannot be translated or compiled
+        static function_type compile( const std::string &typeName, const std::string &expr );
+
+        // C++ translation of expr acting on a variable named obj, or an empty
+        // string if expr uses syntax the translator does not handle
+        static std::string translate( const std::string &expr );
+    };
+
+    // Drop-in replacement for StringObjectFunction<T, lazy>. The reflective
+    // function is always built, so that malformed expressions fail exactly as
+    // before, and is used whenever the native one is not available.
+    template<class T, bool DefaultLazyness = true>
+    class CompiledObjectFunction
+    {
+    public:
+        CompiledObjectFunction( const std::string &expr, bool lazy = DefaultLazyness ) :
+            CompiledObjectFunction( expr, lazy, ExpressionCompiler::enabled() )
+        {
+        }
+
+        // compile: try the native function regardless of the process default
+        CompiledObjectFunction( const std::string &expr, bool lazy, bool compile ) :
+            reflective_( new StringObjectFunction<T, DefaultLazyness>( expr, lazy ) ),
+            compiled_( 0 )
+        {
+            if( compile ) {
+                compiled_ = ExpressionCompiler::compile( edm::TypeID( typeid( T ) ).className(), expr );
+            }
+        }
+
+        double operator()( const T &t ) const
+        {
+            if( compiled_ ) { return compiled_( &t ); }
+            return ( *reflective_ )( t );
+        }
+
+        bool isCompiled() const { return compiled_ != 0; }
+
+    private:
+        std::shared_ptr<StringObjectFunction<T, DefaultLazyness> > reflective_;
+        ExpressionCompiler::function_type compiled_;
+    };
+
+    // Used by the helpers templated on the functor type (StepWiseFunctor, MVAComputer,
+    // CategoryDumper) to pass their compile choice on: only CompiledObjectFunction uses it.
+    template<class F>
+    struct FunctorBuilder {
+        static F build( const std::string &expr, bool ) { return F( expr ); }
+    };
+
+    template<class T, bool DefaultLazyness>
+    struct FunctorBuilder<CompiledObjectFunction<T, DefaultLazyness> > {
+        static CompiledObjectFunction<T, DefaultLazyness> build( const std::string &expr, bool compile )
+        {
+            return CompiledObjectFunction<T, DefaultLazyness>( expr, DefaultLazyness, compile );
+        }
+    };
+}
+
+#endif // flashgg_CompiledObjectFunction_h
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
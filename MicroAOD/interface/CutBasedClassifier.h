@@ -30,6 +30,18 @@ namespace flashgg {
             return std::make_pair( "", 0 );
         }
 
+        // Integer form of operator(): the index of the first category passed, or the number of
+        // categories if none is, and the subcategory. name() turns an index into the category name
+        std::pair<int, int> code( const T &obj ) const
+        {
+            for( unsigned int icut = 0 ; icut < cuts_.size() ; icut++ ) {
+                if( cuts_[icut].first( obj ) ) { return std::make_pair( icut, 0 ); }
+            }
+            return std::make_pair( cuts_.size(), 0 );
+        }
+        std::string name( int code ) const { return ( code < ( int )cuts_.size() ? cuts_[code].second : "" ); }
+        int nCodes() const { return cuts_.size() + 1; }
+
     private:
         std::vector<std::pair<functor_type, std::string> > cuts_;
 
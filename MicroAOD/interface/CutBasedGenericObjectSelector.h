@@ -6,6 +6,7 @@
 #include "CommonTools/Utils/interface/StringCutObjectSelector.h"
 
 #include "flashgg/MicroAOD/interface/StepWiseFunctor.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
 #include "flashgg/MicroAOD/interface/CutBasedClassifier.h"
 
 #include "FWCore/Common/interface/EventBase.h"
@@ -24,8 +25,8 @@ namespace flashgg {
         typedef typename InputCollection::value_type T;
         typedef T object_type;
         typedef CutBasedClassifier<T> classifier_type;
-        typedef StringObjectFunction<T> functor_type;
-        typedef StepWiseFunctor<T> stepwise_functor_type;
+        typedef CompiledObjectFunction<T, false> functor_type;
+        typedef StepWiseFunctor<T, functor_type> stepwise_functor_type;
         typedef StringCutObjectSelector<T, true> selector_type;
         typedef edm::Ref<InputCollection> ref_type;
 
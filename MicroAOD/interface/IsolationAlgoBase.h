@@ -6,6 +6,7 @@
 #include "DataFormats/VertexReco/interface/Vertex.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 #include "flashgg/DataFormats/interface/VertexCandidateMap.h"
+#include "flashgg/MicroAOD/interface/PFCandidateEtaPhiIndex.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "DataFormats/ParticleFlowCandidate/interface/PFCandidate.h"
@@ -25,9 +26,18 @@ namespace flashgg {
         virtual void begin( const pat::Photon &, const edm::Event &, const edm::EventSetup & ) {};
         virtual bool hasChargedIsolation() = 0;
         virtual float chargedIsolation( const edm::Ptr<pat::Photon> &, const edm::Ptr<reco::Vertex>, const flashgg::VertexCandidateMap & ) = 0;
+        // charged isolation with respect to every vertex; algorithms can override it to serve all vertices in a single pass
+        virtual std::map<edm::Ptr<reco::Vertex>, float> chargedIsolationWrtAllVtx( const edm::Ptr<pat::Photon> &, const std::vector<edm::Ptr<reco::Vertex> > &,
+                const flashgg::VertexCandidateMap & );
         virtual bool hasCaloIsolation( reco::PFCandidate::ParticleType ) = 0;
         virtual float caloIsolation( const edm::Ptr<pat::Photon> &, const std::vector<edm::Ptr<pat::PackedCandidate> > &, reco::PFCandidate::ParticleType,
                                      const reco::Vertex *vtx = 0 ) = 0;
+        // same from the per-event eta-phi index of the candidates; algorithms can override it to visit only the candidates near the cone
+        virtual float caloIsolationFromIndex( const edm::Ptr<pat::Photon> &pho, PFCandidateEtaPhiIndex &pfindex, reco::PFCandidate::ParticleType typ,
+                                              const reco::Vertex *vtx = 0 )
+        {
+            return caloIsolation( pho, pfindex.candidates(), typ, vtx );
+        }
 
         virtual void end( pat::Photon & ) {};
 
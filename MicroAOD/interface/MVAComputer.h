@@ -11,6 +11,7 @@
 
 #include "CommonTools/Utils/interface/StringObjectFunction.h"
 #include "CommonTools/Utils/interface/StringCutObjectSelector.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
 
 #include "TMVA/Reader.h"
 #include "flashgg/Taggers/interface/GlobalVariablesDumper.h"
@@ -27,7 +28,8 @@ namespace flashgg {
         typedef FunctorT functor_type;
 
         MVAComputer() {};
-        MVAComputer( const edm::ParameterSet &cfg, GlobalVariablesComputer *global = 0 );
+        // compile: passed on to the functors when they are CompiledObjectFunctions
+        MVAComputer( const edm::ParameterSet &cfg, GlobalVariablesComputer *global = 0, bool compile = ExpressionCompiler::enabled() );
         ~MVAComputer();
 
         std::vector<float> operator()( const object_type &obj ) const;
@@ -36,6 +38,8 @@ namespace flashgg {
 
         void bookMVA() const;        
 
+        // operator() fills the reader inputs in place: an instance must not be
+        // shared between streams (owning modules are edm::stream producers)
         mutable TMVA::Reader *reader_;
         GlobalVariablesComputer *global_;
 
@@ -52,7 +56,7 @@ namespace flashgg {
     };
 
     template<class F, class O, bool useXGB>
-    MVAComputer<F, O, useXGB>::MVAComputer( const edm::ParameterSet &cfg, GlobalVariablesComputer *global ) :
+    MVAComputer<F, O, useXGB>::MVAComputer( const edm::ParameterSet &cfg, GlobalVariablesComputer *global, bool compile ) :
         reader_( 0 ),
         global_( global ),
         regression_( cfg.exists("regression") ? cfg.getParameter<bool>("regression") : false ),
@@ -72,7 +76,7 @@ namespace flashgg {
                 assert( global != 0 );
                 variables_.push_back( std::make_tuple( name + "::" + expr.substr( 7 ), -1 ) );
             } else {
-                functors_.push_back( functor_type( expr ) );
+                functors_.push_back( FunctorBuilder<functor_type>::build( expr, compile ) );
                 variables_.push_back( std::make_tuple( name, functors_.size() - 1 ) );
             }
         }
@@ -17,12 +17,16 @@
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESWatcher.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "Geometry/CaloGeometry/interface/CaloSubdetectorGeometry.h"
+#include "Geometry/Records/interface/CaloGeometryRecord.h"
 #include "MagneticField/Engine/interface/MagneticField.h"
+#include "MagneticField/Records/interface/IdealMagneticFieldRecord.h"
 
 #include "DataFormats/Common/interface/Ptr.h"
+#include "DataFormats/Provenance/interface/ProductID.h"
 #include "DataFormats/PatCandidates/interface/Photon.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 
@@ -43,6 +47,23 @@ namespace diphotons {
         std::vector<std::vector<TVector3> > xtalcorners;
     } sc_xtal_information;
 
+    // crystal of the footprint rotated by the random-cone angle, with the quantities of the footprint test
+    typedef struct {
+        TVector3 position;
+        float barrelradius, endcapz; // surfaces the candidates are propagated to
+        double eta, phi;
+        float etawidth, phiwidth; // enlarged
+        float polx[5], poly[5], centerx, centery;
+    } xtal_footprint;
+
+    // impact point of a candidate on the ECAL surface at a given radius (barrel) or |z| (endcap)
+    typedef struct {
+        float position;
+        bool isbarrel;
+        TVector3 hit;
+        double eta, phi; // of hit, for barrel hits with non-zero perp
+    } propagated_hit;
+
     //
     // class declaration
     //
@@ -72,6 +93,8 @@ namespace diphotons {
         std::vector<edm::Ptr<pat::PackedCandidate> > associatedCandidates;
 
         TVector3 propagatePFCandToEcal( const edm::Ptr<pat::PackedCandidate> &cand, float position, bool isbarrel );
+        const propagated_hit &propagatedHit( const edm::Ptr<pat::PackedCandidate> &cand, float position, bool isbarrel );
+        const std::vector<xtal_footprint> &footprint();
         sc_xtal_information getSCXtalInfo( reco::SuperClusterRef sc );
         bool checkMatchedPFCandidate( const edm::Ptr<pat::PackedCandidate> &pfcandindex );
 
@@ -79,10 +102,23 @@ namespace diphotons {
         CaloSubdetectorGeometry *endcapGeometry;
         TGeoPara eegeom;
         MagneticField *magField;
+        float magFieldZ;
+        edm::ESWatcher<CaloGeometryRecord> geometryWatcher;
+        edm::ESWatcher<IdealMagneticFieldRecord> magFieldWatcher;
 
         reco::SuperClusterRef sc;
         sc_xtal_information infos;
 
+        // footprint crystals, rotated by footprintRotation; recomputed when setup or the rotation change
+        std::vector<xtal_footprint> footprintXtals;
+        float footprintRotation;
+        bool footprintValid;
+
+        // the propagations do not depend on the photon: they are kept for the whole event, per candidate key
+        std::vector<std::vector<propagated_hit> > propagatedHits;
+        edm::ProductID propagatedProduct;
+        edm::Event::CacheIdentifier_t propagatedEvent;
+
         double global_linkbyrechit_enlargement;
         float rotation_phi;
         int removePhotonsInMap_;
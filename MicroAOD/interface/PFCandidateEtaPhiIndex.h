@@ -0,0 +1,73 @@
+#ifndef FLASHgg_PFCandidateEtaPhiIndex_h
+#define FLASHgg_PFCandidateEtaPhiIndex_h
+
+#include "DataFormats/Common/interface/Ptr.h"
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+
+#include <vector>
+
+namespace flashgg {
+
+    // Per-event eta-phi grid of the packed PF candidates, split by pdgId, for the isolation sums.
+    //
+    // The candidates of a pdgId are binned in the eta and phi of their momentum the first time
+    // that pdgId is asked for, so one index serves all the photons, cone sizes and isolation
+    // algorithms of the event. query() returns the candidates of the cells overlapping a cone,
+    // with a safety margin, in their original order: the caller applies its usual selection to
+    // them and sums in the same order as a scan of the whole collection. The momentum eta and
+    // phi are kept, computed as in that scan. Candidates with a non-finite eta or phi are
+    // returned by every query.
+    //
+    // The index refers to the candidate vector, which must outlive it.
+    class PFCandidateEtaPhiIndex
+    {
+
+    public:
+        explicit PFCandidateEtaPhiIndex( const std::vector<edm::Ptr<pat::PackedCandidate> > &pfcandidates );
+
+        const std::vector<edm::Ptr<pat::PackedCandidate> > &candidates() const { return *pfcandidates_; }
+
+        // momentum eta and phi of candidate i, filled once its pdgId has been indexed
+        double eta( unsigned int i ) const { return eta_[i]; }
+        double phi( unsigned int i ) const { return phi_[i]; }
+
+        // indices, in increasing order, of the candidates of this pdgId which may lie within dRMax of (eta, phi);
+        // the vector is overwritten by the next call
+        const std::vector<unsigned int> &query( int pdgId, double eta, double phi, double dRMax );
+        // indices, in increasing order, of all the candidates of this pdgId, overwritten as above
+        const std::vector<unsigned int> &all( int pdgId );
+
+    private:
+        struct Grid {
+            int pdgId;
+            std::vector<unsigned int> all;
+            std::vector<unsigned int> offsets; // per cell, into cells
+            std::vector<unsigned int> cells;   // candidates sorted by cell
+            std::vector<unsigned int> unplaced;
+        };
+
+        const Grid &grid( int pdgId );
+        static int etaBin( double eta );
+        static int phiBin( double phi );
+
+        static constexpr int nEtaBins = 100;
+        static constexpr int nPhiBins = 64;
+        static constexpr double etaMax = 5.;
+        static constexpr double margin = 0.01;
+
+        const std::vector<edm::Ptr<pat::PackedCandidate> > *pfcandidates_;
+        std::vector<int> pdgId_;
+        std::vector<double> eta_, phi_;
+        std::vector<Grid> grids_;
+        std::vector<unsigned int> result_;
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -14,6 +14,7 @@
 
 #include "flashgg/DataFormats/interface/Photon.h"
 #include "flashgg/DataFormats/interface/VertexCandidateMap.h"
+#include "flashgg/MicroAOD/interface/PFCandidateEtaPhiIndex.h"
 
 #include "DataFormats/EcalRecHit/interface/EcalRecHitCollections.h"
 #include "RecoEcal/EgammaCoreTools/interface/EcalClusterLazyTools.h"
@@ -66,22 +67,34 @@ namespace flashgg {
         */
         float              pfIsoChgWrtVtx( const edm::Ptr<pat::Photon> &photon,
                                            const edm::Ptr<reco::Vertex> vtx,
-                                           const flashgg::VertexCandidateMap vtxcandmap,
+                                           const flashgg::VertexCandidateMap &vtxcandmap,
                                            float coneSize, float coneVetoBarrel, float coneVetoEndcap, float ptMin);
 
         /** calculates the charged particle flow isolation for a single photon with respect to all given
             vertices. See pfIsoChgWrtVtx(..) for details about the parameters. */
         std::map<edm::Ptr<reco::Vertex>, float> pfIsoChgWrtAllVtx( const edm::Ptr<pat::Photon> &photon,
                 const std::vector<edm::Ptr<reco::Vertex> > &vertices,
-                const flashgg::VertexCandidateMap vtxcandmap,
+                const flashgg::VertexCandidateMap &vtxcandmap,
                 float coneSize, float coneVetoBarrel, float coneVetoEndcap, float ptMin);
 
+        /** same as above for several outer cone sizes at once: each vertex-associated candidate is visited
+            and its delta R computed only once. Returns one map per entry of coneSizes, in the same order. */
+        std::vector<std::map<edm::Ptr<reco::Vertex>, float> > pfIsoChgWrtAllVtx( const edm::Ptr<pat::Photon> &photon,
+                const std::vector<edm::Ptr<reco::Vertex> > &vertices,
+                const flashgg::VertexCandidateMap &vtxcandmap,
+                const std::vector<float> &coneSizes, float coneVetoBarrel, float coneVetoEndcap, float ptMin);
+
         float              pfIsoChgWrtWorstVtx( std::map<edm::Ptr<reco::Vertex>, float> & );
 
         float              pfCaloIso( const edm::Ptr<pat::Photon> &,
                                       const std::vector<edm::Ptr<pat::PackedCandidate> > &,
                                       float, float, float, float, float, float, float, reco::PFCandidate::ParticleType, const reco::Vertex *vtx = 0 );
 
+        /** same as above, visiting only the candidates of the per-event index near the cone; gives the same sum.
+            Without a vertex the cone direction depends on each candidate's vertex, and all the candidates of the type are visited. */
+        float              pfCaloIso( const edm::Ptr<pat::Photon> &, PFCandidateEtaPhiIndex &,
+                                      float, float, float, float, float, float, float, reco::PFCandidate::ParticleType, const reco::Vertex *vtx = 0 );
+
 
         void               setupMVA( const std::string &, const std::string &, bool , bool);
         float              computeMVAWrtVtx( flashgg::Photon &, const edm::Ptr<reco::Vertex> &, const double, const double eA = 0, const std::vector<double> coeff = vector<double>(0,0),const double cut = 0);
@@ -2,7 +2,7 @@
 #define FLASHgg_RandomizedObjectProducer_h
 
 #include "DataFormats/Common/interface/Handle.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -16,7 +16,7 @@
 namespace flashgg {
 
     template <typename pat_object>
-    class RandomizedObjectProducer : public edm::EDProducer
+    class RandomizedObjectProducer : public edm::stream::EDProducer<>
     {
     public:
         RandomizedObjectProducer( const edm::ParameterSet & );
@@ -30,6 +30,23 @@ namespace flashgg {
             }
             return std::make_pair( cat, stage1based.second  );
         }
+
+        // Integer form of operator(), combining the codes of the two classifiers
+        std::pair<int, int> code( const T &obj ) const
+        {
+            auto cutbased = CutBasedClassifier<T>::code( obj );
+            auto stage1based = StageOneNameClassifier<T>::code( obj );
+            return std::make_pair( stage1based.first * CutBasedClassifier<T>::nCodes() + cutbased.first, stage1based.second );
+        }
+        std::string name( int code ) const
+        {
+            std::string cat = StageOneNameClassifier<T>::name( code / CutBasedClassifier<T>::nCodes() );
+            std::string cut = CutBasedClassifier<T>::name( code % CutBasedClassifier<T>::nCodes() );
+            if( ! cut.empty() ) {
+                cat += (cat.empty()?"":":")+cut;
+            }
+            return cat;
+        }
     };
 }
 
@@ -40,11 +40,27 @@ namespace flashgg {
             return ret;
         }
 
+        // Integer form of operator(): a number given to each stage 1 reco tag in the order they are met,
+        // and the subcategory. name() turns the number into the category name
+        std::pair<int, int> code( const T &obj ) const
+        {
+            int idx = obj.getStage1recoTag();
+            auto cached = codes_.find( idx );
+            if( cached == codes_.end() ) {
+                cached = codes_.insert( std::make_pair( idx, names_.size() ) ).first;
+                names_.push_back( operator()( obj ).first );
+            }
+            return std::make_pair( cached->second, ( int )obj );
+        }
+        std::string name( int code ) const { return names_[code]; }
+
 
     private:
         std::map<std::string, std::string> remap_;
         //mutable std::unordered_map<std::type_index, std::string> cache_;
         mutable std::unordered_map<int, std::string> cache_;
+        mutable std::unordered_map<int, int> codes_;
+        mutable std::vector<std::string> names_;
     };
 }
 
@@ -11,6 +11,7 @@
 
 #include "CommonTools/Utils/interface/StringObjectFunction.h"
 #include "CommonTools/Utils/interface/StringCutObjectSelector.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
 
 #include "TMVA/Reader.h"
 #include "flashgg/Taggers/interface/GlobalVariablesDumper.h"
@@ -24,7 +25,8 @@ namespace flashgg {
         typedef ObjectT object_type;
         typedef FunctorT functor_type;
 
-        StepWiseFunctor( const edm::ParameterSet &cfg );
+        // compile: passed on to the functor when it is a CompiledObjectFunction
+        StepWiseFunctor( const edm::ParameterSet &cfg, bool compile = ExpressionCompiler::enabled() );
         ~StepWiseFunctor();
 
         float operator()( const object_type &obj ) const;
@@ -39,8 +41,8 @@ namespace flashgg {
     };
 
     template<class F, class O>
-    StepWiseFunctor<F, O>::StepWiseFunctor( const edm::ParameterSet &cfg ) :
-        functor_( cfg.getParameter<std::string>( "var" ) ),
+    StepWiseFunctor<F, O>::StepWiseFunctor( const edm::ParameterSet &cfg, bool compile ) :
+        functor_( FunctorBuilder<functor_type>::build( cfg.getParameter<std::string>( "var" ), compile ) ),
         bins_( cfg.getParameter<std::vector<double> >( "bins" ) ),
         vals_( cfg.getParameter<std::vector<double> >( "vals" ) ),
         default_( 0. )
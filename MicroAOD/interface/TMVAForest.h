@@ -0,0 +1,72 @@
+#ifndef FLASHgg_TMVAForest_h
+#define FLASHgg_TMVAForest_h
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Flat, array-based evaluator of the TMVA BDTs (AdaBoost, Bagging and Grad boosting),
+// built once from the TMVA XML weight file.
+//
+// The nodes of all the trees are stored in a few contiguous arrays, and several rows
+// of inputs are scored in one pass, tree by tree, so that each tree stays in cache
+// while it is applied to all the rows. The cuts, purities and responses are stored as
+// floats and the inputs compared as floats, as in TMVA, and the tree outputs are summed
+// in the same order: scores agree with TMVA::Reader::EvaluateMVA to rounding.
+//
+// Input variable transformations are not supported. A forest is read-only once built,
+// and get() shares one instance per weight file across all the modules and streams.
+
+namespace flashgg {
+
+    class TMVAForest
+    {
+
+    public:
+        explicit TMVAForest( const std::string &weightFile );
+
+        // forest for weightFile, loaded at the first call and shared by all the callers
+        static std::shared_ptr<const TMVAForest> get( const std::string &weightFile );
+
+        // input variables (TMVA expressions), in the order expected in each row
+        const std::vector<std::string> &variables() const { return variables_; }
+        size_t nTrees() const { return roots_.size(); }
+
+        // scores the nrows rows of variables().size() inputs stored contiguously from rows
+        void evaluate( const float *rows, size_t nrows, double *scores ) const;
+        double evaluate( const float *row ) const
+        {
+            double score;
+            evaluate( row, 1, &score );
+            return score;
+        }
+
+    private:
+        // child references: >= 0 for a node, < 0 for the leaf -( ref + 1 )
+        int readNode( void *xml, void *node, const std::string &weightFile );
+
+        bool gradBoost_;
+        bool useYesNoLeaf_;
+        double norm_;
+        std::vector<std::string> variables_;
+
+        std::vector<int> roots_;
+        std::vector<double> boostWeights_;
+        // nodes: the ones with x >= cut go to right_ (TMVA cType 0 is stored swapped)
+        std::vector<int> var_;
+        std::vector<float> cut_;
+        std::vector<int> left_;
+        std::vector<int> right_;
+        // leaf values: nType or purity for the AdaBoost forests, response for the Grad ones
+        std::vector<double> leaves_;
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -50,6 +50,10 @@ namespace flashgg {
                                                //                                          const float&
                                              )  = 0;
 
+        // Called by the producers once per event, before selecting the vertex of each pair:
+        // a selector may keep per-event quantities, shared by the pairs, until the next call
+        virtual void beginEvent() {}
+
         const std::string &name() const { return _selectorName; };
 
         virtual void writeInfoFromLastSelectionTo( flashgg::DiPhotonCandidate & ) = 0;
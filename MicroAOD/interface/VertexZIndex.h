@@ -0,0 +1,105 @@
+#ifndef FLASHgg_VertexZIndex_h
+#define FLASHgg_VertexZIndex_h
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Primary vertices sorted by z, so that the vertices compatible with a track
+// can be found by binary search instead of scanning the whole collection.
+//
+// PackedCandidate::dz( p ) is not a pure function of p.z(): it also has a
+// term ( p.x()*cos(phi) + p.y()*sin(phi) ) * pz/pt. The window returned by
+// candidatesNear() is therefore widened by the largest transverse distance of a
+// vertex from the mean vertex position times |pz/pt|, so that it is guaranteed
+// to contain every vertex with |dz| < maxDz. Callers still compute the exact
+// dz for the vertices in the window, which keeps the association identical to
+// the full scan.
+
+namespace flashgg {
+
+    class VertexZIndex
+    {
+
+    public:
+        struct Entry {
+            double z;
+            unsigned int index;
+            bool operator<( const Entry &other ) const { return ( z < other.z || ( z == other.z && index < other.index ) ); }
+        };
+        typedef std::vector<Entry>::const_iterator const_iterator;
+
+        VertexZIndex() : x0_( 0. ), y0_( 0. ), rhoMax_( 0. ) {}
+
+        template<class VertexCollection> void build( const VertexCollection &vertices )
+        {
+            entries_.clear();
+            entries_.reserve( vertices.size() );
+            x0_ = 0.;
+            y0_ = 0.;
+            for( unsigned int j = 0 ; j < vertices.size() ; j++ ) {
+                const auto &pos = vertices[j].position();
+                entries_.push_back( Entry{ pos.z(), j } );
+                x0_ += pos.x();
+                y0_ += pos.y();
+            }
+            if( !entries_.empty() ) {
+                x0_ /= entries_.size();
+                y0_ /= entries_.size();
+            }
+            rhoMax_ = 0.;
+            for( unsigned int j = 0 ; j < vertices.size() ; j++ ) {
+                const auto &pos = vertices[j].position();
+                rhoMax_ = std::max( rhoMax_, std::hypot( pos.x() - x0_, pos.y() - y0_ ) );
+            }
+            std::sort( entries_.begin(), entries_.end() );
+        }
+
+        // All vertices whose z lies within [zmin,zmax]
+        std::pair<const_iterator, const_iterator> range( double zmin, double zmax ) const
+        {
+            auto lo = std::lower_bound( entries_.begin(), entries_.end(), zmin,
+                                        []( const Entry & e, double z ) { return e.z < z; } );
+            auto hi = std::upper_bound( lo, entries_.end(), zmax,
+                                        []( double z, const Entry & e ) { return z < e.z; } );
+            return std::make_pair( lo, hi );
+        }
+
+        // Superset of the vertices for which |cand.dz( vtx.position() )| < maxDz,
+        // for any candidate with the pat::PackedCandidate track parametrisation
+        template<class Candidate> std::pair<const_iterator, const_iterator> candidatesNear( const Candidate &cand, double maxDz ) const
+        {
+            double pt = cand.pt();
+            if( !( pt > 0. ) ) { return std::make_pair( entries_.begin(), entries_.end() ); }
+            double cotTheta = cand.pz() / pt;
+            double cosPhi = std::cos( cand.phi() );
+            double sinPhi = std::sin( cand.phi() );
+            double z0 = cand.vz() - ( ( cand.vx() - x0_ ) * cosPhi + ( cand.vy() - y0_ ) * sinPhi ) * cotTheta;
+            double halfWidth = maxDz + rhoMax_ * std::fabs( cotTheta ) + margin_;
+            if( !std::isfinite( z0 ) || !std::isfinite( halfWidth ) ) { return std::make_pair( entries_.begin(), entries_.end() ); }
+            return range( z0 - halfWidth, z0 + halfWidth );
+        }
+
+        const_iterator begin() const { return entries_.begin(); }
+        const_iterator end() const { return entries_.end(); }
+        unsigned int size() const { return entries_.size(); }
+
+    private:
+        // Absorbs rounding differences between the window and the exact dz (in cm)
+        static constexpr double margin_ = 1.e-4;
+
+        std::vector<Entry> entries_;
+        double x0_, y0_; // mean transverse vertex position
+        double rhoMax_;  // largest transverse distance of a vertex from ( x0_, y0_ )
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -1,5 +1,5 @@
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -19,7 +19,7 @@ using namespace std;
 
 namespace flashgg {
 
-    class CHSLegacyVertexCandidateProducer : public EDProducer
+    class CHSLegacyVertexCandidateProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -24,7 +24,7 @@ using namespace std;
 
 namespace flashgg {
 
-    class DiPhotonProducer : public EDProducer
+    class DiPhotonProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -107,6 +107,7 @@ namespace flashgg {
         //const PtrVector<reco::Conversion>& conversionPointersSingleLeg = conversionsSingleLeg->ptrVector();
 
         unique_ptr<vector<DiPhotonCandidate> > diPhotonColl( new vector<DiPhotonCandidate> );
+        vertexSelector_->beginEvent();
 //    cout << "evt.id().event()= " << evt.id().event() << "\tevt.isRealData()= " << evt.isRealData() << "\tphotons->size()= " << photons->size() << "\tprimaryVertices->size()= " << primaryVertices->size() << endl;
 
         for( unsigned int i = 0 ; i < photons->size() ; i++ ) {
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -8,13 +8,14 @@
 #include "DataFormats/VertexReco/interface/Vertex.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 #include "flashgg/DataFormats/interface/VertexCandidateMap.h"
+#include "flashgg/MicroAOD/interface/VertexZIndex.h"
 
 using namespace edm;
 using namespace std;
 
 namespace flashgg {
 
-    class DzVertexMapProducer : public EDProducer
+    class DzVertexMapProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -25,13 +26,16 @@ namespace flashgg {
         EDGetTokenT<View<pat::PackedCandidate> > pfcandidateToken_;
         double maxAllowedDz_;
         bool useEachTrackOnce_;
+        bool useZIndex_;
+        VertexZIndex zIndex_;
     };
 
     DzVertexMapProducer::DzVertexMapProducer( const ParameterSet &iConfig ) :
         vertexToken_( consumes<View<reco::Vertex> >( iConfig.getParameter<InputTag> ( "VertexTag" ) ) ),
         pfcandidateToken_( consumes<View<pat::PackedCandidate> >( iConfig.getParameter<InputTag> ( "PFCandidatesTag" ) ) ),
         maxAllowedDz_( iConfig.getParameter<double>( "MaxAllowedDz" ) ), // in cm
-        useEachTrackOnce_( iConfig.getParameter<bool>( "UseEachTrackOnce" ) )
+        useEachTrackOnce_( iConfig.getParameter<bool>( "UseEachTrackOnce" ) ),
+        useZIndex_( iConfig.exists( "UseZIndex" ) ? iConfig.getParameter<bool>( "UseZIndex" ) : false )
     {
         produces<VertexCandidateMap>();
     }
@@ -49,7 +53,37 @@ namespace flashgg {
 
         std::unique_ptr<VertexCandidateMap> assoc( new VertexCandidateMap );
 
-        if( useEachTrackOnce_ ) {
+        if( useZIndex_ ) {
+            // Same association as below, but only the vertices within reach in z are tested
+            zIndex_.build( *primaryVertices );
+            for( unsigned int i = 0 ; i < pfCandidates->size() ; i++ ) {
+                Ptr<pat::PackedCandidate> cand = pfCandidates->ptrAt( i );
+                if( cand->charge() == 0 ) { continue; } // skip neutrals
+                auto window = zIndex_.candidatesNear( *cand, maxAllowedDz_ );
+                if( useEachTrackOnce_ ) {
+                    double closestDz = maxAllowedDz_;
+                    unsigned int closestDzIndex = -1;
+                    for( auto it = window.first ; it != window.second ; ++it ) {
+                        double dz = fabs( cand->dz( ( *primaryVertices )[it->index].position() ) );
+                        // break ties towards the lowest index, as the full scan does
+                        if( dz < closestDz || ( dz == closestDz && it->index < closestDzIndex ) ) {
+                            closestDz = dz;
+                            closestDzIndex = it->index;
+                        }
+                    }
+                    if( closestDz < maxAllowedDz_ ) {
+                        assoc->emplace_back( primaryVertices->ptrAt( closestDzIndex ), cand );
+                    }
+                } else {
+                    for( auto it = window.first ; it != window.second ; ++it ) {
+                        double dz = fabs( cand->dz( ( *primaryVertices )[it->index].position() ) );
+                        if( dz < maxAllowedDz_ ) {
+                            assoc->emplace_back( primaryVertices->ptrAt( it->index ), cand );
+                        }
+                    }
+                }
+            }
+        } else if( useEachTrackOnce_ ) {
             // Associate a track to the closest vertex only, and only if dz < maxAllowedDz_
             for( unsigned int i = 0 ; i < pfCandidates->size() ; i++ ) {
                 Ptr<pat::PackedCandidate> cand = pfCandidates->ptrAt( i );
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -8,6 +8,7 @@
 #include "DataFormats/VertexReco/interface/Vertex.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 #include "flashgg/DataFormats/interface/VertexCandidateMap.h"
+#include "flashgg/MicroAOD/interface/VertexZIndex.h"
 
 using namespace edm;
 using namespace std;
@@ -19,7 +20,7 @@ using namespace std;
 
 namespace flashgg {
 
-    class DzVertexMapProducerForCHS : public EDProducer
+    class DzVertexMapProducerForCHS : public edm::stream::EDProducer<>
     {
 
     public:
@@ -29,12 +30,15 @@ namespace flashgg {
         EDGetTokenT<View<reco::Vertex> > vertexToken_;
         EDGetTokenT<View<pat::PackedCandidate> > pfcandidateToken_;
         double maxAllowedDz_;
+        bool useZIndex_;
+        VertexZIndex zIndex_;
     };
 
     DzVertexMapProducerForCHS::DzVertexMapProducerForCHS( const ParameterSet &iConfig ) :
         vertexToken_( consumes<View<reco::Vertex> >( iConfig.getParameter<InputTag> ( "VertexTag" ) ) ),
         pfcandidateToken_( consumes<View<pat::PackedCandidate> >( iConfig.getParameter<InputTag> ( "PFCandidatesTag" ) ) ),
-        maxAllowedDz_( iConfig.getParameter<double>( "MaxAllowedDz" ) ) // in cm
+        maxAllowedDz_( iConfig.getParameter<double>( "MaxAllowedDz" ) ), // in cm
+        useZIndex_( iConfig.exists( "UseZIndex" ) ? iConfig.getParameter<bool>( "UseZIndex" ) : false )
     {
         produces<VertexCandidateMap>();
     }
@@ -57,17 +61,31 @@ namespace flashgg {
         //      assoc->insert(std::make_pair(primaryVertices->ptrAt(j),edm::PtrVector<pat::PackedCandidate>()));
         //    }
 
+        if( useZIndex_ ) { zIndex_.build( *primaryVertices ); }
+
         for( unsigned int i = 0 ; i < pfCandidates->size() ; i++ ) {
             Ptr<pat::PackedCandidate> cand = pfCandidates->ptrAt( i );
             if( cand->charge() == 0 ) { continue; } // skip neutrals
             double closestDz = maxAllowedDz_;
             unsigned int closestDzIndex = -1;
-            for( unsigned int j = 0 ; j < primaryVertices->size() ; j++ ) {
-                Ptr<reco::Vertex> vtx = primaryVertices->ptrAt( j );
-                double dz = fabs( cand->dz( vtx->position() ) );
-                if( dz < closestDz ) {
-                    closestDz = dz;
-                    closestDzIndex = j;
+            if( useZIndex_ ) {
+                auto window = zIndex_.candidatesNear( *cand, maxAllowedDz_ );
+                for( auto it = window.first ; it != window.second ; ++it ) {
+                    double dz = fabs( cand->dz( ( *primaryVertices )[it->index].position() ) );
+                    // break ties towards the lowest index, as the full scan does
+                    if( dz < closestDz || ( dz == closestDz && it->index < closestDzIndex ) ) {
+                        closestDz = dz;
+                        closestDzIndex = it->index;
+                    }
+                }
+            } else {
+                for( unsigned int j = 0 ; j < primaryVertices->size() ; j++ ) {
+                    Ptr<reco::Vertex> vtx = primaryVertices->ptrAt( j );
+                    double dz = fabs( cand->dz( vtx->position() ) );
+                    if( dz < closestDz ) {
+                        closestDz = dz;
+                        closestDzIndex = j;
+                    }
                 }
             }
             if( closestDz < maxAllowedDz_ ) {
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -23,7 +23,7 @@ using namespace std;
 
 namespace flashgg {
 
-    class EGammaMinimizer : public EDProducer
+    class EGammaMinimizer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -2,7 +2,7 @@
 #include <memory>
 // user include file
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
 #include "DataFormats/Common/interface/Handle.h"
 #include "FWCore/Framework/interface/Event.h"
@@ -26,7 +26,7 @@ using namespace reco;
 
 namespace flashgg {
 
-    class ElectronProducer : public edm::EDProducer
+    class ElectronProducer : public edm::stream::EDProducer<>
     {
     public:
         ElectronProducer( const edm::ParameterSet & );
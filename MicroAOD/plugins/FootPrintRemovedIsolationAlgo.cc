@@ -69,6 +69,8 @@ namespace diphotons {
         virtual bool hasChargedIsolation() { return ! chargedVetos_.empty(); };
 
         virtual float chargedIsolation( const edm::Ptr<pat::Photon> &, const edm::Ptr<reco::Vertex>, const flashgg::VertexCandidateMap & );
+        virtual std::map<edm::Ptr<reco::Vertex>, float> chargedIsolationWrtAllVtx( const edm::Ptr<pat::Photon> &, const std::vector<edm::Ptr<reco::Vertex> > &,
+                const flashgg::VertexCandidateMap & );
 
         virtual bool hasCaloIsolation( reco::PFCandidate::ParticleType typ )
         {
@@ -78,10 +80,15 @@ namespace diphotons {
 
         virtual float caloIsolation( const edm::Ptr<pat::Photon> &, const std::vector<edm::Ptr<pat::PackedCandidate> > &, reco::PFCandidate::ParticleType,
                                      const reco::Vertex *vtx = 0 );
+        virtual float caloIsolationFromIndex( const edm::Ptr<pat::Photon> &, flashgg::PFCandidateEtaPhiIndex &, reco::PFCandidate::ParticleType,
+                                              const reco::Vertex *vtx = 0 );
 
         virtual void end( pat::Photon & );
 
     private:
+        // calo isolation from the candidate vector or from the index
+        template <class Candidates> float caloIso( const edm::Ptr<pat::Photon> &, Candidates &, reco::PFCandidate::ParticleType, const reco::Vertex * );
+
         WrappedMiniAODFootPrintRemoval removalAlgo_;
         flashgg::PhotonIdUtils utils_;
         double conesize_, deltaPhi_, veto_;
@@ -147,16 +154,30 @@ namespace diphotons {
         return 0.;
     }
 
-    float FootPrintRemovedIsolationAlgo::caloIsolation( const edm::Ptr<pat::Photon> &pho, const std::vector<edm::Ptr<pat::PackedCandidate> > &ptrs,
+    std::map<edm::Ptr<reco::Vertex>, float> FootPrintRemovedIsolationAlgo::chargedIsolationWrtAllVtx( const edm::Ptr<pat::Photon> &pho,
+            const std::vector<edm::Ptr<reco::Vertex> > &vertices, const flashgg::VertexCandidateMap &mp )
+    {
+        if( ! chargedVetos_.empty() ) {
+            if( ! found_ ) {
+                std::map<edm::Ptr<reco::Vertex>, float> iso;
+                for( auto &vtx : vertices ) { iso[vtx] = 999.; }
+                return iso;
+            }
+            return utils_.pfIsoChgWrtAllVtx( pho, vertices, mp, conesize_, chargedVetos_[0], chargedVetos_[1], chargedVetos_[2] );
+        }
+        return IsolationAlgoBase::chargedIsolationWrtAllVtx( pho, vertices, mp );
+    }
+
+    template <class Candidates> float FootPrintRemovedIsolationAlgo::caloIso( const edm::Ptr<pat::Photon> &pho, Candidates &candidates,
             reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
     {
         if( typ == reco::PFCandidate::gamma && ! photonVetos_.empty() ) {
-            return found_ ? utils_.pfCaloIso( pho, ptrs, conesize_,
+            return found_ ? utils_.pfCaloIso( pho, candidates, conesize_,
                                               photonVetos_[0], photonVetos_[1], photonVetos_[2],
                                               photonVetos_[3], photonVetos_[4], photonVetos_[5],
                                               typ, vtx ) : 999.;
         } else if( typ == reco::PFCandidate::h0 && ! neutralVetos_.empty() ) {
-            return found_ ? utils_.pfCaloIso( pho, ptrs, conesize_,
+            return found_ ? utils_.pfCaloIso( pho, candidates, conesize_,
                                               neutralVetos_[0], neutralVetos_[1], neutralVetos_[2],
                                               neutralVetos_[3], neutralVetos_[4], neutralVetos_[5],
                                               typ, vtx ) : 999.;
@@ -164,6 +185,18 @@ namespace diphotons {
         return 0.;
     }
 
+    float FootPrintRemovedIsolationAlgo::caloIsolation( const edm::Ptr<pat::Photon> &pho, const std::vector<edm::Ptr<pat::PackedCandidate> > &ptrs,
+            reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
+    {
+        return caloIso( pho, ptrs, typ, vtx );
+    }
+
+    float FootPrintRemovedIsolationAlgo::caloIsolationFromIndex( const edm::Ptr<pat::Photon> &pho, flashgg::PFCandidateEtaPhiIndex &pfindex,
+            reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
+    {
+        return caloIso( pho, pfindex, typ, vtx );
+    }
+
     void FootPrintRemovedIsolationAlgo::end( pat::Photon &pho )
     {
         pho.addUserFloat( name() + "_rndcone_deltaphi", deltaPhi_ );
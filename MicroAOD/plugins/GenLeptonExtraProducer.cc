@@ -1,5 +1,5 @@
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -16,7 +16,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class GenLeptonExtraProducer : public EDProducer
+    class GenLeptonExtraProducer : public edm::stream::EDProducer<>
     {
 
     public:
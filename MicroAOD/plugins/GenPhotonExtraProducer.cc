@@ -1,5 +1,5 @@
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -15,7 +15,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class GenPhotonExtraProducer : public EDProducer
+    class GenPhotonExtraProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -24,7 +24,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class HiggsGenJetsSelector : public EDProducer
+    class HiggsGenJetsSelector : public edm::stream::EDProducer<>
     {
 
     public:
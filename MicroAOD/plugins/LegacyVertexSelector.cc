@@ -5,11 +5,15 @@
 #include "DataFormats/VertexReco/interface/Vertex.h"
 #include "DataFormats/EgammaCandidates/interface/Photon.h"
 #include "DataFormats/EgammaCandidates/interface/Conversion.h"
+#include "FWCore/Utilities/interface/Exception.h"
 #include "TVector3.h"
 #include "TVector2.h"
 #include "TMath.h"
 #include "TLorentzVector.h"
 #include "TMVA/Reader.h"
+#include "flashgg/MicroAOD/interface/TMVAForest.h"
+
+#include <algorithm>
 
 namespace flashgg {
 
@@ -44,6 +48,8 @@ namespace flashgg {
                                        ) override;
 
 
+        void beginEvent() override;
+
         void writeInfoFromLastSelectionTo( flashgg::DiPhotonCandidate & ) override;
         void writeInfoFromLastSelectionTo( flashgg::PhotonJetCandidate & ) override;
 
@@ -69,6 +75,9 @@ namespace flashgg {
         void Initialize();
 
     private:
+        // score the rows of mvaInputs_ into mvaScores_, and the pair with the current inputs
+        void evaluateVertexIdMva();
+        float evaluateVertexProbMva();
 
         edm::FileInPath vertexIdMVAweightfile_;
         edm::FileInPath vertexProbMVAweightfile_;
@@ -103,6 +112,11 @@ namespace flashgg {
         double singlelegsigma2Tec;
 
     protected:
+        // native evaluators of the BDTs, shared by all the selectors using the same weight files;
+        // the TMVA readers are only booked when useTMVAReader is set
+        bool useTMVAReader_;
+        std::shared_ptr<const TMVAForest> vertexIdForest_;
+        std::shared_ptr<const TMVAForest> vertexProbForest_;
         TMVA::Reader *VertexIdMva_;
         bool initialized_;
         float logsumpt2_;
@@ -125,6 +139,8 @@ namespace flashgg {
         float dZ2_;
         float vtxprobmva_;
 
+        // Scratch filled by select() and read back by writeInfoFromLastSelectionTo():
+        // the selector is owned by a stream module, so each stream has its own copy
         std::vector<float> vlogsumpt2_;
         std::vector<float> vptbal_;
         std::vector<float> vptasym_;
@@ -133,6 +149,37 @@ namespace flashgg {
         std::vector<float> vmva_value_;
         std::vector<unsigned int> vmva_sortedindex_;
         std::vector<edm::Ptr<reco::Vertex> >  vVtxPtr_;
+
+        // inputs of the vertex id BDT for all the vertices of the pair, one row
+        // (ptasym, ptbal, logsumpt2, limPullToConv, nConv) per vertex, scored in one go
+        static const unsigned int nVertexIdInputs = 5;
+        std::vector<float> mvaInputs_;
+        std::vector<unsigned int> mvaVertexIndex_;
+        std::vector<double> mvaScores_;
+
+        // Per-event summary of the tracks of each vertex, shared by all the pairs of the event.
+        // It is built at the first select() after beginEvent() (at each select() for callers
+        // not calling beginEvent()). Tracks failing the purity requirement are dropped and the
+        // tracks of each vertex are sorted in eta, so that the pairs only walk their footprints.
+        struct TrackSums {
+            double px, py, pt2;
+            unsigned int n;
+        };
+        struct Cone {
+            double eta, phi, dR;
+        };
+        void buildTrackSummary( const std::vector<edm::Ptr<reco::Vertex> > &, const VertexCandidateMap & );
+        bool inCone( size_t, const Cone & ) const;
+        // adds the tracks of vertex ivtx inside cone and outside the veto cones to sums
+        void addConeTracks( unsigned int ivtx, const Cone &cone, const Cone *veto1, const Cone *veto2, TrackSums &sums ) const;
+
+        bool keepTrackSummary_;
+        bool trackSummaryValid_;
+        const VertexCandidateMap *summaryMap_;
+        std::vector<unsigned int> vtxFirstTrack_;
+        std::vector<bool> vtxHasTracks_;
+        std::vector<TrackSums> vtxTrackSums_;
+        std::vector<double> tkEta_, tkPhi_, tkPx_, tkPy_, tkPt2_;
     };
 
     LegacyVertexSelector::LegacyVertexSelector( const edm::ParameterSet &iConfig ) :
@@ -170,11 +217,113 @@ namespace flashgg {
         singlelegsigma2Tid    = iConfig.getParameter<double>( "singlelegsigma2Tid" );
         singlelegsigma2Tec    = iConfig.getParameter<double>( "singlelegsigma2Tec" );
 
+        useTMVAReader_ = iConfig.getUntrackedParameter<bool>( "useTMVAReader", false );
+        VertexIdMva_ = 0;
+        VertexProbMva_ = 0;
+
         initialized_ = false;
+        keepTrackSummary_ = false;
+        trackSummaryValid_ = false;
+        summaryMap_ = 0;
+    }
+
+    void LegacyVertexSelector::beginEvent()
+    {
+        keepTrackSummary_ = true;
+        trackSummaryValid_ = false;
+    }
+
+    void LegacyVertexSelector::buildTrackSummary( const std::vector<edm::Ptr<reco::Vertex> > &vtxs, const VertexCandidateMap &vertexCandidateMap )
+    {
+        struct Track {
+            double eta, phi, px, py, pt2;
+        };
+        std::vector<Track> tracks;
+
+        vtxFirstTrack_.assign( 1, 0 );
+        vtxHasTracks_.clear();
+        vtxTrackSums_.clear();
+        tkEta_.clear();
+        tkPhi_.clear();
+        tkPx_.clear();
+        tkPy_.clear();
+        tkPt2_.clear();
+        for( unsigned int vertex_index = 0 ; vertex_index < vtxs.size() ; vertex_index++ ) {
+            auto mapRange = std::equal_range( vertexCandidateMap.begin(), vertexCandidateMap.end(), vtxs[vertex_index], flashgg::compare_with_vtx() );
+            TrackSums sums = { 0., 0., 0., 0 };
+            tracks.clear();
+            for( auto pair_iter = mapRange.first ; pair_iter != mapRange.second ; pair_iter++ ) {
+                const edm::Ptr<pat::PackedCandidate> cand = pair_iter->second;
+                bool isPure = cand->trackHighPurity();
+                if( !isPure && trackHighPurity ) { continue; }
+                TVector3 tk( cand->px(), cand->py(), cand->pz() );
+                TVector2 tkXY = tk.XYvector();
+                tracks.push_back( { tk.Eta(), tk.Phi(), tkXY.X(), tkXY.Y(), tkXY.Mod2() } );
+                sums.px += tkXY.X();
+                sums.py += tkXY.Y();
+                sums.pt2 += tkXY.Mod2();
+                sums.n++;
+            }
+            std::stable_sort( tracks.begin(), tracks.end(), []( const Track & a, const Track & b ) { return a.eta < b.eta; } );
+            for( auto &track : tracks ) {
+                tkEta_.push_back( track.eta );
+                tkPhi_.push_back( track.phi );
+                tkPx_.push_back( track.px );
+                tkPy_.push_back( track.py );
+                tkPt2_.push_back( track.pt2 );
+            }
+            vtxFirstTrack_.push_back( tkEta_.size() );
+            vtxHasTracks_.push_back( mapRange.first != mapRange.second );
+            vtxTrackSums_.push_back( sums );
+        }
+        summaryMap_ = &vertexCandidateMap;
+        trackSummaryValid_ = true;
+    }
+
+    bool LegacyVertexSelector::inCone( size_t itk, const Cone &cone ) const
+    {
+        // same as TVector3::DeltaR, so that the tracks in the footprint are the same
+        double deta = tkEta_[itk] - cone.eta;
+        double dphi = TVector2::Phi_mpi_pi( tkPhi_[itk] - cone.phi );
+        return TMath::Sqrt( deta * deta + dphi * dphi ) < cone.dR;
+    }
+
+    void LegacyVertexSelector::addConeTracks( unsigned int ivtx, const Cone &cone, const Cone *veto1, const Cone *veto2, TrackSums &sums ) const
+    {
+        // the margin keeps tracks at the edge of the cone in the eta window despite rounding
+        const double margin = 1e-6;
+        auto first = tkEta_.begin() + vtxFirstTrack_[ivtx];
+        auto last = tkEta_.begin() + vtxFirstTrack_[ivtx + 1];
+        size_t begin = std::lower_bound( first, last, cone.eta - cone.dR - margin ) - tkEta_.begin();
+        size_t end = std::upper_bound( first, last, cone.eta + cone.dR + margin ) - tkEta_.begin();
+        for( size_t itk = begin ; itk < end ; itk++ ) {
+            if( !inCone( itk, cone ) ) { continue; }
+            if( veto1 && inCone( itk, *veto1 ) ) { continue; }
+            if( veto2 && inCone( itk, *veto2 ) ) { continue; }
+            sums.px += tkPx_[itk];
+            sums.py += tkPy_[itk];
+            sums.pt2 += tkPt2_[itk];
+            sums.n++;
+        }
     }
 
     void LegacyVertexSelector::Initialize()
     {
+        if( !useTMVAReader_ ) {
+            vertexIdForest_ = TMVAForest::get( vertexIdMVAweightfile_.fullPath() );
+            vertexProbForest_ = TMVAForest::get( vertexProbMVAweightfile_.fullPath() );
+            const std::vector<std::string> vertexIdVariables = { "ptasym", "ptbal", "logsumpt2", "limPullToConv", "nConv" };
+            const std::vector<std::string> vertexProbVariables = { "pt", "NVert", "MVA0", "MVA1", "DZ1", "MVA2", "DZ2", "NConv" };
+            if( vertexIdForest_->variables() != vertexIdVariables ) {
+                throw cms::Exception( "Configuration" ) << "LegacyVertexSelector: unexpected input variables in " << vertexIdMVAweightfile_.fullPath();
+            }
+            if( vertexProbForest_->variables() != vertexProbVariables ) {
+                throw cms::Exception( "Configuration" ) << "LegacyVertexSelector: unexpected input variables in " << vertexProbMVAweightfile_.fullPath();
+            }
+            initialized_ = true;
+            return;
+        }
+
         VertexIdMva_ = new TMVA::Reader( "!Color:Silent" );
         VertexIdMva_->AddVariable( "ptasym", &ptasym_ );
         VertexIdMva_->AddVariable( "ptbal", &ptbal_ );
@@ -206,6 +355,34 @@ namespace flashgg {
         delete VertexProbMva_;
     }
 
+    void LegacyVertexSelector::evaluateVertexIdMva()
+    {
+        size_t nrows = mvaVertexIndex_.size();
+        mvaScores_.resize( nrows );
+        if( vertexIdForest_ ) {
+            if( nrows > 0 ) { vertexIdForest_->evaluate( &mvaInputs_[0], nrows, &mvaScores_[0] ); }
+            return;
+        }
+        for( size_t irow = 0 ; irow < nrows ; irow++ ) {
+            const float *row = &mvaInputs_[irow * nVertexIdInputs];
+            ptasym_ = row[0];
+            ptbal_ = row[1];
+            logsumpt2_ = row[2];
+            pull_conv_ = row[3];
+            nConv_ = row[4];
+            mvaScores_[irow] = VertexIdMva_->EvaluateMVA( "BDT" );
+        }
+    }
+
+    float LegacyVertexSelector::evaluateVertexProbMva()
+    {
+        if( vertexProbForest_ ) {
+            const float row[] = { dipho_pt_, nVert_, MVA0_, MVA1_, dZ1_, MVA2_, dZ2_, nConv_ };
+            return vertexProbForest_->evaluate( row );
+        }
+        return VertexProbMva_->EvaluateMVA( "BDT" );
+    }
+
     double LegacyVertexSelector::vtxZFromConvOnly( const edm::Ptr<flashgg::Photon> &pho, const edm::Ptr<reco:: Conversion> &conversion,
             const math::XYZPoint &beamSpot ) const
     {
@@ -598,6 +775,8 @@ namespace flashgg {
         vmva_value_.clear();
         vVtxPtr_.clear();
         vmva_sortedindex_.clear();
+        mvaInputs_.clear();
+        mvaVertexIndex_.clear();
 
         std::vector<std::pair<unsigned int, float> > sorter;
 
@@ -635,6 +814,9 @@ namespace flashgg {
         if( !initialized_ ) {
             Initialize();
         }
+        if( !keepTrackSummary_ || !trackSummaryValid_ || summaryMap_ != &vertexCandidateMap || vtxTrackSums_.size() != vtxs.size() ) {
+            buildTrackSummary( vtxs, vertexCandidateMap );
+        }
 
         std::vector<float> vlogsumpt2;
         std::vector<float> vptbal;
@@ -671,29 +853,21 @@ namespace flashgg {
             sumpt.Set( 0., 0. );
 
 
-            auto mapRange = std::equal_range( vertexCandidateMap.begin(), vertexCandidateMap.end(), vtx, flashgg::compare_with_vtx() );
-            if( mapRange.first == mapRange.second ) { continue; }
-            for( auto pair_iter = mapRange.first ; pair_iter != mapRange.second ; pair_iter++ ) {
-                const edm::Ptr<pat::PackedCandidate> cand = pair_iter->second;
-                TVector3 tk;
-                TVector2 tkXY;
-                double dr1 = 0;
-                double dr2 = 0;
-                tk.SetXYZ( cand->px(), cand->py(), cand->pz() );
-                tkXY = tk.XYvector();
-                dr1 = tk.DeltaR( p14.Vect() );
-                dr2 = tk.DeltaR( p24.Vect() );
-                bool isPure = cand->trackHighPurity();
-                if( !isPure && trackHighPurity ) { continue; }
+            if( !vtxHasTracks_[vertex_index] ) { continue; }
 
-                if( dr1 < dRexclude || dr2 < dRexclude ) {
-                    sumpt2_in += tkXY.Mod2();
-                    continue;
-                }
-                sumpt += tkXY;
-                sumpt2_out += tkXY.Mod2();
-                ptbal -= tkXY * ( p14 + p24 ).Vect().XYvector().Unit();
+            // all the tracks of the vertex, minus the ones in the photon footprints
+            const TrackSums &all = vtxTrackSums_[vertex_index];
+            TrackSums in = { 0., 0., 0., 0 };
+            Cone cone1 = { p14.Vect().Eta(), p14.Vect().Phi(), dRexclude };
+            Cone cone2 = { p24.Vect().Eta(), p24.Vect().Phi(), dRexclude };
+            addConeTracks( vertex_index, cone1, 0, 0, in );
+            addConeTracks( vertex_index, cone2, &cone1, 0, in );
+            if( in.n < all.n ) {
+                sumpt.Set( all.px - in.px, all.py - in.py );
+                sumpt2_out = all.pt2 - in.pt2;
+                ptbal = -( sumpt * ( p14 + p24 ).Vect().XYvector().Unit() );
             }
+            sumpt2_in = in.pt2;
 
             ptasym = ( sumpt.Mod() - ( p14 + p24 ).Vect().XYvector().Mod() ) / ( sumpt.Mod() + ( p14 + p24 ).Vect().XYvector().Mod() );
             ptasym_ = ptasym;
@@ -725,15 +899,25 @@ namespace flashgg {
             ptbal_ = ptbal;
             pull_conv_ = pull_conv;
             nConv_ = nConv;
-            float mva_value = VertexIdMva_->EvaluateMVA( "BDT" );
 
-            vlogsumpt2.push_back( logsumpt2_ );
-            vptbal.push_back( ptbal_ );
-            vptasym.push_back( ptasym_ );
-            vpull_conv.push_back( pull_conv_ );
-            vnConv.push_back( nConv_ );
+            const float inputs[nVertexIdInputs] = { ptasym_, ptbal_, logsumpt2_, pull_conv_, nConv_ };
+            mvaInputs_.insert( mvaInputs_.end(), inputs, inputs + nVertexIdInputs );
+            mvaVertexIndex_.push_back( vertex_index );
+        }
+
+        evaluateVertexIdMva();
+        for( unsigned int irow = 0 ; irow < mvaVertexIndex_.size() ; irow++ ) {
+            const float *inputs = &mvaInputs_[irow * nVertexIdInputs];
+            vertex_index = mvaVertexIndex_[irow];
+            float mva_value = mvaScores_[irow];
+
+            vlogsumpt2.push_back( inputs[2] );
+            vptbal.push_back( inputs[1] );
+            vptasym.push_back( inputs[0] );
+            vpull_conv.push_back( inputs[3] );
+            vnConv.push_back( inputs[4] );
             vmva_value.push_back( mva_value );
-            vVtxPtr.push_back( vtx );
+            vVtxPtr.push_back( vtxs[vertex_index] );
 
             std::pair<unsigned int, float>pairToSort = std::make_pair( vmva_value.size() - 1, mva_value );
             sorter.push_back( pairToSort );
@@ -741,9 +925,9 @@ namespace flashgg {
             if( mva_value > max_mva_value ) {
                 max_mva_value = mva_value;
                 selected_vertex_index = vertex_index;
-                logsumpt2selected_ = logsumpt2_;
-                ptbalselected_ = ptbal_;
-                ptasymselected_ = ptasym_;
+                logsumpt2selected_ = inputs[2];
+                ptbalselected_ = inputs[1];
+                ptasymselected_ = inputs[0];
             }
         }
 
@@ -790,7 +974,7 @@ namespace flashgg {
         if( sorter.size() < 3 ) dZ2_=100;
         
 
-        vtxprobmva_ = VertexProbMva_->EvaluateMVA( "BDT" );
+        vtxprobmva_ = evaluateVertexProbMva();
 
         return vtxs[selected_vertex_index];
     }
@@ -814,6 +998,8 @@ namespace flashgg {
         vmva_value_.clear();
         vVtxPtr_.clear();
         vmva_sortedindex_.clear();
+        mvaInputs_.clear();
+        mvaVertexIndex_.clear();
 
         std::vector<std::pair<unsigned int, float> > sorter;
 
@@ -846,6 +1032,9 @@ namespace flashgg {
         if( !initialized_ ) {
             Initialize();
         }
+        if( !keepTrackSummary_ || !trackSummaryValid_ || summaryMap_ != &vertexCandidateMap || vtxTrackSums_.size() != vtxs.size() ) {
+            buildTrackSummary( vtxs, vertexCandidateMap );
+        }
 
         std::vector<float> vlogsumpt2;
         std::vector<float> vptbal;
@@ -877,35 +1066,25 @@ namespace flashgg {
 
             sumpt.Set( 0., 0. );
 
-            auto mapRange = std::equal_range( vertexCandidateMap.begin(), vertexCandidateMap.end(), vtx, flashgg::compare_with_vtx() );
-            if( mapRange.first == mapRange.second ) { continue; }
-
-            for( auto pair_iter = mapRange.first ; pair_iter != mapRange.second ; pair_iter++ ) {
-                const edm::Ptr<pat::PackedCandidate> cand = pair_iter->second;
-                
-                TVector3 tk;
-                TVector2 tkXY;
-                double dr1 = 0;
-                double dr2 = 0;
-                tk.SetXYZ( cand->px(), cand->py(), cand->pz() );
-                tkXY = tk.XYvector();
-                dr1 = tk.DeltaR( p14.Vect() );
-                dr2 = tk.DeltaR( p24.Vect() );
-
-                // gamma+jet: skip tracks around the jet direction
-                if ( dr2 < 0.4 ) { continue; }
-
-                bool isPure = cand->trackHighPurity();
-                if( !isPure && trackHighPurity ) { continue; }
-
-                if( dr1 < dRexclude || dr2 < dRexclude ) {
-                    sumpt2_in += tkXY.Mod2();
-                    continue;
-                }
-                sumpt += tkXY;
-                sumpt2_out += tkXY.Mod2();
-                ptbal -= tkXY * ( p14 + p24 ).Vect().XYvector().Unit();
+            if( !vtxHasTracks_[vertex_index] ) { continue; }
+
+            // all the tracks of the vertex, minus the ones in the photon and jet footprints
+            const TrackSums &all = vtxTrackSums_[vertex_index];
+            TrackSums in = { 0., 0., 0., 0 };
+            TrackSums jet = { 0., 0., 0., 0 };
+            Cone cone1 = { p14.Vect().Eta(), p14.Vect().Phi(), dRexclude };
+            Cone cone2 = { p24.Vect().Eta(), p24.Vect().Phi(), dRexclude };
+            // gamma+jet: skip tracks around the jet direction
+            Cone jetCone = { p24.Vect().Eta(), p24.Vect().Phi(), 0.4 };
+            addConeTracks( vertex_index, jetCone, 0, 0, jet );
+            addConeTracks( vertex_index, cone1, &jetCone, 0, in );
+            addConeTracks( vertex_index, cone2, &jetCone, &cone1, in );
+            if( in.n + jet.n < all.n ) {
+                sumpt.Set( all.px - jet.px - in.px, all.py - jet.py - in.py );
+                sumpt2_out = all.pt2 - jet.pt2 - in.pt2;
+                ptbal = -( sumpt * ( p14 + p24 ).Vect().XYvector().Unit() );
             }
+            sumpt2_in = in.pt2;
 
             ptasym = ( sumpt.Mod() - ( p14 + p24 ).Vect().XYvector().Mod() ) / ( sumpt.Mod() + ( p14 + p24 ).Vect().XYvector().Mod() );
             ptasym_ = ptasym;
@@ -940,15 +1119,25 @@ namespace flashgg {
             ptbal_ = ptbal;
             pull_conv_ = pull_conv;
             nConv_ = nConv;
-            float mva_value = VertexIdMva_->EvaluateMVA( "BDT" );
 
-            vlogsumpt2.push_back( logsumpt2_ );
-            vptbal.push_back( ptbal_ );
-            vptasym.push_back( ptasym_ );
-            vpull_conv.push_back( pull_conv_ );
-            vnConv.push_back( nConv_ );
+            const float inputs[nVertexIdInputs] = { ptasym_, ptbal_, logsumpt2_, pull_conv_, nConv_ };
+            mvaInputs_.insert( mvaInputs_.end(), inputs, inputs + nVertexIdInputs );
+            mvaVertexIndex_.push_back( vertex_index );
+        }
+
+        evaluateVertexIdMva();
+        for( unsigned int irow = 0 ; irow < mvaVertexIndex_.size() ; irow++ ) {
+            const float *inputs = &mvaInputs_[irow * nVertexIdInputs];
+            vertex_index = mvaVertexIndex_[irow];
+            float mva_value = mvaScores_[irow];
+
+            vlogsumpt2.push_back( inputs[2] );
+            vptbal.push_back( inputs[1] );
+            vptasym.push_back( inputs[0] );
+            vpull_conv.push_back( inputs[3] );
+            vnConv.push_back( inputs[4] );
             vmva_value.push_back( mva_value );
-            vVtxPtr.push_back( vtx );
+            vVtxPtr.push_back( vtxs[vertex_index] );
 
             std::pair<unsigned int, float>pairToSort = std::make_pair( vmva_value.size() - 1, mva_value );
             sorter.push_back( pairToSort );
@@ -956,9 +1145,9 @@ namespace flashgg {
             if( mva_value > max_mva_value ) {
                 max_mva_value = mva_value;
                 selected_vertex_index = vertex_index;
-                logsumpt2selected_ = logsumpt2_;
-                ptbalselected_ = ptbal_;
-                ptasymselected_ = ptasym_;
+                logsumpt2selected_ = inputs[2];
+                ptbalselected_ = inputs[1];
+                ptasymselected_ = inputs[0];
             }
         }
 
@@ -996,7 +1185,7 @@ namespace flashgg {
         MVA2_     = third_max_mva_value;
         dZ2_      = vtxs[selected_vertex_index]->position().z() - vtxs[third_selected_vertex_index]->position().z();
 
-        vtxprobmva_ = VertexProbMva_->EvaluateMVA( "BDT" );
+        vtxprobmva_ = evaluateVertexProbMva();
 
         return vtxs[selected_vertex_index];
 
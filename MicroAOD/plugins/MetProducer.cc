@@ -4,7 +4,7 @@
 #include "flashgg/DataFormats/interface/Met.h"
 //#include "DataFormats/PatCandidates/interface/MET.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
 #include "DataFormats/Common/interface/Handle.h"
 #include "FWCore/Framework/interface/Event.h"
@@ -17,7 +17,7 @@
 
 namespace flashgg {
 
-    class MetProducer : public edm::EDProducer
+    class MetProducer : public edm::stream::EDProducer<>
     {
     public:
         MetProducer( const edm::ParameterSet & );
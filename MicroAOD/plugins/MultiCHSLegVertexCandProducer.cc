@@ -4,7 +4,7 @@
  *
  */
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -22,7 +22,7 @@ using namespace edm;
 using namespace std;
 
 namespace flashgg {
-    class MultiCHSLegacyVertexCandProducer : public EDProducer
+    class MultiCHSLegacyVertexCandProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -63,21 +63,6 @@ namespace flashgg {
         evt.getByToken( vertexToken_, primaryVertices );
         //const PtrVector<reco::Vertex>& pvPtrs = primaryVertices->ptrVector();
 
-        // packed cands
-        Handle<View<pat::PackedCandidate> > pfCandidates;
-        evt.getByToken( pfcandidateToken_, pfCandidates );
-        // const PtrVector<pat::PackedCandidate>& pfPtrs = pfCandidates->ptrVector();
-
-        Handle<VertexCandidateMap> vtxmap;
-        // Handle<View<reco::Vertex> > primaryVertices;
-        // Handle<reco::VertexCollection> primaryVertices;
-        evt.getByToken( vertexCandidateMapToken_, vtxmap );
-
-        // Non-const copy so we can sort by candidates (which may be associated to more than one vertex)
-        VertexCandidateMap vtxmapbycand( *vtxmap );
-        std::stable_sort( vtxmapbycand.begin(), vtxmapbycand.end(), flashgg::compare_by_cand() );
-
-
         edm::Ptr<reco::Vertex> choosenVertex;
 
 
@@ -107,8 +92,24 @@ namespace flashgg {
             }
         }
 
+        // Most of the vertex indices are not used by any diphoton of the event: their collection
+        // stays empty, and the candidates and the vertex map are only read for the used ones
         std::unique_ptr<vector<pat::PackedCandidate> > result( new vector<pat::PackedCandidate>() );
         if( keep_event ) {
+            // packed cands
+            Handle<View<pat::PackedCandidate> > pfCandidates;
+            evt.getByToken( pfcandidateToken_, pfCandidates );
+            // const PtrVector<pat::PackedCandidate>& pfPtrs = pfCandidates->ptrVector();
+
+            // the map is sorted by vertex: take the candidates of the chosen vertex, sorted
+            Handle<VertexCandidateMap> vtxmap;
+            evt.getByToken( vertexCandidateMapToken_, vtxmap );
+            auto mapRange = std::equal_range( vtxmap->begin(), vtxmap->end(), choosenVertex, flashgg::compare_with_vtx() );
+            std::vector<edm::Ptr<pat::PackedCandidate> > vertexCands;
+            vertexCands.reserve( mapRange.second - mapRange.first );
+            for( auto pair_iter = mapRange.first ; pair_iter != mapRange.second ; pair_iter++ ) { vertexCands.push_back( pair_iter->second ); }
+            std::sort( vertexCands.begin(), vertexCands.end() );
+
             for( unsigned int pfCandLoop = 0 ; pfCandLoop < pfCandidates->size() ; pfCandLoop++ ) {
                 edm::Ptr<pat::PackedCandidate> cand = pfCandidates->ptrAt( pfCandLoop );
                 if( cand->charge() == 0 ) { //keep all neutral objects.
@@ -117,11 +118,8 @@ namespace flashgg {
                     continue;
                 }
                 // Keep charged candidate if it's associated to the appropriate vertex
-                auto mapRange = std::equal_range( vtxmapbycand.begin(), vtxmapbycand.end(), cand, flashgg::compare_with_cand() );
-                for( auto pair_iter = mapRange.first ; pair_iter != mapRange.second ; pair_iter++ ) {
-                    edm::Ptr<reco::Vertex> currentVertex = pair_iter->first;
-                    if( choosenVertex == currentVertex ) { result->push_back( *cand ); }
-                }
+                auto candRange = std::equal_range( vertexCands.begin(), vertexCands.end(), cand );
+                for( auto cand_iter = candRange.first ; cand_iter != candRange.second ; cand_iter++ ) { result->push_back( *cand ); }
             }
         }
         if( debug_ ) std::cout << setw( 13 ) << "event nb=" << eventNb
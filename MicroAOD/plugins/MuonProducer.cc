@@ -2,7 +2,7 @@
 #include <memory>
 // user include files
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
 #include "DataFormats/Common/interface/Handle.h"
 #include "FWCore/Framework/interface/Event.h"
@@ -16,7 +16,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class MuonProducer : public edm::EDProducer
+    class MuonProducer : public edm::stream::EDProducer<>
     {
     public:
         MuonProducer( const edm::ParameterSet & );
@@ -5,7 +5,7 @@
 #include <iterator>
 #include <cctype>
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
 #include "DataFormats/Common/interface/Handle.h"
 #include "FWCore/Framework/interface/Event.h"
@@ -32,7 +32,7 @@ using namespace edm;
 
 namespace flashgg {
     
-    class PDFWeightProducer : public edm::EDProducer
+    class PDFWeightProducer : public edm::stream::EDProducer<>
     {
     public:
         PDFWeightProducer( const edm::ParameterSet & );
@@ -1,7 +1,7 @@
 #ifndef flashgg_PerPhotonMVADiPhotonComputer_h
 #define flashgg_PerPhotonMVADiPhotonComputer_h
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -22,7 +22,7 @@ using namespace std;
 using namespace edm;
 
 namespace flashgg {
-    class PerPhotonMVADiPhotonProducer : public EDProducer
+    class PerPhotonMVADiPhotonProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -28,7 +28,7 @@ using namespace std;
 
 namespace flashgg {
 
-    class PhotonJetProducer : public EDProducer
+    class PhotonJetProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -141,6 +141,7 @@ namespace flashgg {
         double rho_    = *rho;
 
         unique_ptr<vector<PhotonJetCandidate> > PhotonJetColl( new vector<PhotonJetCandidate> );
+        vertexSelector_->beginEvent();
 
         // --- Photon selection (min pt, photon id)
         for ( unsigned int i = 0 ; i < photons->size() ; i++ ){
@@ -1,6 +1,6 @@
 #include "Geometry/CaloTopology/interface/CaloTopology.h"
 #include "Geometry/CaloEventSetup/interface/CaloTopologyRecord.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -39,7 +39,7 @@ namespace flashgg {
         std::vector<double> vetos_;
     };
 
-    class PhotonProducer : public EDProducer
+    class PhotonProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -89,6 +89,8 @@ namespace flashgg {
         double _phoIsoCutoff;
 
         std::string egmMvaValuesInfo_;
+
+        std::vector<float> chargedIsoConeSizes_;
     };
 
 
@@ -108,7 +110,8 @@ namespace flashgg {
         _effectiveAreas((iConfig.getParameter<edm::FileInPath>("effAreasConfigFile")).fullPath()),
         _phoIsoPtScalingCoeff(iConfig.getParameter<std::vector<double >>("phoIsoPtScalingCoeff")),
         _phoIsoCutoff(iConfig.getParameter<double>("phoIsoCutoff")),
-        egmMvaValuesInfo_( iConfig.getParameter<string>("egmMvaValuesInfo"))
+        egmMvaValuesInfo_( iConfig.getParameter<string>("egmMvaValuesInfo")),
+        chargedIsoConeSizes_( { 0.4, 0.3, 0.2 } )
     {
         is2017_ = iConfig.getParameter<bool>( "is2017" );
         
@@ -182,9 +185,12 @@ namespace flashgg {
         // const PtrVector<pat::Photon>& photonPointers = photons->ptrVector();
         // const PtrVector<pat::PackedCandidate>& pfcandidatePointers = pfcandidates->ptrVector();
         // const PtrVector<reco::Vertex>& vertexPointers = vertices->ptrVector();
-        const flashgg::VertexCandidateMap vtxToCandMap = *( vertexCandidateMap.product() );
+        const flashgg::VertexCandidateMap &vtxToCandMap = *( vertexCandidateMap.product() );
+        const std::vector<edm::Ptr<reco::Vertex> > &vertexPtrs = vertices->ptrs();
         const double rhoFixedGrd = *( rhoHandle.product() );
         const reco::Vertex *neutVtx = ( useVtx0ForNeutralIso_ ? &vertices->at( 0 ) : 0 );
+        // eta-phi index of the PF candidates, shared by the neutral and photon isolations of all the photons
+        PFCandidateEtaPhiIndex pfIndex( pfcandidates->ptrs() );
 
         unique_ptr<vector<flashgg::Photon> > photonColl( new vector<flashgg::Photon> );
 
@@ -256,8 +262,12 @@ namespace flashgg {
             //                                                                                                                       inner (veto) cone size barrel
             //                                                                                                                             inner (veto) cone size endcap
             //                                                                                                                                   min track pt
-            std::map<edm::Ptr<reco::Vertex>, float> isomap04 = phoTools_.pfIsoChgWrtAllVtx( pp, vertices->ptrs(), vtxToCandMap, 0.4, 0.02, 0.02, 0.1 );
-            std::map<edm::Ptr<reco::Vertex>, float> isomap03 = phoTools_.pfIsoChgWrtAllVtx( pp, vertices->ptrs(), vtxToCandMap, 0.3, 0.02, 0.02, 0.1 );
+            // The 0.4, 0.3 and 0.2 cones (the latter is needed for the photon preselection) are filled in a single pass
+            std::vector<std::map<edm::Ptr<reco::Vertex>, float> > isomaps = phoTools_.pfIsoChgWrtAllVtx( pp, vertexPtrs, vtxToCandMap, chargedIsoConeSizes_,
+                                                                                                        0.02, 0.02, 0.1 );
+            std::map<edm::Ptr<reco::Vertex>, float> &isomap04 = isomaps[0];
+            std::map<edm::Ptr<reco::Vertex>, float> &isomap03 = isomaps[1];
+            std::map<edm::Ptr<reco::Vertex>, float> &isomap02 = isomaps[2];
             fg.setpfChgIso04( isomap04 );
             fg.setpfChgIso03( isomap03 );
             std::map<edm::Ptr<reco::Vertex>, float> &ref_isomap04 = isomap04;
@@ -267,24 +277,22 @@ namespace flashgg {
             fg.setpfChgIsoWrtWorstVtx04( pfChgIsoWrtWorstVtx04 );
             fg.setpfChgIsoWrtWorstVtx03( pfChgIsoWrtWorstVtx03 );
 
-            // This map is needed for the photon preselection
-            std::map<edm::Ptr<reco::Vertex>, float> isomap02 = phoTools_.pfIsoChgWrtAllVtx( pp, vertices->ptrs(), vtxToCandMap, 0.2, 0.02, 0.02, 0.1 );
             fg.setpfChgIso02( isomap02 );
             fg.setpfChgIsoWrtChosenVtx02( 0. ); // just to initalize things properly, will be setup for real in the diphoton producer once the vertex is chosen
 
-            float pfPhoIso04 = phoTools_.pfCaloIso( pp, pfcandidates->ptrs(), 0.4, 0.0, 0.070, 0.015, 0.0, 0.0, 0.0, PFCandidate::gamma, neutVtx );
-            float pfPhoIso03 = phoTools_.pfCaloIso( pp, pfcandidates->ptrs(), 0.3, 0.0, 0.070, 0.015, 0.0, 0.0, 0.0, PFCandidate::gamma, neutVtx );
+            float pfPhoIso04 = phoTools_.pfCaloIso( pp, pfIndex, 0.4, 0.0, 0.070, 0.015, 0.0, 0.0, 0.0, PFCandidate::gamma, neutVtx );
+            float pfPhoIso03 = phoTools_.pfCaloIso( pp, pfIndex, 0.3, 0.0, 0.070, 0.015, 0.0, 0.0, 0.0, PFCandidate::gamma, neutVtx );
             fg.setpfPhoIso04( pfPhoIso04 );
             fg.setpfPhoIso03( pfPhoIso03 );
 
-            float pfNeutIso04 = phoTools_.pfCaloIso( pp, pfcandidates->ptrs(), 0.4, 0.0, 0.000, 0.000, 0.0, 0.0, 0.0, PFCandidate::h0, neutVtx );
-            float pfNeutIso03 = phoTools_.pfCaloIso( pp, pfcandidates->ptrs(), 0.3, 0.0, 0.000, 0.000, 0.0, 0.0, 0.0, PFCandidate::h0, neutVtx );
+            float pfNeutIso04 = phoTools_.pfCaloIso( pp, pfIndex, 0.4, 0.0, 0.000, 0.000, 0.0, 0.0, 0.0, PFCandidate::h0, neutVtx );
+            float pfNeutIso03 = phoTools_.pfCaloIso( pp, pfIndex, 0.3, 0.0, 0.000, 0.000, 0.0, 0.0, 0.0, PFCandidate::h0, neutVtx );
             fg.setpfNeutIso04( pfNeutIso04 );
             fg.setpfNeutIso03( pfNeutIso03 );
 
             double eA_pho = _effectiveAreas.getEffectiveArea( abs(pp->superCluster()->eta()) );
 
-            std::map<edm::Ptr<reco::Vertex>, float> mvamap = phoTools_.computeMVAWrtAllVtx( fg, vertices->ptrs(), rhoFixedGrd, eA_pho, _phoIsoPtScalingCoeff, _phoIsoCutoff );
+            std::map<edm::Ptr<reco::Vertex>, float> mvamap = phoTools_.computeMVAWrtAllVtx( fg, vertexPtrs, rhoFixedGrd, eA_pho, _phoIsoPtScalingCoeff, _phoIsoCutoff );
             fg.setPhoIdMvaD( mvamap );
 
             // add extra isolations (useful for tuning)
@@ -292,7 +300,7 @@ namespace flashgg {
                 for( size_t iso = 0; iso < extraCaloIsolations_.size(); ++iso ) {
                     CaloIsoParams &p = extraCaloIsolations_[iso];
                     phoTools_.removeOverlappingCandidates( p.overlapRemoval_ );
-                    float val = phoTools_.pfCaloIso( pp, pfcandidates->ptrs(),
+                    float val = phoTools_.pfCaloIso( pp, pfIndex,
                                                      p.vetos_[0], p.vetos_[1], p.vetos_[2], p.vetos_[3], p.vetos_[4], p.vetos_[5], p.vetos_[6],
                                                      p.type_, neutVtx );
                     /// cout << "User Isolation " << iso << " " << val << endl;
@@ -302,20 +310,15 @@ namespace flashgg {
 
             if( ! extraIsoAlgos_.empty() ) {
                 for( auto &algo : extraIsoAlgos_ ) {
-                    std::map<edm::Ptr<reco::Vertex>, float> iso;
                     algo->begin( *pp, evt, iSetup );
                     if( algo->hasChargedIsolation() ) {
-                        auto vpts = vertices->ptrs();
-                        for( auto &vtx : vpts ) {
-                            iso[vtx] = algo->chargedIsolation( pp, vtx, vtxToCandMap );
-                        }
-                        fg.setExtraChIso( algo->name(), iso );
+                        fg.setExtraChIso( algo->name(), algo->chargedIsolationWrtAllVtx( pp, vertexPtrs, vtxToCandMap ) );
                     }
                     if( algo->hasCaloIsolation( PFCandidate::gamma ) ) {
-                        fg.setExtraPhoIso( algo->name(), algo->caloIsolation( pp, pfcandidates->ptrs(), PFCandidate::gamma, neutVtx ) );
+                        fg.setExtraPhoIso( algo->name(), algo->caloIsolationFromIndex( pp, pfIndex, PFCandidate::gamma, neutVtx ) );
                     }
                     if( algo->hasCaloIsolation( PFCandidate::h0 ) ) {
-                        fg.setExtraNeutIso( algo->name(), algo->caloIsolation( pp, pfcandidates->ptrs(), PFCandidate::h0, neutVtx ) );
+                        fg.setExtraNeutIso( algo->name(), algo->caloIsolationFromIndex( pp, pfIndex, PFCandidate::h0, neutVtx ) );
                     }
                     algo->end( fg );
                 }
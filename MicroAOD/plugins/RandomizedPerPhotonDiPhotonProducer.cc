@@ -9,7 +9,7 @@
  */
 
 #include "DataFormats/Common/interface/Handle.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -24,7 +24,7 @@
 
 namespace flashgg {
 
-    class RandomizedPerPhotonDiPhotonProducer : public edm::EDProducer
+    class RandomizedPerPhotonDiPhotonProducer : public edm::stream::EDProducer<>
     {
     public:
         RandomizedPerPhotonDiPhotonProducer( const edm::ParameterSet & );
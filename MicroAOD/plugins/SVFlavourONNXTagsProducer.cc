@@ -23,6 +23,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <map>
 #include <numeric>
 #include <nlohmann/json.hpp>
 
@@ -56,7 +57,15 @@ private:
                                      float replace_inf_value = 0,
                                      float min = 0,
                                      float max = -1);
-  void make_inputs(const reco::DeepBoostedJetTagInfo &taginfo);
+  // padded length of each input group for one SV
+  std::vector<unsigned> input_lengths(const reco::DeepBoostedJetTagInfo &taginfo) const;
+  // appends the inputs of one SV to data_, each group padded to the given length
+  void append_inputs(const reco::DeepBoostedJetTagInfo &taginfo, const std::vector<unsigned> &lengths);
+  // runs the model once on the SVs in sv_indices and stores their scores in outputs
+  void run_batch(const TagInfoCollection &tag_infos,
+                 const std::vector<unsigned> &sv_indices,
+                 const std::vector<unsigned> &lengths,
+                 std::vector<std::vector<float>> &outputs);
 
   const edm::EDGetTokenT<TagInfoCollection> src_;
   const edm::EDGetTokenT<JetCollection> jets_;
@@ -69,6 +78,8 @@ private:
 
   FloatArrays data_;
 
+  // pad all the SVs of the event to the same length and run once, instead of once per distinct length
+  bool pad_batch_ = false;
   bool debug_ = false;
 };
 
@@ -77,6 +88,7 @@ SVFlavourONNXTagsProducer::SVFlavourONNXTagsProducer(const edm::ParameterSet &iC
       jets_(consumes<JetCollection>(iConfig.getParameter<edm::InputTag>("phantom_jets"))),
       svs_(consumes<SVCollection>(iConfig.getParameter<edm::InputTag>("secondary_vertices"))),
       flav_names_(iConfig.getParameter<std::vector<std::string>>("flav_names")),
+      pad_batch_(iConfig.getUntrackedParameter<bool>("padBatch", false)),
       debug_(iConfig.getUntrackedParameter<bool>("debugMode", false)) {
   // load preprocessing info
   auto json_path = iConfig.getParameter<std::string>("preprocess_json");
@@ -184,6 +196,7 @@ void SVFlavourONNXTagsProducer::fillDescriptions(edm::ConfigurationDescriptions
   desc.add<edm::FileInPath>("model_path",
                             edm::FileInPath("flashgg/MicroAOD/data/ParticleNetSV/V01/model.onnx"));
   desc.add<std::vector<std::string>>("flav_names", std::vector<std::string>{});
+  desc.addOptionalUntracked<bool>("padBatch", false);
   desc.addOptionalUntracked<bool>("debugMode", false);
 
   descriptions.addWithDefaultLabel(desc);
@@ -204,27 +217,37 @@ void SVFlavourONNXTagsProducer::produce(edm::Event &iEvent, const edm::EventSetu
   iEvent.getByToken(jets_, jets);
   iEvent.getByToken(svs_, svs);
 
-  auto outSVs = std::make_unique<std::vector<flashgg::SecondaryVertex>>();
+  // SVs with features, batched by padded input lengths: within a batch the inputs have
+  // exactly the shapes they would have if run one by one
+  std::vector<std::vector<float>> outputs(tag_infos->size(), std::vector<float>(flav_names_.size(), 0));
+  std::map<std::vector<unsigned>, std::vector<unsigned>> batches;
+  std::vector<unsigned> max_lengths;
   for (unsigned sv_n = 0; sv_n < tag_infos->size(); ++sv_n) {
     const auto &taginfo = (*tag_infos)[sv_n];
+    if (taginfo.features().empty()) {
+      continue;
+    }
+    auto lengths = input_lengths(taginfo);
+    if (pad_batch_) {
+      max_lengths.resize(lengths.size(), 0);
+      for (unsigned igroup = 0; igroup < lengths.size(); ++igroup) {
+        max_lengths[igroup] = std::max(max_lengths[igroup], lengths[igroup]);
+      }
+      lengths.clear();
+    }
+    batches[lengths].push_back(sv_n);
+  }
+  for (const auto &batch : batches) {
+    run_batch(*tag_infos, batch.second, pad_batch_ ? max_lengths : batch.first, outputs);
+  }
+
+  auto outSVs = std::make_unique<std::vector<flashgg::SecondaryVertex>>();
+  outSVs->reserve(tag_infos->size());
+  for (unsigned sv_n = 0; sv_n < tag_infos->size(); ++sv_n) {
     outSVs->push_back(svs->at(sv_n)); // do a copy here
     auto &sv = outSVs->back();
 
-    std::vector<float> outputs(flav_names_.size(), 0);  // init as all zeros
-
-    if (!taginfo.features().empty()) {
-      // convert inputs
-      make_inputs(taginfo);
-      // run prediction and get outputs
-      outputs = globalCache()->run(input_names_, data_, input_shapes_)[0];
-      assert(outputs.size() == flav_names_.size());
-    }
-
-    std::vector<float> probs;
-    for (std::size_t flav_n = 0; flav_n < flav_names_.size(); flav_n++) {
-      probs.push_back(outputs[flav_n]);
-    }
-    sv.setSvTagProbs(probs);
+    sv.setSvTagProbs(outputs[sv_n]);
     sv.setSvGenFlav(jets->at(sv_n).hasUserFloat("gen_flavour") ? jets->at(sv_n).userFloat("gen_flavour") : -1);
     sv.setSvNBHadrons(jets->at(sv_n).hasUserFloat("n_bhadrons") ? jets->at(sv_n).userFloat("n_bhadrons") : -1);
     sv.setSvNCHadrons(jets->at(sv_n).hasUserFloat("n_chadrons") ? jets->at(sv_n).userFloat("n_chadrons") : -1);
@@ -269,15 +292,23 @@ std::vector<float> SVFlavourONNXTagsProducer::center_norm_pad(const std::vector<
   return out;
 }
 
-void SVFlavourONNXTagsProducer::make_inputs(const reco::DeepBoostedJetTagInfo &taginfo) {
+std::vector<unsigned> SVFlavourONNXTagsProducer::input_lengths(const reco::DeepBoostedJetTagInfo &taginfo) const {
+  std::vector<unsigned> lengths;
+  for (const auto &group_name : input_names_) {
+    const auto &prep_params = prep_info_map_.at(group_name);
+    // the length of the dynamic axis is set by the first variable of the group
+    unsigned size = taginfo.features().get(prep_params.var_names.at(0)).size();
+    lengths.push_back(std::clamp(size, prep_params.min_length, prep_params.max_length));
+  }
+  return lengths;
+}
+
+void SVFlavourONNXTagsProducer::append_inputs(const reco::DeepBoostedJetTagInfo &taginfo,
+                                              const std::vector<unsigned> &lengths) {
   for (unsigned igroup = 0; igroup < input_names_.size(); ++igroup) {
     const auto &group_name = input_names_[igroup];
     const auto &prep_params = prep_info_map_.at(group_name);
     auto &group_values = data_[igroup];
-    group_values.resize(input_sizes_[igroup]);
-    // first reset group_values to 0
-    std::fill(group_values.begin(), group_values.end(), 0);
-    unsigned curr_pos = 0;
     // transform/pad
     for (unsigned i = 0; i < prep_params.var_names.size(); ++i) {
       const auto &varname = prep_params.var_names[i];
@@ -286,17 +317,13 @@ void SVFlavourONNXTagsProducer::make_inputs(const reco::DeepBoostedJetTagInfo &t
       auto val = center_norm_pad(raw_value,
                                  info.center,
                                  info.norm_factor,
-                                 prep_params.min_length,
-                                 prep_params.max_length,
+                                 lengths[igroup],
+                                 lengths[igroup],
                                  info.pad,
                                  info.replace_inf_value,
                                  info.lower_bound,
                                  info.upper_bound);
-      std::copy(val.begin(), val.end(), group_values.begin() + curr_pos);
-      curr_pos += val.size();
-      if (i == 0 && (!input_shapes_.empty())) {
-        input_shapes_[igroup][2] = val.size();
-      }
+      group_values.insert(group_values.end(), val.begin(), val.end());
 
       if (debug_) {
         std::cout << " -- var=" << varname << ", center=" << info.center << ", scale=" << info.norm_factor
@@ -307,7 +334,32 @@ void SVFlavourONNXTagsProducer::make_inputs(const reco::DeepBoostedJetTagInfo &t
         std::cout << std::endl;
       }
     }
-    group_values.resize(curr_pos);
+  }
+}
+
+void SVFlavourONNXTagsProducer::run_batch(const TagInfoCollection &tag_infos,
+                                          const std::vector<unsigned> &sv_indices,
+                                          const std::vector<unsigned> &lengths,
+                                          std::vector<std::vector<float>> &outputs) {
+  const unsigned batch_size = sv_indices.size();
+  for (unsigned igroup = 0; igroup < input_names_.size(); ++igroup) {
+    data_[igroup].clear();
+    data_[igroup].reserve(batch_size * prep_info_map_.at(input_names_[igroup]).var_names.size() * lengths[igroup]);
+  }
+  for (auto sv_n : sv_indices) {
+    append_inputs(tag_infos[sv_n], lengths);
+  }
+  for (unsigned igroup = 0; igroup < input_shapes_.size(); ++igroup) {
+    input_shapes_[igroup][0] = batch_size;
+    input_shapes_[igroup][2] = lengths[igroup];
+  }
+  // run prediction and scatter the outputs back to the SVs
+  const auto scores = globalCache()->run(input_names_, data_, input_shapes_, {}, batch_size)[0];
+  assert(scores.size() == batch_size * flav_names_.size());
+  for (unsigned ib = 0; ib < batch_size; ++ib) {
+    std::copy(scores.begin() + ib * flav_names_.size(),
+              scores.begin() + (ib + 1) * flav_names_.size(),
+              outputs[sv_indices[ib]].begin());
   }
 }
 
@@ -28,6 +28,8 @@ namespace flashgg {
         virtual void begin( const pat::Photon &, const edm::Event &, const edm::EventSetup & );
         virtual bool hasChargedIsolation() { return ! chargedVetos_.empty(); };
         virtual float chargedIsolation( const edm::Ptr<pat::Photon> &, const edm::Ptr<reco::Vertex>, const flashgg::VertexCandidateMap & );
+        virtual std::map<edm::Ptr<reco::Vertex>, float> chargedIsolationWrtAllVtx( const edm::Ptr<pat::Photon> &, const std::vector<edm::Ptr<reco::Vertex> > &,
+                const flashgg::VertexCandidateMap & );
         virtual bool hasCaloIsolation( reco::PFCandidate::ParticleType typ )
         {
             return ( typ == reco::PFCandidate::gamma && ! photonVetos_.empty() ) ||
@@ -35,10 +37,15 @@ namespace flashgg {
         };
         virtual float caloIsolation( const edm::Ptr<pat::Photon> &, const std::vector<edm::Ptr<pat::PackedCandidate> > &, reco::PFCandidate::ParticleType,
                                      const reco::Vertex *vtx = 0 );
+        virtual float caloIsolationFromIndex( const edm::Ptr<pat::Photon> &, PFCandidateEtaPhiIndex &, reco::PFCandidate::ParticleType,
+                                              const reco::Vertex *vtx = 0 );
 
         virtual void end( pat::Photon & );
 
     private:
+        // calo isolation from the candidate vector or from the index
+        template <class Candidates> float caloIso( const edm::Ptr<pat::Photon> &, Candidates &, reco::PFCandidate::ParticleType, const reco::Vertex * );
+
         double conesize_;
         PhotonIdUtils utils_;
         std::vector<double> chargedVetos_, photonVetos_, neutralVetos_;
@@ -58,19 +65,40 @@ namespace flashgg {
         /// return utils_.pfIsoChgWrtVtx(pho,vtx,mp,conesize_,0.02,0.02,0.1);
     }
 
-    float StdIsolationAlgo::caloIsolation( const edm::Ptr<pat::Photon> &pho, const std::vector<edm::Ptr<pat::PackedCandidate> > &ptrs,
-                                           reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
+    std::map<edm::Ptr<reco::Vertex>, float> StdIsolationAlgo::chargedIsolationWrtAllVtx( const edm::Ptr<pat::Photon> &pho,
+            const std::vector<edm::Ptr<reco::Vertex> > &vertices, const flashgg::VertexCandidateMap &mp )
+    {
+        if( ! chargedVetos_.empty() ) {
+            return utils_.pfIsoChgWrtAllVtx( pho, vertices, mp, conesize_, chargedVetos_[0], chargedVetos_[1], chargedVetos_[2] );
+        }
+        return IsolationAlgoBase::chargedIsolationWrtAllVtx( pho, vertices, mp );
+    }
+
+    template <class Candidates> float StdIsolationAlgo::caloIso( const edm::Ptr<pat::Photon> &pho, Candidates &candidates,
+            reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
     {
         if( typ == reco::PFCandidate::gamma && ! photonVetos_.empty() ) {
-            return utils_.pfCaloIso( pho, ptrs, conesize_, photonVetos_[0], photonVetos_[1], photonVetos_[2], photonVetos_[3], photonVetos_[4], photonVetos_[5], typ, vtx );
+            return utils_.pfCaloIso( pho, candidates, conesize_, photonVetos_[0], photonVetos_[1], photonVetos_[2], photonVetos_[3], photonVetos_[4], photonVetos_[5], typ, vtx );
         } else if( typ == reco::PFCandidate::h0 && ! neutralVetos_.empty() ) {
-            return utils_.pfCaloIso( pho, ptrs, conesize_, neutralVetos_[0], neutralVetos_[1], neutralVetos_[2], neutralVetos_[3], neutralVetos_[4], neutralVetos_[5], typ,
+            return utils_.pfCaloIso( pho, candidates, conesize_, neutralVetos_[0], neutralVetos_[1], neutralVetos_[2], neutralVetos_[3], neutralVetos_[4], neutralVetos_[5], typ,
                                      vtx );
         }
         return 0.;
         /// return utils_.pfCaloIso(pho, ptrs, conesize_, 0.0, 0.070, 0.015, 0.0, 0.0, 0.0, typ, vtx);
     }
 
+    float StdIsolationAlgo::caloIsolation( const edm::Ptr<pat::Photon> &pho, const std::vector<edm::Ptr<pat::PackedCandidate> > &ptrs,
+            reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
+    {
+        return caloIso( pho, ptrs, typ, vtx );
+    }
+
+    float StdIsolationAlgo::caloIsolationFromIndex( const edm::Ptr<pat::Photon> &pho, PFCandidateEtaPhiIndex &pfindex,
+            reco::PFCandidate::ParticleType typ, const reco::Vertex *vtx )
+    {
+        return caloIso( pho, pfindex, typ, vtx );
+    }
+
     void StdIsolationAlgo::end( pat::Photon & )
     {
 
@@ -2,7 +2,7 @@
 // S. Zenz, July 2015
 // Because sometimes internal rhyme is more important than consistent collection naming
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -17,7 +17,7 @@ using namespace std;
 using namespace edm;
 
 namespace flashgg {
-    class VectorVectorJetCollector : public EDProducer
+    class VectorVectorJetCollector : public edm::stream::EDProducer<>
     {
 
     public:
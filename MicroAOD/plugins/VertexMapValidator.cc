@@ -1,5 +1,5 @@
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -18,7 +18,7 @@ using namespace std;
 
 namespace flashgg {
 
-    class VertexMapValidator : public EDProducer
+    class VertexMapValidator : public edm::stream::EDProducer<>
     {
 
     public:
@@ -0,0 +1,74 @@
+// Keeps the weight label table of the WeightedObjects once per file instead of once per object.
+// At the beginning of each run the tables stored by earlier processes are read back into
+// flashgg::WeightLabels, so that the labels of the objects read from the input can be listed
+// and pattern-matched; at the end of each run all the labels known to this process are stored.
+
+#include "FWCore/Framework/interface/one/EDProducer.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Provenance/interface/BranchDescription.h"
+#include "flashgg/DataFormats/interface/WeightLabels.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace edm;
+
+namespace flashgg {
+
+    class WeightLabelTableProducer : public edm::one::EDProducer<edm::one::WatchRuns, edm::EndRunProducer>
+    {
+    public:
+        WeightLabelTableProducer( const ParameterSet & );
+
+    private:
+        void produce( Event &, const EventSetup & ) override {}
+        void beginRun( const Run &, const EventSetup & ) override;
+        void endRun( const Run &, const EventSetup & ) override {}
+        void endRunProduce( Run &, const EventSetup & ) override;
+
+        vector<EDGetTokenT<vector<string> > > inputTokens_;
+    };
+
+    WeightLabelTableProducer::WeightLabelTableProducer( const ParameterSet &iConfig )
+    {
+        const string label = iConfig.getParameter<string>( "@module_label" );
+        // the tables of the previous processes, stored under the same module label
+        callWhenNewProductsRegistered( [this, label]( const BranchDescription & branch ) {
+            if( branch.branchType() == InRun && !branch.produced() && branch.moduleLabel() == label
+                    && branch.unwrappedTypeID() == TypeID( typeid( vector<string> ) ) ) {
+                inputTokens_.push_back( consumes<vector<string>, InRun>( InputTag( branch.moduleLabel(), branch.productInstanceName(), branch.processName() ) ) );
+            }
+        } );
+        produces<vector<string>, InRun>();
+    }
+
+    void WeightLabelTableProducer::beginRun( const Run &iRun, const EventSetup & )
+    {
+        for( auto &token : inputTokens_ ) {
+            Handle<vector<string> > labels;
+            iRun.getByToken( token, labels );
+            if( !labels.isValid() ) { continue; }
+            for( auto &name : *labels ) { WeightLabels::intern( name ); }
+        }
+    }
+
+    void WeightLabelTableProducer::endRunProduce( Run &iRun, const EventSetup & )
+    {
+        iRun.put( std::make_unique<vector<string> >( WeightLabels::labels() ) );
+    }
+}
+
+typedef flashgg::WeightLabelTableProducer FlashggWeightLabelTableProducer;
+DEFINE_FWK_MODULE( FlashggWeightLabelTableProducer );
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -12,6 +12,7 @@ from flashgg.MicroAOD.flashggSecondaryVertices_cfi import flashggSVFlavourTagInf
 
 from flashgg.MicroAOD.flashggLeptonSelectors_cff import flashggSelectedMuons,flashggSelectedElectrons
 from flashgg.MicroAOD.flashggMicroAODGenSequence_cff import *
+from flashgg.MicroAOD.flashggWeightLabels_cfi import flashggWeightLabels
 
 eventCount = cms.EDProducer("EventCountProducer")
 weightsCount = cms.EDProducer("WeightsCountProducer",
@@ -30,7 +31,7 @@ weightsCount = cms.EDProducer("WeightsCountProducer",
 flashggDiPhotonFilterSequence = cms.Sequence()
 flashggMuonFilterSequence = cms.Sequence()
 
-flashggMicroAODSequence = cms.Sequence( eventCount+weightsCount
+flashggMicroAODSequence = cms.Sequence( eventCount+weightsCount+flashggWeightLabels
                                        +flashggVertexMapUnique+flashggVertexMapNonUnique
                                        +flashggMicroAODGenSequence
                                        +flashggPhotons * flashggRandomizedPhotons * flashggDiPhotons
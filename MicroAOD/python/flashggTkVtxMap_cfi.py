@@ -4,14 +4,16 @@ flashggVertexMapUnique = cms.EDProducer('FlashggDzVertexMapProducer',
                                         PFCandidatesTag=cms.InputTag('packedPFCandidates'),
                                         VertexTag=cms.InputTag('offlineSlimmedPrimaryVertices'),
                                         MaxAllowedDz=cms.double(0.2),
-                                        UseEachTrackOnce=cms.bool(True)
+                                        UseEachTrackOnce=cms.bool(True),
+                                        UseZIndex=cms.bool(True)
                                         )
 
 flashggVertexMapNonUnique = cms.EDProducer('FlashggDzVertexMapProducer',
                                            PFCandidatesTag=cms.InputTag('packedPFCandidates'),
                                            VertexTag=cms.InputTag('offlineSlimmedPrimaryVertices'),
                                            MaxAllowedDz=cms.double(0.2), 
-                                           UseEachTrackOnce=cms.bool(False)
+                                           UseEachTrackOnce=cms.bool(False),
+                                           UseZIndex=cms.bool(True)
                                            )
 
 #flashggVertexMapForCHSOld = cms.EDProducer('FlashggDzVertexMapProducerForCHS',
@@ -0,0 +1,5 @@
+import FWCore.ParameterSet.Config as cms
+
+# one table of the WeightedObject weight labels per run: reads back the tables of the
+# input files and stores the labels known to this process (the module label must be kept)
+flashggWeightLabels = cms.EDProducer("FlashggWeightLabelTableProducer")
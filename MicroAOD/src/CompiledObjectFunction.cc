@@ -0,0 +1,371 @@
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "TClass.h"
+#include "TInterpreter.h"
+#include "TVirtualMutex.h"
+
+namespace {
+
+    // Recursive-descent translation of the StringObjectFunction / StringCutObjectSelector
+    // grammar into C++. Every number and method result is converted to double before
+    // it enters arithmetic, as the reflective evaluator does, so that integer-valued
+    // methods give the same results (e.g. nJets/2). Anything outside the supported
+    // subset (method arguments that are not literals, data members, unknown functions,
+    // chained comparisons...) makes the translation fail, and the caller falls back to
+    // the reflective path.
+    class ExpressionTranslator
+    {
+    public:
+        ExpressionTranslator( const std::string &expr ) : expr_( expr ), pos_( 0 ), ok_( true ) {}
+
+        std::string translate()
+        {
+            std::string ret = orExpr();
+            skipSpaces();
+            if( !ok_ || pos_ != expr_.size() ) { return ""; }
+            return ret;
+        }
+
+    private:
+        void skipSpaces() { while( pos_ < expr_.size() && isspace( expr_[pos_] ) ) { ++pos_; } }
+
+        bool accept( const char *tok )
+        {
+            skipSpaces();
+            size_t len = strlen( tok );
+            if( expr_.compare( pos_, len, tok ) == 0 ) {
+                pos_ += len;
+                return true;
+            }
+            return false;
+        }
+
+        // Single-character operator that is not the first character of a longer one
+        bool acceptSingle( char c, char notFollowedBy )
+        {
+            skipSpaces();
+            if( pos_ < expr_.size() && expr_[pos_] == c && ( pos_ + 1 >= expr_.size() || expr_[pos_ + 1] != notFollowedBy ) ) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        void expect( const char *tok ) { if( !accept( tok ) ) { ok_ = false; } }
+
+        std::string identifier()
+        {
+            skipSpaces();
+            size_t start = pos_;
+            if( pos_ < expr_.size() && ( isalpha( expr_[pos_] ) || expr_[pos_] == '_' ) ) {
+                while( pos_ < expr_.size() && ( isalnum( expr_[pos_] ) || expr_[pos_] == '_' ) ) { ++pos_; }
+            }
+            return expr_.substr( start, pos_ - start );
+        }
+
+        std::string number()
+        {
+            skipSpaces();
+            size_t start = pos_;
+            while( pos_ < expr_.size() && ( isdigit( expr_[pos_] ) || expr_[pos_] == '.' ) ) { ++pos_; }
+            if( pos_ > start && pos_ < expr_.size() && ( expr_[pos_] == 'e' || expr_[pos_] == 'E' ) ) {
+                size_t save = pos_++;
+                if( pos_ < expr_.size() && ( expr_[pos_] == '+' || expr_[pos_] == '-' ) ) { ++pos_; }
+                if( pos_ < expr_.size() && isdigit( expr_[pos_] ) ) {
+                    while( pos_ < expr_.size() && isdigit( expr_[pos_] ) ) { ++pos_; }
+                } else {
+                    pos_ = save;
+                }
+            }
+            return expr_.substr( start, pos_ - start );
+        }
+
+        std::string stringLiteral()
+        {
+            skipSpaces();
+            char quote = expr_[pos_];
+            size_t end = expr_.find( quote, pos_ + 1 );
+            if( end == std::string::npos ) { ok_ = false; return ""; }
+            std::string body = expr_.substr( pos_ + 1, end - pos_ - 1 );
+            pos_ = end + 1;
+            if( body.find_first_of( "\"\\" ) != std::string::npos ) { ok_ = false; }
+            return "\"" + body + "\"";
+        }
+
+        bool atNumber()
+        {
+            skipSpaces();
+            return ( pos_ < expr_.size() && ( isdigit( expr_[pos_] ) ||
+                                              ( expr_[pos_] == '.' && pos_ + 1 < expr_.size() && isdigit( expr_[pos_ + 1] ) ) ) );
+        }
+
+        bool atString()
+        {
+            skipSpaces();
+            return ( pos_ < expr_.size() && ( expr_[pos_] == '\'' || expr_[pos_] == '"' ) );
+        }
+
+        std::string orExpr()
+        {
+            std::string ret = andExpr();
+            while( ok_ && ( accept( "||" ) || acceptSingle( '|', '|' ) ) ) {
+                ret = "( " + ret + " || " + andExpr() + " )";
+            }
+            return ret;
+        }
+
+        std::string andExpr()
+        {
+            std::string ret = notExpr();
+            while( ok_ && ( accept( "&&" ) || acceptSingle( '&', '&' ) ) ) {
+                ret = "( " + ret + " && " + notExpr() + " )";
+            }
+            return ret;
+        }
+
+        std::string notExpr()
+        {
+            if( acceptSingle( '!', '=' ) ) { return "( !" + notExpr() + " )"; }
+            return comparison();
+        }
+
+        std::string comparison()
+        {
+            static const char *ops[] = { "<=", ">=", "==", "!=", "<", ">" };
+            std::string ret = arith();
+            for( const char *op : ops ) {
+                if( accept( op ) ) {
+                    ret = "( " + ret + " " + op + " " + arith() + " )";
+                    for( const char *op2 : ops ) {
+                        skipSpaces();
+                        if( expr_.compare( pos_, strlen( op2 ), op2 ) == 0 ) { ok_ = false; }
+                    }
+                    break;
+                }
+            }
+            return ret;
+        }
+
+        std::string arith()
+        {
+            std::string ret = term();
+            while( ok_ ) {
+                if( accept( "+" ) ) { ret = "( " + ret + " + " + term() + " )"; }
+                else if( accept( "-" ) ) { ret = "( " + ret + " - " + term() + " )"; }
+                else { break; }
+            }
+            return ret;
+        }
+
+        std::string term()
+        {
+            std::string ret = power();
+            while( ok_ ) {
+                if( accept( "*" ) ) { ret = "( " + ret + " * " + power() + " )"; }
+                else if( accept( "/" ) ) { ret = "( " + ret + " / " + power() + " )"; }
+                else { break; }
+            }
+            return ret;
+        }
+
+        std::string power()
+        {
+            std::string ret = unary();
+            while( ok_ && accept( "^" ) ) {
+                ret = "std::pow( " + ret + ", " + unary() + " )";
+            }
+            return ret;
+        }
+
+        std::string unary()
+        {
+            if( accept( "-" ) ) { return "( -" + unary() + " )"; }
+            if( accept( "+" ) ) { return unary(); }
+            return primary();
+        }
+
+        std::string primary()
+        {
+            if( !ok_ ) { return ""; }
+            if( atNumber() ) { return "double( " + number() + " )"; }
+            if( accept( "(" ) ) {
+                std::string ret = orExpr();
+                expect( ")" );
+                return "( " + ret + " )";
+            }
+            if( accept( "?" ) ) {
+                std::string cond = orExpr();
+                expect( "?" );
+                std::string ifTrue = orExpr();
+                expect( ":" );
+                std::string ifFalse = orExpr();
+                return "( ( " + cond + " ) ? double( " + ifTrue + " ) : double( " + ifFalse + " ) )";
+            }
+            size_t save = pos_;
+            std::string name = identifier();
+            if( name.empty() ) { ok_ = false; return ""; }
+            if( accept( "(" ) ) {
+                std::string func = function( name );
+                if( !func.empty() ) {
+                    std::vector<std::string> args;
+                    if( !accept( ")" ) ) {
+                        do { args.push_back( "double( " + orExpr() + " )" ); } while( ok_ && accept( "," ) );
+                        expect( ")" );
+                    }
+                    if( !checkArity( name, args.size() ) ) { ok_ = false; return ""; }
+                    std::string ret = func + "( ";
+                    for( size_t iarg = 0 ; iarg < args.size() ; ++iarg ) { ret += ( iarg > 0 ? ", " : "" ) + args[iarg]; }
+                    return ret + " )";
+                }
+            }
+            pos_ = save;
+            return "flashgg_jit::num( " + memberChain() + " )";
+        }
+
+        std::string memberChain()
+        {
+            std::string ret = "obj";
+            bool first = true;
+            do {
+                std::string name = identifier();
+                if( name.empty() ) { ok_ = false; return ""; }
+                std::string args;
+                if( accept( "(" ) ) {
+                    if( !accept( ")" ) ) {
+                        do {
+                            std::string arg;
+                            if( atString() ) { arg = stringLiteral(); }
+                            else if( accept( "-" ) && atNumber() ) { arg = "-" + number(); }
+                            else if( atNumber() ) { arg = number(); }
+                            else { ok_ = false; return ""; }
+                            args += ( args.empty() ? " " : ", " ) + arg;
+                        } while( ok_ && accept( "," ) );
+                        expect( ")" );
+                        args += " ";
+                    }
+                }
+                ret = ( first ? ret : "flashgg_jit::deref( " + ret + " )" ) + "." + name + "(" + args + ")";
+                first = false;
+            } while( ok_ && accept( "." ) );
+            return ret;
+        }
+
+        static std::string function( const std::string &name )
+        {
+            static const std::map<std::string, std::string> functions = {
+                { "abs", "std::fabs" }, { "acos", "std::acos" }, { "asin", "std::asin" }, { "atan", "std::atan" },
+                { "atan2", "std::atan2" }, { "cos", "std::cos" }, { "cosh", "std::cosh" }, { "exp", "std::exp" },
+                { "hypot", "std::hypot" }, { "log", "std::log" }, { "log10", "std::log10" }, { "max", "std::max" },
+                { "min", "std::min" }, { "pow", "std::pow" }, { "sin", "std::sin" }, { "sinh", "std::sinh" },
+                { "sqrt", "std::sqrt" }, { "tan", "std::tan" }, { "tanh", "std::tanh" },
+                { "deltaPhi", "reco::deltaPhi" }, { "deltaR", "reco::deltaR" }
+            };
+            auto it = functions.find( name );
+            return ( it == functions.end() ? "" : it->second );
+        }
+
+        static bool checkArity( const std::string &name, size_t nargs )
+        {
+            if( name == "deltaR" ) { return nargs == 4; }
+            if( name == "atan2" || name == "hypot" || name == "max" || name == "min" || name == "pow" || name == "deltaPhi" ) { return nargs == 2; }
+            return nargs == 1;
+        }
+
+        const std::string &expr_;
+        size_t pos_;
+        bool ok_;
+    };
+
+    const char *prelude =
+        "#include <cmath>\n"
+        "#include <algorithm>\n"
+        "#include \"DataFormats/Math/interface/deltaR.h\"\n"
+        "#include \"DataFormats/Math/interface/deltaPhi.h\"\n"
+        "namespace flashgg_jit {\n"
+        "    template<class T> double num( const T &x ) { return double( x ); }\n"
+        "    template<class T> auto deref_impl( const T &x, int ) -> decltype( *x ) { return *x; }\n"
+        "    template<class T> const T &deref_impl( const T &x, long ) { return x; }\n"
+        "    template<class T> auto deref( const T &x ) -> decltype( deref_impl( x, 0 ) ) { return deref_impl( x, 0 ); }\n"
+        "}\n";
+
+    // FLASHGG_COMPILED_EXPRESSIONS in the environment turns the compiler on for every
+    // user of CompiledObjectFunction that does not make its own choice
+    std::atomic<bool> &enabledFlag()
+    {
+        static std::atomic<bool> enabled( std::getenv( "FLASHGG_COMPILED_EXPRESSIONS" ) != 0 );
+        return enabled;
+    }
+
+    std::mutex cacheMutex_;
+    std::map<std::string, flashgg::ExpressionCompiler::function_type> cache_;
+}
+
+namespace flashgg {
+
+    void ExpressionCompiler::setEnabled( bool enabled ) { enabledFlag() = enabled; }
+
+    bool ExpressionCompiler::enabled() { return enabledFlag(); }
+
+    std::string ExpressionCompiler::translate( const std::string &expr )
+    {
+        return ExpressionTranslator( expr ).translate();
+    }
+
+    ExpressionCompiler::function_type ExpressionCompiler::compile( const std::string &typeName, const std::string &expr )
+    {
+        std::lock_guard<std::mutex> guard( cacheMutex_ );
+        std::string key = typeName + "\n" + expr;
+        auto cached = cache_.find( key );
+        if( cached != cache_.end() ) { return cached->second; }
+
+        function_type ret = 0;
+        std::string body = translate( expr );
+        if( !body.empty() ) {
+            R__LOCKGUARD( gInterpreterMutex );
+            static bool preludeDeclared = gInterpreter->Declare( prelude );
+            // make sure the dictionary, and with it the class declaration, is loaded
+            if( preludeDeclared && TClass::GetClass( typeName.c_str() ) ) {
+                std::ostringstream name;
+                name << "f" << std::hash<std::string>()( key ) << "_" << cache_.size();
+                std::ostringstream code;
+                code << "namespace flashgg_jit {\n"
+                     << "    double " << name.str() << "( const void *ptr ) {\n"
+                     << "        const " << typeName << " &obj = *static_cast<const " << typeName << " *>( ptr );\n"
+                     << "        return double( " << body << " );\n"
+                     << "    }\n"
+                     << "}\n";
+                if( gInterpreter->Declare( code.str().c_str() ) ) {
+                    TInterpreter::EErrorCode error = TInterpreter::kNoError;
+                    Long_t address = gInterpreter->Calc( ( "(long)&flashgg_jit::" + name.str() ).c_str(), &error );
+                    if( error == TInterpreter::kNoError && address != 0 ) {
+                        ret = reinterpret_cast<function_type>( address );
+                    }
+                }
+            }
+        }
+        if( !ret ) {
+            std::cerr << "[ExpressionCompiler] could not compile \"" << expr << "\" for " << typeName << ", using the reflective evaluator" << std::endl;
+        }
+        cache_[key] = ret;
+        return ret;
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -8,6 +8,17 @@ namespace flashgg {
     IsolationAlgoBase::~IsolationAlgoBase()
     {
     }
+
+    std::map<edm::Ptr<reco::Vertex>, float> IsolationAlgoBase::chargedIsolationWrtAllVtx( const edm::Ptr<pat::Photon> &pho,
+            const std::vector<edm::Ptr<reco::Vertex> > &vertices,
+            const flashgg::VertexCandidateMap &mp )
+    {
+        std::map<edm::Ptr<reco::Vertex>, float> iso;
+        for( auto &vtx : vertices ) {
+            iso[vtx] = chargedIsolation( pho, vtx, mp );
+        }
+        return iso;
+    }
 }
 // Local Variables:
 // mode:c++
@@ -61,6 +61,13 @@ MiniAODFootprintRemoval::MiniAODFootprintRemoval( edm::ParameterSet iConfig )
 {
     //now do what ever initialization is needed
     rotation_phi = 0.;
+    barrelGeometry = 0;
+    endcapGeometry = 0;
+    magField = 0;
+    magFieldZ = 0.;
+    footprintRotation = 0.;
+    footprintValid = false;
+    propagatedEvent = 0;
 
     eegeom = TGeoPara( 1, 1, 1, 0, 0, 0 );
 
@@ -71,17 +78,31 @@ MiniAODFootprintRemoval::MiniAODFootprintRemoval( edm::ParameterSet iConfig )
 
 void MiniAODFootprintRemoval::setup( const pat::Photon &photon, const edm::Event &iEvent, const edm::EventSetup &iSetup )
 {
-    edm::ESHandle<CaloGeometry> geometry ;
-    iSetup.get<CaloGeometryRecord>().get( geometry );
-    barrelGeometry = ( CaloSubdetectorGeometry * )( geometry->getSubdetectorGeometry( DetId::Ecal, EcalBarrel ) );
-    endcapGeometry = ( CaloSubdetectorGeometry * )( geometry->getSubdetectorGeometry( DetId::Ecal, EcalEndcap ) );
+    // geometry and field are only fetched again when their records change
+    if( geometryWatcher.check( iSetup ) ) {
+        edm::ESHandle<CaloGeometry> geometry ;
+        iSetup.get<CaloGeometryRecord>().get( geometry );
+        barrelGeometry = ( CaloSubdetectorGeometry * )( geometry->getSubdetectorGeometry( DetId::Ecal, EcalBarrel ) );
+        endcapGeometry = ( CaloSubdetectorGeometry * )( geometry->getSubdetectorGeometry( DetId::Ecal, EcalEndcap ) );
+    }
+
+    if( magFieldWatcher.check( iSetup ) ) {
+        edm::ESHandle<MagneticField> magneticField;
+        iSetup.get<IdealMagneticFieldRecord>().get( magneticField );
+        magField = ( MagneticField * )( magneticField.product() );
+        magFieldZ = magField->inTesla( GlobalPoint( 0., 0., 0. ) ).z();
+        propagatedHits.clear();
+    }
 
-    edm::ESHandle<MagneticField> magneticField;
-    iSetup.get<IdealMagneticFieldRecord>().get( magneticField );
-    magField = ( MagneticField * )( magneticField.product() );
+    // the candidates propagated for the previous photons of the event are kept
+    if( iEvent.cacheIdentifier() != propagatedEvent ) {
+        propagatedHits.clear();
+        propagatedEvent = iEvent.cacheIdentifier();
+    }
 
     // compute supe-cluster foot-print
     infos = getSCXtalInfo( photon.superCluster() );
+    footprintValid = false;
 
     // use association map to recover link by super-cluster ref
     if( removePhotonsInMap_ > 0 ) {
@@ -149,7 +170,7 @@ TVector3 MiniAODFootprintRemoval::propagatePFCandToEcal( const edm::Ptr<pat::Pac
     }
 
     if( type == 1 ) { // APPROXIMATE helix propagation
-        float field = magField->inTesla( GlobalPoint( 0., 0., 0. ) ).z();
+        float field = magFieldZ;
         float charge = cand->charge();
         float curvature = ( cand->pt() ) / ( 0.3 * field * charge ) * 100; // curvature radius in cm
         float final_radius = ecalpfhit.Perp();
@@ -164,6 +185,70 @@ TVector3 MiniAODFootprintRemoval::propagatePFCandToEcal( const edm::Ptr<pat::Pac
     return ecalpfhit;
 }
 
+const propagated_hit &MiniAODFootprintRemoval::propagatedHit( const edm::Ptr<pat::PackedCandidate> &cand, float position, bool isbarrel )
+{
+    if( cand.id() != propagatedProduct ) {
+        propagatedHits.clear();
+        propagatedProduct = cand.id();
+    }
+    if( propagatedHits.size() <= cand.key() ) { propagatedHits.resize( cand.key() + 1 ); }
+
+    // the footprint crystals are at a handful of different radii (or z), so each candidate has only a few entries
+    std::vector<propagated_hit> &hits = propagatedHits[cand.key()];
+    for( const auto &hit : hits ) {
+        if( hit.position == position && hit.isbarrel == isbarrel ) { return hit; }
+    }
+
+    propagated_hit hit;
+    hit.position = position;
+    hit.isbarrel = isbarrel;
+    hit.hit = propagatePFCandToEcal( cand, position, isbarrel );
+    hit.eta = hit.phi = 0.;
+    if( isbarrel && hit.hit.Perp() != 0 ) {
+        hit.eta = hit.hit.Eta();
+        hit.phi = hit.hit.Phi();
+    }
+    hits.push_back( hit );
+    return hits.back();
+}
+
+const std::vector<xtal_footprint> &MiniAODFootprintRemoval::footprint()
+{
+    if( footprintValid && footprintRotation == rotation_phi ) { return footprintXtals; }
+
+    footprintXtals.resize( infos.xtalposition.size() );
+    for( unsigned int j = 0; j < footprintXtals.size(); j++ ) {
+        xtal_footprint &xtal = footprintXtals[j];
+
+        xtal.position = infos.xtalposition[j];
+        TVector3 xtal_corners[4];
+        for( int k = 0; k < 4; k++ ) { xtal_corners[k] = infos.xtalcorners[j][k]; }
+        if( rotation_phi != 0 ) {
+            TRotation r;
+            r.RotateZ( rotation_phi );
+            xtal.position *= r;
+            for( int k = 0; k < 4; k++ ) { xtal_corners[k] *= r; }
+        }
+        xtal.barrelradius = xtal.position.Perp();
+        xtal.endcapz = xtal.position.z();
+        xtal.eta = xtal.position.Eta();
+        xtal.phi = xtal.position.Phi();
+
+        xtal.etawidth = infos.xtaletawidth[j] * ( 1.0 + global_linkbyrechit_enlargement );
+        xtal.phiwidth = infos.xtalphiwidth[j] * ( 1.0 + global_linkbyrechit_enlargement );
+
+        for( int k = 0; k < 4; k++ ) { xtal.polx[k] = xtal_corners[k].x(); }
+        for( int k = 0; k < 4; k++ ) { xtal.poly[k] = xtal_corners[k].y(); }
+        xtal.polx[4] = xtal.polx[0];
+        xtal.poly[4] = xtal.poly[0]; // closed polygon
+        xtal.centerx = ( xtal.polx[0] + xtal.polx[1] + xtal.polx[2] + xtal.polx[3] ) / 4;
+        xtal.centery = ( xtal.poly[0] + xtal.poly[1] + xtal.poly[2] + xtal.poly[3] ) / 4;
+    }
+    footprintRotation = rotation_phi;
+    footprintValid = true;
+    return footprintXtals;
+}
+
 sc_xtal_information MiniAODFootprintRemoval::getSCXtalInfo( reco::SuperClusterRef sc )
 {
     sc_xtal_information out;
@@ -279,55 +364,32 @@ bool MiniAODFootprintRemoval::checkPFCandInFootprint( const pat::Photon &pho, co
     int type = findPFCandType( cand->pdgId() );
     if( type > 2 ) { return false; }
 
-    bool inside = false;
+    // the crystals are rotated once per photon and the candidate propagated once per event and surface:
+    // only the footprint tests are left for each (candidate, crystal)
+    for( const auto &xtal : footprint() ) {
 
-    for( int j = 0; j < infos.nxtals; j++ ) {
-
-        TVector3 xtal_position = infos.xtalposition[j];
-        if( rotation_phi != 0 ) {
-            TRotation r;
-            r.RotateZ( rotation_phi );
-            xtal_position *= r;
-        }
-
-        TVector3 ecalpfhit = propagatePFCandToEcal( cand, isbarrel ? xtal_position.Perp() : xtal_position.z(), isbarrel );
+        const propagated_hit &propagated = propagatedHit( cand, isbarrel ? xtal.barrelradius : xtal.endcapz, isbarrel );
+        const TVector3 &ecalpfhit = propagated.hit;
 
         if( ecalpfhit.Perp() == 0 ) { continue; }
 
         if( isbarrel ) {
-            float xtalEtaWidth = infos.xtaletawidth[j] * ( 1.0 + global_linkbyrechit_enlargement );
-            float xtalPhiWidth = infos.xtalphiwidth[j] * ( 1.0 + global_linkbyrechit_enlargement );
-            float deta = ecalpfhit.Eta() - xtal_position.Eta();
-            float dphi = reco::deltaPhi( ecalpfhit.Phi(), xtal_position.Phi() );
-            if( fabs( deta ) < xtalEtaWidth / 2 && fabs( dphi ) < xtalPhiWidth / 2 ) { inside = true; }
+            float deta = propagated.eta - xtal.eta;
+            float dphi = reco::deltaPhi( propagated.phi, xtal.phi );
+            if( fabs( deta ) < xtal.etawidth / 2 && fabs( dphi ) < xtal.phiwidth / 2 ) { return true; }
         } else { // EE
-            if( ecalpfhit.z()*xtal_position.z() > 0 ) {
-                TVector3 xtal_corners[4];
-                for( int k = 0; k < 4; k++ ) { xtal_corners[k] = infos.xtalcorners[j][k]; }
-                if( rotation_phi != 0 ) {
-                    TRotation r;
-                    r.RotateZ( rotation_phi );
-                    for( int k = 0; k < 4; k++ ) { xtal_corners[k] *= r; }
-                }
+            if( ecalpfhit.z()*xtal.position.z() > 0 ) {
                 float hitx = ecalpfhit.x();
                 float hity = ecalpfhit.y();
-                float polx[5];
-                float poly[5];
-                for( int k = 0; k < 4; k++ ) { polx[k] = xtal_corners[k].x(); }
-                for( int k = 0; k < 4; k++ ) { poly[k] = xtal_corners[k].y(); }
-                polx[4] = polx[0];
-                poly[4] = poly[0]; // closed polygon
-                float centerx = ( polx[0] + polx[1] + polx[2] + polx[3] ) / 4;
-                float centery = ( poly[0] + poly[1] + poly[2] + poly[3] ) / 4;
-                hitx = centerx + ( hitx - centerx ) / ( 1.0 + global_linkbyrechit_enlargement );
-                hity = centery + ( hity - centery ) / ( 1.0 + global_linkbyrechit_enlargement );
-                if( TMath::IsInside( hitx, hity, 5, polx, poly ) ) { inside = true; }
+                hitx = xtal.centerx + ( hitx - xtal.centerx ) / ( 1.0 + global_linkbyrechit_enlargement );
+                hity = xtal.centery + ( hity - xtal.centery ) / ( 1.0 + global_linkbyrechit_enlargement );
+                if( TMath::IsInside( hitx, hity, 5, xtal.polx, xtal.poly ) ) { return true; }
             }
         }
 
     }
 
-    return inside;
+    return false;
 }
 
 int MiniAODFootprintRemoval::findPFCandType( int id )
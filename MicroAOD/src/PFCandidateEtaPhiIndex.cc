@@ -0,0 +1,115 @@
+#include "flashgg/MicroAOD/interface/PFCandidateEtaPhiIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace flashgg {
+
+    constexpr int PFCandidateEtaPhiIndex::nEtaBins;
+    constexpr int PFCandidateEtaPhiIndex::nPhiBins;
+    constexpr double PFCandidateEtaPhiIndex::etaMax;
+    constexpr double PFCandidateEtaPhiIndex::margin;
+
+    PFCandidateEtaPhiIndex::PFCandidateEtaPhiIndex( const std::vector<edm::Ptr<pat::PackedCandidate> > &pfcandidates ) :
+        pfcandidates_( &pfcandidates ),
+        pdgId_( pfcandidates.size() ),
+        eta_( pfcandidates.size(), 0. ),
+        phi_( pfcandidates.size(), 0. )
+    {
+        for( unsigned int i = 0 ; i < pfcandidates.size() ; i++ ) {
+            pdgId_[i] = pfcandidates[i]->pdgId();
+        }
+    }
+
+    int PFCandidateEtaPhiIndex::etaBin( double eta )
+    {
+        double bin = std::floor( ( eta + etaMax ) * nEtaBins / ( 2. * etaMax ) );
+        return int( std::min( std::max( bin, 0. ), nEtaBins - 1. ) );
+    }
+
+    int PFCandidateEtaPhiIndex::phiBin( double phi )
+    {
+        return int( std::floor( ( phi + M_PI ) * nPhiBins / ( 2. * M_PI ) ) );
+    }
+
+    const PFCandidateEtaPhiIndex::Grid &PFCandidateEtaPhiIndex::grid( int pdgId )
+    {
+        for( const auto &grid : grids_ ) {
+            if( grid.pdgId == pdgId ) { return grid; }
+        }
+
+        grids_.emplace_back();
+        Grid &grid = grids_.back();
+        grid.pdgId = pdgId;
+        std::vector<int> cell;
+        for( unsigned int i = 0 ; i < pdgId_.size() ; i++ ) {
+            if( pdgId_[i] != pdgId ) { continue; }
+            grid.all.push_back( i );
+            const auto &pfcand = ( *pfcandidates_ )[i];
+            eta_[i] = pfcand->momentum().Eta();
+            phi_[i] = pfcand->momentum().Phi();
+            if( !std::isfinite( eta_[i] ) || !std::isfinite( phi_[i] ) ) {
+                grid.unplaced.push_back( i );
+                cell.push_back( -1 );
+                continue;
+            }
+            int iphi = phiBin( phi_[i] ) % nPhiBins;
+            if( iphi < 0 ) { iphi += nPhiBins; }
+            cell.push_back( etaBin( eta_[i] ) * nPhiBins + iphi );
+        }
+
+        // counting sort, which keeps the candidates of each cell in increasing order
+        grid.offsets.assign( nEtaBins * nPhiBins + 1, 0 );
+        for( int c : cell ) {
+            if( c >= 0 ) { grid.offsets[c + 1]++; }
+        }
+        for( int c = 0 ; c < nEtaBins * nPhiBins ; c++ ) {
+            grid.offsets[c + 1] += grid.offsets[c];
+        }
+        grid.cells.resize( grid.offsets.back() );
+        std::vector<unsigned int> next( grid.offsets.begin(), grid.offsets.end() - 1 );
+        for( unsigned int k = 0 ; k < cell.size() ; k++ ) {
+            if( cell[k] >= 0 ) { grid.cells[next[cell[k]]++] = grid.all[k]; }
+        }
+        return grid;
+    }
+
+    const std::vector<unsigned int> &PFCandidateEtaPhiIndex::all( int pdgId )
+    {
+        result_ = grid( pdgId ).all;
+        return result_;
+    }
+
+    const std::vector<unsigned int> &PFCandidateEtaPhiIndex::query( int pdgId, double eta, double phi, double dRMax )
+    {
+        const Grid &grid = this->grid( pdgId );
+        double r = dRMax + margin;
+        if( !std::isfinite( eta ) || !std::isfinite( phi ) || !( r < M_PI ) ) {
+            result_ = grid.all;
+            return result_;
+        }
+
+        result_.clear();
+        int etaLow = etaBin( eta - r ), etaHigh = etaBin( eta + r );
+        int phiLow = phiBin( phi - r ), phiHigh = phiBin( phi + r );
+        int nPhi = std::min( phiHigh - phiLow + 1, nPhiBins );
+        for( int ieta = etaLow ; ieta <= etaHigh ; ieta++ ) {
+            for( int k = 0 ; k < nPhi ; k++ ) {
+                int iphi = ( phiLow + k ) % nPhiBins;
+                if( iphi < 0 ) { iphi += nPhiBins; }
+                int c = ieta * nPhiBins + iphi;
+                result_.insert( result_.end(), grid.cells.begin() + grid.offsets[c], grid.cells.begin() + grid.offsets[c + 1] );
+            }
+        }
+        result_.insert( result_.end(), grid.unplaced.begin(), grid.unplaced.end() );
+        std::sort( result_.begin(), result_.end() );
+        return result_;
+    }
+}
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -3,6 +3,8 @@
 #include "DataFormats/Math/interface/deltaR.h"
 #include "DataFormats/Candidate/interface/Candidate.h"
 
+#include <algorithm>
+
 #include "Geometry/CaloTopology/interface/CaloTopology.h"
 #include "RecoEcal/EgammaCoreTools/interface/EcalClusterTools.h"
 
@@ -42,7 +44,7 @@ bool PhotonIdUtils::vetoPackedCand( const pat::Photon &photon, const edm::Ptr<pa
 
 float PhotonIdUtils::pfIsoChgWrtVtx( const edm::Ptr<pat::Photon> &photon,
                                      const edm::Ptr<reco::Vertex> vtx,
-                                     const flashgg::VertexCandidateMap vtxcandmap,
+                                     const flashgg::VertexCandidateMap &vtxcandmap,
                                      float coneSize, float coneVetoBarrel, float coneVetoEndcap,
                                      float ptMin
                                    )
@@ -84,20 +86,71 @@ float PhotonIdUtils::pfIsoChgWrtVtx( const edm::Ptr<pat::Photon> &photon,
 
 map<edm::Ptr<reco::Vertex>, float> PhotonIdUtils::pfIsoChgWrtAllVtx( const edm::Ptr<pat::Photon> &photon,
         const std::vector<edm::Ptr<reco::Vertex> > &vertices,
-        const flashgg::VertexCandidateMap vtxcandmap,
+        const flashgg::VertexCandidateMap &vtxcandmap,
         float coneSize, float coneVetoBarrel, float coneVetoEndcap,
         float ptMin )
 {
-    map<edm::Ptr<reco::Vertex>, float> isomap;
-    isomap.clear();
+    std::vector<map<edm::Ptr<reco::Vertex>, float> > isomaps = pfIsoChgWrtAllVtx( photon, vertices, vtxcandmap, std::vector<float>( 1, coneSize ),
+                                                                                  coneVetoBarrel, coneVetoEndcap, ptMin );
+    return isomaps[0];
+}
+
+
+std::vector<map<edm::Ptr<reco::Vertex>, float> > PhotonIdUtils::pfIsoChgWrtAllVtx( const edm::Ptr<pat::Photon> &photon,
+        const std::vector<edm::Ptr<reco::Vertex> > &vertices,
+        const flashgg::VertexCandidateMap &vtxcandmap,
+        const std::vector<float> &coneSizes, float coneVetoBarrel, float coneVetoEndcap,
+        float ptMin )
+{
+    std::vector<map<edm::Ptr<reco::Vertex>, float> > isomaps( coneSizes.size() );
+    if( coneSizes.empty() ) { return isomaps; }
+
+    float coneVeto = 0;
+    if( photon->isEB() )      { coneVeto = coneVetoBarrel; }
+    else if( photon->isEE() ) { coneVeto = coneVetoEndcap; }
+    float maxConeSize = *std::max_element( coneSizes.begin(), coneSizes.end() );
 
+    std::vector<float> isovalues( coneSizes.size() );
     for( unsigned int iv = 0; iv < vertices.size(); iv++ ) {
+        const edm::Ptr<reco::Vertex> &vtx = vertices[iv];
+        auto mapRange = std::equal_range( vtxcandmap.begin(), vtxcandmap.end(), vtx, flashgg::compare_with_vtx() );
+        if( mapRange.first == mapRange.second ) { // no entries for this vertex
+            for( auto &isomap : isomaps ) { isomap.insert( make_pair( vtx, -1. ) ); }
+            continue;
+        }
 
-        float iso = pfIsoChgWrtVtx( photon, vertices[iv], vtxcandmap, coneSize, coneVetoBarrel, coneVetoEndcap, ptMin );
-        isomap.insert( make_pair( vertices[iv], iso ) );
+        math::XYZVector SCdirection( photon->superCluster()->x() - vtx->x(),
+                                     photon->superCluster()->y() - vtx->y(),
+                                     photon->superCluster()->z() - vtx->z()
+                                   );
+        double scEta = SCdirection.Eta();
+        double scPhi = SCdirection.Phi() + deltaPhiRotation_; // rotate SC in phi if requested (random cone isolation)
+
+        std::fill( isovalues.begin(), isovalues.end(), 0. );
+        for( auto pair_iter = mapRange.first ; pair_iter != mapRange.second ; pair_iter++ ) {
+            const edm::Ptr<pat::PackedCandidate> &pfcand = pair_iter->second;
+
+            if( abs( pfcand->pdgId() ) == 11 || abs( pfcand->pdgId() ) == 13 ) { continue; } //J. Tao not e/mu
+            if( pfcand->pt() < ptMin )         { continue; }
+            // the delta R is computed once and shared by all the cones; candidates outside of all of them
+            // are dropped before the (comparatively expensive) overlap removal
+            float dRTkToVtx  = deltaR( pfcand->momentum().Eta(), pfcand->momentum().Phi(), scEta, scPhi );
+            if( dRTkToVtx > maxConeSize || dRTkToVtx < coneVeto ) { continue; }
+            if( removeOverlappingCandidates_ &&
+                    ( ( overlapAlgo_ == 0 &&  vetoPackedCand( *photon, pfcand ) ) ||
+                      ( overlapAlgo_ != 0 && ( *overlapAlgo_ )( *photon, pfcand ) ) ) ) { continue; }
+
+            for( unsigned int ic = 0; ic < coneSizes.size(); ic++ ) {
+                if( dRTkToVtx > coneSizes[ic] ) { continue; }
+                isovalues[ic] += pfcand->pt();
+            }
+        }
+        for( unsigned int ic = 0; ic < coneSizes.size(); ic++ ) {
+            isomaps[ic].insert( make_pair( vtx, isovalues[ic] ) );
+        }
     }
 
-    return isomap;
+    return isomaps;
 }
 
 
@@ -196,6 +249,75 @@ float PhotonIdUtils::pfCaloIso( const edm::Ptr<pat::Photon> &photon,
     return isovalue;
 }
 
+float PhotonIdUtils::pfCaloIso( const edm::Ptr<pat::Photon> &photon,
+                                PFCandidateEtaPhiIndex &pfindex,
+                                float dRMax,
+                                float dRVetoBarrel,
+                                float dRVetoEndcap,
+                                float etaStripBarrel,
+                                float etaStripEndcap,
+                                float minEnergyBarrel,
+                                float minEnergyEndcap,
+                                reco::PFCandidate::ParticleType type,
+                                const reco::Vertex *vtx
+                              )
+{
+    static reco::PFCandidate helper;
+    int pdgId = helper.translateTypeToPdgId( type );
+
+    float isovalue = 0;
+
+    float dRVeto = 99;
+    float maxetaStrip = 99;
+
+    if( photon->isEB() ) {
+        dRVeto        = dRVetoBarrel;
+        maxetaStrip  = etaStripBarrel;
+    } else if( photon->isEE() ) {
+        dRVeto        = dRVetoEndcap;
+        maxetaStrip  = etaStripEndcap;
+    }
+
+    // with a common vertex, the cone axis is the same for all the candidates and only the cells around it are visited
+    math::XYZVector SCdirection;
+    if( vtx ) {
+        SCdirection = math::XYZVector( photon->superCluster()->x() - vtx->x(),
+                                       photon->superCluster()->y() - vtx->y(),
+                                       photon->superCluster()->z() - vtx->z()
+                                     );
+    }
+    const std::vector<unsigned int> &indices = ( vtx ? pfindex.query( pdgId, SCdirection.Eta(), SCdirection.Phi(), dRMax ) : pfindex.all( pdgId ) );
+    const std::vector<edm::Ptr<pat::PackedCandidate> > &pfcandidates = pfindex.candidates();
+
+    for( unsigned int ipf : indices ) {
+
+        const edm::Ptr<pat::PackedCandidate> &pfcand = pfcandidates[ipf];
+
+        if( photon->isEB() ) if( fabs( pfcand->pt() ) < minEnergyBarrel )     { continue; }
+        if( photon->isEE() ) if( fabs( pfcand->energy() ) < minEnergyEndcap ) { continue; }
+
+        if( removeOverlappingCandidates_ && vetoPackedCand( *photon, pfcand ) ) { continue; }
+
+        if( !vtx ) {
+            math::XYZPoint  pfcandvtx = pfcand->vertex();
+            SCdirection = math::XYZVector( photon->superCluster()->x() - pfcandvtx.x(),
+                                           photon->superCluster()->y() - pfcandvtx.y(),
+                                           photon->superCluster()->z() - pfcandvtx.z()
+                                         );
+        }
+
+        float dEta = fabs( SCdirection.Eta() - pfindex.eta( ipf ) );
+        float dR   = deltaR( SCdirection.Eta(), SCdirection.Phi(), pfindex.eta( ipf ), pfindex.phi( ipf ) );
+
+        if( dEta < maxetaStrip )        { continue; }
+        if( dR < dRVeto || dR > dRMax ) { continue; }
+
+        isovalue += pfcand->pt();
+    }
+
+    return isovalue;
+}
+
 // *****************************************************************************************************************
 //                    PHOTON MVA CALCULATION
 // *****************************************************************************************************************
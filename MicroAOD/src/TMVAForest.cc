@@ -0,0 +1,188 @@
+#include "flashgg/MicroAOD/interface/TMVAForest.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TXMLEngine.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace flashgg {
+
+    namespace {
+        XMLNodePointer_t findChild( TXMLEngine &xml, XMLNodePointer_t parent, const char *name )
+        {
+            for( XMLNodePointer_t child = xml.GetChild( parent ); child; child = xml.GetNext( child ) ) {
+                if( strcmp( xml.GetNodeName( child ), name ) == 0 ) { return child; }
+            }
+            return 0;
+        }
+
+        // TMVA stores the node attributes as Float_t
+        float floatAttr( TXMLEngine &xml, XMLNodePointer_t node, const char *name )
+        {
+            const char *value = xml.GetAttr( node, name );
+            return ( value ? strtof( value, 0 ) : 0. );
+        }
+
+        int intAttr( TXMLEngine &xml, XMLNodePointer_t node, const char *name )
+        {
+            const char *value = xml.GetAttr( node, name );
+            return ( value ? atoi( value ) : 0 );
+        }
+    }
+
+    TMVAForest::TMVAForest( const std::string &weightFile ) :
+        gradBoost_( false ),
+        useYesNoLeaf_( true ),
+        norm_( 0. )
+    {
+        TXMLEngine xml;
+        XMLDocPointer_t doc = xml.ParseFile( weightFile.c_str() );
+        if( !doc ) {
+            throw cms::Exception( "Configuration" ) << "TMVAForest: cannot parse " << weightFile;
+        }
+        XMLNodePointer_t root = xml.DocGetRootElement( doc );
+
+        std::string boostType = "AdaBoost";
+        if( XMLNodePointer_t options = findChild( xml, root, "Options" ) ) {
+            for( XMLNodePointer_t option = xml.GetChild( options ); option; option = xml.GetNext( option ) ) {
+                const char *name = xml.GetAttr( option, "name" );
+                const char *content = xml.GetNodeContent( option );
+                if( !name || !content ) { continue; }
+                if( strcmp( name, "BoostType" ) == 0 ) { boostType = content; }
+                if( strcmp( name, "UseYesNoLeaf" ) == 0 ) { useYesNoLeaf_ = ( strcmp( content, "True" ) == 0 ); }
+            }
+        }
+        if( boostType == "Grad" ) {
+            gradBoost_ = true;
+        } else if( boostType != "AdaBoost" && boostType != "Bagging" ) {
+            xml.FreeDoc( doc );
+            throw cms::Exception( "Configuration" ) << "TMVAForest: unsupported BoostType " << boostType << " in " << weightFile;
+        }
+
+        XMLNodePointer_t transformations = findChild( xml, root, "Transformations" );
+        const char *ntransformations = ( transformations ? xml.GetAttr( transformations, "NTransformations" ) : 0 );
+        if( ntransformations && atoi( ntransformations ) != 0 ) {
+            xml.FreeDoc( doc );
+            throw cms::Exception( "Configuration" ) << "TMVAForest: input variable transformations are not supported (" << weightFile << ")";
+        }
+
+        if( XMLNodePointer_t variables = findChild( xml, root, "Variables" ) ) {
+            for( XMLNodePointer_t variable = xml.GetChild( variables ); variable; variable = xml.GetNext( variable ) ) {
+                const char *expression = xml.GetAttr( variable, "Expression" );
+                variables_.push_back( expression ? expression : "" );
+            }
+        }
+
+        XMLNodePointer_t weights = findChild( xml, root, "Weights" );
+        if( !weights ) {
+            xml.FreeDoc( doc );
+            throw cms::Exception( "Configuration" ) << "TMVAForest: no Weights in " << weightFile;
+        }
+        try {
+            for( XMLNodePointer_t tree = xml.GetChild( weights ); tree; tree = xml.GetNext( tree ) ) {
+                if( strcmp( xml.GetNodeName( tree ), "BinaryTree" ) != 0 ) { continue; }
+                XMLNodePointer_t top = findChild( xml, tree, "Node" );
+                if( !top ) { continue; }
+                const char *boostWeight = xml.GetAttr( tree, "boostWeight" );
+                boostWeights_.push_back( boostWeight ? atof( boostWeight ) : 1. );
+                norm_ += boostWeights_.back();
+                roots_.push_back( readNode( &xml, top, weightFile ) );
+            }
+        } catch( ... ) {
+            xml.FreeDoc( doc );
+            throw;
+        }
+        xml.FreeDoc( doc );
+    }
+
+    int TMVAForest::readNode( void *engine, void *node, const std::string &weightFile )
+    {
+        TXMLEngine &xml = *static_cast<TXMLEngine *>( engine );
+        XMLNodePointer_t left = 0, right = 0;
+        for( XMLNodePointer_t child = xml.GetChild( node ); child; child = xml.GetNext( child ) ) {
+            if( strcmp( xml.GetNodeName( child ), "Node" ) != 0 ) { continue; }
+            const char *pos = xml.GetAttr( child, "pos" );
+            if( pos && pos[0] == 'l' ) { left = child; }
+            if( pos && pos[0] == 'r' ) { right = child; }
+        }
+
+        if( !left || !right ) {
+            if( gradBoost_ ) {
+                leaves_.push_back( floatAttr( xml, node, "res" ) );
+            } else if( useYesNoLeaf_ ) {
+                leaves_.push_back( intAttr( xml, node, "nType" ) );
+            } else {
+                leaves_.push_back( floatAttr( xml, node, "purity" ) );
+            }
+            return -( int )leaves_.size();
+        }
+
+        int ivar = intAttr( xml, node, "IVar" );
+        if( ivar < 0 || ( size_t )ivar >= variables_.size() ) {
+            throw cms::Exception( "Configuration" ) << "TMVAForest: node on variable " << ivar << " in " << weightFile;
+        }
+        // TMVA goes right if ( x >= cut ) == cType
+        bool cType = ( intAttr( xml, node, "cType" ) != 0 );
+        int inode = var_.size();
+        var_.push_back( ivar );
+        cut_.push_back( floatAttr( xml, node, "Cut" ) );
+        left_.push_back( 0 );
+        right_.push_back( 0 );
+        int l = readNode( engine, left, weightFile );
+        int r = readNode( engine, right, weightFile );
+        left_[inode] = ( cType ? l : r );
+        right_[inode] = ( cType ? r : l );
+        return inode;
+    }
+
+    void TMVAForest::evaluate( const float *rows, size_t nrows, double *scores ) const
+    {
+        const size_t nvars = variables_.size();
+        for( size_t irow = 0 ; irow < nrows ; irow++ ) { scores[irow] = 0.; }
+        for( size_t itree = 0 ; itree < roots_.size() ; itree++ ) {
+            const double weight = ( gradBoost_ ? 1. : boostWeights_[itree] );
+            for( size_t irow = 0 ; irow < nrows ; irow++ ) {
+                const float *row = rows + irow * nvars;
+                int inode = roots_[itree];
+                while( inode >= 0 ) {
+                    inode = ( row[var_[inode]] >= cut_[inode] ? right_[inode] : left_[inode] );
+                }
+                scores[irow] += weight * leaves_[-inode - 1];
+            }
+        }
+        for( size_t irow = 0 ; irow < nrows ; irow++ ) {
+            if( gradBoost_ ) {
+                scores[irow] = 2.0 / ( 1.0 + exp( -2.0 * scores[irow] ) ) - 1;
+            } else {
+                scores[irow] = ( norm_ > std::numeric_limits<double>::epsilon() ? scores[irow] / norm_ : 0. );
+            }
+        }
+    }
+
+    std::shared_ptr<const TMVAForest> TMVAForest::get( const std::string &weightFile )
+    {
+        static std::mutex mutex;
+        static std::map<std::string, std::weak_ptr<const TMVAForest> > forests;
+        std::lock_guard<std::mutex> lock( mutex );
+        auto forest = forests[weightFile].lock();
+        if( !forest ) {
+            forest = std::make_shared<const TMVAForest>( weightFile );
+            forests[weightFile] = forest;
+        }
+        return forest;
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -0,0 +1,181 @@
+// Compares the precompiled mode of BTagCalibrationReader with the TF1 path, for every
+// operating point, measurement type, flavour and systematic of a calibration file, over
+// a dense grid of eta, pt and discriminator points that includes each bin edge and the
+// floats next to it. Reports the number of differing results and the time taken by each mode.
+// Usage: validate_btag_calibration calibration.csv [newFormat=1] [pointsPerAxis=100]
+
+#include "flashgg/Systematics/interface/BTagCalibrationStandalone.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    struct Axis {
+        set<float> edges;
+        float lo = numeric_limits<float>::max();
+        float hi = -numeric_limits<float>::max();
+
+        void add( float edge )
+        {
+            edges.insert( edge );
+            // the open-ended bounds of the files (e.g. 99999) would stretch the grid
+            if( fabs( edge ) < 5000. ) {
+                lo = min( lo, edge );
+                hi = max( hi, edge );
+            }
+        }
+
+        vector<float> points( int n, bool symmetric ) const
+        {
+            vector<float> result;
+            float first = ( lo <= hi ? lo : 0. ), last = ( lo <= hi ? hi : 1. );
+            if( symmetric ) { first = min( first, -last ); }
+            float margin = 0.1 * ( last - first ) + 1.;
+            for( int i = 0 ; i <= n ; i++ ) { result.push_back( first - margin + ( last - first + 2 * margin ) * i / n ); }
+            for( float edge : edges ) {
+                for( float sign : { 1.f, -1.f } ) {
+                    if( sign < 0. && !symmetric ) { continue; }
+                    result.push_back( sign * edge );
+                    result.push_back( nextafter( sign * edge, numeric_limits<float>::infinity() ) );
+                    result.push_back( nextafter( sign * edge, -numeric_limits<float>::infinity() ) );
+                    // the points moved inside the pt range by eval_auto_bounds
+                    result.push_back( sign * edge + 0.0001f );
+                    result.push_back( sign * edge - 0.0001f );
+                }
+            }
+            return result;
+        }
+    };
+
+    struct Selection {
+        set<string> sysTypes;
+        set<int> flavours;
+        Axis eta, pt, discr;
+    };
+}
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 2 ) {
+        cerr << "Usage: " << argv[0] << " calibration.csv [newFormat=1] [pointsPerAxis=100]" << endl;
+        return 1;
+    }
+    string fileName = argv[1];
+    bool newFormat = ( argc > 2 ? atoi( argv[2] ) != 0 : true );
+    int nPoints = ( argc > 3 ? atoi( argv[3] ) : 100 );
+
+    // what the file contains, by (operating point, measurement type)
+    BTagCalibration calib( "validation", fileName, newFormat );
+    map<pair<int, string>, Selection> selections;
+    ifstream in( fileName );
+    string line;
+    while( getline( in, line ) ) {
+        line = BTagEntry::trimStr( line );
+        if( line.empty() || line.find( "OperatingPoint" ) != string::npos ) { continue; }
+        BTagEntry entry( line, newFormat );
+        Selection &sel = selections[make_pair( int( entry.params.operatingPoint ), entry.params.measurementType )];
+        sel.sysTypes.insert( entry.params.sysType );
+        sel.flavours.insert( entry.params.jetFlavor );
+        sel.eta.add( entry.params.etaMin );
+        sel.eta.add( entry.params.etaMax );
+        sel.pt.add( entry.params.ptMin );
+        sel.pt.add( entry.params.ptMax );
+        sel.discr.add( entry.params.discrMin );
+        sel.discr.add( entry.params.discrMax );
+    }
+
+    long nTotal = 0, nDiffTotal = 0;
+    for( auto &item : selections ) {
+        auto op = BTagEntry::OperatingPoint( item.first.first );
+        const string &measurement = item.first.second;
+        Selection &sel = item.second;
+        if( !sel.sysTypes.count( "central" ) ) {
+            cout << "Skipping operating point " << op << ", " << measurement << ": no central entries" << endl;
+            continue;
+        }
+        vector<string> others;
+        for( auto &sys : sel.sysTypes ) {
+            if( sys != "central" ) { others.push_back( sys ); }
+        }
+
+        BTagCalibrationReader tf1Reader( op, "central", others );
+        BTagCalibrationReader fastReader( op, "central", others, true );
+        for( int jf : sel.flavours ) {
+            tf1Reader.load( calib, BTagEntry::JetFlavor( jf ), measurement );
+            fastReader.load( calib, BTagEntry::JetFlavor( jf ), measurement );
+        }
+
+        bool useDiscr = ( op == BTagEntry::OP_RESHAPING );
+        vector<float> etas = sel.eta.points( nPoints / 4, true );
+        vector<float> pts = sel.pt.points( nPoints, false );
+        vector<float> discrs = ( useDiscr ? sel.discr.points( nPoints, false ) : vector<float>( 1, 0. ) );
+        etas.push_back( numeric_limits<float>::quiet_NaN() );
+        pts.push_back( numeric_limits<float>::quiet_NaN() );
+
+        vector<string> sysTypes( 1, "central" );
+        sysTypes.insert( sysTypes.end(), others.begin(), others.end() );
+        vector<int> sysIndices;
+        for( auto &sys : sysTypes ) { sysIndices.push_back( fastReader.sysIndex( sys ) ); }
+
+        long n = 0, nDiff = 0;
+        double maxDiff = 0., tTF1 = 0., tFast = 0.;
+        vector<double> reference( pts.size() ), result( pts.size() );
+        for( int jf : sel.flavours ) {
+            for( unsigned isys = 0 ; isys < sysTypes.size() ; isys++ ) {
+                for( float eta : etas ) {
+                    for( float discr : discrs ) {
+                        auto t0 = chrono::steady_clock::now();
+                        for( unsigned ipt = 0 ; ipt < pts.size() ; ipt++ ) {
+                            reference[ipt] = tf1Reader.eval_auto_bounds( sysTypes[isys], BTagEntry::JetFlavor( jf ), eta, pts[ipt], discr );
+                        }
+                        auto t1 = chrono::steady_clock::now();
+                        for( unsigned ipt = 0 ; ipt < pts.size() ; ipt++ ) {
+                            result[ipt] = fastReader.eval_auto_bounds( sysIndices[isys], BTagEntry::JetFlavor( jf ), eta, pts[ipt], discr );
+                        }
+                        auto t2 = chrono::steady_clock::now();
+                        tTF1 += chrono::duration<double>( t1 - t0 ).count();
+                        tFast += chrono::duration<double>( t2 - t1 ).count();
+
+                        for( unsigned ipt = 0 ; ipt < pts.size() ; ipt++ ) {
+                            n++;
+                            if( reference[ipt] == result[ipt] || ( std::isnan( reference[ipt] ) && std::isnan( result[ipt] ) ) ) { continue; }
+                            if( nDiff++ < 10 ) {
+                                cout << "  differs: flavour " << jf << " " << sysTypes[isys] << " eta " << eta << " pt " << pts[ipt] << " discr " << discr
+                                     << ": " << reference[ipt] << " (TF1) " << result[ipt] << " (precompiled)" << endl;
+                            }
+                            maxDiff = max( maxDiff, fabs( reference[ipt] - result[ipt] ) );
+                        }
+                    }
+                }
+            }
+        }
+        cout << "Operating point " << op << ", " << measurement << ": " << sel.flavours.size() << " flavours, " << sysTypes.size() << " systematics, "
+             << fastReader.nTF1Formulas() << " of " << tf1Reader.nTF1Formulas() << " formulas left to TF1" << endl;
+        cout << "  " << n << " points, " << nDiff << " differ (max " << maxDiff << "); TF1 " << tTF1 << " s, precompiled " << tFast << " s, speedup "
+             << tTF1 / max( tFast, 1e-9 ) << endl;
+        nTotal += n;
+        nDiffTotal += nDiff;
+    }
+    cout << nTotal << " points, " << nDiffTotal << " differ" << endl;
+    return ( nDiffTotal == 0 ? 0 : 2 );
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -143,6 +143,12 @@ protected:
  * Helper class to pull out a specific set of BTagEntry's out of a
  * BTagCalibration. TF1 functions are set up at initialization time.
  *
+ * In precompiled mode, load() also turns the entries of each flavour and
+ * systematic into a lookup table over the eta, pt and discriminator bin
+ * edges, and the formulas into closures (the few it cannot compile exactly
+ * are left to their TF1). The results are the same as with the TF1 path.
+ * The systematics can then be addressed by index, see sysIndex().
+ *
  ************************************************************/
 
 #include <memory>
@@ -158,7 +164,8 @@ public:
   BTagCalibrationReader() {}
   BTagCalibrationReader(BTagEntry::OperatingPoint op,
                         const std::string & sysType="central",
-                        const std::vector<std::string> & otherSysTypes={});
+                        const std::vector<std::string> & otherSysTypes={},
+                        bool precompiled=false);
 
   void load(const BTagCalibration & c,
             BTagEntry::JetFlavor jf,
@@ -175,9 +182,21 @@ public:
                           float pt,
                           float discr=0.) const;
 
+  // 0 for sysType, i+1 for otherSysTypes[i]
+  int sysIndex(const std::string & sys) const;
+
+  double eval_auto_bounds(int sysIndex,
+                          BTagEntry::JetFlavor jf,
+                          float eta,
+                          float pt,
+                          float discr=0.) const;
+
   std::pair<float, float> min_max_pt(BTagEntry::JetFlavor jf,
                                      float eta,
                                      float discr=0.) const;
+
+  // formulas evaluated with TF1 in precompiled mode, over all flavours and systematics
+  unsigned nTF1Formulas() const;
 protected:
   std::shared_ptr<BTagCalibrationReaderImpl> pimpl;
 };
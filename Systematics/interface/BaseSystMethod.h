@@ -45,6 +45,16 @@ namespace flashgg {
             throw cms::Exception( "NotImplemented" ) << " concrete classes need only implement one of applyCorrection or makeWeight - check class setup";
         }
 
+        // weights of the same object for several shifts, in the order of syst_values;
+        // methods that can share their lookups between the shifts override this
+        virtual void makeWeights( const flashgg_object &y, const std::vector<param_var> &syst_values, std::vector<float> &weights )
+        {
+            weights.resize( syst_values.size() );
+            for( unsigned int i = 0 ; i < syst_values.size() ; i++ ) {
+                weights[i] = makeWeight( y, syst_values[i] );
+            }
+        }
+
         const std::string &name() const { return _Name; };
         const std::string &label() const { return _Label; };
         bool makesWeight() const { return _MakesWeight; }
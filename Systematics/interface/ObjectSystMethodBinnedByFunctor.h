@@ -5,6 +5,7 @@
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "DataFormats/Common/interface/Handle.h"
 #include "CommonTools/Utils/interface/StringObjectFunction.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
 
 #include "flashgg/MicroAOD/interface/GlobalVariablesComputer.h"
 
@@ -32,10 +33,10 @@ namespace flashgg {
     };
         
 
-    template<class flashgg_object> class WrappedStringObjectFunctor : public ObjectFunctorTrait<flashgg_object>, StringObjectFunction<flashgg_object>
+    template<class flashgg_object> class WrappedStringObjectFunctor : public ObjectFunctorTrait<flashgg_object>, CompiledObjectFunction<flashgg_object>
     {
     public:
-        WrappedStringObjectFunctor(const std::string & expr) : StringObjectFunction<flashgg_object>(expr,true) {};
+        WrappedStringObjectFunctor(const std::string & expr) : CompiledObjectFunction<flashgg_object>(expr,true) {};
         
         double eval(const flashgg_object & obj) const { return this->operator()(obj); };
     };
@@ -2,7 +2,7 @@
 #define FLASHgg_ObjectSystematicProducer_h
 
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Utilities/interface/InputTag.h"
 #include "DataFormats/Common/interface/Handle.h"
 #include "FWCore/Framework/interface/Event.h"
@@ -11,6 +11,7 @@
 #include "TrackingTools/IPTools/interface/IPTools.h"
 
 #include "flashgg/Systematics/interface/BaseSystMethod.h"
+#include "flashgg/DataFormats/interface/DiPhotonCandidate.h"
 
 #include "flashgg/MicroAOD/interface/GlobalVariablesComputer.h"
 
@@ -25,8 +26,14 @@ using namespace std;
 
 namespace flashgg {
 
+    // Lets an output object refer to the input object it was corrected from instead of copying
+    // what it shares with it; only diphotons support it, storing their photons as deltas
+    template <typename flashgg_object>
+    void compactObject( flashgg_object &, const edm::Ptr<flashgg_object> & ) {}
+    inline void compactObject( DiPhotonCandidate &y, const edm::Ptr<DiPhotonCandidate> &base ) { y.compactPhotons( base ); }
+
     template <typename flashgg_object, typename param_var, template <typename...> class output_container>
-    class ObjectSystematicProducer : public edm::EDProducer
+    class ObjectSystematicProducer : public edm::stream::EDProducer<>
     {
     public:
 
@@ -45,12 +52,35 @@ namespace flashgg {
                                pair<param_var, param_var>  syst_shift );
         void ApplyNonCentralWeights( flashgg_object &y );
 
+        // Central chain split into steps: the 1D corrections followed by the 2D ones.
+        // ApplyCentralCorrections keeps a copy of the object (and of the running weight)
+        // just before each step that has shifted collections, so that a shift only
+        // needs to re-run the varied step and the ones after it
+        void ApplyCentralStep( flashgg_object &y, unsigned int step, float &theWeight );
+        void ApplyCentralCorrections( flashgg_object &y, std::vector<flashgg_object> &snapshots, std::vector<float> &snapshotWeights );
+        template <typename shift_type>
+        void ApplyCorrectionsFromStep( flashgg_object &y, float theWeight, unsigned int step,
+                                       shared_ptr<BaseSystMethod<flashgg_object, shift_type> > CorrToShift, shift_type syst_shift );
+
         edm::EDGetTokenT<View<flashgg_object> > ObjectToken_;
 
+        bool cacheCentralChain_;
+        bool compactOutput_;
+        std::vector<int> snapshotIndex_; // per step, position in the snapshot list or -1
+
         std::vector<std::vector<param_var> > sigmas_;
         std::vector<std::string> collectionLabelsNonCentral_;
 
         std::vector<std::vector<pair<param_var, param_var> > > sigmas2D_;
+
+        // Central weight of each weight-type step, as evaluated by the last ApplyCentralStep, and
+        // whether no object-modifying correction follows that step in the chain, in which case
+        // the weight is still valid for the fully corrected object
+        std::vector<float> centralWeights_;
+        std::vector<bool> weightIsFinal_;
+        std::vector<param_var> shifts_;
+        std::vector<pair<param_var, param_var> > shifts2D_;
+        std::vector<float> shiftWeights_;
     };
 
     template <typename flashgg_object, typename param_var, template <typename...> class output_container>
@@ -58,6 +88,10 @@ namespace flashgg {
         globalVars_(iConfig),
         ObjectToken_( consumes<View<flashgg_object> >( iConfig.getParameter<InputTag>( "src" ) ) )
     {
+        cacheCentralChain_ = iConfig.exists( "CacheCentralChain" ) ? iConfig.getParameter<bool>( "CacheCentralChain" ) : true;
+        // Opt-in: compacted outputs can only be read back from files that also keep the input collection
+        compactOutput_ = iConfig.exists( "CompactOutput" ) ? iConfig.getParameter<bool>( "CompactOutput" ) : false;
+
         //        edm::Service<edm::RandomNumberGenerator> rng;
         //        if( ! rng.isAvailable() ) {
         //            throw cms::Exception( "Configuration" ) << "ObjectSystematicProducer requires the RandomNumberGeneratorService  - please add to configuration";
@@ -139,6 +173,27 @@ namespace flashgg {
 
             ipset2D++;
         }
+
+        // Same conditions as the shifted collection loops in produce()
+        int nsnapshots = 0;
+        for( unsigned int ncorr = 0 ; ncorr < Corrections_.size() ; ncorr++ ) {
+            bool shifted = ( !Corrections_.at( ncorr )->makesWeight() && !sigmas_.at( ncorr ).empty() );
+            snapshotIndex_.push_back( shifted ? nsnapshots++ : -1 );
+        }
+        for( unsigned int ncorr = 0 ; ncorr < Corrections2D_.size() ; ncorr++ ) {
+            bool shifted = ( !Corrections_.at( ncorr )->makesWeight() && !sigmas2D_.at( ncorr ).empty() );
+            snapshotIndex_.push_back( shifted ? nsnapshots++ : -1 );
+        }
+
+        centralWeights_.assign( snapshotIndex_.size(), 1. );
+        weightIsFinal_.assign( snapshotIndex_.size(), false );
+        bool correctionFollows = false;
+        for( unsigned int step = snapshotIndex_.size() ; step-- > 0 ; ) {
+            bool isWeight = ( step < Corrections_.size() ? Corrections_.at( step )->makesWeight()
+                              : Corrections2D_.at( step - Corrections_.size() )->makesWeight() );
+            weightIsFinal_[step] = ( isWeight && !correctionFollows );
+            if( !isWeight ) { correctionFollows = true; }
+        }
     }
 
     ///fucntion takes in the current corection one is looping through and compares with its own internal loop, given that this will be within the corr and sys loop it takes care of the 2n+1 collection number////
@@ -148,42 +203,19 @@ namespace flashgg {
             param_var syst_shift )
     {
         float theWeight = 1.;
-        //        std::cout << " 1d before 1d " << std::endl;
         //        std::cout << " In ObjectSystematicProducer::ApplyCorrections pt m " << y.pt() << " " << y.mass() << std::endl;
         for( unsigned int ncorr = 0; ncorr < Corrections_.size(); ncorr++ ) {
             if( CorrToShift == Corrections_.at( ncorr ) ) {
                 Corrections_.at( ncorr )->applyCorrection( y, syst_shift );
-            } else if( Corrections_.at( ncorr )->makesWeight() ) {
-                //                std::cout << " Setting weight for " << Corrections_.at( ncorr )->shiftLabel( 0 ) <<
-                //                    " to " << Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) ) << std::endl;
-                y.setWeight( Corrections_.at( ncorr )->shiftLabel( 0 ), Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) ) ); // use very carefully, n.b. not scaled
-                theWeight *= Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) );
             } else {
-                Corrections_.at( ncorr )->applyCorrection( y, param_var( 0 ) );
+                ApplyCentralStep( y, ncorr, theWeight );
             }
         }
-        //        std::cout << " 1d before 2d " << std::endl;
         for( unsigned int ncorr = 0; ncorr < Corrections2D_.size(); ncorr++ ) {
-            //            std::cout << " 2d ncorr=" << ncorr << "/" << Corrections2D_.size() << std::endl;
-            if( Corrections2D_.at( ncorr )->makesWeight() ) {
-                y.setWeight( Corrections2D_.at( ncorr )->shiftLabel( PAIR_ZERO ), Corrections2D_.at( ncorr )->makeWeight( y, PAIR_ZERO ) ); // use very carefully, n.b. not scaled
-                theWeight *= Corrections2D_.at( ncorr )->makeWeight( y, PAIR_ZERO );
-                //                std::cout << " 2d changed the weight to" << theWeight << std::endl;
-                //                std::cout << "    " << Corrections2D_.at( ncorr )->shiftLabel( PAIR_ZERO ) << std::endl;
-            } else {
-                Corrections2D_.at( ncorr )->applyCorrection( y, PAIR_ZERO );
-                //                std::cout << " 2d applied correction " << std::endl;
-                //                std::cout << "    " << Corrections2D_.at( ncorr )->shiftLabel( PAIR_ZERO ) << std::endl;
-            }
+            ApplyCentralStep( y, Corrections_.size() + ncorr, theWeight );
         }
         //        std::cout << " Applied a central weight of " << theWeight << " - as part of 1d shift" << std::endl;
-        //        if( CorrToShift == nullptr ) {
-        //            std::cout << "   Shift was central " << std::endl;
-        //        } else {
-        //            std::cout << "   Shift was " << CorrToShift->shiftLabel( syst_shift ) << std::endl;
-        //        }
         y.setCentralWeight( theWeight );
-        //        std::cout << " 1d end " << std::endl;
     }
 
     template <typename flashgg_object, typename param_var, template <typename...> class output_container>
@@ -193,51 +225,109 @@ namespace flashgg {
     {
         float theWeight = 1.;
         //        std::cout << " In ObjectSystematicProducer::ApplyCorrections pt m " << y.pt() << " " << y.mass() << std::endl;
-        //        std::cout << "2d before 1d" << std::endl;
         for( unsigned int ncorr = 0; ncorr < Corrections_.size(); ncorr++ ) {
-            if( Corrections_.at( ncorr )->makesWeight() ) {
-                //                std::cout << " Setting weight for " << Corrections_.at( ncorr )->shiftLabel( 0 ) << 
-                //                    " to " << Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) ) << std::endl;
-                y.setWeight( Corrections_.at( ncorr )->shiftLabel( 0 ), Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) ) ); // use very carefully, n.b. not scaled
-                theWeight *= Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) );
-            } else {
-                Corrections_.at( ncorr )->applyCorrection( y, param_var( 0 ) );
-            }
+            ApplyCentralStep( y, ncorr, theWeight );
         }
-        //        std::cout << "2d before 2d" << std::endl;
         for( unsigned int ncorr = 0; ncorr < Corrections2D_.size(); ncorr++ ) {
             if( CorrToShift == Corrections2D_.at( ncorr ) ) {
                 Corrections2D_.at( ncorr )->applyCorrection( y, syst_shift );
-            } else if( Corrections2D_.at( ncorr )->makesWeight() ) {
-                y.setWeight( Corrections2D_.at( ncorr )->shiftLabel( PAIR_ZERO ),
-                             Corrections2D_.at( ncorr )->makeWeight( y, PAIR_ZERO ) ); // use very carefully, n.b. not scaled        
-                theWeight *= Corrections2D_.at( ncorr )->makeWeight( y, PAIR_ZERO );
             } else {
-                Corrections2D_.at( ncorr )->applyCorrection( y, PAIR_ZERO );
+                ApplyCentralStep( y, Corrections_.size() + ncorr, theWeight );
             }
         }
         y.setCentralWeight( theWeight );
         //        std::cout << " Applied a central weight of " << theWeight << " - as part of 2d shift" << std::endl;
     }
 
+    template <typename flashgg_object, typename param_var, template <typename...> class output_container>
+    void ObjectSystematicProducer<flashgg_object, param_var, output_container>::ApplyCentralStep( flashgg_object &y, unsigned int step, float &theWeight )
+    {
+        if( step < Corrections_.size() ) {
+            if( Corrections_.at( step )->makesWeight() ) {
+                float weight = Corrections_.at( step )->makeWeight( y, param_var( 0 ) );
+                centralWeights_[step] = weight;
+                y.setWeight( Corrections_.at( step )->shiftLabel( 0 ), weight ); // use very carefully, n.b. not scaled
+                theWeight *= weight;
+            } else {
+                Corrections_.at( step )->applyCorrection( y, param_var( 0 ) );
+            }
+        } else {
+            unsigned int ncorr = step - Corrections_.size();
+            if( Corrections2D_.at( ncorr )->makesWeight() ) {
+                float weight = Corrections2D_.at( ncorr )->makeWeight( y, PAIR_ZERO );
+                centralWeights_[step] = weight;
+                y.setWeight( Corrections2D_.at( ncorr )->shiftLabel( PAIR_ZERO ), weight ); // use very carefully, n.b. not scaled
+                theWeight *= weight;
+            } else {
+                Corrections2D_.at( ncorr )->applyCorrection( y, PAIR_ZERO );
+            }
+        }
+    }
+
+    template <typename flashgg_object, typename param_var, template <typename...> class output_container>
+    void ObjectSystematicProducer<flashgg_object, param_var, output_container>::ApplyCentralCorrections( flashgg_object &y,
+            std::vector<flashgg_object> &snapshots, std::vector<float> &snapshotWeights )
+    {
+        float theWeight = 1.;
+        snapshots.clear();
+        snapshotWeights.clear();
+        for( unsigned int step = 0 ; step < snapshotIndex_.size() ; step++ ) {
+            if( snapshotIndex_[step] >= 0 ) {
+                snapshots.push_back( y );
+                snapshotWeights.push_back( theWeight );
+            }
+            ApplyCentralStep( y, step, theWeight );
+        }
+        y.setCentralWeight( theWeight );
+    }
+
+    template <typename flashgg_object, typename param_var, template <typename...> class output_container>
+    template <typename shift_type>
+    void ObjectSystematicProducer<flashgg_object, param_var, output_container>::ApplyCorrectionsFromStep( flashgg_object &y, float theWeight, unsigned int step,
+            shared_ptr<BaseSystMethod<flashgg_object, shift_type> > CorrToShift, shift_type syst_shift )
+    {
+        CorrToShift->applyCorrection( y, syst_shift );
+        for( unsigned int next = step + 1 ; next < snapshotIndex_.size() ; next++ ) {
+            ApplyCentralStep( y, next, theWeight );
+        }
+        y.setCentralWeight( theWeight );
+    }
+
+    // Must follow the central pass of the same object: the central weights it left in centralWeights_
+    // are reused as the denominators of the steps that no correction follows, the others are
+    // evaluated again on the corrected object together with the shifts
     template <typename flashgg_object, typename param_var, template <typename...> class output_container>
     void ObjectSystematicProducer<flashgg_object, param_var, output_container>::ApplyNonCentralWeights( flashgg_object &y )
     {
         for( unsigned int ncorr = 0; ncorr < Corrections_.size(); ncorr++ ) {
-            if( Corrections_.at( ncorr )->makesWeight() ) {
-                for( const auto &sig : sigmas_.at( ncorr ) ) {
-                    float weightAdjust = ( Corrections_.at( ncorr )->makeWeight( y, sig ) / Corrections_.at( ncorr )->makeWeight( y, param_var( 0 ) ) );
-                    std::string label = Corrections_.at( ncorr )->shiftLabel( sig );
+            if( Corrections_.at( ncorr )->makesWeight() && !sigmas_.at( ncorr ).empty() ) {
+                bool cached = weightIsFinal_[ncorr];
+                shifts_.clear();
+                if( !cached ) { shifts_.push_back( param_var( 0 ) ); }
+                shifts_.insert( shifts_.end(), sigmas_.at( ncorr ).begin(), sigmas_.at( ncorr ).end() );
+                Corrections_.at( ncorr )->makeWeights( y, shifts_, shiftWeights_ );
+                float central = ( cached ? centralWeights_[ncorr] : shiftWeights_[0] );
+                unsigned int ifirst = ( cached ? 0 : 1 );
+                for( unsigned int isig = 0 ; isig < sigmas_.at( ncorr ).size() ; isig++ ) {
+                    float weightAdjust = ( shiftWeights_[ifirst + isig] / central );
+                    std::string label = Corrections_.at( ncorr )->shiftLabel( sigmas_.at( ncorr )[isig] );
                     y.setWeight( label, weightAdjust * y.centralWeight() );
                     //                    std::cout << " Applying 1d non-central weight " << label << " of " << y.weight( label ) << " - pt eta " << y.pt() << " " << y.eta() << std::endl;
                 }
             }
         }
         for( unsigned int ncorr = 0; ncorr < Corrections2D_.size(); ncorr++ ) {
-            if( Corrections2D_.at( ncorr )->makesWeight() ) {
-                for( const auto &sig : sigmas2D_.at( ncorr ) ) {
-                    float weightAdjust = ( Corrections2D_.at( ncorr )->makeWeight( y, sig ) / Corrections2D_.at( ncorr )->makeWeight( y, PAIR_ZERO ) );
-                    std::string label = Corrections2D_.at( ncorr )->shiftLabel( sig );
+            if( Corrections2D_.at( ncorr )->makesWeight() && !sigmas2D_.at( ncorr ).empty() ) {
+                bool cached = weightIsFinal_[Corrections_.size() + ncorr];
+                shifts2D_.clear();
+                if( !cached ) { shifts2D_.push_back( PAIR_ZERO ); }
+                shifts2D_.insert( shifts2D_.end(), sigmas2D_.at( ncorr ).begin(), sigmas2D_.at( ncorr ).end() );
+                Corrections2D_.at( ncorr )->makeWeights( y, shifts2D_, shiftWeights_ );
+                float central = ( cached ? centralWeights_[Corrections_.size() + ncorr] : shiftWeights_[0] );
+                unsigned int ifirst = ( cached ? 0 : 1 );
+                for( unsigned int isig = 0 ; isig < sigmas2D_.at( ncorr ).size() ; isig++ ) {
+                    float weightAdjust = ( shiftWeights_[ifirst + isig] / central );
+                    std::string label = Corrections2D_.at( ncorr )->shiftLabel( sigmas2D_.at( ncorr )[isig] );
                     y.setWeight( label, weightAdjust * y.centralWeight() );
                     //                    std::cout << " Applying 2d non-central weight " << label << " of " << y.weight( label ) << " - pt eta " << y.pt() << " " << y.eta() << std::endl;
                 }
@@ -261,22 +351,6 @@ namespace flashgg {
 
         globalVars_.update(evt);
         
-        // Build central collection
-        std::vector<float> centralWeights;
-        unique_ptr<output_container<flashgg_object> > centralObjectColl( new output_container<flashgg_object> );
-        for( unsigned int i = 0; i < objects->size(); i++ ) {
-            flashgg_object *p_obj = objects->ptrAt( i )->clone();
-            flashgg_object obj = *p_obj;
-            delete p_obj;
-            ApplyCorrections( obj, nullptr, param_var( 0 ) );
-            ApplyNonCentralWeights( obj );
-            centralWeights.push_back( obj.centralWeight() );
-            centralObjectColl->push_back( obj );
-        }
-        evt.put( std::move(centralObjectColl) ); // put central collection in event
-
-        //        std::cout << " after producing central" << std::endl;
-
         // build 2N shifted collections
         // A dynamically allocated array of unique_ptrs may be a bit "unsafe" to maintain,
         // although I think I have done it correctly - the delete[] statement below is vital
@@ -288,18 +362,44 @@ namespace flashgg {
         for( unsigned int ncoll = 0 ; ncoll < total_shifted_collections ; ncoll++ ) {
             all_shifted_collections[ncoll].reset( new output_container<flashgg_object> );
         }
+
+        // With cacheCentralChain_ the central chain is run once per object, and each shifted
+        // object starts from the copy taken just before the varied correction
+        unique_ptr<output_container<flashgg_object> > centralObjectColl( new output_container<flashgg_object> );
+        std::vector<flashgg_object> snapshots;
+        std::vector<float> snapshotWeights;
         for( unsigned int i = 0; i < objects->size(); i++ ) {
+            flashgg_object obj = ( *objects )[i];
+            if( cacheCentralChain_ ) {
+                ApplyCentralCorrections( obj, snapshots, snapshotWeights );
+            } else {
+                ApplyCorrections( obj, nullptr, param_var( 0 ) );
+            }
+            ApplyNonCentralWeights( obj );
+            float centralWeight = obj.centralWeight();
+            edm::Ptr<flashgg_object> input = objects->ptrAt( i );
+            if( compactOutput_ ) { compactObject( obj, input ); }
+            centralObjectColl->push_back( obj );
+
             unsigned int ncoll = 0;
             for( unsigned int ncorr = 0 ; ncorr < Corrections_.size() ; ncorr++ ) {
                 for( const auto &sig : sigmas_.at( ncorr ) ) {
                     //                    std::cout << i << " " << ncoll << " " << sig << std::endl;
                     if( !Corrections_.at( ncorr )->makesWeight() ) {
-                        flashgg_object *p_obj = objects->ptrAt( i )->clone();
-                        flashgg_object obj = *p_obj;
-                        delete p_obj;
-                        ApplyCorrections( obj, Corrections_.at( ncorr ), sig );
-                        obj.setCentralWeight( centralWeights[i] );
-                        all_shifted_collections[ncoll]->push_back( obj );
+                        if( cacheCentralChain_ ) {
+                            int isnap = snapshotIndex_[ncorr];
+                            flashgg_object shifted = snapshots[isnap];
+                            ApplyCorrectionsFromStep( shifted, snapshotWeights[isnap], ncorr, Corrections_.at( ncorr ), sig );
+                            shifted.setCentralWeight( centralWeight );
+                            if( compactOutput_ ) { compactObject( shifted, input ); }
+                            all_shifted_collections[ncoll]->push_back( shifted );
+                        } else {
+                            flashgg_object shifted = ( *objects )[i];
+                            ApplyCorrections( shifted, Corrections_.at( ncorr ), sig );
+                            shifted.setCentralWeight( centralWeight );
+                            if( compactOutput_ ) { compactObject( shifted, input ); }
+                            all_shifted_collections[ncoll]->push_back( shifted );
+                        }
                         ncoll++;
                     }
                 }
@@ -308,17 +408,27 @@ namespace flashgg {
                 for( const auto &sig : sigmas2D_.at( ncorr ) ) {
                     //                    std::cout << i << " " << ncoll << " " << sig.first << " " << sig.second << std::endl;
                     if( !Corrections_.at( ncorr )->makesWeight() ) {
-                        flashgg_object *p_obj = objects->ptrAt( i )->clone();
-                        flashgg_object obj = *p_obj;
-                        delete p_obj;
-                        ApplyCorrections( obj, Corrections2D_.at( ncorr ), sig );
-                        obj.setCentralWeight( centralWeights[i] );
-                        all_shifted_collections[ncoll]->push_back( obj );
+                        if( cacheCentralChain_ ) {
+                            unsigned int step = Corrections_.size() + ncorr;
+                            int isnap = snapshotIndex_[step];
+                            flashgg_object shifted = snapshots[isnap];
+                            ApplyCorrectionsFromStep( shifted, snapshotWeights[isnap], step, Corrections2D_.at( ncorr ), sig );
+                            shifted.setCentralWeight( centralWeight );
+                            if( compactOutput_ ) { compactObject( shifted, input ); }
+                            all_shifted_collections[ncoll]->push_back( shifted );
+                        } else {
+                            flashgg_object shifted = ( *objects )[i];
+                            ApplyCorrections( shifted, Corrections2D_.at( ncorr ), sig );
+                            shifted.setCentralWeight( centralWeight );
+                            if( compactOutput_ ) { compactObject( shifted, input ); }
+                            all_shifted_collections[ncoll]->push_back( shifted );
+                        }
                         ncoll++;
                     }
                 }
             }
         }
+        evt.put( std::move(centralObjectColl) ); // put central collection in event
 
         // Put shifted collections in event
         for( unsigned int ncoll = 0 ; ncoll < total_shifted_collections ; ncoll++ ) {
@@ -12,15 +12,18 @@
 
 BTagCalibrationReader readerShapeB(BTagEntry::OP_RESHAPING,  // operating point
                                    "central",               // central sys type
-                                   {"up_jes", "down_jes", "up_lf", "down_lf", "up_hfstats1", "down_hfstats1", "up_hfstats2", "down_hfstats2"});        // other systematics type
+                                   {"up_jes", "down_jes", "up_lf", "down_lf", "up_hfstats1", "down_hfstats1", "up_hfstats2", "down_hfstats2"},        // other systematics type
+                                   true);                   // precompiled
 
 BTagCalibrationReader readerShapeC(BTagEntry::OP_RESHAPING,  // operating point
                                    "central",               // central sys type
-                                   {"up_cferr1", "down_cferr1", "up_cferr2", "down_cferr2"});        // other systematics type
+                                   {"up_cferr1", "down_cferr1", "up_cferr2", "down_cferr2"},        // other systematics type
+                                   true);                   // precompiled
 
 BTagCalibrationReader readerShapeUDSG(BTagEntry::OP_RESHAPING,  // operating point
                                       "central",               // central sys type
-                                      {"up_jes", "down_jes", "up_hf", "down_hf", "up_lfstats1", "down_lfstats1", "up_lfstats2", "down_lfstats2"});        // other systematics type
+                                      {"up_jes", "down_jes", "up_hf", "down_hf", "up_lfstats1", "down_lfstats1", "up_lfstats2", "down_lfstats2"},        // other systematics type
+                                      true);                   // precompiled
 
 bool isloadedReshape = false;
 
@@ -35,15 +38,24 @@ namespace flashgg {
 
         JetBTagReshapeWeight( const edm::ParameterSet &conf, edm::ConsumesCollector && iC, const GlobalVariablesComputer * gv );
         float makeWeight( const flashgg::Jet &y, int syst_shift ) override;
+        void makeWeights( const flashgg::Jet &y, const std::vector<int> &syst_shifts, std::vector<float> &weights ) override;
         std::string shiftLabel( int syst_shift ) const override;
 
     private:
+        bool scaleFactors( const flashgg::Jet &obj, double &jet_scalefactor, double &jet_scalefactor_up, double &jet_scalefactor_do );
+        float shiftedWeight( double jet_scalefactor, double jet_scalefactor_up, double jet_scalefactor_do, int syst_shift ) const;
+
         selector_type overall_range_;
         bool debug_;
         std::string bTag_;
         bool btagSFreshape_;
         int bTagReshapeSystOption_;
         BTagCalibration calibReshape_;
+        // per BTagEntry::JetFlavor, the source of uncertainty selected by bTagReshapeSystOption
+        // and the indices of its up and down variations in the reader, 0 (central) if none
+        std::string sysSource_[3];
+        int sysUp_[3];
+        int sysDown_[3];
     };
 
     JetBTagReshapeWeight::JetBTagReshapeWeight( const edm::ParameterSet &conf, edm::ConsumesCollector && iC, const GlobalVariablesComputer * gv ) : 
@@ -59,6 +71,18 @@ namespace flashgg {
         // std::string btag_algo = bTag_=="pfDeepJet" ? "DeepJet" : "pfDeepCSV" ? "DeepCSV" : "CSVv2";  //// DeepJet =  DeepFlavour
         std::string btag_algo = bTag_=="pfDeepJet" ? "DeepJet" : "DeepCSV" ;
         calibReshape_ = BTagCalibration(btag_algo, conf.getParameter<edm::FileInPath>("bTagCalibrationFile").fullPath(), conf.getParameter<bool>("isNewCSVFormat"));
+
+        // sources by bTagReshapeSystOption, for b, c and light jets
+        const std::vector<std::vector<std::string> > sources = { { "", "jes", "lf", "hfstats1", "hfstats2", "", "", "", "", "" },
+                                                                 { "", "", "", "", "", "cferr1", "cferr2", "", "", "" },
+                                                                 { "", "jes", "", "", "", "", "", "hf", "lfstats1", "lfstats2" } };
+        const BTagCalibrationReader *readers[3] = { &readerShapeB, &readerShapeC, &readerShapeUDSG };
+        for( unsigned jf = 0 ; jf < 3 ; jf++ ) {
+            bool known = ( bTagReshapeSystOption_ >= 0 && bTagReshapeSystOption_ < int( sources[jf].size() ) );
+            sysSource_[jf] = ( known ? sources[jf][bTagReshapeSystOption_] : "" );
+            sysUp_[jf] = ( sysSource_[jf].empty() ? 0 : readers[jf]->sysIndex( "up_" + sysSource_[jf] ) );
+            sysDown_[jf] = ( sysSource_[jf].empty() ? 0 : readers[jf]->sysIndex( "down_" + sysSource_[jf] ) );
+        }
     }
 
     std::string JetBTagReshapeWeight::shiftLabel( int syst_value ) const
@@ -74,14 +98,10 @@ namespace flashgg {
         return result;
     }
 
-    float JetBTagReshapeWeight::makeWeight( const flashgg::Jet &obj, int syst_shift ) 
+    // Scale factors of the jet from the calibration readers: the up and down ones are those of the
+    // source selected by bTagReshapeSystOption, or the central one. False outside the overall range
+    bool JetBTagReshapeWeight::scaleFactors( const flashgg::Jet &obj, double &jet_scalefactor, double &jet_scalefactor_up, double &jet_scalefactor_do )
     {
-
-        if( this->debug_ ) {
-            std::cout<<"In JetBTagReshapeProducer and syst_shift="<<  syst_shift <<std::endl;
-        }
-
-
         if(!isloadedReshape){
         readerShapeB.load(calibReshape_,                // calibration instance
                           BTagEntry::FLAV_B,    // btag flavour
@@ -97,140 +117,100 @@ namespace flashgg {
         isloadedReshape = true;
         }
 
-        float theWeight = 1.;
+        if( !overall_range_( obj ) ) { return false; }
 
-        if( overall_range_( obj ) ) {
-            
-            if( this->debug_ ) {
-                std::cout<<"In JetBTagReshapeProducer inside range "<<std::endl;
-            }
+        if( this->debug_ ) {
+            std::cout<<"In JetBTagReshapeProducer inside range "<<std::endl;
+        }
 
-            float central = 1., errup = 1., errdown = 1.;
+        //obtaining scale factors
 
+        //https://twiki.cern.ch/twiki/bin/view/CMS/BTagCalibration
 
-            //obtaining scale factors
+        float JetPt = obj.pt();
+        float JetEta = fabs(obj.eta());
+        int JetFlav = obj.hadronFlavour();
+        float JetBDiscriminator;
 
-            //https://twiki.cern.ch/twiki/bin/view/CMS/BTagCalibration
+        if(bTag_=="pfDeepJet") JetBDiscriminator = obj.bDiscriminator("mini_pfDeepFlavourJetTags:probb")+ obj.bDiscriminator("mini_pfDeepFlavourJetTags:probbb")+ obj.bDiscriminator("mini_pfDeepFlavourJetTags:problepb"); 
+        else JetBDiscriminator = obj.bDiscriminator("pfDeepCSVJetTags:probb")+ obj.bDiscriminator("pfDeepCSVJetTags:probbb"); //JM
+        //   else JetBDiscriminator= obj.bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
 
-            float JetPt = obj.pt();
-            float JetEta = fabs(obj.eta());
-            int JetFlav = obj.hadronFlavour();
-            float JetBDiscriminator;
+        if( this->debug_ ) {
+            std::cout << " In JetBTagReshapeWeight before calib reader: Object has pt= " << obj.pt() << " eta=" << obj.eta() << " flavour=" << obj.hadronFlavour()
+                      << " values for scale factors : "<< JetPt <<" "<< JetEta <<" "<<JetFlav 
+                      << " b-tagger = " << bTag_<< " BTag Values : "<< JetBDiscriminator <<endl;
+        }
 
-            if(bTag_=="pfDeepJet") JetBDiscriminator = obj.bDiscriminator("mini_pfDeepFlavourJetTags:probb")+ obj.bDiscriminator("mini_pfDeepFlavourJetTags:probbb")+ obj.bDiscriminator("mini_pfDeepFlavourJetTags:problepb"); 
-            else JetBDiscriminator = obj.bDiscriminator("pfDeepCSVJetTags:probb")+ obj.bDiscriminator("pfDeepCSVJetTags:probbb"); //JM
-            //   else JetBDiscriminator= obj.bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
+        //get scale factors from calib reader
+        
+        if( JetBDiscriminator < 0.0 ) JetBDiscriminator = -0.05;
+        if( JetBDiscriminator > 1.0 ) JetBDiscriminator = 1.0;
 
-            if( this->debug_ ) {
-                std::cout << " In JetBTagReshapeWeight before calib reader: " << shiftLabel( syst_shift ) << ": Object has pt= " << obj.pt() << " eta=" << obj.eta() << " flavour=" << obj.hadronFlavour()
-                          << " values for scale factors : "<< JetPt <<" "<< JetEta <<" "<<JetFlav 
-                          << " b-tagger = " << bTag_<< " BTag Values : "<< JetBDiscriminator <<endl;
-            }
+        //for the scale factor up / down variation : have to take each source one ata a time
+        
+        BTagEntry::JetFlavor jf = ( JetFlav == 5 ? BTagEntry::FLAV_B : JetFlav == 4 ? BTagEntry::FLAV_C : BTagEntry::FLAV_UDSG );
+        const BTagCalibrationReader &reader = ( jf == BTagEntry::FLAV_B ? readerShapeB : jf == BTagEntry::FLAV_C ? readerShapeC : readerShapeUDSG );
 
-            //get scale factors from calib reader
-            double jet_scalefactor = 1.0;
-            double jet_scalefactor_up =  1.0;
-            double jet_scalefactor_do =  1.0;
-            
-            if( JetBDiscriminator < 0.0 ) JetBDiscriminator = -0.05;
-            if( JetBDiscriminator > 1.0 ) JetBDiscriminator = 1.0;
-
-            //for the scale factor up / down variation : have to take each source one ata a time
-            
-            if(JetFlav == 5){// b jets
-                jet_scalefactor = readerShapeB.eval_auto_bounds("central", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);  
-                
-                jet_scalefactor_up = jet_scalefactor;
-                jet_scalefactor_do = jet_scalefactor;
-                if(bTagReshapeSystOption_ == 1){
-                    jet_scalefactor_up = readerShapeB.eval_auto_bounds("up_jes", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeB.eval_auto_bounds("down_jes", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" jes : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                } 
-                if(bTagReshapeSystOption_ == 2){
-                    jet_scalefactor_up = readerShapeB.eval_auto_bounds("up_lf", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeB.eval_auto_bounds("down_lf", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" lf : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                }
-                if(bTagReshapeSystOption_ == 3){
-                    jet_scalefactor_up = readerShapeB.eval_auto_bounds("up_hfstats1", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeB.eval_auto_bounds("down_hfstats1", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" hfstats1 : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                }
-                if(bTagReshapeSystOption_ == 4){
-                    jet_scalefactor_up = readerShapeB.eval_auto_bounds("up_hfstats2", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeB.eval_auto_bounds("down_hfstats2", BTagEntry::FLAV_B, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" hfstats2 : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                }
-
-            } else if(JetFlav == 4){// c jets
-                jet_scalefactor = readerShapeC.eval_auto_bounds("central", BTagEntry::FLAV_C, JetEta, JetPt, JetBDiscriminator); 
-                
-                jet_scalefactor_up = jet_scalefactor;
-                jet_scalefactor_do = jet_scalefactor;
-                if(bTagReshapeSystOption_ == 5){
-                    jet_scalefactor_up = readerShapeC.eval_auto_bounds("up_cferr1", BTagEntry::FLAV_C, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeC.eval_auto_bounds("down_cferr1", BTagEntry::FLAV_C, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" cferr1 : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                }
-                if(bTagReshapeSystOption_ == 6){
-                    jet_scalefactor_up = readerShapeC.eval_auto_bounds("up_cferr2", BTagEntry::FLAV_C, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeC.eval_auto_bounds("down_cferr2", BTagEntry::FLAV_C, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" cferr2 : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                }
-
-            } else {// light jets
-                jet_scalefactor = readerShapeUDSG.eval_auto_bounds("central", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator); 
-                
-                jet_scalefactor_up = jet_scalefactor;
-                jet_scalefactor_do = jet_scalefactor;
-                if(bTagReshapeSystOption_ == 1){
-                    jet_scalefactor_up = readerShapeUDSG.eval_auto_bounds("up_jes", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeUDSG.eval_auto_bounds("down_jes", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" jes : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                } 
-                if(bTagReshapeSystOption_ == 7){
-                    jet_scalefactor_up = readerShapeUDSG.eval_auto_bounds("up_hf", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeUDSG.eval_auto_bounds("down_hf", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" hf : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                } 
-                if(bTagReshapeSystOption_ == 8){
-                    jet_scalefactor_up = readerShapeUDSG.eval_auto_bounds("up_lfstats1", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeUDSG.eval_auto_bounds("down_lfstats1", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" lfstats1 : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                } 
-                if(bTagReshapeSystOption_ == 9){
-                    jet_scalefactor_up = readerShapeUDSG.eval_auto_bounds("up_lfstats2", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    jet_scalefactor_do = readerShapeUDSG.eval_auto_bounds("down_lfstats2", BTagEntry::FLAV_UDSG, JetEta, JetPt, JetBDiscriminator);
-                    if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" lfstats1 : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
-                }
-            }
-            
+        jet_scalefactor = reader.eval_auto_bounds( 0, jf, JetEta, JetPt, JetBDiscriminator );
+
+        jet_scalefactor_up = jet_scalefactor;
+        jet_scalefactor_do = jet_scalefactor;
+        if( sysUp_[jf] > 0 ) {
+            jet_scalefactor_up = reader.eval_auto_bounds( sysUp_[jf], jf, JetEta, JetPt, JetBDiscriminator );
+            jet_scalefactor_do = reader.eval_auto_bounds( sysDown_[jf], jf, JetEta, JetPt, JetBDiscriminator );
+            if( this->debug_ )  { std::cout << " In JetBTagReshapeWeight Systematics : "<<" " << sysSource_[jf] << " : "<<jet_scalefactor<<" "<<jet_scalefactor_up<<" "<<jet_scalefactor_do<<std::endl; }
+        }
+        return true;
+    }
+
+    float JetBTagReshapeWeight::shiftedWeight( double jet_scalefactor, double jet_scalefactor_up, double jet_scalefactor_do, int syst_shift ) const
+    {
+        float theWeight = 1.;
+        float central = 1., errup = 1., errdown = 1.;
+
+        if ( syst_shift < 0 ){
+            jet_scalefactor_do = abs(syst_shift) * (jet_scalefactor_do - jet_scalefactor) + jet_scalefactor;
+        }
+        if ( syst_shift > 0 ){
+            jet_scalefactor_up = abs(syst_shift) * (jet_scalefactor_up - jet_scalefactor) + jet_scalefactor;
+        }
+
+        if( this->debug_ ) {
+            std::cout << " In JetBTagReshapeWeight : " << shiftLabel( syst_shift ) << " SF type : " << btagSFreshape_
+                      << " scale factors : "<< jet_scalefactor <<" "<< jet_scalefactor_up <<" "<< jet_scalefactor_do << std::endl;
+        }
+
+        central = jet_scalefactor ;
+        errdown = jet_scalefactor_do ;
+        errup = jet_scalefactor_up ;
+                    
+        theWeight = central;
+        if ( syst_shift < 0 ) theWeight = errdown;
+        if ( syst_shift > 0 ) theWeight = errup;
+        return theWeight;
+    }
+
+    float JetBTagReshapeWeight::makeWeight( const flashgg::Jet &obj, int syst_shift ) 
+    {
+
+        if( this->debug_ ) {
+            std::cout<<"In JetBTagReshapeProducer and syst_shift="<<  syst_shift <<std::endl;
+        }
+
+        float theWeight = 1.;
+        double jet_scalefactor = 1.0;
+        double jet_scalefactor_up =  1.0;
+        double jet_scalefactor_do =  1.0;
+
+        if( scaleFactors( obj, jet_scalefactor, jet_scalefactor_up, jet_scalefactor_do ) ) {
             if( this->debug_ ) {
                 std::cout << " In JetBTagReshapeWeight after obtaining SF: " << shiftLabel( syst_shift ) << " SF type : " << btagSFreshape_  << ": Object has pt= " << obj.pt() << " eta=" << obj.eta() << " flavour=" << obj.hadronFlavour()
                            << " scale factors : "<< jet_scalefactor <<" "<< jet_scalefactor_up <<" "<< jet_scalefactor_do << std::endl;
             }
-            
-            if ( syst_shift < 0 ){
-                jet_scalefactor_do = abs(syst_shift) * (jet_scalefactor_do - jet_scalefactor) + jet_scalefactor;
-            }
-            if ( syst_shift > 0 ){
-                jet_scalefactor_up = abs(syst_shift) * (jet_scalefactor_up - jet_scalefactor) + jet_scalefactor;
-            }
-            
-            if( this->debug_ ) {
-                std::cout << " In JetBTagReshapeWeight : " << shiftLabel( syst_shift ) << " SF type : " << btagSFreshape_ << " : Object has pt= " << obj.pt() << " eta=" << obj.eta() << " flavour=" << obj.hadronFlavour()
-                          << " scale factors : "<< jet_scalefactor <<" "<< jet_scalefactor_up <<" "<< jet_scalefactor_do << std::endl;
-            }
-            
-            central = jet_scalefactor ;
-            errdown = jet_scalefactor_do ;
-            errup = jet_scalefactor_up ;
-                        
-            theWeight = central;
-            if ( syst_shift < 0 ) theWeight = errdown;
-            if ( syst_shift > 0 ) theWeight = errup;
-            
+
+            theWeight = shiftedWeight( jet_scalefactor, jet_scalefactor_up, jet_scalefactor_do, syst_shift );
+
             if( this->debug_ ) {
                 std::cout << " In JetBTagReshapeWeight : " << shiftLabel( syst_shift ) << " SF type : " << btagSFreshape_ <<  " : Object has pt= " << obj.pt() << " eta=" << obj.eta() << " flavour=" << obj.hadronFlavour()
                           << " and we apply a weight of " << theWeight << std::endl;
@@ -239,6 +219,20 @@ namespace flashgg {
         return theWeight;
     }
 
+    // The lookups are shared by all the shifts: the ObjectSystematicProducer asks for the central
+    // weight and the up and down ones together
+    void JetBTagReshapeWeight::makeWeights( const flashgg::Jet &obj, const std::vector<int> &syst_shifts, std::vector<float> &weights )
+    {
+        weights.assign( syst_shifts.size(), 1. );
+        double jet_scalefactor = 1.0;
+        double jet_scalefactor_up =  1.0;
+        double jet_scalefactor_do =  1.0;
+        if( !scaleFactors( obj, jet_scalefactor, jet_scalefactor_up, jet_scalefactor_do ) ) { return; }
+        for( unsigned int i = 0 ; i < syst_shifts.size() ; i++ ) {
+            weights[i] = shiftedWeight( jet_scalefactor, jet_scalefactor_up, jet_scalefactor_do, syst_shifts[i] );
+        }
+    }
+
 }
 
 DEFINE_EDM_PLUGIN( FlashggSystematicJetMethodsFactory,
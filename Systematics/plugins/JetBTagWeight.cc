@@ -10,15 +10,19 @@
 
 //For medium working point
 
-BTagCalibrationReader readerMedB(BTagEntry::OP_MEDIUM, "central", {"up", "down"}); //readerMedB.load(calib, BTagEntry::FLAV_B, "comb"); 
+BTagCalibrationReader readerMedB(BTagEntry::OP_MEDIUM, "central", {"up", "down"}, true); //readerMedB.load(calib, BTagEntry::FLAV_B, "comb"); 
 
-BTagCalibrationReader readerMedC(BTagEntry::OP_MEDIUM, "central", {"up", "down"}); //readerMedC.load(calib, BTagEntry::FLAV_C, "comb");   // operating point
+BTagCalibrationReader readerMedC(BTagEntry::OP_MEDIUM, "central", {"up", "down"}, true); //readerMedC.load(calib, BTagEntry::FLAV_C, "comb");   // operating point
                                // "central",               // central sys type
                                // {"up", "down"});        // other systematics type
-BTagCalibrationReader readerMedUDSG(BTagEntry::OP_MEDIUM,  "central", {"up", "down"}); //readerMedUDSG.load(calib, BTagEntry::FLAV_UDSG, "comb");  // operating point
+BTagCalibrationReader readerMedUDSG(BTagEntry::OP_MEDIUM,  "central", {"up", "down"}, true); //readerMedUDSG.load(calib, BTagEntry::FLAV_UDSG, "comb");  // operating point
                                // "central",               // central sys type
                                // {"up", "down"});        // other systematics type
 
+// sysIndex of the other systematics types above
+const int sysIndexUp = 1;
+const int sysIndexDown = 2;
+
 bool isloaded = false;
 
 
@@ -157,17 +161,17 @@ namespace flashgg {
             // if(!btagSFreshape_){ //for medium WP
 
                 if(JetFlav == 5){// b jets
-                    jet_scalefactor = readerMedB.eval_auto_bounds("central", BTagEntry::FLAV_B, JetEta, JetPt); 
-                    jet_scalefactor_up = readerMedB.eval_auto_bounds("up", BTagEntry::FLAV_B, JetEta, JetPt);
-                    jet_scalefactor_do = readerMedB.eval_auto_bounds("down", BTagEntry::FLAV_B, JetEta, JetPt);
+                    jet_scalefactor = readerMedB.eval_auto_bounds(0, BTagEntry::FLAV_B, JetEta, JetPt); 
+                    jet_scalefactor_up = readerMedB.eval_auto_bounds(sysIndexUp, BTagEntry::FLAV_B, JetEta, JetPt);
+                    jet_scalefactor_do = readerMedB.eval_auto_bounds(sysIndexDown, BTagEntry::FLAV_B, JetEta, JetPt);
                 } else if(JetFlav == 4){// c jets
-                    jet_scalefactor = readerMedC.eval_auto_bounds("central", BTagEntry::FLAV_C, JetEta, JetPt); 
-                    jet_scalefactor_up = readerMedC.eval_auto_bounds("up", BTagEntry::FLAV_C, JetEta, JetPt);
-                    jet_scalefactor_do = readerMedC.eval_auto_bounds("down", BTagEntry::FLAV_C, JetEta, JetPt);
+                    jet_scalefactor = readerMedC.eval_auto_bounds(0, BTagEntry::FLAV_C, JetEta, JetPt); 
+                    jet_scalefactor_up = readerMedC.eval_auto_bounds(sysIndexUp, BTagEntry::FLAV_C, JetEta, JetPt);
+                    jet_scalefactor_do = readerMedC.eval_auto_bounds(sysIndexDown, BTagEntry::FLAV_C, JetEta, JetPt);
                 } else {// light jets
-                    jet_scalefactor = readerMedUDSG.eval_auto_bounds("central", BTagEntry::FLAV_UDSG, JetEta, JetPt); 
-                    jet_scalefactor_up =  readerMedUDSG.eval_auto_bounds("up", BTagEntry::FLAV_UDSG, JetEta, JetPt); 
-                    jet_scalefactor_do =  readerMedUDSG.eval_auto_bounds("down", BTagEntry::FLAV_UDSG, JetEta, JetPt);
+                    jet_scalefactor = readerMedUDSG.eval_auto_bounds(0, BTagEntry::FLAV_UDSG, JetEta, JetPt); 
+                    jet_scalefactor_up =  readerMedUDSG.eval_auto_bounds(sysIndexUp, BTagEntry::FLAV_UDSG, JetEta, JetPt); 
+                    jet_scalefactor_do =  readerMedUDSG.eval_auto_bounds(sysIndexDown, BTagEntry::FLAV_UDSG, JetEta, JetPt);
                 }
                 
                 if( this->debug_ ) {
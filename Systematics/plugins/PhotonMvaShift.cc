@@ -48,25 +48,23 @@ namespace flashgg {
                 if (!applyCentralValue()) shift_val = 0.;
                 float shift_err = val_err.second[0]; // e.g. 0.1
                 float shift = shift_val + syst_shift * shift_err;
-                std::vector<edm::Ptr<reco::Vertex> > keys;
                 if( debug_ ) {
                     std::cout << "  " << shiftLabel( syst_shift ) << ": Photon has pt= " << y.pt() << " eta=" << y.eta()
                               << " and we apply an mva shift of " << shift << std::endl;
                     std::cout << "     MVA VALUES BEFORE: ";
-                    auto beforeMap = y.phoIdMvaD();
-                    for(auto keyval = beforeMap.begin(); keyval != beforeMap.end(); ++keyval) {
-                        keys.push_back( keyval->first );
-                        std::cout << keyval->second << " ";
+                    const auto &beforeMap = y.phoIdMvaD();
+                    for( unsigned int key = 0 ; key < beforeMap.size() ; key++ ) {
+                        if( beforeMap.has( key ) ) { std::cout << beforeMap.at( key ) << " "; }
                     }
                     std::cout << std::endl;
                 }
                 y.shiftAllMvaValuesBy( shift ); // we shift all because we don't have access to the selected vertex
                                                 // the others are no longer used at this stage anyway, so it cannot hurt
                 if ( debug_) {
-                    auto afterMap = y.phoIdMvaD();
+                    const auto &afterMap = y.phoIdMvaD();
                     std::cout << "     MVA VALUES AFTER: ";
-                    for(auto key = keys.begin() ; key != keys.end() ; ++key ) {
-                        std::cout << afterMap.at(*key) << " ";
+                    for( unsigned int key = 0 ; key < afterMap.size() ; key++ ) {
+                        if( afterMap.has( key ) ) { std::cout << afterMap.at( key ) << " "; }
                     }
                     std::cout << std::endl;
                 }
@@ -76,30 +76,26 @@ namespace flashgg {
             }
             if (correctionIndex == -1) std::cerr << "ERROR: not enough corrections defined for IDMVA" << std::endl;            
          
-            auto beforeMap = y.phoIdMvaD();
-            std::vector<edm::Ptr<reco::Vertex> > keys;
+            const auto &mvaMap = y.phoIdMvaD();
             if( debug_ ) {
                 std::cout << " PhoID MVA Syst shift from transformation : Photon has pt= " << y.pt() << " eta=" << y.eta();
                 std::cout << "     MVA VALUES BEFORE: ";
-                for(auto keyval = beforeMap.begin(); keyval != beforeMap.end(); ++keyval) {
-                    keys.push_back( keyval->first );
-                    std::cout << keyval->second << " ";
+                for( unsigned int key = 0 ; key < mvaMap.size() ; key++ ) {
+                    if( mvaMap.has( key ) ) { std::cout << mvaMap.at( key ) << " "; }
                 }
                 std::cout << std::endl;
             }
-            edm::Ptr<reco::Vertex> vtx;
             float shift =0., mvaVal=0.;
-            for(auto keyval = beforeMap.begin(); keyval != beforeMap.end(); ++keyval) {
-                vtx = keyval->first;
-                mvaVal = keyval->second;
+            for( unsigned int key = 0 ; key < mvaMap.size() ; key++ ) {
+                if( !mvaMap.has( key ) ) { continue; }
+                mvaVal = mvaMap.at( key );
                 shift = shift_val + (corrections_[correctionIndex]->Eval(mvaVal) - mvaVal )*abs(syst_shift);
-                y.shiftMvaValueBy(shift, vtx);
+                y.shiftMvaValueByKey(shift, key);
             }
             if ( debug_) {
-                auto afterMap = y.phoIdMvaD();
                 std::cout << "     MVA VALUES AFTER: ";
-                for(auto key = keys.begin() ; key != keys.end() ; ++key ) {
-                    std::cout << afterMap.at(*key) << " ";
+                for( unsigned int key = 0 ; key < mvaMap.size() ; key++ ) {
+                    if( mvaMap.has( key ) ) { std::cout << mvaMap.at( key ) << " "; }
                 }
                 std::cout << std::endl;
             }
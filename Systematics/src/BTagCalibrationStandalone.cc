@@ -389,6 +389,302 @@ std::string BTagCalibration::token(const BTagEntry::Parameters &par)
 }
 
 
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace {
+
+// Compiles the calibration formulas into closures, for the precompiled mode of
+// BTagCalibrationReader. Only the part of the TFormula syntax for which the
+// closures compute the same doubles as the TF1 is accepted: x, numbers, + - * /
+// with the C++ precedences, comparisons, && || ! ?:, and log, log10, exp, sqrt,
+// pow, abs, fabs, with or without TMath::, and TMath::Min, TMath::Max.
+// Anything else (including a division of two integers, which C++ truncates)
+// throws FormulaError, and the entry is left to its TF1.
+struct FormulaError {};
+
+struct FormulaNode {
+  std::function<double(double)> func;
+  bool isConst;
+  bool isInt;    // integer-valued in C++ (int literals, bools)
+  double value;  // if isConst
+};
+
+class FormulaCompiler
+{
+public:
+  explicit FormulaCompiler(const std::string &formula): s_(formula), pos_(0) {}
+
+  FormulaNode compile()
+  {
+    FormulaNode n = ternary();
+    skip();
+    if (pos_ != s_.size()) throw FormulaError();
+    return n;
+  }
+
+private:
+  static FormulaNode constant(double v, bool isInt)
+  {
+    return FormulaNode{[v](double) { return v; }, true, isInt, v};
+  }
+
+  static FormulaNode apply1(const FormulaNode &a, double (*op)(double), bool isInt=false)
+  {
+    if (a.isConst) return constant(op(a.value), isInt);
+    auto fa = a.func;
+    return FormulaNode{[fa, op](double x) { return op(fa(x)); }, false, isInt, 0.};
+  }
+
+  static FormulaNode apply2(const FormulaNode &a, const FormulaNode &b,
+                            double (*op)(double, double), bool isInt=false)
+  {
+    if (a.isConst && b.isConst) return constant(op(a.value, b.value), isInt);
+    auto fa = a.func;
+    auto fb = b.func;
+    return FormulaNode{[fa, fb, op](double x) { return op(fa(x), fb(x)); }, false, isInt, 0.};
+  }
+
+  void skip()
+  {
+    while (pos_ < s_.size() && isspace(s_[pos_])) ++pos_;
+  }
+
+  bool accept(const char *tok)
+  {
+    skip();
+    size_t n = strlen(tok);
+    if (s_.compare(pos_, n, tok) != 0) return false;
+    pos_ += n;
+    return true;
+  }
+
+  void expect(const char *tok)
+  {
+    if (!accept(tok)) throw FormulaError();
+  }
+
+  FormulaNode ternary()
+  {
+    FormulaNode cond = logicalOr();
+    if (!accept("?")) return cond;
+    FormulaNode a = ternary();
+    expect(":");
+    FormulaNode b = ternary();
+    bool isInt = a.isInt && b.isInt;
+    if (cond.isConst) {
+      FormulaNode r = cond.value != 0. ? a : b;
+      r.isInt = isInt;
+      return r;
+    }
+    auto fc = cond.func;
+    auto fa = a.func;
+    auto fb = b.func;
+    return FormulaNode{[fc, fa, fb](double x) { return fc(x) != 0. ? fa(x) : fb(x); }, false, isInt, 0.};
+  }
+
+  FormulaNode logicalOr()
+  {
+    FormulaNode a = logicalAnd();
+    while (accept("||")) {
+      a = apply2(a, logicalAnd(), [](double u, double v) { return (u != 0. || v != 0.) ? 1. : 0.; }, true);
+    }
+    return a;
+  }
+
+  FormulaNode logicalAnd()
+  {
+    FormulaNode a = equality();
+    while (accept("&&")) {
+      a = apply2(a, equality(), [](double u, double v) { return (u != 0. && v != 0.) ? 1. : 0.; }, true);
+    }
+    return a;
+  }
+
+  FormulaNode equality()
+  {
+    FormulaNode a = relational();
+    while (true) {
+      if (accept("==")) {
+        a = apply2(a, relational(), [](double u, double v) { return u == v ? 1. : 0.; }, true);
+      } else if (accept("!=")) {
+        a = apply2(a, relational(), [](double u, double v) { return u != v ? 1. : 0.; }, true);
+      } else {
+        return a;
+      }
+    }
+  }
+
+  FormulaNode relational()
+  {
+    FormulaNode a = additive();
+    while (true) {
+      if (accept("<=")) {
+        a = apply2(a, additive(), [](double u, double v) { return u <= v ? 1. : 0.; }, true);
+      } else if (accept(">=")) {
+        a = apply2(a, additive(), [](double u, double v) { return u >= v ? 1. : 0.; }, true);
+      } else if (accept("<")) {
+        a = apply2(a, additive(), [](double u, double v) { return u < v ? 1. : 0.; }, true);
+      } else if (accept(">")) {
+        a = apply2(a, additive(), [](double u, double v) { return u > v ? 1. : 0.; }, true);
+      } else {
+        return a;
+      }
+    }
+  }
+
+  FormulaNode additive()
+  {
+    FormulaNode a = multiplicative();
+    while (true) {
+      if (accept("+")) {
+        FormulaNode b = multiplicative();
+        a = apply2(a, b, [](double u, double v) { return u + v; }, a.isInt && b.isInt);
+      } else if (accept("-")) {
+        FormulaNode b = multiplicative();
+        a = apply2(a, b, [](double u, double v) { return u - v; }, a.isInt && b.isInt);
+      } else {
+        return a;
+      }
+    }
+  }
+
+  FormulaNode multiplicative()
+  {
+    FormulaNode a = unary();
+    while (true) {
+      if (accept("*")) {
+        FormulaNode b = unary();
+        a = apply2(a, b, [](double u, double v) { return u * v; }, a.isInt && b.isInt);
+      } else if (accept("/")) {
+        FormulaNode b = unary();
+        if (a.isInt && b.isInt) throw FormulaError();
+        a = apply2(a, b, [](double u, double v) { return u / v; });
+      } else {
+        return a;
+      }
+    }
+  }
+
+  FormulaNode unary()
+  {
+    if (accept("-")) {
+      FormulaNode a = unary();
+      return apply1(a, [](double u) { return -u; }, a.isInt);
+    }
+    if (accept("+")) return unary();
+    if (accept("!")) {
+      return apply1(unary(), [](double u) { return u == 0. ? 1. : 0.; }, true);
+    }
+    return primary();
+  }
+
+  FormulaNode primary()
+  {
+    skip();
+    if (pos_ >= s_.size()) throw FormulaError();
+    if (accept("(")) {
+      FormulaNode n = ternary();
+      expect(")");
+      return n;
+    }
+    char c = s_[pos_];
+    if (isdigit(c) || c == '.') return number();
+    if (!isalpha(c) && c != '_') throw FormulaError();
+
+    size_t begin = pos_;
+    while (pos_ < s_.size() && (isalnum(s_[pos_]) || s_[pos_] == '_' || s_[pos_] == ':')) ++pos_;
+    std::string name = s_.substr(begin, pos_ - begin);
+    if (name == "x") {
+      return FormulaNode{[](double x) { return x; }, false, false, 0.};
+    }
+
+    expect("(");
+    FormulaNode a = ternary();
+    if (accept(",")) {
+      FormulaNode b = ternary();
+      expect(")");
+      if (name == "pow" || name == "TMath::Power") {
+        return apply2(a, b, [](double u, double v) { return std::pow(u, v); });
+      }
+      if (name == "TMath::Max") {
+        return apply2(a, b, [](double u, double v) { return u >= v ? u : v; });
+      }
+      if (name == "TMath::Min") {
+        return apply2(a, b, [](double u, double v) { return u <= v ? u : v; });
+      }
+      throw FormulaError();
+    }
+    expect(")");
+    if (name == "log" || name == "TMath::Log") return apply1(a, [](double u) { return std::log(u); });
+    if (name == "log10" || name == "TMath::Log10") return apply1(a, [](double u) { return std::log10(u); });
+    if (name == "exp" || name == "TMath::Exp") return apply1(a, [](double u) { return std::exp(u); });
+    if (name == "sqrt" || name == "TMath::Sqrt") return apply1(a, [](double u) { return std::sqrt(u); });
+    if (name == "abs" || name == "fabs" || name == "TMath::Abs") return apply1(a, [](double u) { return std::fabs(u); });
+    throw FormulaError();
+  }
+
+  FormulaNode number()
+  {
+    size_t begin = pos_;
+    bool isInt = true;
+    while (pos_ < s_.size() && isdigit(s_[pos_])) ++pos_;
+    if (pos_ < s_.size() && s_[pos_] == '.') {
+      isInt = false;
+      ++pos_;
+      while (pos_ < s_.size() && isdigit(s_[pos_])) ++pos_;
+    }
+    if (pos_ < s_.size() && (s_[pos_] == 'e' || s_[pos_] == 'E')) {
+      isInt = false;
+      ++pos_;
+      if (pos_ < s_.size() && (s_[pos_] == '+' || s_[pos_] == '-')) ++pos_;
+      if (pos_ >= s_.size() || !isdigit(s_[pos_])) throw FormulaError();
+      while (pos_ < s_.size() && isdigit(s_[pos_])) ++pos_;
+    }
+    std::string literal = s_.substr(begin, pos_ - begin);
+    if (literal == ".") throw FormulaError();
+    if (pos_ < s_.size() && (isalpha(s_[pos_]) || s_[pos_] == '_')) throw FormulaError();  // suffixes
+    return constant(strtod(literal.c_str(), nullptr), isInt);
+  }
+
+  const std::string s_;
+  size_t pos_;
+};
+
+// Position of v among the sorted bin edges: 2i+1 if v is edges[i], 2i if it
+// lies between edges[i-1] and edges[i]. All the range checks of the reader
+// compare with the edges, so they give the same answer within a position;
+// NaN goes to position 0, below all the edges, which fails them all like NaN.
+inline unsigned edgePosition(const std::vector<float> &edges, float v)
+{
+  auto it = std::lower_bound(edges.begin(), edges.end(), v);
+  unsigned i = it - edges.begin();
+  return (it != edges.end() && *it == v) ? 2*i + 1 : 2*i;
+}
+
+// A value at the given position, to evaluate the range checks there
+inline float edgePositionValue(const std::vector<float> &edges, unsigned position)
+{
+  if (edges.empty()) return 0.;
+  unsigned i = position / 2;
+  if (position % 2) return edges[i];
+  if (i == 0) return std::nextafter(edges[0], -std::numeric_limits<float>::infinity());
+  return std::nextafter(edges[i-1], std::numeric_limits<float>::infinity());
+}
+
+std::vector<float> sortedEdges(std::vector<float> edges)
+{
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  return edges;
+}
+
+}  // namespace
+
+
 
 
 class BTagCalibrationReader::BTagCalibrationReaderImpl
@@ -403,13 +699,37 @@ public:
     float ptMax;
     float discrMin;
     float discrMax;
+    std::string formula;
     TF1 func;
   };
 
+  // precompiled mode: the formula of an entry, folded to a constant or as a
+  // closure, or left to the TF1 of the entry if neither
+  struct Formula {
+    bool isConst;
+    double value;
+    std::function<double(double)> func;
+  };
+
+  // precompiled mode, per jet flavour: the bin edges of each axis, and what the
+  // linear searches return at each position among them (see edgePosition)
+  struct LookupTable {
+    std::vector<float> etaEdges;
+    std::vector<float> ptEdges;
+    std::vector<float> discrEdges;  // only for reshaping
+    unsigned nPt;
+    unsigned nDiscr;
+    std::vector<int> entry;                           // per (eta, pt, discr), -1 if none
+    std::vector<std::pair<float, float> > etaBounds;  // min_max_eta per discr
+    std::vector<std::pair<float, float> > ptBounds;   // min_max_pt per (eta, discr)
+    std::vector<Formula> formulas;                    // per entry
+  };
+
 private:
   BTagCalibrationReaderImpl(BTagEntry::OperatingPoint op,
                             const std::string & sysType,
-                            const std::vector<std::string> & otherSysTypes={});
+                            const std::vector<std::string> & otherSysTypes={},
+                            bool precompiled=false);
 
   void load(const BTagCalibration & c,
             BTagEntry::JetFlavor jf,
@@ -420,7 +740,9 @@ private:
               float pt,
               float discr) const;
 
-  double eval_auto_bounds(const std::string & sys,
+  // sys: name of the systematic for the error message, or null
+  double eval_auto_bounds(int sysIndex,
+                          const std::string * sys,
                           BTagEntry::JetFlavor jf,
                           float eta,
                           float pt,
@@ -433,22 +755,46 @@ private:
   std::pair<float, float> min_max_eta(BTagEntry::JetFlavor jf,
                                      float discr) const;
 
+  // linear searches, with eta already folded if useAbsEta_
+  int find_entry(BTagEntry::JetFlavor jf,
+                 float eta,
+                 float pt,
+                 float discr) const;
+
+  std::pair<float, float> search_min_max_pt(BTagEntry::JetFlavor jf,
+                                            float eta,
+                                            float discr) const;
+
+  std::pair<float, float> search_min_max_eta(BTagEntry::JetFlavor jf,
+                                             float discr) const;
+
+  void compile(BTagEntry::JetFlavor jf);
+
+  unsigned nTF1Formulas() const;
+
   BTagEntry::OperatingPoint op_;
   std::string sysType_;
   std::vector<std::vector<TmpEntry> > tmpData_;  // first index: jetFlavor
   std::vector<bool> useAbsEta_;                  // first index: jetFlavor
   std::map<std::string, std::shared_ptr<BTagCalibrationReaderImpl>> otherSysTypeReaders_;
+  std::map<std::string, int> otherSysTypeIndex_;
+  std::vector<std::shared_ptr<BTagCalibrationReaderImpl> > otherSysTypeList_;  // in sysIndex order
+  bool precompiled_;
+  std::vector<LookupTable> tables_;              // first index: jetFlavor
 };
 
 
 BTagCalibrationReader::BTagCalibrationReaderImpl::BTagCalibrationReaderImpl(
                                              BTagEntry::OperatingPoint op,
                                              const std::string & sysType,
-                                             const std::vector<std::string> & otherSysTypes):
+                                             const std::vector<std::string> & otherSysTypes,
+                                             bool precompiled):
   op_(op),
   sysType_(sysType),
   tmpData_(3),
-  useAbsEta_(3, true)
+  useAbsEta_(3, true),
+  precompiled_(precompiled),
+  tables_(3)
 {
   for (const std::string & ost : otherSysTypes) {
     if (otherSysTypeReaders_.count(ost)) {
@@ -458,8 +804,15 @@ std::cerr << "ERROR in BTagCalibration: "
 throw std::exception();
     }
     otherSysTypeReaders_[ost] = std::unique_ptr<BTagCalibrationReaderImpl>(
-        new BTagCalibrationReaderImpl(op, ost)
+        new BTagCalibrationReaderImpl(op, ost, {}, precompiled)
     );
+    otherSysTypeList_.push_back(otherSysTypeReaders_[ost]);
+    otherSysTypeIndex_[ost] = otherSysTypeList_.size();
+  }
+  if (precompiled_) {  // flavours that are never loaded
+    for (unsigned jf = 0; jf < tables_.size(); ++jf) {
+      compile(BTagEntry::JetFlavor(jf));
+    }
   }
 }
 
@@ -490,6 +843,7 @@ throw std::exception();
     te.ptMax = be.params.ptMax;
     te.discrMin = be.params.discrMin;
     te.discrMax = be.params.discrMax;
+    te.formula = be.formula;
 
     if (op_ == BTagEntry::OP_RESHAPING) {
       te.func = TF1("", be.formula.c_str(),
@@ -505,24 +859,116 @@ throw std::exception();
     }
   }
 
+  if (precompiled_) {
+    compile(jf);
+  }
+
   for (auto & p : otherSysTypeReaders_) {
     p.second->load(c, jf, measurementType);
   }
 }
 
-double BTagCalibrationReader::BTagCalibrationReaderImpl::eval(
+void BTagCalibrationReader::BTagCalibrationReaderImpl::compile(BTagEntry::JetFlavor jf)
+{
+  bool use_discr = (op_ == BTagEntry::OP_RESHAPING);
+  const auto &entries = tmpData_.at(jf);
+  LookupTable &t = tables_.at(jf);
+
+  std::vector<float> eta, pt, discr;
+  for (const auto &e : entries) {
+    eta.push_back(e.etaMin);
+    eta.push_back(e.etaMax);
+    pt.push_back(e.ptMin);
+    pt.push_back(e.ptMax);
+    if (use_discr) {
+      discr.push_back(e.discrMin);
+      discr.push_back(e.discrMax);
+    }
+  }
+  t.etaEdges = sortedEdges(eta);
+  t.ptEdges = sortedEdges(pt);
+  t.discrEdges = sortedEdges(discr);
+  unsigned nEta = 2*t.etaEdges.size() + 1;
+  t.nPt = 2*t.ptEdges.size() + 1;
+  t.nDiscr = 2*t.discrEdges.size() + 1;
+
+  // filled from the last entry to the first, so that the first match wins as
+  // in the linear search
+  t.entry.assign(nEta*t.nPt*t.nDiscr, -1);
+  for (int i = int(entries.size()) - 1; i >= 0; --i) {
+    const auto &e = entries[i];
+    for (unsigned ieta = 0; ieta < nEta; ++ieta) {
+      float vEta = edgePositionValue(t.etaEdges, ieta);
+      if (!(e.etaMin <= vEta && vEta <= e.etaMax)) continue;
+      for (unsigned ipt = 0; ipt < t.nPt; ++ipt) {
+        float vPt = edgePositionValue(t.ptEdges, ipt);
+        if (!(e.ptMin < vPt && vPt <= e.ptMax)) continue;
+        for (unsigned idiscr = 0; idiscr < t.nDiscr; ++idiscr) {
+          float vDiscr = edgePositionValue(t.discrEdges, idiscr);
+          if (use_discr && !(e.discrMin <= vDiscr && vDiscr < e.discrMax)) continue;
+          t.entry[(ieta*t.nPt + ipt)*t.nDiscr + idiscr] = i;
+        }
+      }
+    }
+  }
+
+  t.etaBounds.clear();
+  t.ptBounds.clear();
+  for (unsigned idiscr = 0; idiscr < t.nDiscr; ++idiscr) {
+    t.etaBounds.push_back(search_min_max_eta(jf, edgePositionValue(t.discrEdges, idiscr)));
+  }
+  for (unsigned ieta = 0; ieta < nEta; ++ieta) {
+    for (unsigned idiscr = 0; idiscr < t.nDiscr; ++idiscr) {
+      t.ptBounds.push_back(search_min_max_pt(jf,
+                                             edgePositionValue(t.etaEdges, ieta),
+                                             edgePositionValue(t.discrEdges, idiscr)));
+    }
+  }
+
+  t.formulas.clear();
+  for (const auto &e : entries) {
+    Formula f{false, 0., nullptr};
+    try {
+      FormulaNode n = FormulaCompiler(e.formula).compile();
+      f.isConst = n.isConst;
+      f.value = n.value;
+      f.func = n.func;
+    } catch (const FormulaError &) {
+      // evaluated with the TF1
+    }
+    t.formulas.push_back(f);
+  }
+}
+
+unsigned BTagCalibrationReader::BTagCalibrationReaderImpl::nTF1Formulas() const
+{
+  unsigned n = 0;
+  if (precompiled_) {
+    for (const auto &t : tables_) {
+      for (const auto &f : t.formulas) {
+        if (!f.isConst && !f.func) ++n;
+      }
+    }
+  } else {
+    for (const auto &entries : tmpData_) {
+      n += entries.size();
+    }
+  }
+  for (const auto &p : otherSysTypeList_) {
+    n += p->nTF1Formulas();
+  }
+  return n;
+}
+
+int BTagCalibrationReader::BTagCalibrationReaderImpl::find_entry(
                                              BTagEntry::JetFlavor jf,
                                              float eta,
                                              float pt,
                                              float discr) const
 {
   bool use_discr = (op_ == BTagEntry::OP_RESHAPING);
-  if (useAbsEta_[jf] && eta < 0) {
-    eta = -eta;
-  }
 
-  // search linearly through eta, pt and discr ranges and eval
-  // future: find some clever data structure based on intervals
+  // search linearly through eta, pt and discr ranges
   const auto &entries = tmpData_.at(jf);
   for (unsigned i=0; i<entries.size(); ++i) {
     const auto &e = entries.at(i);
@@ -532,19 +978,52 @@ double BTagCalibrationReader::BTagCalibrationReaderImpl::eval(
     ){
       if (use_discr) {                                    // discr. reshaping?
         if (e.discrMin <= discr && discr < e.discrMax) {  // check discr
-          return e.func.Eval(discr);
+          return i;
         }
       } else {
-        return e.func.Eval(pt);
+        return i;
       }
     }
   }
 
-  return 0.;  // default value
+  return -1;
+}
+
+double BTagCalibrationReader::BTagCalibrationReaderImpl::eval(
+                                             BTagEntry::JetFlavor jf,
+                                             float eta,
+                                             float pt,
+                                             float discr) const
+{
+  bool use_discr = (op_ == BTagEntry::OP_RESHAPING);
+  if (useAbsEta_[jf] && eta < 0) {
+    eta = -eta;
+  }
+
+  int i;
+  if (precompiled_) {
+    const LookupTable &t = tables_[jf];
+    unsigned idiscr = use_discr ? edgePosition(t.discrEdges, discr) : 0;
+    i = t.entry[(edgePosition(t.etaEdges, eta)*t.nPt + edgePosition(t.ptEdges, pt))*t.nDiscr + idiscr];
+    if (i >= 0) {
+      const Formula &f = t.formulas[i];
+      if (f.isConst) return f.value;
+      if (f.func) return f.func(use_discr ? discr : pt);
+    }
+  } else {
+    i = find_entry(jf, eta, pt, discr);
+  }
+
+  if (i < 0) {
+    return 0.;  // default value
+  }
+  const auto &e = tmpData_[jf][i];
+  return use_discr ? e.func.Eval(discr) : e.func.Eval(pt);
 }
 
 double BTagCalibrationReader::BTagCalibrationReaderImpl::eval_auto_bounds(
-                                             const std::string & sys,
+                                             int sysIndex,
+                                             const std::string * sys,
                                              BTagEntry::JetFlavor jf,
                                              float eta,
                                              float pt,
@@ -577,18 +1056,19 @@ double BTagCalibrationReader::BTagCalibrationReaderImpl::eval_auto_bounds(
 
   // get central SF (and maybe return)
   double sf = eval(jf, eta, pt_for_eval, discr);
-  if (sys == sysType_) {
+  if (sysIndex == 0) {
     return sf;
   }
 
   // get sys SF (and maybe return)
-  if (!otherSysTypeReaders_.count(sys)) {
+  if (sysIndex < 0 || sysIndex > int(otherSysTypeList_.size())) {
 std::cerr << "ERROR in BTagCalibration: "
-        << "sysType not available (maybe not loaded?): "
-        << sys;
+        << "sysType not available (maybe not loaded?): ";
+if (sys) std::cerr << *sys;
+else std::cerr << "index " << sysIndex;
 throw std::exception();
   }
-  double sf_err = otherSysTypeReaders_.at(sys)->eval(jf, eta, pt_for_eval, discr);
+  double sf_err = otherSysTypeList_[sysIndex-1]->eval(jf, eta, pt_for_eval, discr);
   if (!is_out_of_bounds) {
     return sf_err;
   }
@@ -603,11 +1083,25 @@ std::pair<float, float> BTagCalibrationReader::BTagCalibrationReaderImpl::min_ma
                                                float eta,
                                                float discr) const
 {
-  bool use_discr = (op_ == BTagEntry::OP_RESHAPING);
   if (useAbsEta_[jf] && eta < 0) {
     eta = -eta;
   }
 
+  if (precompiled_) {
+    const LookupTable &t = tables_[jf];
+    unsigned idiscr = (op_ == BTagEntry::OP_RESHAPING) ? edgePosition(t.discrEdges, discr) : 0;
+    return t.ptBounds[edgePosition(t.etaEdges, eta)*t.nDiscr + idiscr];
+  }
+  return search_min_max_pt(jf, eta, discr);
+}
+
+std::pair<float, float> BTagCalibrationReader::BTagCalibrationReaderImpl::search_min_max_pt(
+                                               BTagEntry::JetFlavor jf,
+                                               float eta,
+                                               float discr) const
+{
+  bool use_discr = (op_ == BTagEntry::OP_RESHAPING);
+
   const auto &entries = tmpData_.at(jf);
   float min_pt = -1., max_pt = -1.;
   for (const auto & e: entries) {
@@ -638,6 +1132,18 @@ std::pair<float, float> BTagCalibrationReader::BTagCalibrationReaderImpl::min_ma
 std::pair<float, float> BTagCalibrationReader::BTagCalibrationReaderImpl::min_max_eta(
                                                BTagEntry::JetFlavor jf,
                                                float discr) const
+{
+  if (precompiled_) {
+    const LookupTable &t = tables_[jf];
+    unsigned idiscr = (op_ == BTagEntry::OP_RESHAPING) ? edgePosition(t.discrEdges, discr) : 0;
+    return t.etaBounds[idiscr];
+  }
+  return search_min_max_eta(jf, discr);
+}
+
+std::pair<float, float> BTagCalibrationReader::BTagCalibrationReaderImpl::search_min_max_eta(
+                                               BTagEntry::JetFlavor jf,
+                                               float discr) const
 {
   bool use_discr = (op_ == BTagEntry::OP_RESHAPING);
 
@@ -663,8 +1169,9 @@ std::pair<float, float> BTagCalibrationReader::BTagCalibrationReaderImpl::min_ma
 
 BTagCalibrationReader::BTagCalibrationReader(BTagEntry::OperatingPoint op,
                                              const std::string & sysType,
-                                             const std::vector<std::string> & otherSysTypes):
-  pimpl(new BTagCalibrationReaderImpl(op, sysType, otherSysTypes)) {}
+                                             const std::vector<std::string> & otherSysTypes,
+                                             bool precompiled):
+  pimpl(new BTagCalibrationReaderImpl(op, sysType, otherSysTypes, precompiled)) {}
 
 void BTagCalibrationReader::load(const BTagCalibration & c,
                                  BTagEntry::JetFlavor jf,
@@ -681,13 +1188,31 @@ double BTagCalibrationReader::eval(BTagEntry::JetFlavor jf,
   return pimpl->eval(jf, eta, pt, discr);
 }
 
+int BTagCalibrationReader::sysIndex(const std::string & sys) const
+{
+  if (sys == pimpl->sysType_) {
+    return 0;
+  }
+  auto found = pimpl->otherSysTypeIndex_.find(sys);
+  return found == pimpl->otherSysTypeIndex_.end() ? -1 : found->second;
+}
+
 double BTagCalibrationReader::eval_auto_bounds(const std::string & sys,
                                                BTagEntry::JetFlavor jf,
                                                float eta,
                                                float pt,
                                                float discr) const
 {
-  return pimpl->eval_auto_bounds(sys, jf, eta, pt, discr);
+  return pimpl->eval_auto_bounds(sysIndex(sys), &sys, jf, eta, pt, discr);
+}
+
+double BTagCalibrationReader::eval_auto_bounds(int sysIndex,
+                                               BTagEntry::JetFlavor jf,
+                                               float eta,
+                                               float pt,
+                                               float discr) const
+{
+  return pimpl->eval_auto_bounds(sysIndex, nullptr, jf, eta, pt, discr);
 }
 
 std::pair<float, float> BTagCalibrationReader::min_max_pt(BTagEntry::JetFlavor jf,
@@ -697,6 +1222,10 @@ std::pair<float, float> BTagCalibrationReader::min_max_pt(BTagEntry::JetFlavor j
   return pimpl->min_max_pt(jf, eta, discr);
 }
 
+unsigned BTagCalibrationReader::nTF1Formulas() const
+{
+  return pimpl->nTF1Formulas();
+}
 
 
 
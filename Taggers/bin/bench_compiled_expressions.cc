@@ -0,0 +1,124 @@
+// Compares the time per variable of the reflective StringObjectFunction and of the
+// natively compiled expressions (CompiledObjectFunction) on diphoton candidates.
+// The default variable list is the one of Taggers/test/diphotonsDumper_cfg.py; a
+// file with one expression per line ("name := expr" is accepted) can be given instead.
+// Usage: bench_compiled_expressions <MicroAOD file> [expressions.txt] [label=flashggDiPhotons] [maxEvents=1000]
+
+#include "DataFormats/FWLite/interface/Event.h"
+#include "DataFormats/FWLite/interface/Handle.h"
+#include "FWCore/FWLite/interface/FWLiteEnabler.h"
+#include "CommonTools/Utils/interface/StringObjectFunction.h"
+#include "flashgg/DataFormats/interface/DiPhotonCandidate.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
+
+#include "TFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 2 ) {
+        cerr << "Usage: " << argv[0] << " <MicroAOD file> [expressions.txt] [label=flashggDiPhotons] [maxEvents=1000]" << endl;
+        return 1;
+    }
+    string label = ( argc > 3 ? argv[3] : "flashggDiPhotons" );
+    int maxEvents = ( argc > 4 ? atoi( argv[4] ) : 1000 );
+
+    vector<string> expressions = {
+        "mass",
+        "leadingPhoton.pt",
+        "subLeadingPhoton.pt",
+        "min(leadingPhoton.full5x5_r9,subLeadingPhoton.full5x5_r9)",
+        "max(abs(leadingPhoton.superCluster.eta),abs(leadingPhoton.superCluster.eta))",
+        "leadingView.phoIdMvaWrtChosenVtx",
+        "subLeadingView.phoIdMvaWrtChosenVtx"
+    };
+    if( argc > 2 && string( argv[2] ) != "-" ) {
+        expressions.clear();
+        ifstream in( argv[2] );
+        string line;
+        while( getline( in, line ) ) {
+            auto pos = line.find( ":=" );
+            if( pos != string::npos ) { line = line.substr( pos + 2 ); }
+            if( line.find_first_not_of( " \t" ) == string::npos || line[line.find_first_not_of( " \t" )] == '#' ) { continue; }
+            expressions.push_back( line );
+        }
+    }
+
+    FWLiteEnabler::enable();
+    TFile *file = TFile::Open( argv[1] );
+    if( !file ) { return 1; }
+
+    vector<flashgg::DiPhotonCandidate> candidates;
+    fwlite::Event event( file );
+    int ievent = 0;
+    for( event.toBegin(); !event.atEnd() && ievent < maxEvents; ++event, ++ievent ) {
+        fwlite::Handle<vector<flashgg::DiPhotonCandidate> > diphotons;
+        diphotons.getByLabel( event, label.c_str() );
+        candidates.insert( candidates.end(), diphotons->begin(), diphotons->end() );
+    }
+    cout << "Read " << candidates.size() << " candidates from " << ievent << " events" << endl;
+    if( candidates.empty() ) { return 1; }
+
+    vector<StringObjectFunction<flashgg::DiPhotonCandidate, true> > reflective;
+    vector<flashgg::ExpressionCompiler::function_type> compiled;
+    auto startCompile = chrono::steady_clock::now();
+    for( const auto &expr : expressions ) {
+        reflective.emplace_back( expr );
+        compiled.push_back( flashgg::ExpressionCompiler::compile( "flashgg::DiPhotonCandidate", expr ) );
+    }
+    double compileMs = chrono::duration<double, milli>( chrono::steady_clock::now() - startCompile ).count();
+
+    const int nRepeat = 10;
+    double sink = 0.;
+    unsigned int nCompiled = 0, nMismatch = 0;
+    double tReflective = 0., tCompiled = 0.;
+    for( unsigned int iexpr = 0 ; iexpr < expressions.size() ; iexpr++ ) {
+        if( !compiled[iexpr] ) { continue; }
+        nCompiled++;
+        for( const auto &cand : candidates ) {
+            double a = reflective[iexpr]( cand ), b = compiled[iexpr]( &cand );
+            if( a != b && !( std::isnan( a ) && std::isnan( b ) ) ) {
+                if( nMismatch++ < 10 ) { cout << "Mismatch for " << expressions[iexpr] << ": " << a << " vs " << b << endl; }
+            }
+        }
+        auto t0 = chrono::steady_clock::now();
+        for( int irep = 0 ; irep < nRepeat ; irep++ ) {
+            for( const auto &cand : candidates ) { sink += reflective[iexpr]( cand ); }
+        }
+        auto t1 = chrono::steady_clock::now();
+        for( int irep = 0 ; irep < nRepeat ; irep++ ) {
+            for( const auto &cand : candidates ) { sink += compiled[iexpr]( &cand ); }
+        }
+        auto t2 = chrono::steady_clock::now();
+        tReflective += chrono::duration<double, nano>( t1 - t0 ).count();
+        tCompiled += chrono::duration<double, nano>( t2 - t1 ).count();
+    }
+    if( nCompiled == 0 ) {
+        cout << "None of the " << expressions.size() << " expressions could be compiled" << endl;
+        return 1;
+    }
+
+    double nEvaluations = double( nRepeat ) * candidates.size() * nCompiled;
+    cout << "Compiled " << nCompiled << "/" << expressions.size() << " expressions in " << compileMs << " ms" << endl;
+    cout << "reflective[ns/var]   compiled[ns/var]   speedup   mismatches" << endl;
+    cout << tReflective / nEvaluations << "   " << tCompiled / nEvaluations << "   " << tReflective / tCompiled << "   " << nMismatch << endl;
+    cout << "(checksum " << sink << ")" << endl;
+    return ( nMismatch == 0 ? 0 : 2 );
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
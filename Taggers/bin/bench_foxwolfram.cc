@@ -0,0 +1,160 @@
+// Compares the Fox-Wolfram moments of FoxWolfram with the former implementation, which
+// computed every moment with its own double loop over the TLorentzVectors, on random
+// events of N = 4...30 objects, and reports the time per event for the six weightings
+// of the first orders. Exits with 2 if any moment differs.
+// Usage: bench_foxwolfram [maxOrder=4] [eventsPerN=2000]
+
+#include "flashgg/Taggers/interface/FoxWolfram.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+    // the per-moment loops FoxWolfram used to run
+    class LegacyFoxWolfram
+    {
+    public:
+        LegacyFoxWolfram( const vector<TLorentzVector> &eventVectors ) : _eventVectors( eventVectors ) {}
+
+        double getMoment( FoxWolfram::WeightType wType, unsigned int order )
+        {
+            if( wType == FoxWolfram::ETA ) {
+                double avgEta = 0.0;
+                for( unsigned int i = 0; i < _eventVectors.size(); ++i ) { avgEta += _eventVectors[i].Eta(); }
+                avgEta /= _eventVectors.size();
+                double norm = 0.0;
+                double sum = 0.0;
+                for( unsigned int i = 0; i < _eventVectors.size(); ++i ) {
+                    norm += 1.0 / ( fabs( _eventVectors[i].Eta() - avgEta ) );
+                    for( unsigned int j = 0; j < _eventVectors.size(); ++j ) {
+                        double angle = cosTheta( _eventVectors[i], _eventVectors[j] );
+                        sum += 1.0 / ( fabs( _eventVectors[i].Eta() - avgEta ) * fabs( _eventVectors[j].Eta() - avgEta ) ) * ROOT::Math::legendre( order, angle );
+                    }
+                }
+                return sum / norm / norm;
+            }
+            double sum = 0.0;
+            double norm = 0.0;
+            TLorentzVector shat( 0, 0, 0, 0 );
+            for( unsigned int i = 0; i < _eventVectors.size(); ++i ) {
+                shat += _eventVectors[i];
+                norm += weight( wType, _eventVectors[i] );
+                for( unsigned int j = 0; j < _eventVectors.size(); ++j ) {
+                    double angle = cosTheta( _eventVectors[i], _eventVectors[j] );
+                    if( wType == FoxWolfram::ONE ) {
+                        sum += ROOT::Math::legendre( order, angle );
+                    } else {
+                        sum += weight( wType, _eventVectors[i] ) * weight( wType, _eventVectors[j] ) * ROOT::Math::legendre( order, angle );
+                    }
+                }
+            }
+            if( wType == FoxWolfram::ONE ) { return sum; }
+            if( wType == FoxWolfram::SHAT ) { return sum / shat.P() / shat.P(); }
+            return sum / norm / norm;
+        }
+
+    private:
+        static double weight( FoxWolfram::WeightType wType, const TLorentzVector &v )
+        {
+            switch( wType ) {
+            case FoxWolfram::PT: return v.Pt();
+            case FoxWolfram::PZ: return v.Pz();
+            default: return v.P();
+            }
+        }
+
+        static double cosTheta( const TLorentzVector &v1, const TLorentzVector &v2 )
+        {
+            double ret = 0;
+            if( v1.P() != 0 && v2.P() != 0 ) {
+                ret = ( v1.Px() * v2.Px() + v1.Py() * v2.Py() + v1.Pz() * v2.Pz() ) / ( v1.P() * v2.P() );
+            }
+            if( ret > 0.9999 ) { ret = 0.9999; }
+            else if( ret < -0.9999 ) { ret = -0.9999; }
+            return ret;
+        }
+
+        vector<TLorentzVector> _eventVectors;
+    };
+
+    bool same( double a, double b )
+    {
+        return ( a == b ) || ( a != a && b != b ) || memcmp( &a, &b, sizeof( double ) ) == 0;
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    unsigned int maxOrder = ( argc > 1 ? atoi( argv[1] ) : 4 );
+    unsigned int eventsPerN = ( argc > 2 ? atoi( argv[2] ) : 2000 );
+    const vector<FoxWolfram::WeightType> weights = { FoxWolfram::SHAT, FoxWolfram::PT, FoxWolfram::ETA,
+                                                     FoxWolfram::PSUM, FoxWolfram::PZ, FoxWolfram::ONE };
+
+    mt19937 rng( 20190101 );
+    exponential_distribution<double> ptDist( 1. / 40. );
+    uniform_real_distribution<double> etaDist( -4.7, 4.7 ), phiDist( -M_PI, M_PI );
+
+    unsigned long nDifferent = 0;
+    printf( "%4s %14s %14s %9s\n", "N", "legacy [us]", "new [us]", "speedup" );
+    for( unsigned int n = 4 ; n <= 30 ; n++ ) {
+        vector<vector<TLorentzVector> > events( eventsPerN );
+        for( auto &event : events ) {
+            for( unsigned int i = 0 ; i < n ; i++ ) {
+                TLorentzVector v;
+                v.SetPtEtaPhiM( 15. + ptDist( rng ), etaDist( rng ), phiDist( rng ), 0. );
+                event.push_back( v );
+            }
+        }
+
+        vector<double> legacyMoments, newMoments;
+        legacyMoments.reserve( eventsPerN * maxOrder * weights.size() );
+        newMoments.reserve( eventsPerN * maxOrder * weights.size() );
+
+        auto start = chrono::steady_clock::now();
+        for( auto &event : events ) {
+            LegacyFoxWolfram fw( event );
+            for( unsigned int order = 1 ; order <= maxOrder ; order++ ) {
+                for( auto wType : weights ) { legacyMoments.push_back( fw.getMoment( wType, order ) ); }
+            }
+        }
+        double legacyTime = chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+
+        start = chrono::steady_clock::now();
+        for( auto &event : events ) {
+            FoxWolfram fw( event );
+            for( unsigned int order = 1 ; order <= maxOrder ; order++ ) {
+                for( double moment : fw.getMoments( weights, order ) ) { newMoments.push_back( moment ); }
+            }
+        }
+        double newTime = chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+
+        for( unsigned int i = 0 ; i < legacyMoments.size() ; i++ ) {
+            if( !same( legacyMoments[i], newMoments[i] ) ) {
+                if( nDifferent < 10 ) {
+                    printf( "N=%u moment %u: legacy %.17g new %.17g\n", n, i, legacyMoments[i], newMoments[i] );
+                }
+                nDifferent++;
+            }
+        }
+        printf( "%4u %14.3f %14.3f %9.2f\n", n, legacyTime / eventsPerN, newTime / eventsPerN, legacyTime / newTime );
+    }
+
+    cout << nDifferent << " moments differ" << endl;
+    return ( nDifferent > 0 ? 2 : 0 );
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
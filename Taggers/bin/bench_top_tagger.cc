@@ -0,0 +1,117 @@
+// Compares the resolved top tagger scoring each triplet through TMVA::Reader, as it used to,
+// with the batched TMVAForest scoring, on the jets of the events of a MicroAOD file (ttH
+// hadronic events for a meaningful jet multiplicity). Jets are taken from the collection of
+// the first vertex with the TTHHadronicTagProducer selection (pt > 25, |eta| < 2.4).
+// Reports the time per event and how often the best triplets agree.
+// Usage: bench_top_tagger <MicroAOD file> [weights.xml] [maxEvents=1000] [label=flashggFinalJets]
+
+#include "DataFormats/FWLite/interface/Event.h"
+#include "DataFormats/FWLite/interface/Handle.h"
+#include "FWCore/FWLite/interface/FWLiteEnabler.h"
+#include "FWCore/ParameterSet/interface/FileInPath.h"
+#include "flashgg/DataFormats/interface/Jet.h"
+#include "flashgg/Taggers/interface/BDT_resolvedTopTagger.h"
+
+#include "TFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    struct TopJet {
+        float pt, eta, phi, mass, deepcsv, cvsl, cvsb, ptD, axis1;
+        int mult;
+    };
+
+    double run( flashgg::BDT_resolvedTopTagger &tagger, const vector<vector<TopJet> > &events, vector<vector<float> > &results )
+    {
+        results.clear();
+        auto start = chrono::steady_clock::now();
+        for( const auto &jets : events ) {
+            for( const auto &jet : jets ) {
+                tagger.addJet( jet.pt, jet.eta, jet.phi, jet.mass, jet.deepcsv, jet.cvsl, jet.cvsb, jet.ptD, jet.axis1, jet.mult );
+            }
+            results.push_back( tagger.EvalMVA() );
+            tagger.clear();
+        }
+        return chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 2 ) {
+        cerr << "Usage: " << argv[0] << " <MicroAOD file> [weights.xml] [maxEvents=1000] [label=flashggFinalJets]" << endl;
+        return 1;
+    }
+    string weights = ( argc > 2 && string( argv[2] ) != "-" ? argv[2] : edm::FileInPath( "flashgg/Taggers/data/resTop_xgb_csv_order_deepCTag.xml" ).fullPath() );
+    int maxEvents = ( argc > 3 ? atoi( argv[3] ) : 1000 );
+    string label = ( argc > 4 ? argv[4] : "flashggFinalJets" );
+
+    FWLiteEnabler::enable();
+    TFile *file = TFile::Open( argv[1] );
+    if( !file ) { return 1; }
+
+    vector<vector<TopJet> > events;
+    unsigned long nTriplets = 0;
+    fwlite::Event event( file );
+    int ievent = 0;
+    for( event.toBegin(); !event.atEnd() && ievent < maxEvents; ++event, ++ievent ) {
+        fwlite::Handle<vector<vector<flashgg::Jet> > > jetCollections;
+        jetCollections.getByLabel( event, label.c_str() );
+        if( jetCollections->empty() ) { continue; }
+        vector<TopJet> jets;
+        for( const auto &jet : jetCollections->at( 0 ) ) {
+            if( jet.pt() < 25. || fabs( jet.eta() ) > 2.4 ) { continue; }
+            TopJet top;
+            top.pt = jet.pt();
+            top.eta = jet.eta();
+            top.phi = jet.phi();
+            top.mass = jet.mass();
+            top.deepcsv = jet.bDiscriminator( "pfDeepCSVJetTags:probb" ) + jet.bDiscriminator( "pfDeepCSVJetTags:probbb" );
+            top.cvsl = jet.bDiscriminator( "pfDeepCSVJetTags:probc" ) + jet.bDiscriminator( "pfDeepCSVJetTags:probudsg" );
+            top.cvsb = jet.bDiscriminator( "pfDeepCSVJetTags:probc" ) + jet.bDiscriminator( "pfDeepCSVJetTags:probb" ) + jet.bDiscriminator( "pfDeepCSVJetTags:probbb" );
+            top.ptD = jet.userFloat( "ptD" );
+            top.axis1 = jet.userFloat( "axis1" );
+            top.mult = jet.userFloat( "totalMult" );
+            jets.push_back( top );
+        }
+        nTriplets += ( jets.size() < 3 ? 0 : jets.size() * ( jets.size() - 1 ) * ( jets.size() - 2 ) / 6 );
+        events.push_back( jets );
+    }
+    cout << "Read " << events.size() << " events, " << nTriplets << " triplets" << endl;
+    if( events.empty() ) { return 1; }
+
+    flashgg::BDT_resolvedTopTagger readerTagger( weights, true );
+    flashgg::BDT_resolvedTopTagger forestTagger( weights );
+    vector<vector<float> > readerResults, forestResults;
+    double tReader = run( readerTagger, events, readerResults );
+    double tForest = run( forestTagger, events, forestResults );
+
+    unsigned int nSameTriplet = 0;
+    float maxDiff = 0.;
+    for( unsigned int i = 0 ; i < events.size() ; i++ ) {
+        const auto &a = readerResults[i], &b = forestResults[i];
+        if( a[13] == b[13] && a[14] == b[14] && a[15] == b[15] ) { nSameTriplet++; }
+        maxDiff = max( maxDiff, fabs( a[0] - b[0] ) );
+    }
+
+    cout << "TMVA::Reader per triplet: " << tReader / events.size() << " us/event" << endl;
+    cout << "TMVAForest batched:       " << tForest / events.size() << " us/event (x" << tReader / tForest << ")" << endl;
+    cout << "Same best triplet in " << nSameTriplet << "/" << events.size() << " events, max score difference " << maxDiff << endl;
+    return 0;
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
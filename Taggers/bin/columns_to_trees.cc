@@ -0,0 +1,133 @@
+// Rebuilds the per-category trees of a CollectionDumper from its columnar output (dumpColumns option,
+// see Taggers/interface/ColumnarTree.h). The trees are written to <directory>/trees, as dumpTrees would.
+// Only the trees whose name matches the optional regular expression are rebuilt.
+// Usage: columns_to_trees <input file> <output file> [directory=tagsDumper] [columns=columns] [regex]
+
+#include "TBranch.h"
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TTree.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 3 ) {
+        cerr << "Usage: " << argv[0] << " <input file> <output file> [directory=tagsDumper] [columns=columns] [regex]" << endl;
+        return 1;
+    }
+    string directory = ( argc > 3 ? argv[3] : "tagsDumper" );
+    string columnsName = ( argc > 4 ? argv[4] : "columns" );
+    regex selection( argc > 5 ? argv[5] : ".*" );
+
+    unique_ptr<TFile> input( TFile::Open( argv[1] ) );
+    if( !input || input->IsZombie() ) { return 1; }
+    TTree *columns = dynamic_cast<TTree *>( input->Get( ( directory + "/" + columnsName ).c_str() ) );
+    TTree *dictionary = dynamic_cast<TTree *>( input->Get( ( directory + "/" + columnsName + "_dictionary" ).c_str() ) );
+    if( !columns || !dictionary ) {
+        cerr << "Could not find " << directory << "/" << columnsName << " and its dictionary in " << argv[1] << endl;
+        return 1;
+    }
+
+    unique_ptr<TFile> output( TFile::Open( argv[2], "RECREATE" ) );
+    if( !output || output->IsZombie() ) { return 1; }
+    TDirectory *treesDir = output->mkdir( directory.c_str() )->mkdir( "trees" );
+
+    string *treeName = 0;
+    vector<string> *branches = 0;
+    int dumper, nPdfWeights, nAlphaSWeights, nScaleWeights;
+    dictionary->SetBranchAddress( "tree", &treeName );
+    dictionary->SetBranchAddress( "branches", &branches );
+    dictionary->SetBranchAddress( "dumper", &dumper );
+    dictionary->SetBranchAddress( "nPdfWeights", &nPdfWeights );
+    dictionary->SetBranchAddress( "nAlphaSWeights", &nAlphaSWeights );
+    dictionary->SetBranchAddress( "nScaleWeights", &nScaleWeights );
+    auto arrays = [&]() -> vector<pair<string, int> > {
+        return { { "pdfWeights", nPdfWeights }, { "alphaSWeights", nAlphaSWeights }, { "scaleWeights", nScaleWeights } };
+    };
+
+    // one buffer per input branch, shared by all the output trees using it and sized
+    // before booking so that the addresses do not change
+    map<string, vector<double> > buffers;
+    for( Long64_t ientry = 0; ientry < dictionary->GetEntries(); ++ientry ) {
+        dictionary->GetEntry( ientry );
+        if( !regex_match( *treeName, selection ) ) { continue; }
+        for( auto &name : *branches ) { buffers[name].resize( 1 ); }
+        for( auto &array : arrays() ) {
+            if( array.second == 0 ) { continue; }
+            // the arrays are float, two per buffer element
+            auto &buf = buffers[array.first];
+            buf.resize( max( buf.size(), ( size_t )( array.second + 1 ) / 2 ) );
+        }
+    }
+
+    vector<TTree *> outputs;
+    for( Long64_t ientry = 0; ientry < dictionary->GetEntries(); ++ientry ) {
+        dictionary->GetEntry( ientry );
+        if( !regex_match( *treeName, selection ) ) { continue; }
+        if( ( size_t )dumper >= outputs.size() ) { outputs.resize( dumper + 1, 0 ); }
+        treesDir->cd();
+        TTree *tree = new TTree( treeName->c_str(), treeName->c_str() );
+        outputs[dumper] = tree;
+        for( auto &name : *branches ) {
+            TBranch *branch = columns->GetBranch( name.c_str() );
+            if( !branch ) {
+                cerr << "Branch " << name << " of " << *treeName << " missing from " << columnsName << endl;
+                return 1;
+            }
+            // the title of the branches booked by the dumpers is their leaf list
+            tree->Branch( name.c_str(), &buffers[name][0], branch->GetTitle() );
+        }
+        for( auto &array : arrays() ) {
+            if( array.second == 0 ) { continue; }
+            tree->Branch( array.first.c_str(), &buffers[array.first][0], ( array.first + "[" + to_string( array.second ) + "]/F" ).c_str() );
+        }
+    }
+
+    columns->SetBranchStatus( "*", 0 );
+    for( auto &buf : buffers ) {
+        columns->SetBranchStatus( buf.first.c_str(), 1 );
+        columns->SetBranchAddress( buf.first.c_str(), &buf.second[0] );
+    }
+    // counters of the pdf weight arrays
+    const vector<pair<string, string> > counters = { { "pdfWeights", "nPdfWeights" }, { "alphaSWeights", "nAlphaSWeights" }, { "scaleWeights", "nScaleWeights" } };
+    for( auto &counter : counters ) {
+        if( buffers.count( counter.first ) ) { columns->SetBranchStatus( counter.second.c_str(), 1 ); }
+    }
+    int entryDumper;
+    TBranch *dumperBranch = columns->GetBranch( "dumper" );
+    columns->SetBranchStatus( "dumper", 1 );
+    columns->SetBranchAddress( "dumper", &entryDumper );
+
+    Long64_t nfilled = 0;
+    for( Long64_t ientry = 0; ientry < columns->GetEntries(); ++ientry ) {
+        // read the other columns only for the selected dumpers
+        dumperBranch->GetEntry( ientry );
+        if( ( size_t )entryDumper >= outputs.size() || !outputs[entryDumper] ) { continue; }
+        columns->GetEntry( ientry );
+        outputs[entryDumper]->Fill();
+        ++nfilled;
+    }
+
+    output->Write();
+    size_t ntrees = 0;
+    for( auto tree : outputs ) { ntrees += ( tree != 0 ); }
+    cout << "Rebuilt " << ntrees << " trees with " << nfilled << " entries out of " << columns->GetEntries() << endl;
+    return 0;
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
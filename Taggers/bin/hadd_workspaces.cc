@@ -1,5 +1,19 @@
 // Benoit Courbon
 // https://github.com/bcourbon/flashgg/blob/132cd5163b3564da81b79b91829e9aec47126b78/TagAlgos/bin/hadd_workspaces.cc
+//
+// Usage: hadd_workspaces [-j workers] [-n fanIn] [-d tmpdir] <output> <input1> [<input2> ...]
+//
+// Without options the inputs are merged in one go, as they always were.
+// With -j and/or -n the workspaces are reduced in a tree: the inputs are split into
+// consecutive groups of at most fanIn files, each group is merged by a forked worker
+// (at most -j at a time) into a temporary file, and so on until at most fanIn files are
+// left for the final merge. Groups are consecutive and the datahists of each input are
+// kept separate until the final merge, so the output is the same as the one-go merge.
+// Trees and histograms are merged by a single hadd of all the inputs, which runs in
+// its own worker at the same time.
+// -d only moves the temporary files (the intermediate merges and the hadd output of the
+// trees and histograms) from next to the output to tmpdir: it does not turn on the tree
+// reduction by itself, in any mode.
 
 #include "TDirectoryFile.h"
 #include <string>
@@ -7,19 +21,185 @@
 #include "../src/WorkspaceCombiner.cc"
 #include <vector>
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// exit statuses of the workers that ended while waiting for other ones
+static std::map<pid_t, int> finishedWorkers;
+
+static std::string MemoryReport()
+{
+    long rss = 0, pages = 0;
+    std::ifstream statm( "/proc/self/statm" );
+    if( statm >> pages >> rss ) { rss *= sysconf( _SC_PAGESIZE ) / 1024; }
+    struct rusage self, children;
+    getrusage( RUSAGE_SELF, &self );
+    getrusage( RUSAGE_CHILDREN, &children );
+    std::ostringstream report;
+    report << std::fixed << std::setprecision( 1 ) << "rss " << rss / 1024. << " MB, peak " << self.ru_maxrss / 1024.
+           << " MB, largest worker peak " << children.ru_maxrss / 1024. << " MB";
+    return report.str();
+}
+
+static bool WaitForWorker( pid_t pid )
+{
+    int status = 0;
+    auto done = finishedWorkers.find( pid );
+    if( done != finishedWorkers.end() ) {
+        status = done->second;
+    } else if( waitpid( pid, &status, 0 ) != pid ) {
+        return false;
+    }
+    return WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+}
+
+// Runs work(0) ... work(njobs-1) in forked workers, at most nworkers at a time.
+// done(i) is called in the parent as each job finishes. Returns false if any job failed.
+static bool RunInWorkers( int nworkers, size_t njobs, std::function<int( size_t )> work, std::function<void( size_t )> done )
+{
+    std::map<pid_t, size_t> running;
+    size_t next = 0;
+    bool ok = true;
+    while( next < njobs || !running.empty() ) {
+        while( ok && next < njobs && ( int )running.size() < std::max( nworkers, 1 ) ) {
+            pid_t pid = fork();
+            if( pid == 0 ) {
+                int status = work( next );
+                std::cout.flush();
+                _exit( status );
+            }
+            if( pid < 0 ) {
+                perror( "hadd_workspaces: fork" );
+                ok = false;
+                break;
+            }
+            running[pid] = next++;
+        }
+        if( running.empty() ) { break; }
+        int status = 0;
+        pid_t pid = waitpid( -1, &status, 0 );
+        if( pid < 0 ) {
+            perror( "hadd_workspaces: waitpid" );
+            return false;
+        }
+        auto job = running.find( pid );
+        if( job == running.end() ) {
+            finishedWorkers[pid] = status;
+            continue;
+        }
+        if( !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) {
+            std::cerr << "hadd_workspaces: worker for job " << job->second << " failed" << std::endl;
+            ok = false;
+        } else {
+            done( job->second );
+        }
+        running.erase( job );
+    }
+    return ok;
+}
 
 int main( int argc, char *argv[] )
 {
     bool doTreesAndHistograms = true;
 
+    int nworkers = 1;
+    int fanIn = 0;
+    std::string tmpdir;
+    int iarg = 1;
+    for( ; iarg < argc && argv[iarg][0] == '-' && iarg + 1 < argc; iarg += 2 ) {
+        std::string option( argv[iarg] );
+        if( option == "-j" ) { nworkers = atoi( argv[iarg + 1] ); }
+        else if( option == "-n" ) { fanIn = atoi( argv[iarg + 1] ); }
+        else if( option == "-d" ) { tmpdir = argv[iarg + 1]; }
+        else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+    if( argc - iarg < 2 ) {
+        std::cerr << "Usage: " << argv[0] << " [-j workers] [-n fanIn] [-d tmpdir] <output> <input1> [<input2> ...]" << std::endl
+                  << "  -j workers  merge in a tree with at most this many forked workers" << std::endl
+                  << "  -n fanIn    merge in a tree, at most this many files per merge" << std::endl
+                  << "  -d tmpdir   directory for the temporary files (default: next to the output), does not enable the tree merge" << std::endl;
+        return 1;
+    }
+
     std::vector<string> input;
-    std::string outputfile = argv[1];
+    std::string outputfile = argv[iarg];
+
+    for( int f = iarg + 1; f < argc; f++ ) { input.push_back( argv[f] ); }
+
+    if( nworkers > 1 && fanIn <= 0 ) { fanIn = std::max<int>( 2, ( input.size() + nworkers - 1 ) / nworkers ); }
+    if( fanIn == 1 ) { fanIn = 2; }
+    bool reduceInTree = ( fanIn > 0 && input.size() > ( size_t )fanIn );
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() { return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(); };
 
-    for( int f = 2; f < argc; f++ ) { input.push_back( argv[f] ); }
+    std::string outputBase = outputfile;
+    if( outputBase.size() > 5 && outputBase.compare( outputBase.size() - 5, 5, ".root" ) == 0 ) { outputBase.erase( outputBase.size() - 5 ); }
+    if( !tmpdir.empty() ) { outputBase = tmpdir + "/" + outputBase.substr( outputBase.rfind( '/' ) + 1 ); }
+    std::string auxfile = outputBase + "_treesAndHistos.root";
+
+    // trees and histograms: the same hadd as in WorkspaceCombiner::MergeTreesAndHistograms, in its own worker
+    pid_t haddPid = -1;
+    if( doTreesAndHistograms && ( reduceInTree || nworkers > 1 ) ) {
+        haddPid = fork();
+        if( haddPid == 0 ) {
+            std::vector<char *> args = { ( char * )"hadd", ( char * )"-f", ( char * )auxfile.c_str() };
+            for( auto &name : input ) { args.push_back( ( char * )name.c_str() ); }
+            args.push_back( 0 );
+            execvp( "hadd", &args[0] );
+            perror( "hadd_workspaces: hadd" );
+            _exit( 1 );
+        }
+        if( haddPid < 0 ) {
+            perror( "hadd_workspaces: fork" );
+            return 1;
+        }
+        cout << endl << " Merging trees and histos in process " << haddPid << endl << endl;
+    }
+
+    std::vector<string> files = input;
+    std::vector<string> temporaries;
+    for( int level = 0; reduceInTree && files.size() > ( size_t )fanIn; ++level ) {
+        size_t ngroups = ( files.size() + fanIn - 1 ) / fanIn;
+        std::vector<string> outputs;
+        for( size_t g = 0; g < ngroups; g++ ) { outputs.push_back( Form( "%s_merge%d_%zu.root", outputBase.c_str(), level, g ) ); }
+        cout << endl << " Level " << level << ": merging " << files.size() << " files into " << ngroups << " with " << nworkers << " workers" << endl << endl;
+        size_t ndone = 0;
+        bool ok = RunInWorkers( nworkers, ngroups,
+        [&]( size_t g ) {
+            std::vector<string> group( files.begin() + g * fanIn, files.begin() + std::min( files.size(), ( g + 1 ) * fanIn ) );
+            WorkspaceCombiner merger;
+            merger.Init( outputs[g], group );
+            merger.SetKeepDataHistParts( true );
+            merger.GetWorkspaces( merger.GetFirstFile() );
+            merger.MergeWorkspaces();
+            merger.Save( false );
+            return 0;
+        },
+        [&]( size_t g ) {
+            cout << "[hadd_workspaces] level " << level << " group " << g << " done (" << ++ndone << "/" << ngroups << "), "
+                 << elapsed() << " s, " << MemoryReport() << endl;
+        } );
+        for( auto &name : temporaries ) { remove( name.c_str() ); }
+        temporaries = outputs;
+        if( !ok ) {
+            for( auto &name : temporaries ) { remove( name.c_str() ); }
+            return 1;
+        }
+        files = outputs;
+    }
 
     WorkspaceCombiner merger;
 
-    merger.Init( outputfile, input );
+    merger.Init( outputfile, files );
+    merger.SetAuxFileName( auxfile );
 
     cout << endl << "Initialization" << endl << endl;
 
@@ -31,13 +211,24 @@ int main( int argc, char *argv[] )
 
     if( doTreesAndHistograms ) {
         cout << endl << " Merging trees and histos " << endl << endl;
-        merger.GetTreesAndHistograms( merger.MergeTreesAndHistograms() );
+        if( haddPid > 0 ) {
+            if( !WaitForWorker( haddPid ) ) {
+                std::cerr << "hadd_workspaces: merging trees and histograms failed" << std::endl;
+                return 1;
+            }
+            merger.GetTreesAndHistograms( TFile::Open( auxfile.c_str() ) );
+        } else {
+            merger.GetTreesAndHistograms( merger.MergeTreesAndHistograms() );
+        }
         cout << endl << " Saving workspaces, histograms and trees " << endl << endl;
     } else {
         cout << endl << " Skipping trees and histos, saving workspaces only" << endl << endl;
     }
 
     merger.Save( doTreesAndHistograms );
+
+    for( auto &name : temporaries ) { remove( name.c_str() ); }
+    cout << "[hadd_workspaces] merged " << input.size() << " files in " << elapsed() << " s, " << MemoryReport() << endl;
 }
 
 // Local Variables:
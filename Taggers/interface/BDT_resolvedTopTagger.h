@@ -8,6 +8,8 @@
 #include "DataFormats/Math/interface/LorentzVector.h"
 #include <DataFormats/Math/interface/deltaR.h>
 #include "TMVA/Reader.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "flashgg/MicroAOD/interface/TMVAForest.h"
 #include <iostream>
 #include <algorithm>
 
@@ -57,10 +59,14 @@ public:
   int j3idx = -99;
 };
 
+// The triplets are built from per-jet inputs and per-pair deltaR and masses computed once per
+// event; the ones in the top mass window are scored together by a flat TMVAForest, which agrees
+// with TMVA::Reader to rounding. The reader is used instead when asked for, or when the weight
+// file cannot be read by TMVAForest.
 class BDT_resolvedTopTagger {
 public:
-  BDT_resolvedTopTagger(std::string weight_file_name){
-    Init(weight_file_name);
+  BDT_resolvedTopTagger(std::string weight_file_name, bool useTMVAReader = false){
+    Init(weight_file_name, useTMVAReader);
   };
   ~BDT_resolvedTopTagger(){
     clear();
@@ -69,17 +75,38 @@ public:
     jets.push_back(std::make_shared<BDT_rTT_Jet>(pt,eta,phi,mass,deepcsv,cvsl,cvsb,ptD,axis1,mult));
   };
   void clear();
-  void Init(std::string weight_file_name);
+  void Init(std::string weight_file_name, bool useTMVAReader = false);
+  // best candidate: score, top and W kinematics, jet indices (after sorting by deepcsv); -99 if none
   std::vector<float> EvalMVA();
+  // the topK best candidates, best first, each in the format of EvalMVA()
+  std::vector<std::vector<float> > EvalMVA(unsigned int topK);
   void setDebug(bool val){debug = val;};
 
 private:
 
-  float EvalScore(const std::shared_ptr<BDT_rTT_top>);
+  static constexpr unsigned int nJetVars = 8;
+  static constexpr unsigned int nVars = 3*nJetVars+8;
+
+  struct Candidate {
+    int j1idx, j2idx, j3idx; // j2 is the leading W jet
+    BDT_rTT_ptvec p4, p4w;
+  };
+
+  float EvalScore(const float *row);
+  std::vector<float> Output(const Candidate &top, float score) const;
 
   std::vector<std::shared_ptr<BDT_rTT_Jet>> jets;
 
   std::shared_ptr<TMVA::Reader> TMVAReader_ = nullptr;
+  std::shared_ptr<const TMVAForest> forest_ = nullptr;
+
+  // per-event buffers
+  std::vector<float> jetVars_;   // nJetVars per jet
+  std::vector<float> pairDR_;    // njets x njets
+  std::vector<float> pairMass_;  // njets x njets
+  std::vector<Candidate> cands_;
+  std::vector<float> rows_;      // nVars per candidate
+  std::vector<double> scores_;
 
   float var_b_pt = -99;
   float var_b_mass = -99;
@@ -122,7 +149,26 @@ private:
 };
 
 inline
-void BDT_resolvedTopTagger::Init(std::string weight_file_name){
+void BDT_resolvedTopTagger::Init(std::string weight_file_name, bool useTMVAReader){
+
+  if (!useTMVAReader) {
+    try {
+      forest_ = TMVAForest::get(weight_file_name);
+    } catch (cms::Exception &e) {
+      std::cout << "BDT_resolvedTopTagger: using TMVA::Reader, " << e.what() << std::endl;
+      forest_ = nullptr;
+    }
+  }
+  const std::vector<std::string> variables = {
+    "var_b_pt", "var_b_mass", "var_b_ptD", "var_b_axis1", "var_b_mult", "var_b_deepcsv_bvsall", "var_b_deepcsv_cvsb", "var_b_deepcsv_cvsl",
+    "var_wj1_pt", "var_wj1_mass", "var_wj1_ptD", "var_wj1_axis1", "var_wj1_mult", "var_wj1_deepcsv_bvsall", "var_wj1_deepcsv_cvsb", "var_wj1_deepcsv_cvsl",
+    "var_wj2_pt", "var_wj2_mass", "var_wj2_ptD", "var_wj2_axis1", "var_wj2_mult", "var_wj2_deepcsv_bvsall", "var_wj2_deepcsv_cvsb", "var_wj2_deepcsv_cvsl",
+    "var_b_wj1_deltaR", "var_b_wj1_mass", "var_b_wj2_deltaR", "var_b_wj2_mass", "var_wcand_deltaR", "var_wcand_mass", "var_b_wcand_deltaR", "var_topcand_mass" };
+  if (forest_ && forest_->variables() != variables) {
+    std::cout << "BDT_resolvedTopTagger: using TMVA::Reader, the variables of " << weight_file_name << " are not in the expected order" << std::endl;
+    forest_ = nullptr;
+  }
+  if (forest_) return;
 
   TMVAReader_ = std::make_shared<TMVA::Reader>( "!Color:!Silent" );
 
@@ -212,130 +258,170 @@ void BDT_resolvedTopTagger::clear(){
 inline
 std::vector<float> BDT_resolvedTopTagger::EvalMVA(){
 
+  std::vector<std::vector<float> > tops = EvalMVA(1);
+  return tops.empty() ? std::vector<float>(16,-99) : tops[0];
+
+};
+
+inline
+std::vector<std::vector<float> > BDT_resolvedTopTagger::EvalMVA(unsigned int topK){
+
   int njets = jets.size();
   std::sort(jets.begin(),jets.end(),[](const std::shared_ptr<BDT_rTT_Jet> &a, const std::shared_ptr<BDT_rTT_Jet> &b){return a->deepcsv() > b->deepcsv();});
 
-  std::vector<std::shared_ptr<BDT_rTT_top>> allcands;
+  // inputs of each jet and of each pair, shared by all the triplets
+  jetVars_.resize(njets*nJetVars);
+  pairDR_.resize(njets*njets);
+  pairMass_.resize(njets*njets);
+  for (int i=0; i<njets; i++) {
+    const BDT_rTT_Jet &jet = *jets[i];
+    float *vars = &jetVars_[i*nJetVars];
+    vars[0] = jet.pt();
+    vars[1] = jet.mass();
+    vars[2] = jet.ptD();
+    vars[3] = std::exp(-jet.axis1()); // training uses definition of axis1 without -log
+    vars[4] = jet.mult();
+    vars[5] = jet.deepcsv();
+    vars[6] = jet.cvsb();
+    vars[7] = jet.cvsl();
+    for (int j=i+1; j<njets; j++) {
+      pairDR_[i*njets+j] = pairDR_[j*njets+i] = deltaR(jet.eta(),jet.phi(),jets[j]->eta(),jets[j]->phi());
+      pairMass_[i*njets+j] = pairMass_[j*njets+i] = (static_cast<const BDT_rTT_ptvec&>(jet)+static_cast<const BDT_rTT_ptvec&>(*jets[j])).mass();
+    }
+  }
 
+  // triplets in the top mass window
+  cands_.clear();
+  rows_.clear();
   for (int i1=0; i1<njets-2; i1++) {
     for (int i2=i1+1; i2<njets-1; i2++){
       for (int i3=i2+1; i3<njets; i3++){
-	auto topcand = std::make_shared<BDT_rTT_top>(jets.at(i1),jets.at(i2),jets.at(i3));
-        if ((fabs(topcand->p4->mass()-175)>80)) continue;
-
-        topcand->score = EvalScore(topcand);
-        topcand->j1idx = i1;
-        topcand->j2idx = i2;
-        topcand->j3idx = i3;
-        allcands.push_back(topcand);
+        Candidate top;
+        top.j1idx = i1;
+        top.j2idx = i2;
+        top.j3idx = i3;
+        int w1 = (jets[i2]->pt() > jets[i3]->pt()) ? i2 : i3;
+        int w2 = (w1 == i2) ? i3 : i2;
+        top.p4w = static_cast<const BDT_rTT_ptvec&>(*jets[w1])+static_cast<const BDT_rTT_ptvec&>(*jets[w2]);
+        top.p4 = top.p4w+static_cast<const BDT_rTT_ptvec&>(*jets[i1]);
+        if ((fabs(top.p4.mass()-175)>80)) continue;
+
+        cands_.push_back(top);
+        rows_.insert(rows_.end(),&jetVars_[i1*nJetVars],&jetVars_[i1*nJetVars]+nJetVars);
+        rows_.insert(rows_.end(),&jetVars_[w1*nJetVars],&jetVars_[w1*nJetVars]+nJetVars);
+        rows_.insert(rows_.end(),&jetVars_[w2*nJetVars],&jetVars_[w2*nJetVars]+nJetVars);
+        rows_.push_back(pairDR_[i1*njets+w1]);
+        rows_.push_back(pairMass_[i1*njets+w1]);
+        rows_.push_back(pairDR_[i1*njets+w2]);
+        rows_.push_back(pairMass_[i1*njets+w2]);
+        rows_.push_back(pairDR_[w1*njets+w2]);
+        rows_.push_back(top.p4w.mass());
+        rows_.push_back(deltaR(jets[i1]->eta(),jets[i1]->phi(),top.p4w.eta(),top.p4w.phi()));
+        rows_.push_back(top.p4.mass());
       }
     }
   }
 
   if (debug) std::cout << "njets " << njets << std::endl;
 
-  std::vector<float> output(16,-99);
-  if (allcands.size()>0) {
-    auto top = *std::min_element(allcands.begin(),allcands.end(),[](const std::shared_ptr<BDT_rTT_top> &a, const std::shared_ptr<BDT_rTT_top> &b){return a->score > b->score;});
-    output.at(0) = top->score; // mvaValue
-    output.at(1) = top->p4->pt(); // HadTop_pt
-    output.at(2) = top->p4->eta(); // HadTop_eta
-    output.at(3) = top->p4->phi(); // HadTop_phi
-    output.at(4) = top->p4->mass(); // HadTop_mass
-    output.at(5) = top->p4w->pt(); // W_fromHadTop_pt
-    output.at(6) = top->p4w->eta(); // W_fromHadTop_eta
-    output.at(7) = top->p4w->phi(); // W_fromHadTop_phi
-    output.at(8) = top->p4w->mass(); // W_fromHadTop_mass
-    output.at(9) = std::max(top->j2->deepcsv(),top->j3->deepcsv()); // W_fromHadTop_maxCSVjj
-    output.at(10) = deltaR(top->j2->eta(),top->j2->phi(),top->j3->eta(),top->j3->phi()); // W_fromHadTop_dRjj
-    output.at(11) = deltaR(top->b->eta(),top->b->phi(),top->p4w->eta(),top->p4w->phi()); // W_fromHadTop_dRb
-    output.at(12) = top->b->deepcsv(); // b_fromHadTop_CSV
-    output.at(13) = top->j1idx;
-    output.at(14) = top->j2idx;
-    output.at(15) = top->j3idx;
+  // score them all at once
+  std::vector<float> scores(cands_.size());
+  if (forest_) {
+    scores_.resize(cands_.size());
+    forest_->evaluate(rows_.data(),cands_.size(),scores_.data());
+    for (unsigned int k=0; k<cands_.size(); k++) scores[k] = scores_[k];
+  } else {
+    for (unsigned int k=0; k<cands_.size(); k++) scores[k] = EvalScore(&rows_[k*nVars]);
   }
-  if (debug) std::cout << "returning " << output.at(0) << std::endl;
+
+  // best first; among equal scores the first triplet, as the single best candidate always was
+  std::vector<unsigned int> order(cands_.size());
+  for (unsigned int k=0; k<order.size(); k++) order[k] = k;
+  unsigned int nout = std::min<size_t>(topK,order.size());
+  std::partial_sort(order.begin(),order.begin()+nout,order.end(),[&scores](unsigned int a, unsigned int b){
+      return (scores[a] > scores[b]) || (scores[a] == scores[b] && a < b);});
+
+  std::vector<std::vector<float> > output;
+  for (unsigned int k=0; k<nout; k++) output.push_back(Output(cands_[order[k]],scores[order[k]]));
+  if (debug) std::cout << "returning " << (output.empty() ? -99 : output[0].at(0)) << std::endl;
+  return output;
+
+};
+
+inline
+std::vector<float> BDT_resolvedTopTagger::Output(const Candidate &top, float score) const {
+
+  const BDT_rTT_Jet &b = *jets[top.j1idx];
+  int w1 = (jets[top.j2idx]->pt() > jets[top.j3idx]->pt()) ? top.j2idx : top.j3idx;
+  int w2 = (w1 == top.j2idx) ? top.j3idx : top.j2idx;
+  const BDT_rTT_Jet &j2 = *jets[w1];
+  const BDT_rTT_Jet &j3 = *jets[w2];
+
+  std::vector<float> output(16,-99);
+  output.at(0) = score; // mvaValue
+  output.at(1) = top.p4.pt(); // HadTop_pt
+  output.at(2) = top.p4.eta(); // HadTop_eta
+  output.at(3) = top.p4.phi(); // HadTop_phi
+  output.at(4) = top.p4.mass(); // HadTop_mass
+  output.at(5) = top.p4w.pt(); // W_fromHadTop_pt
+  output.at(6) = top.p4w.eta(); // W_fromHadTop_eta
+  output.at(7) = top.p4w.phi(); // W_fromHadTop_phi
+  output.at(8) = top.p4w.mass(); // W_fromHadTop_mass
+  output.at(9) = std::max(j2.deepcsv(),j3.deepcsv()); // W_fromHadTop_maxCSVjj
+  output.at(10) = deltaR(j2.eta(),j2.phi(),j3.eta(),j3.phi()); // W_fromHadTop_dRjj
+  output.at(11) = deltaR(b.eta(),b.phi(),top.p4w.eta(),top.p4w.phi()); // W_fromHadTop_dRb
+  output.at(12) = b.deepcsv(); // b_fromHadTop_CSV
+  output.at(13) = top.j1idx;
+  output.at(14) = top.j2idx;
+  output.at(15) = top.j3idx;
   return output;
 
 };
 
 inline
-float BDT_resolvedTopTagger::EvalScore(const std::shared_ptr<BDT_rTT_top> top){
-
-  var_b_pt = top->b->pt();
-  var_b_mass = top->b->mass();
-  var_b_ptD = top->b->ptD();
-  var_b_axis1 = std::exp(-top->b->axis1()); // training uses definition of axis1 without -log
-  var_b_mult = top->b->mult();
-  var_b_csv = top->b->deepcsv();
-  var_b_cvsb = top->b->cvsb();
-  var_b_cvsl = top->b->cvsl();
-
-  var_wj1_pt = top->j2->pt();
-  var_wj1_mass = top->j2->mass();
-  var_wj1_ptD = top->j2->ptD();
-  var_wj1_axis1 = std::exp(-top->j2->axis1()); // training uses definition of axis1 without -log
-  var_wj1_mult = top->j2->mult();
-  var_wj1_csv = top->j2->deepcsv();
-  var_wj1_cvsb = top->j2->cvsb();
-  var_wj1_cvsl = top->j2->cvsl();
-
-  var_wj2_pt = top->j3->pt();
-  var_wj2_mass = top->j3->mass();
-  var_wj2_ptD = top->j3->ptD();
-  var_wj2_axis1 = std::exp(-top->j3->axis1()); // training uses definition of axis1 without -log
-  var_wj2_mult = top->j3->mult();
-  var_wj2_csv = top->j3->deepcsv();
-  var_wj2_cvsb = top->j3->cvsb();
-  var_wj2_cvsl = top->j3->cvsl();
-
-  var_b_wj1_deltaR = deltaR(top->b->eta(),top->b->phi(),top->j2->eta(),top->j2->phi());
-  var_b_wj1_mass = (*(dynamic_cast<BDT_rTT_ptvec*>(top->b.get()))+*(dynamic_cast<BDT_rTT_ptvec*>(top->j2.get()))).mass();
-  var_b_wj2_deltaR = deltaR(top->b->eta(),top->b->phi(),top->j3->eta(),top->j3->phi());
-  var_b_wj2_mass = (*(dynamic_cast<BDT_rTT_ptvec*>(top->b.get()))+*(dynamic_cast<BDT_rTT_ptvec*>(top->j3.get()))).mass();
-  var_wcand_deltaR = deltaR(top->j2->eta(),top->j2->phi(),top->j3->eta(),top->j3->phi());
-  var_wcand_mass = top->p4w->mass();
-  var_b_wcand_deltaR = deltaR(top->b->eta(),top->b->phi(),top->p4w->eta(),top->p4w->phi());
-  var_topcand_mass = top->p4->mass();
+float BDT_resolvedTopTagger::EvalScore(const float *row){
+
+  var_b_pt = row[0];
+  var_b_mass = row[1];
+  var_b_ptD = row[2];
+  var_b_axis1 = row[3];
+  var_b_mult = row[4];
+  var_b_csv = row[5];
+  var_b_cvsb = row[6];
+  var_b_cvsl = row[7];
+
+  var_wj1_pt = row[8];
+  var_wj1_mass = row[9];
+  var_wj1_ptD = row[10];
+  var_wj1_axis1 = row[11];
+  var_wj1_mult = row[12];
+  var_wj1_csv = row[13];
+  var_wj1_cvsb = row[14];
+  var_wj1_cvsl = row[15];
+
+  var_wj2_pt = row[16];
+  var_wj2_mass = row[17];
+  var_wj2_ptD = row[18];
+  var_wj2_axis1 = row[19];
+  var_wj2_mult = row[20];
+  var_wj2_csv = row[21];
+  var_wj2_cvsb = row[22];
+  var_wj2_cvsl = row[23];
+
+  var_b_wj1_deltaR = row[24];
+  var_b_wj1_mass = row[25];
+  var_b_wj2_deltaR = row[26];
+  var_b_wj2_mass = row[27];
+  var_wcand_deltaR = row[28];
+  var_wcand_mass = row[29];
+  var_b_wcand_deltaR = row[30];
+  var_topcand_mass = row[31];
 
   float score = TMVAReader_->EvaluateMVA("BDT");
 
   if (debug) {
-    std::cout <<  var_b_pt << " " ;
-    std::cout <<  var_b_mass << " " ;
-    std::cout <<  var_b_ptD << " " ;
-    std::cout <<  var_b_axis1 << " " ;
-    std::cout <<  var_b_mult << " " ;
-    std::cout <<  var_b_csv << " " ;
-    std::cout <<  var_b_cvsb << " " ;
-    std::cout <<  var_b_cvsl << " " ;
-
-    std::cout <<  var_wj1_pt << " " ;
-    std::cout <<  var_wj1_mass << " " ;
-    std::cout <<  var_wj1_ptD << " " ;
-    std::cout <<  var_wj1_axis1 << " " ;
-    std::cout <<  var_wj1_mult << " " ;
-    std::cout <<  var_wj1_csv << " " ;
-    std::cout <<  var_wj1_cvsb << " " ;
-    std::cout <<  var_wj1_cvsl << " " ;
-
-    std::cout <<  var_wj2_pt << " " ;
-    std::cout <<  var_wj2_mass << " " ;
-    std::cout <<  var_wj2_ptD << " " ;
-    std::cout <<  var_wj2_axis1 << " " ;
-    std::cout <<  var_wj2_mult << " " ;
-    std::cout <<  var_wj2_csv << " " ;
-    std::cout <<  var_wj2_cvsb << " " ;
-    std::cout <<  var_wj2_cvsl << " " ;
-
-    std::cout <<  var_b_wj1_deltaR << " " ;
-    std::cout <<  var_b_wj1_mass << " " ;
-    std::cout <<  var_b_wj2_deltaR << " " ;
-    std::cout <<  var_b_wj2_mass << " " ;
-    std::cout <<  var_wcand_deltaR << " " ;
-    std::cout <<  var_wcand_mass << " " ;
-    std::cout <<  var_b_wcand_deltaR << " " ;
-    std::cout <<  var_topcand_mass << " " << std::endl;
+    for (unsigned int i=0; i<nVars; i++) std::cout << row[i] << " " ;
+    std::cout << std::endl;
     std::cout << score << std::endl;
   }
 
@@ -24,8 +24,10 @@
 #include "CommonTools/Utils/interface/StringCutObjectSelector.h"
 
 #include "flashgg/Taggers/interface/GlobalVariablesDumper.h"
+#include "flashgg/Taggers/interface/ColumnarTree.h"
 #include "flashgg/MicroAOD/interface/MVAComputer.h"
 #include "flashgg/MicroAOD/interface/StepWiseFunctor.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
 
 namespace flashgg {
 
@@ -118,16 +120,20 @@ namespace flashgg {
         typedef FunctorMVAWrapper<object_type, mva_type> wrapped_mva_type;
         typedef GlobalVarWrapper<object_type> wrapped_global_var_type;
 
-        CategoryDumper( const std::string &name, const edm::ParameterSet &cfg, GlobalVariablesDumper *dumper = 0 );
+        // compileExpressions: passed on to the functors when they are CompiledObjectFunctions
+        CategoryDumper( const std::string &name, const edm::ParameterSet &cfg, GlobalVariablesDumper *dumper = 0,
+                        bool compileExpressions = ExpressionCompiler::enabled() );
         ~CategoryDumper();
 
         void bookHistos( TFileDirectory &fs, const std::map<std::string, std::string> &replacements );
         void bookTree( TFileDirectory &fs, const char *weightVar, const std::map<std::string, std::string> &replacements );
         void bookRooDataset( RooWorkspace &ws, const char *weightVar, const std::map<std::string, std::string> &replacements);
+        void bookColumns( ColumnarTree &columns, const std::string &category, const std::string &systLabel, int subcat,
+                          const std::map<std::string, std::string> &replacements );
         void compressPdfWeightDatasets(RooWorkspace *ws);
         
 
-        void fill( const object_type &obj, double weight, vector<double>, int n_cand = 0, int htxsBin = -999, double genweight = 1.);
+        void fill( const object_type &obj, double weight, const vector<double> &pdfWeights, int n_cand = 0, int htxsBin = -999, double genweight = 1.);
         string  GetName();
         bool isBinnedOnly();
 
@@ -172,10 +178,26 @@ namespace flashgg {
         bool pdfVarsAdded_;
         bool splitPdfByStage0Bin_;
         bool splitPdfByStage1Bin_;
+
+        // RooRealVar handles resolved in bookRooDataset, 0 for variables not in the arg set
+        RooRealVar *rooWeight_;
+        RooRealVar *rooPdfWeightsWeight_;
+        RooRealVar *rooStageBin_;
+        std::vector<RooRealVar *> rooVarHandles_;
+        std::vector<RooRealVar *> rooPdfVarHandles_;
+        std::vector<RooRealVar *> rooPdfWeightHandles_; // same order as the pdfWeights vector
+        std::vector<RooRealVar *> rooScaleWeightHandles_;
+
+
+        // shared columnar output, column storage is 0 for the variables not dumped
+        ColumnarTree *columns_;
+        int columnsIndex_;
+        std::vector<float *> columnSlots_;
     };
 
     template<class F, class O>
-    CategoryDumper<F, O>::CategoryDumper( const std::string &name, const edm::ParameterSet &cfg, GlobalVariablesDumper *dumper ):
+    CategoryDumper<F, O>::CategoryDumper( const std::string &name, const edm::ParameterSet &cfg, GlobalVariablesDumper *dumper,
+                                          bool compileExpressions ):
         dataset_( 0 ), 
         dataset_pdfWeights_( 0 ), 
         tree_( 0 ), 
@@ -188,7 +210,12 @@ namespace flashgg {
         nAlphaSWeights_(0),
         nScaleWeights_(0),
         splitPdfByStage0Bin_( false ),
-        splitPdfByStage1Bin_( false )
+        splitPdfByStage1Bin_( false ),
+        rooWeight_( 0 ),
+        rooPdfWeightsWeight_( 0 ),
+        rooStageBin_( 0 ),
+        columns_( 0 ),
+        columnsIndex_( -1 )
     {
         using namespace std;
         name_ = name;
@@ -242,13 +269,13 @@ namespace flashgg {
             if( var.existsAs<edm::ParameterSet>( "expr" ) ) {
                 auto expr = var.getParameter<edm::ParameterSet>( "expr" );
                 auto name = var.getUntrackedParameter<string>( "name" );
-                stepwise_functors_.push_back( std::shared_ptr<wrapped_stepwise_functor_type>( new wrapped_stepwise_functor_type( new stepwise_functor_type( expr ) ) ) );
+                stepwise_functors_.push_back( std::shared_ptr<wrapped_stepwise_functor_type>( new wrapped_stepwise_functor_type( new stepwise_functor_type( expr, compileExpressions ) ) ) );
                 names_.push_back( name );
                 variables_.push_back( make_tuple( 0., stepwise_functors_.back(), nbins, vmin, vmax, binning ) );
             } else {
                 auto expr = var.getParameter<string>( "expr" );
                 auto name = var.getUntrackedParameter<string>( "name", expr );
-                functors_.push_back( std::shared_ptr<wrapped_functor_type>( new wrapped_functor_type( new functor_type( expr ) ) ) );
+                functors_.push_back( std::shared_ptr<wrapped_functor_type>( new wrapped_functor_type( new functor_type( FunctorBuilder<functor_type>::build( expr, compileExpressions ) ) ) ) );
                 names_.push_back( name );
                 variables_.push_back( make_tuple( 0., functors_.back(), nbins, vmin, vmax, binning ) );
             }
@@ -262,7 +289,7 @@ namespace flashgg {
                 auto vmin = mva.getUntrackedParameter<double>( "vmin", numeric_limits<double>::lowest() );
                 auto vmax = mva.getUntrackedParameter<double>( "vmax", numeric_limits<double>::max() );
                 vector<double > binning;
-                mvas_.push_back( std::shared_ptr<wrapped_mva_type>( new wrapped_mva_type( new mva_type( mva, globalVarsDumper_ ) ) ) );
+                mvas_.push_back( std::shared_ptr<wrapped_mva_type>( new wrapped_mva_type( new mva_type( mva, globalVarsDumper_, compileExpressions ) ) ) );
                 names_.push_back( name );
                 variables_.push_back( make_tuple( 0., mvas_.back(), nbins, vmin, vmax, binning ) );
             }
@@ -397,6 +424,29 @@ namespace flashgg {
         }
     }
     
+    template<class F, class O>
+    void CategoryDumper<F, O>::bookColumns( ColumnarTree &columns, const std::string &category, const std::string &systLabel, int subcat,
+                                            const std::map<std::string, std::string> &replacements )
+    {
+        std::vector<std::string> dumped;
+        for( auto &name : names_ ) {
+            if( ! dumpOnly_.empty() && find( dumpOnly_.begin(), dumpOnly_.end(), name ) == dumpOnly_.end() ) { continue; }
+            dumped.push_back( name );
+        }
+        columns_ = &columns;
+        columnsIndex_ = columns.addDumper( formatString( name_, replacements ), category, systLabel, subcat, dumped, dumpGenWeight_,
+                                           dumpPdfWeights_ ? nPdfWeights_ : 0, dumpPdfWeights_ ? nAlphaSWeights_ : 0, dumpPdfWeights_ ? nScaleWeights_ : 0 );
+        columnSlots_.clear();
+        size_t icol = 0;
+        for( auto &name : names_ ) {
+            if( ! dumpOnly_.empty() && find( dumpOnly_.begin(), dumpOnly_.end(), name ) == dumpOnly_.end() ) {
+                columnSlots_.push_back( 0 );
+            } else {
+                columnSlots_.push_back( columns.column( columnsIndex_, icol++ ) );
+            }
+        }
+    }
+
     template<class F, class O>
     void CategoryDumper<F, O>::compressPdfWeightDatasets( RooWorkspace * ws)
     {
@@ -593,6 +643,32 @@ namespace flashgg {
         dataset_pdfWeights_ = dset_pdfWeights;
     }
 
+    rooWeight_ = dynamic_cast<RooRealVar *>( rooVars_.find( weightVar ) );
+    rooPdfWeightsWeight_ = dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( weightVar ) );
+    rooStageBin_ = 0;
+    if( splitPdfByStage0Bin_ ) {
+        rooStageBin_ = dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( "stage0bin" ) );
+    } else if( splitPdfByStage1Bin_ ) {
+        rooStageBin_ = dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( "stage1p2bin" ) );
+    }
+    rooVarHandles_.clear();
+    rooPdfVarHandles_.clear();
+    for( auto &name : names_ ) {
+        rooVarHandles_.push_back( dynamic_cast<RooRealVar *>( rooVars_.find( name.c_str() ) ) );
+        rooPdfVarHandles_.push_back( dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( name.c_str() ) ) );
+    }
+    rooPdfWeightHandles_.clear();
+    rooScaleWeightHandles_.clear();
+    for( int i = 0; i < nPdfWeights_; i++ ) {
+        rooPdfWeightHandles_.push_back( dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( Form( "pdfWeight_%d", i ) ) ) );
+    }
+    for( int i = 0; i < nAlphaSWeights_; i++ ) {
+        rooPdfWeightHandles_.push_back( dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( Form( "alphaSWeight_%d", i ) ) ) );
+    }
+    for( int i = 0; i < nScaleWeights_; i++ ) {
+        rooPdfWeightHandles_.push_back( dynamic_cast<RooRealVar *>( rooVars_pdfWeights_.find( Form( "scaleWeight_%d", i ) ) ) );
+        rooScaleWeightHandles_.push_back( dynamic_cast<RooRealVar *>( rooVars_.find( Form( "scaleWeight_%d", i ) ) ) );
+    }
 }
 
     template<class F, class O>
@@ -608,62 +684,60 @@ bool CategoryDumper<F, O>::isBinnedOnly( )
 }
 
     template<class F, class O>
-    void CategoryDumper<F, O>::fill( const object_type &obj, double weight, vector<double> pdfWeights, int n_cand, int htxsBin, double genweight)
+    void CategoryDumper<F, O>::fill( const object_type &obj, double weight, const vector<double> &pdfWeights, int n_cand, int htxsBin, double genweight)
 {  
     n_cand_ = n_cand;
     weight_ = weight;
     genweight_ = genweight;
     
     if( dataset_ && (!binnedOnly_) ) {
-        if ( rooVars_.find("weight") ) dynamic_cast<RooRealVar &>( rooVars_["weight"] ).setVal( weight_ );
+        if ( rooWeight_ ) rooWeight_->setVal( weight_ );
     }
     if (dumpPdfWeights_){
         if( tree_ ) {
             std::copy(pdfWeights.begin(),pdfWeights.end(),variables_pdfWeights_.begin());
         }
-        if( dataset_pdfWeights_ && rooVars_pdfWeights_.find("weight") ) {
-            dynamic_cast<RooRealVar &>( rooVars_pdfWeights_["weight"] ).setVal( weight_ );
+        if( dataset_pdfWeights_ && rooPdfWeightsWeight_ ) {
+            rooPdfWeightsWeight_->setVal( weight_ );
             if ((nPdfWeights_+ nAlphaSWeights_ + nScaleWeights_) != (int) (pdfWeights.size())){ 
                 throw cms::Exception( "Configuration" ) << " Specified number of pdfWeights (" << nPdfWeights_ <<") plus alphaSWeights ("<<nAlphaSWeights_
                                                         <<") plus scaleWeights (" << nScaleWeights_ << ") does not match length of pdfWeights Vector ("
                                                         << pdfWeights.size() << ")." ;
             }
-            for ( int i =0; i< nPdfWeights_; i++) {
-                if (rooVars_pdfWeights_.find(Form("pdfWeight_%d",i))) dynamic_cast<RooRealVar &>( rooVars_pdfWeights_[Form("pdfWeight_%d",i)] ).setVal( pdfWeights[i] );
-            }
-            for ( int i =0; i<nAlphaSWeights_  ; i++) {
-                if (rooVars_pdfWeights_.find(Form("alphaSWeight_%d",i))) dynamic_cast<RooRealVar &>( rooVars_pdfWeights_[Form("alphaSWeight_%d",i)] ).setVal( pdfWeights[i+nPdfWeights_] ); // alpha S weights currently stored at the end of pdfweight vector 
-            }
-            for ( int i =0; i< nScaleWeights_; i++) {
-                if (rooVars_pdfWeights_.find(Form("scaleWeight_%d",i))) dynamic_cast<RooRealVar &>( rooVars_pdfWeights_[Form("scaleWeight_%d",i)] ).setVal( pdfWeights[i+nPdfWeights_+nAlphaSWeights_] ); // and scale weights stored after that!
-                if (rooVars_.find(Form("scaleWeight_%d",i))) dynamic_cast<RooRealVar &>( rooVars_[Form("scaleWeight_%d",i)] ).setVal( pdfWeights[i+nPdfWeights_+nAlphaSWeights_] ); // and scale weights stored after that!
-            }
-            if ( splitPdfByStage0Bin_ && htxsBin > -1 ) {
-                if (rooVars_pdfWeights_.find("stage0bin")) dynamic_cast<RooRealVar &>( rooVars_pdfWeights_["stage0bin"]).setVal( htxsBin );
+            // alpha S weights are stored after the pdf weights, and scale weights after those
+            for( size_t i = 0; i < rooPdfWeightHandles_.size(); i++ ) {
+                if( rooPdfWeightHandles_[i] ) rooPdfWeightHandles_[i]->setVal( pdfWeights[i] );
+                if( i >= (size_t)(nPdfWeights_ + nAlphaSWeights_) ) {
+                    RooRealVar *scaleWeight = rooScaleWeightHandles_[i - nPdfWeights_ - nAlphaSWeights_];
+                    if( scaleWeight ) scaleWeight->setVal( pdfWeights[i] );
+                }
             }
-            if ( splitPdfByStage1Bin_ && htxsBin > -1 ) {
-                if (rooVars_pdfWeights_.find("stage1p2bin")) dynamic_cast<RooRealVar &>( rooVars_pdfWeights_["stage1p2bin"]).setVal( htxsBin );
+            if ( ( splitPdfByStage0Bin_ || splitPdfByStage1Bin_ ) && htxsBin > -1 ) {
+                if ( rooStageBin_ ) rooStageBin_->setVal( htxsBin );
             }
         }
     }
     
     for( size_t ivar = 0; ivar < names_.size(); ++ivar ) {
-        auto name = names_[ivar].c_str();
         auto &var = variables_[ivar];
         auto &val = std::get<0>( var );
         val = ( *std::get<1>( var ) )( obj );
+        if( columns_ && columnSlots_[ivar] ) { *columnSlots_[ivar] = val; }
         if( dataset_ ) {
-            if ( rooVars_.find(name) !=0 ) dynamic_cast<RooRealVar &>( rooVars_[name] ).setVal( val );
+            if ( rooVarHandles_[ivar] ) rooVarHandles_[ivar]->setVal( val );
             if (dumpPdfWeights_) {
-                if( rooVars_pdfWeights_.find(name) != 0 ) {
-                    if ( val == 0. ) { std::cout << " WARNING we have a weight 0 that we're pushing back into rooVars_pdfWeights_[ " << name << " ] " << std::endl; }
-                    dynamic_cast<RooRealVar &>( rooVars_pdfWeights_[name] ).setVal( val ); 
+                if( rooPdfVarHandles_[ivar] ) {
+                    if ( val == 0. ) { std::cout << " WARNING we have a weight 0 that we're pushing back into rooVars_pdfWeights_[ " << names_[ivar] << " ] " << std::endl; }
+                    rooPdfVarHandles_[ivar]->setVal( val ); 
                 }
             }
         }
     }
     if( tree_ ) { tree_->Fill(); }
+    if( columns_ ) { columns_->fill( columnsIndex_, n_cand_, weight_, genweight_, pdfWeights ); }
     if( dataset_ ) {
+        // added row by row: RooDataSet and its vector store only take rows, so buffering them
+        // in blocks would replay the same setVal + add calls later, with an extra copy
         dataset_->add( rooVars_, weight_ );
         if (dumpPdfWeights_ && dataset_pdfWeights_) {
             dataset_pdfWeights_->add( rooVars_pdfWeights_, weight_ );
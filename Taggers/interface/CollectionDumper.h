@@ -2,7 +2,9 @@
 #define flashgg_CollectionDumper_h
 
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
 
 #include "TH1.h"
 #include "TTree.h"
@@ -36,8 +38,10 @@
 #include "flashgg/MicroAOD/interface/StageOneNameClassifier.h"
 #include "flashgg/MicroAOD/interface/CutAndClassBasedClassifier.h"
 #include "flashgg/MicroAOD/interface/StageOneBasedClassifier.h"
+#include "flashgg/MicroAOD/interface/CompiledObjectFunction.h"
 #include "flashgg/Taggers/interface/GlobalVariablesDumper.h"
 #include "flashgg/DataFormats/interface/PDFWeightObject.h"
+#include "flashgg/DataFormats/interface/WeightedObject.h"
 #include "SimDataFormats/HTXS/interface/HiggsTemplateCrossSections.h"
 
 
@@ -66,6 +70,20 @@ namespace flashgg {
         TrivialClassifier( const edm::ParameterSet &cfg ) {}
 
         std::pair<std::string, int> operator()( const T &obj ) const { return std::make_pair( "", 0 ); }
+        std::pair<int, int> code( const T &obj ) const { return std::make_pair( 0, 0 ); }
+        std::string name( int code ) const { return ""; }
+    };
+
+    // Reaches the WeightedObject of a candidate, statically when the candidate type derives from it
+    template <class T, bool = std::is_base_of<WeightedObject, T>::value>
+    struct WeightedObjectCast
+    {
+        static const WeightedObject *get( const T &obj ) { return dynamic_cast<const WeightedObject *>( &obj ); }
+    };
+    template <class T>
+    struct WeightedObjectCast<T, true>
+    {
+        static const WeightedObject *get( const T &obj ) { return &obj; }
     };
 
     template<class CollectionT, class CandidateT = typename CollectionT::value_type, class ClassifierT = TrivialClassifier<CandidateT> >
@@ -75,7 +93,7 @@ namespace flashgg {
     public:
         typedef CollectionT collection_type;
         typedef CandidateT candidate_type;
-        typedef StringObjectFunction<CandidateT, true> function_type;
+        typedef CompiledObjectFunction<CandidateT> function_type;
         typedef CategoryDumper<function_type, candidate_type> dumper_type;
         typedef ClassifierT classifier_type;
         // typedef std::pair<std::string, std::string> KeyT;
@@ -98,6 +116,8 @@ namespace flashgg {
         double eventWeight( const edm::EventBase &event );
         double eventGenWeight( const edm::EventBase &event );
         vector<double> pdfWeights( const edm::EventBase &event );
+        struct Dispatch;
+        const Dispatch &dispatch( int code );
         int getStage0bin( const edm::EventBase &event );
         int getStage1bin( const edm::EventBase &event );
         int getStxsNJet( const edm::EventBase &event );
@@ -122,11 +142,13 @@ namespace flashgg {
         double sqrtS_;
         double intLumi_;
         std::string nameTemplate_;
+        std::string weightName_;
         
         bool dumpTrees_;
         bool dumpWorkspace_;
         std::string workspaceName_;
         bool dumpHistos_, dumpGlobalVariables_;
+        bool dumpColumns_;
         // bool dumpNNLOPSweight_;
         
         std::map< KeyT, bool> hasSubcat_;
@@ -169,7 +191,17 @@ namespace flashgg {
 
         //std::map<std::string, std::vector<dumper_type> > dumpers_; FIXME template key
         std::map< KeyT, std::vector<dumper_type> > dumpers_;
+        // Per classifier code, the dumpers of its category, null if it is not dumped, and whether
+        // it has subcategories; resolved from the category name the first time the code is met
+        struct Dispatch {
+            Dispatch() : resolved( false ), dumpers( 0 ), hasSubcat( false ) {}
+            bool resolved;
+            std::vector<dumper_type> *dumpers;
+            bool hasSubcat;
+        };
+        std::vector<Dispatch> dispatch_;
         RooWorkspace *ws_;
+        std::unique_ptr<ColumnarTree> columns_;
         /// TTree * bookTree(const std::string & name, TFileDirectory& fs);
         /// void fillTreeBranches(const flashgg::Photon & pho)
 
@@ -243,10 +275,12 @@ namespace flashgg {
         sqrtS_               = cfg.getUntrackedParameter<double>( "sqrtS", 13. );
         intLumi_             = cfg.getUntrackedParameter<double>( "intLumi",1000. );
         nameTemplate_        = cfg.getUntrackedParameter<std::string>( "nameTemplate", "$COLLECTION" );
+        weightName_          = cfg.getUntrackedParameter<std::string>( "weightName", "weight" );
         dumpTrees_           = cfg.getUntrackedParameter<bool>( "dumpTrees", false );
         dumpWorkspace_       = cfg.getUntrackedParameter<bool>( "dumpWorkspace", false );
         workspaceName_       = cfg.getUntrackedParameter<std::string>( "workspaceName", src_.label() );
         dumpHistos_          = cfg.getUntrackedParameter<bool>( "dumpHistos", false );
+        dumpColumns_         = cfg.getUntrackedParameter<bool>( "dumpColumns", false );
         classifier_          = cfg.getParameter<edm::ParameterSet>( "classifierCfg" );
         throwOnUnclassified_ = cfg.exists("throwOnUnclassified") ? cfg.getParameter<bool>("throwOnUnclassified") : false;
         splitPdfByStage0Bin_ = cfg.getUntrackedParameter<bool>( "splitPdfByStage0Bin", false);
@@ -280,6 +314,23 @@ namespace flashgg {
        
         pdfWeightHistosBooked_=false;
 
+        // single tree for all categories and systematic labels, see ColumnarTree.h
+        columns_.reset();
+        if( dumpColumns_ ) {
+            auto columnsName = cfg.getUntrackedParameter<std::string>( "columnsName", "columns" );
+            columns_.reset( new ColumnarTree( fs.make<TTree>( columnsName.c_str(), columnsName.c_str() ),
+                                              fs.make<TTree>( ( columnsName + "_dictionary" ).c_str(), ( columnsName + "_dictionary" ).c_str() ),
+                                              weightName_,
+                                              cfg.getUntrackedParameter<int>( "columnsCompression", -1 ),
+                                              cfg.getUntrackedParameter<int>( "columnsClusterSize", 0 ) ) );
+            if( globalVarsDumper_ ) {
+                columns_->bookGlobalVariables( globalVarsDumper_, replacements );
+            }
+        }
+
+        // expressions of this dumper are turned into native code when the dumpers are built
+        bool compileExpressions = ExpressionCompiler::enabled() || cfg.getUntrackedParameter<bool>( "compileExpressions", false );
+
         auto categories = cfg.getParameter<std::vector<edm::ParameterSet> >( "categories" );
         for( auto &cat : categories ) {
             auto label   = cat.getParameter<std::string>( "label" );
@@ -326,13 +377,19 @@ namespace flashgg {
             
             hasSubcat_[key] = ( subcats > 0 );
             auto &dumpers = dumpers_[key];
+            size_t firstDumper = dumpers.size();
             if( subcats == 0 ) {
                 name = replaceString( replaceString( replaceString( name, "_$SUBCAT", "" ), "$SUBCAT_", "" ), "$SUBCAT", "" );
-                dumpers.push_back( dumper_type( name, cat, globalVarsDumper_ ) );
+                dumpers.push_back( dumper_type( name, cat, globalVarsDumper_, compileExpressions ) );
             } else {
                 for( int isub = 0; isub < subcats; ++isub ) {
                     auto subcatname = replaceString( name, "$SUBCAT", Form( "%d", isub ) );
-                    dumpers.push_back( dumper_type( subcatname, cat, globalVarsDumper_ ) );
+                    dumpers.push_back( dumper_type( subcatname, cat, globalVarsDumper_, compileExpressions ) );
+                }
+            }
+            if( columns_ ) {
+                for( size_t idumper = firstDumper; idumper < dumpers.size(); ++idumper ) {
+                    dumpers[idumper].bookColumns( *columns_, classname, label, idumper - firstDumper, replacements );
                 }
             }
         }
@@ -340,7 +397,7 @@ namespace flashgg {
         workspaceName_ = formatString( workspaceName_, replacements );
         if( dumpWorkspace_ ) {
             ws_ = fs.make<RooWorkspace>( workspaceName_.c_str(), workspaceName_.c_str() );
-            dynamic_cast<RooRealVar *>( ws_->factory( "weight[1.]" ) )->setConstant( false );
+            dynamic_cast<RooRealVar *>( ws_->factory( ( weightName_ + "[1.]" ).c_str() ) )->setConstant( false );
             if (dumpPdfWeights_){
                 // Already on default list anyway
                 //                if (splitPdfByStage0Bin_ ) {
@@ -367,11 +424,11 @@ namespace flashgg {
         for( auto &dumpers : dumpers_ ) {
             for( auto &dumper : dumpers.second ) {
                 if( dumpWorkspace_ ) {
-                    dumper.bookRooDataset( *ws_, "weight", replacements);
+                    dumper.bookRooDataset( *ws_, weightName_.c_str(), replacements);
                 }
                 if( dumpTrees_ ) {
                     TFileDirectory dir = fs.mkdir( "trees" );
-                    dumper.bookTree( dir, "weight", replacements );
+                    dumper.bookTree( dir, weightName_.c_str(), replacements );
                 }
                 if( dumpHistos_ ) {
                     TFileDirectory dir = fs.mkdir( "histograms" );
@@ -617,6 +674,23 @@ namespace flashgg {
         return pdfWeights;
     }    
     
+    template<class C, class T, class U>
+    const typename CollectionDumper<C, T, U>::Dispatch &CollectionDumper<C, T, U>::dispatch( int code )
+    {
+        if( code >= ( int )dispatch_.size() ) { dispatch_.resize( code + 1 ); }
+        Dispatch &which = dispatch_[code];
+        if( ! which.resolved ) {
+            auto key = classifier_.name( code );
+            auto dumpers = dumpers_.find( key );
+            if( dumpers != dumpers_.end() ) {
+                which.dumpers = &dumpers->second;
+                which.hasSubcat = hasSubcat_[key];
+            }
+            which.resolved = true;
+        }
+        return which;
+    }
+
     template<class C, class T, class U>
     void CollectionDumper<C, T, U>::analyze( const edm::EventBase &event )
     {
@@ -649,20 +723,20 @@ namespace flashgg {
         int nfilled = maxCandPerEvent_;
         
         for( auto &cand : collection ) {
-            auto cat = classifier_( cand );
-            auto which = dumpers_.find( cat.first );
+            auto cat = classifier_.code( cand );
+            const auto &which = dispatch( cat.first );
             
-            if( which != dumpers_.end() ) {
-                int isub = ( hasSubcat_[cat.first] ? cat.second : 0 );
+            if( which.dumpers ) {
+                int isub = ( which.hasSubcat ? cat.second : 0 );
                 double fillWeight =weight_;
-                const  WeightedObject* tag = dynamic_cast<const WeightedObject* >( &cand );
+                const  WeightedObject* tag = WeightedObjectCast<candidate_type>::get( cand );
                 if ( tag != NULL ){
                     fillWeight =fillWeight*(tag->centralWeight());
                     }
-                    which->second[isub].fill( cand, fillWeight, pdfWeights_, maxCandPerEvent_ - nfilled, splitPdfByStage0Bin_ ? stage0bin_ : stage1bin_,genweight_ );
+                    ( *which.dumpers )[isub].fill( cand, fillWeight, pdfWeights_, maxCandPerEvent_ - nfilled, splitPdfByStage0Bin_ ? stage0bin_ : stage1bin_,genweight_ );
                     --nfilled;
             } else if( throwOnUnclassified_ ) {
-                throw cms::Exception( "Runtime error" ) << "could not find dumper for category [" << cat.first << "," << cat.second << "]"
+                throw cms::Exception( "Runtime error" ) << "could not find dumper for category [" << classifier_.name( cat.first ) << "," << cat.second << "]"
                                                         << "If you want to allow this (eg because you don't want to dump some of the candidates in the collection)\n"
                                                         << "please set throwOnUnclassified in the dumper configuration\n";
             }
@@ -0,0 +1,94 @@
+#ifndef flashgg_ColumnarTree_h
+#define flashgg_ColumnarTree_h
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "TTree.h"
+
+namespace flashgg {
+
+    class GlobalVariablesDumper;
+
+    // One tree holding the candidates of all the category dumpers of a CollectionDumper,
+    // instead of one tree per category and systematic label.
+    // Each entry carries the index of the dumper that filled it, together with the
+    // category (className), the systematic label and the subcategory as dictionary-encoded
+    // integer columns. Each variable is stored in a single float column shared by all the
+    // dumpers defining it, and is NaN in the entries of the other dumpers.
+    // The dictionary tree has one entry per dumper, with the name and the branch list of
+    // the per-category tree it replaces: bin/columns_to_trees.cc rebuilds those trees.
+    class ColumnarTree
+    {
+
+    public:
+        // weightName: name of the event weight branch, as in the per-category trees
+        // compression: ROOT compression settings (100*algorithm+level), -1 keeps the file default
+        // clusterSize: TTree::SetAutoFlush argument (entries if > 0, bytes if < 0), 0 keeps the ROOT default
+        ColumnarTree( TTree *tree, TTree *dictionary, const std::string &weightName = "weight",
+                      int compression = -1, long long clusterSize = 0 );
+
+        void bookGlobalVariables( GlobalVariablesDumper *dumper, const std::map<std::string, std::string> &replacements );
+
+        // registers a category dumper and returns its index
+        int addDumper( const std::string &treeName, const std::string &category, const std::string &systLabel, int subcat,
+                       const std::vector<std::string> &variables, bool genWeight, int nPdfWeights, int nAlphaSWeights, int nScaleWeights );
+
+        // storage of the ivar-th variable passed to addDumper for dumper idumper
+        float *column( int idumper, size_t ivar );
+
+        void fill( int idumper, int candidate, float weight, float genweight, const std::vector<double> &pdfWeights );
+
+    private:
+        struct DumperInfo {
+            int category, systLabel, subcat;
+            int nPdfWeights, nAlphaSWeights, nScaleWeights;
+            std::vector<size_t> columns;
+        };
+
+        // books the branches depending on all the dumpers and applies the I/O settings
+        void book();
+        int encode( std::map<std::string, int> &dictionary, const std::string &value );
+        // throws if a variable would be stored in a branch booked by this class or by the global variables
+        void checkName( const std::string &name, const std::string &owner ) const;
+
+        TTree *tree_;
+        TTree *dictionary_;
+        std::string weightName_;
+        int compression_;
+        long long clusterSize_;
+        bool booked_;
+        bool hasGenWeight_;
+
+        std::set<std::string> reservedNames_;
+        std::vector<std::string> globalNames_;
+        std::map<std::string, size_t> columnIndex_;
+        std::deque<float> columns_; // element addresses are stable when adding columns
+        std::map<std::string, int> categories_, systLabels_;
+        std::vector<DumperInfo> dumpers_;
+
+        // current entry
+        int dumper_, category_, systLabel_, subcat_, candidate_;
+        float weight_, genweight_;
+        int nPdfWeights_, nAlphaSWeights_, nScaleWeights_;
+        std::vector<float> pdfWeights_, alphaSWeights_, scaleWeights_;
+
+        // current dictionary entry
+        std::string dictTree_, dictCategory_, dictSystLabel_;
+        std::vector<std::string> dictBranches_;
+        int dictDumper_, dictCategoryIndex_, dictSystLabelIndex_, dictSubcat_;
+        int dictNPdfWeights_, dictNAlphaSWeights_, dictNScaleWeights_;
+    };
+}
+
+#endif // flashgg_ColumnarTree_h
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -4,27 +4,55 @@
 #include "Math/SpecFuncMathMore.h"
 #include "TLorentzVector.h"
 #include <cmath>
+#include <vector>
 
 //loosely based on http://arxiv.org/abs/1212.4436
 
+// The momenta are kept as arrays (px, py, pz, |p|, pt, eta) and the clamped cosines of all the
+// pairs are computed once, in the constructor. The Legendre polynomials of the cosines are
+// computed once per order (the matrix is symmetric) and shared by all the weightings, so asking
+// for the six moments of an order costs N^2/2 polynomial evaluations instead of 6 N^2.
+// The sums run over the pairs in the same order as the former per-moment loops, and give the
+// same values to the last bit.
 class FoxWolfram
 {
     protected:
-        std::vector<TLorentzVector> _eventVectors;
+        unsigned int _n;
+        std::vector<double> _px, _py, _pz, _p, _pt, _eta;
+        std::vector<double> _cos; // _n x _n
+        std::vector<std::vector<double> > _legendre; // per order, _n x _n
         double totalEnergy;
     public:
         enum WeightType
         {
             SHAT,PT,ETA,PSUM,PZ,ONE
         };
-    
+
         FoxWolfram(const std::vector<TLorentzVector>& eventVectors):
-            _eventVectors(eventVectors)
+            _n(eventVectors.size())
         {
+            reserve();
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                add(eventVectors[i].Px(),eventVectors[i].Py(),eventVectors[i].Pz());
+            }
+            computeCosines();
         }
-        
-        
-        
+
+        // struct-of-arrays input; the energies are not used by the moments
+        FoxWolfram(const double* px, const double* py, const double* pz, unsigned int n):
+            _n(n)
+        {
+            reserve();
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                add(px[i],py[i],pz[i]);
+            }
+            computeCosines();
+        }
+
+
+
         double getMoment(WeightType wType, unsigned int order)
         {
             switch (wType)
@@ -52,16 +80,33 @@ class FoxWolfram
                 case ONE:
                 {
                     return getMomentOne(order);
-                } 
+                }
             }
             return -1;
         }
-        
+
+        // the moments of one order for several weightings, in the order of wTypes
+        std::vector<double> getMoments(const std::vector<WeightType>& wTypes, unsigned int order)
+        {
+            std::vector<double> moments;
+            moments.reserve(wTypes.size());
+            for (auto wType : wTypes)
+            {
+                moments.push_back(getMoment(wType,order));
+            }
+            return moments;
+        }
+
         double cosTheta(const TLorentzVector& v1, const TLorentzVector& v2)
+        {
+            return cosTheta(v1.Px(),v1.Py(),v1.Pz(),v1.P(),v2.Px(),v2.Py(),v2.Pz(),v2.P());
+        }
+
+        static double cosTheta(double px1, double py1, double pz1, double p1, double px2, double py2, double pz2, double p2)
         {
 	  double ret = 0;
-	  if(v1.P()!=0 && v2.P()!=0)
-	    ret = (v1.Px()*v2.Px()+v1.Py()*v2.Py()+v1.Pz()*v2.Pz()) / (v1.P()*v2.P());
+	  if(p1!=0 && p2!=0)
+	    ret = (px1*px2+py1*py2+pz1*pz2) / (p1*p2);
 
 	  if(ret>0.9999)
 	    ret = 0.9999;
@@ -71,114 +116,169 @@ class FoxWolfram
 
 	  return ret;
         }
-       
-        
-        double getMomentShat(unsigned int order) 
+
+
+        double getMomentShat(unsigned int order)
         {
+            const double* legendre = legendreMatrix(order);
             double sum = 0.0;
-            TLorentzVector shat(0,0,0,0);
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
-            {  
-                shat+=_eventVectors[i];
-                for (unsigned int j = 0; j < _eventVectors.size(); ++j)
-                {
-                    double angle = cosTheta(_eventVectors[i],_eventVectors[j]);
-                    sum+=_eventVectors[i].P()*_eventVectors[j].P()*ROOT::Math::legendre(order,angle);
-                }
+            double shatX = 0.0, shatY = 0.0, shatZ = 0.0;
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                shatX+=_px[i];
+                shatY+=_py[i];
+                shatZ+=_pz[i];
+                addRow(sum,_p,_p[i],legendre+i*_n);
             }
-            
-            return sum/shat.P()/shat.P();
+            double shatP = std::sqrt(shatX*shatX+shatY*shatY+shatZ*shatZ);
+
+            return sum/shatP/shatP;
         }
-        
-        double getMomentPt(unsigned int order) 
+
+        double getMomentPt(unsigned int order)
         {
-            double sum = 0.0;
-            double norm = 0.0;
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
-            {  
-                norm+=_eventVectors[i].Pt();
-                for (unsigned int j = 0; j < _eventVectors.size(); ++j)
-                {
-                    double angle = cosTheta(_eventVectors[i],_eventVectors[j]);
-                    sum+=_eventVectors[i].Pt()*_eventVectors[j].Pt()*ROOT::Math::legendre(order,angle);
-                }
-            }
-            
-            return sum/norm/norm;
+            return normalisedMoment(_pt,order);
         }
-        
-        double getMomentEta(unsigned int order) 
+
+        double getMomentEta(unsigned int order)
         {
+            const double* legendre = legendreMatrix(order);
             double avgEta = 0.0;
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
-            {  
-                avgEta+=_eventVectors[i].Eta();
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                avgEta+=_eta[i];
             }
-            avgEta/= _eventVectors.size();
-        
+            avgEta/= _n;
+
+            std::vector<double> dEta(_n);
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                dEta[i] = fabs(_eta[i]-avgEta);
+            }
+
             double norm = 0.0;
             double sum = 0.0;
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
-            {  
-                norm+=1.0/(fabs(_eventVectors[i].Eta()-avgEta));
-                for (unsigned int j = 0; j < _eventVectors.size(); ++j)
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                norm+=1.0/dEta[i];
+                const double* row = legendre+i*_n;
+                for (unsigned int j = 0; j < _n; ++j)
                 {
-                    double angle = cosTheta(_eventVectors[i],_eventVectors[j]);
-                    sum+=1.0/(fabs(_eventVectors[i].Eta()-avgEta)*fabs(_eventVectors[j].Eta()-avgEta))*ROOT::Math::legendre(order,angle);
+                    sum+=1.0/(dEta[i]*dEta[j])*row[j];
                 }
             }
             return sum/norm/norm;
         }
-        
-        double getMomentPsum(unsigned int order) 
+
+        double getMomentPsum(unsigned int order)
+        {
+            return normalisedMoment(_p,order);
+        }
+
+        double getMomentPz(unsigned int order)
         {
+            return normalisedMoment(_pz,order);
+        }
+
+        double getMomentOne(unsigned int order)
+        {
+            const double* legendre = legendreMatrix(order);
             double sum = 0.0;
-            double norm = 0.0;
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
-            {  
-                norm+=_eventVectors[i].P();
-                for (unsigned int j = 0; j < _eventVectors.size(); ++j)
+            for (unsigned int k = 0; k < _n*_n; ++k)
+            {
+                sum+=legendre[k];
+            }
+
+            return sum;
+        }
+
+    protected:
+        void reserve()
+        {
+            _px.reserve(_n);
+            _py.reserve(_n);
+            _pz.reserve(_n);
+            _p.reserve(_n);
+            _pt.reserve(_n);
+            _eta.reserve(_n);
+        }
+
+        // p, pt and eta as TLorentzVector computes them
+        void add(double px, double py, double pz)
+        {
+            double p = std::sqrt(px*px+py*py+pz*pz);
+            double cosTheta = (p == 0.0 ? 1.0 : pz/p);
+            double eta;
+            if (cosTheta*cosTheta < 1)
+                eta = -0.5*std::log((1.0-cosTheta)/(1.0+cosTheta));
+            else if (pz == 0)
+                eta = 0;
+            else
+                eta = (pz > 0 ? 10e10 : -10e10);
+            _px.push_back(px);
+            _py.push_back(py);
+            _pz.push_back(pz);
+            _p.push_back(p);
+            _pt.push_back(std::sqrt(px*px+py*py));
+            _eta.push_back(eta);
+        }
+
+        void computeCosines()
+        {
+            _cos.resize(_n*_n);
+            for (unsigned int i = 0; i < _n; ++i)
+            {
+                double* row = &_cos[i*_n];
+                for (unsigned int j = 0; j < _n; ++j)
                 {
-                    double angle = cosTheta(_eventVectors[i],_eventVectors[j]);
-                    sum+=_eventVectors[i].P()*_eventVectors[j].P()*ROOT::Math::legendre(order,angle);
+                    row[j] = cosTheta(_px[i],_py[i],_pz[i],_p[i],_px[j],_py[j],_pz[j],_p[j]);
                 }
             }
-            
-            return sum/norm/norm;
         }
-        
-        double getMomentPz(unsigned int order) 
+
+        // P_order of the cosines, computed on the first request of each order
+        const double* legendreMatrix(unsigned int order)
         {
-            double sum = 0.0;
-            double norm = 0.0;
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
-            {  
-                norm+=_eventVectors[i].Pz();
-                for (unsigned int j = 0; j < _eventVectors.size(); ++j)
+            if (_legendre.size() <= order)
+                _legendre.resize(order+1);
+            std::vector<double>& legendre = _legendre[order];
+            if (legendre.empty() && _n > 0)
+            {
+                legendre.resize(_n*_n);
+                for (unsigned int i = 0; i < _n; ++i)
                 {
-                    double angle = cosTheta(_eventVectors[i],_eventVectors[j]);
-                    sum+=_eventVectors[i].Pz()*_eventVectors[j].Pz()*ROOT::Math::legendre(order,angle);
+                    for (unsigned int j = i; j < _n; ++j)
+                    {
+                        legendre[i*_n+j] = legendre[j*_n+i] = ROOT::Math::legendre(order,_cos[i*_n+j]);
+                    }
                 }
             }
+            return legendre.data();
+        }
 
-            return sum/norm/norm;
+        // sum += wi*w[j]*row[j] for all j, in order
+        void addRow(double& sum, const std::vector<double>& w, double wi, const double* row) const
+        {
+            for (unsigned int j = 0; j < _n; ++j)
+            {
+                sum+=wi*w[j]*row[j];
+            }
         }
-        
-        double getMomentOne(unsigned int order) 
+
+        // sum_ij w[i]*w[j]*P(cos_ij) / (sum_i w[i])^2
+        double normalisedMoment(const std::vector<double>& w, unsigned int order)
         {
+            const double* legendre = legendreMatrix(order);
             double sum = 0.0;
-            for (unsigned int i = 0; i < _eventVectors.size(); ++i)
+            double norm = 0.0;
+            for (unsigned int i = 0; i < _n; ++i)
             {
-                for (unsigned int j = 0; j < _eventVectors.size(); ++j)
-                {
-                    double angle = cosTheta(_eventVectors[i],_eventVectors[j]);
-                    sum+=ROOT::Math::legendre(order,angle);
-                }
+                norm+=w[i];
+                addRow(sum,w,w[i],legendre+i*_n);
             }
-            
-            return sum;
+
+            return sum/norm/norm;
         }
 };
 
 #endif
-
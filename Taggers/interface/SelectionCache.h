@@ -0,0 +1,52 @@
+#ifndef FLASHgg_SelectionCache_h
+#define FLASHgg_SelectionCache_h
+
+#include "DataFormats/Common/interface/Ptr.h"
+#include "DataFormats/Provenance/interface/ProductID.h"
+#include "flashgg/DataFormats/interface/DiPhotonCandidate.h"
+
+#include <map>
+#include <utility>
+
+namespace flashgg {
+
+    // Per-event memo of the object selections repeated in the systematics loops of the tag producers.
+    //
+    // A selection is keyed on the identity of its inputs: the diphoton it is made against and the
+    // ProductID of the collection it selects from. The jet and MET variations reuse the nominal
+    // diphotons, so they get back what the nominal pass selected; a diphoton variation has its own
+    // Ptrs and is selected again. The producer calls clear() at the beginning of each event.
+    template <class Value>
+    class SelectionCache
+    {
+
+    public:
+        typedef std::pair<edm::Ptr<DiPhotonCandidate>, edm::ProductID> key_type;
+
+        void clear() { cache_.clear(); }
+
+        // the stored value for (dipho, input), computed by select() the first time
+        template <class Select>
+        const Value &get( const edm::Ptr<DiPhotonCandidate> &dipho, const edm::ProductID &input, Select select )
+        {
+            key_type key( dipho, input );
+            auto found = cache_.find( key );
+            if( found == cache_.end() ) {
+                found = cache_.emplace( key, select() ).first;
+            }
+            return found->second;
+        }
+
+    private:
+        std::map<key_type, Value> cache_;
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
@@ -9,7 +9,7 @@
 #include "flashgg/DataFormats/interface/Electron.h"
 #include "flashgg/DataFormats/interface/Muon.h"
 
-#include "PhysicsTools/TensorFlow/interface/TensorFlow.h"
+#include "flashgg/Taggers/interface/TensorFlowModelRegistry.h"
 
 namespace flashgg {
 
@@ -34,17 +34,24 @@ class TTH_DNN_Helper
 
         float EvaluateDNN();
 
+        // Batched evaluation: queue the inputs of each candidate after SetInputs, then score them in one run
+        void QueueDNN();
+        std::vector<float> EvaluateQueuedDNN();
+
     private:
         void Preprocess();
 
         string weight_file_;
 
-        tensorflow::GraphDef* graph_;
-        tensorflow::Session*  session_;
+        std::shared_ptr<const TensorFlowModel> model_;
         
+        // Per-event input buffers: one helper per stream module instance
         std::vector<double> 		        global_features_; // e.g. Met, N_jets, max b-tag score, etc.
         std::vector<std::vector<double>> 	object_features_; // pT ordered list of jets (and leptons)
 
+        std::vector<std::vector<double>>                queued_global_features_;
+        std::vector<std::vector<std::vector<double>>>   queued_object_features_;
+
         std::vector<double>                 preprocess_scheme_global_features_mean_;
         std::vector<double>                 preprocess_scheme_global_features_stddev_;
         std::vector<double>                 preprocess_scheme_object_features_mean_;
@@ -62,16 +69,13 @@ class TTH_DNN_Helper
 
 inline
 TTH_DNN_Helper::~TTH_DNN_Helper() {
-    tensorflow::closeSession(session_);
-    delete graph_;
 }
 
 inline
 TTH_DNN_Helper::TTH_DNN_Helper(string weight_file, bool debug) {
     weight_file_ = weight_file;
 
-    graph_ = tensorflow::loadGraphDef((weight_file_).c_str());
-    session_ = tensorflow::createSession(graph_);  
+    model_ = TensorFlowModelRegistry::instance().get(weight_file_);
 
     inputs_set_ = false;
     preprocess_ = false;
@@ -277,35 +281,60 @@ void TTH_DNN_Helper::SetInputs(std::vector<edm::Ptr<flashgg::Jet>> jets, std::ve
 
 inline
 float TTH_DNN_Helper::EvaluateDNN() {
+    QueueDNN();
+    return EvaluateQueuedDNN()[0];
+}
+
+inline
+void TTH_DNN_Helper::QueueDNN() {
     if (!inputs_set_)
         throw "[DNN Helper] [ERROR]: Inputs have not been reset since last evaluation!";
 
-    tensorflow::Tensor global_input(tensorflow::DT_FLOAT, {1, length_global_});
-    tensorflow::Tensor object_input(tensorflow::DT_FLOAT, tensorflow::TensorShape({1, length_object_sequence_, length_object_}));
+    queued_global_features_.push_back(std::move(global_features_));
+    queued_object_features_.push_back(std::move(object_features_));
 
-    for (unsigned int i = 0; i < length_global_; i++) {
-        global_input.matrix<float>()(0,i) = float(global_features_[i]);
-        if (debug_)
-            cout << "Global feature " << i << ": " << float(global_features_[i]) << endl;
-    }
+    global_features_.clear();
+    object_features_.clear(); 
+    inputs_set_ = false;
+}
 
-    for (unsigned int i = 0; i < length_object_sequence_; i++) {
-        for (unsigned int j = 0; j < length_object_; j++) {
-            object_input.tensor<float,3>()(0,i,j) = float(object_features_[i][j]);
+inline
+std::vector<float> TTH_DNN_Helper::EvaluateQueuedDNN() {
+    std::vector<float> scores;
+    const unsigned int n = queued_global_features_.size();
+    if (n == 0)
+        return scores;
+
+    tensorflow::Tensor global_input(tensorflow::DT_FLOAT, {n, length_global_});
+    tensorflow::Tensor object_input(tensorflow::DT_FLOAT, tensorflow::TensorShape({n, length_object_sequence_, length_object_}));
+
+    for (unsigned int k = 0; k < n; k++) {
+        for (unsigned int i = 0; i < length_global_; i++) {
+            global_input.matrix<float>()(k,i) = float(queued_global_features_[k][i]);
             if (debug_)
-	            cout << "Object feature " << i << ", " << j << ": " << float(object_features_[i][j]) << endl;
-        } 
+                cout << "Global feature " << i << ": " << float(queued_global_features_[k][i]) << endl;
+        }
+
+        for (unsigned int i = 0; i < length_object_sequence_; i++) {
+            for (unsigned int j = 0; j < length_object_; j++) {
+                object_input.tensor<float,3>()(k,i,j) = float(queued_object_features_[k][i][j]);
+                if (debug_)
+                    cout << "Object feature " << i << ", " << j << ": " << float(queued_object_features_[k][i][j]) << endl;
+            } 
+        }
     }
 
     std::vector<tensorflow::Tensor> output;
  
-    tensorflow::run(session_, {{"input_objects", object_input}, {"input_global", global_input}}, {"output/Sigmoid"}, &output);
+    model_->run({{"input_objects", object_input}, {"input_global", global_input}}, {"output/Sigmoid"}, &output);
 
-    global_features_.clear();
-    object_features_.clear(); 
-    inputs_set_ = false;
+    queued_global_features_.clear();
+    queued_object_features_.clear();
 
-    return output[0].matrix<float>()(0,0);  
+    scores.resize(n);
+    for (unsigned int k = 0; k < n; k++)
+        scores[k] = output[0].matrix<float>()(k,0);
+    return scores;
 }
 
 
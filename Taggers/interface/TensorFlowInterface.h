@@ -1,6 +1,6 @@
 #ifndef flashgg_Taggers_TensorFlowInterface_h
 #define flashgg_Taggers_TensorFlowInterface_h
-#include "PhysicsTools/TensorFlow/interface/TensorFlow.h"
+#include "flashgg/Taggers/interface/TensorFlowModelRegistry.h"
 
 #include <assert.h>
 #include <string> // std::string
@@ -36,6 +36,14 @@ public:
   std::map<std::string, double>
   operator()(const std::map<std::string, double> & mvaInputs) const;
 
+  /**
+   * @brief Calculates MVA outputs of several candidates in one evaluation of the model.
+   * @param mvaInputs Values of MVA input variables, one std::map per candidate
+   * @return          MVA outputs, in the order of the candidates
+   */
+  std::vector<std::map<std::string, double>>
+  operator()(const std::vector<std::map<std::string, double>> & mvaInputs) const;
+
   //tensorflow::Session & getSession() const { return *session_; }
 
   //using GraphPtr = std::shared_ptr<tensorflow::GraphDef>;
@@ -43,11 +51,9 @@ public:
 
 private:
   std::string mvaFileName_;
-  tensorflow::GraphDef * graphDef_;
+  std::shared_ptr<const flashgg::TensorFlowModel> model_;
   //int NumberOfInputs;
-  //tensorflow::Session * session_;
   //GraphPtr graph_;
-  tensorflow::Session * session_;
   const std::vector<std::string> classes_;
   std::string input_layer_name;
   std::string output_layer_name;
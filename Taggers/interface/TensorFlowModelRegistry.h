@@ -0,0 +1,84 @@
+#ifndef flashgg_Taggers_TensorFlowModelRegistry_h
+#define flashgg_Taggers_TensorFlowModelRegistry_h
+
+#include "PhysicsTools/TensorFlow/interface/TensorFlow.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace flashgg {
+
+    // A frozen TensorFlow graph loaded once per process, with the single session every user runs it
+    // through (tensorflow::Session::Run is thread safe). Keeps count of the runs, the rows they
+    // evaluated and the time they took, reported when the last user lets go of the model.
+    class TensorFlowModel
+    {
+
+    public:
+        TensorFlowModel( const std::string &path, const std::string &checksum, size_t fileSize );
+        ~TensorFlowModel();
+
+        TensorFlowModel( const TensorFlowModel & ) = delete;
+        TensorFlowModel &operator=( const TensorFlowModel & ) = delete;
+
+        const std::string &path() const { return path_; }
+        const std::string &checksum() const { return checksum_; }
+        const tensorflow::GraphDef &graph() const { return *graph_; }
+
+        // Runs the graph; the first dimension of the first input is counted as the number of rows
+        void run( const std::vector<std::pair<std::string, tensorflow::Tensor> > &inputs,
+                  const std::vector<std::string> &outputNames,
+                  std::vector<tensorflow::Tensor> *outputs ) const;
+
+        void report( std::ostream &out ) const;
+
+    private:
+        std::string path_;
+        std::string checksum_;
+        size_t fileSize_;
+        double loadSeconds_;
+
+        tensorflow::GraphDef *graph_;
+        tensorflow::Session *session_;
+
+        mutable std::atomic<unsigned long> nRuns_;
+        mutable std::atomic<unsigned long> nRows_;
+        mutable std::atomic<unsigned long long> runNanoseconds_;
+    };
+
+    // Hands out the models by file path. Files with the same content share one model, which is
+    // freed once no module holds it any more.
+    class TensorFlowModelRegistry
+    {
+
+    public:
+        static TensorFlowModelRegistry &instance();
+
+        std::shared_ptr<const TensorFlowModel> get( const std::string &path );
+
+        // Reports the models currently loaded
+        void report( std::ostream &out ) const;
+
+    private:
+        TensorFlowModelRegistry() {}
+
+        mutable std::mutex mutex_;
+        std::map<std::string, std::weak_ptr<const TensorFlowModel> > byPath_;
+        std::map<std::string, std::weak_ptr<const TensorFlowModel> > byChecksum_;
+    };
+}
+
+#endif
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
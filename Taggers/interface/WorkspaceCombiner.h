@@ -87,9 +87,24 @@ public:
 
     void Save( bool doTreesAndHistograms );
 
+    // Output of the standard hadd of trees and histograms, by default next to the output file
+    void SetAuxFileName( string auxFileName_ );
+
+    // For the intermediate merges of a tree reduction: the datahists of each input are stored
+    // as separate parts (name__haddWorkspacesPartNNNNNN) instead of being added, so that the final
+    // merge adds them in input order and gives the same sums as a single merge. Only that exact
+    // suffix is stripped when reading the parts back.
+    void SetKeepDataHistParts( bool keep );
+
 
 private :
 
+    void AddDataSet( unsigned int w, RooDataSet *dataset );
+
+    void AddDataHist( unsigned int w, RooDataHist *datahist );
+
+    void AddVar( unsigned int w, RooRealVar *datavar );
+
     vector<string> inputFileNames;
 
     string outputFileName;
@@ -107,6 +122,14 @@ private :
     //    vector<vector<RooRealVar *> > vars; //[workspace][dataset(cat)]
     vector<std::unordered_map<std::string, RooRealVar *> > vars; //[workspace][dataset(cat)]
 
+    bool keepDataHistParts;
+
+    vector<vector<string> > dataNames; //[workspace][dataset], in the order they were first seen
+
+    vector<vector<string> > varNames; //[workspace][var], in the order they were first seen
+
+    vector<vector<RooDataHist *> > dataHParts; //[workspace][part], in input order
+
     vector<TTree *> trees;
 
     vector<TH1 *> histos;
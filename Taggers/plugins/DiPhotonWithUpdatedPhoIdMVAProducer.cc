@@ -1,5 +1,5 @@
 #include "DataFormats/Common/interface/Handle.h"
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -22,7 +22,7 @@ using namespace reco;
 
 namespace flashgg {
 
-    class DiPhotonWithUpdatedPhoIdMVAProducer : public edm::EDProducer
+    class DiPhotonWithUpdatedPhoIdMVAProducer : public edm::stream::EDProducer<>
     {
     public:
         DiPhotonWithUpdatedPhoIdMVAProducer( const edm::ParameterSet & );
@@ -2,7 +2,7 @@
 
 #include "DataFormats/Common/interface/Handle.h"
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/Frameworkfwd.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
@@ -29,7 +29,7 @@ using namespace reco;
 namespace flashgg {
     const bool useXGB = false;
     
-    class DifferentialPhoIdInputsCorrector : public edm::EDProducer
+    class DifferentialPhoIdInputsCorrector : public edm::stream::EDProducer<>
     {
     public:
         DifferentialPhoIdInputsCorrector( const edm::ParameterSet & );
@@ -457,12 +457,8 @@ namespace flashgg {
                 correctPhoton(dipho->getLeadingPhoton(), engine, rhoFixedGrd);
                 correctPhoton(dipho->getSubLeadingPhoton(), engine, rhoFixedGrd);
 
-                auto leadChgIsos = dipho->getLeadingPhoton().pfChgIso03();
-                leadChgIsos[dipho->vtx()] = dipho->getLeadingPhoton().pfChgIsoWrtChosenVtx03();
-                dipho->getLeadingPhoton().setpfChgIso03(leadChgIsos);
-                auto subleadChgIsos = dipho->getSubLeadingPhoton().pfChgIso03();
-                subleadChgIsos[dipho->vtx()] = dipho->getSubLeadingPhoton().pfChgIsoWrtChosenVtx03();
-                dipho->getSubLeadingPhoton().setpfChgIso03(subleadChgIsos);
+                dipho->getLeadingPhoton().setpfChgIso03WrtVtx(dipho->vtx(), dipho->getLeadingPhoton().pfChgIsoWrtChosenVtx03());
+                dipho->getSubLeadingPhoton().setpfChgIso03WrtVtx(dipho->vtx(), dipho->getSubLeadingPhoton().pfChgIsoWrtChosenVtx03());
 
                 if( reRunRegression_ ) {
                     // store original energy 
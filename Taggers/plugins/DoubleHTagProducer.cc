@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -18,10 +18,11 @@
 #include "flashgg/DataFormats/interface/TagTruthBase.h"
 #include "DataFormats/Common/interface/RefToPtr.h"
 #include "flashgg/Taggers/interface/LeptonSelection.h"
+#include "flashgg/Taggers/interface/SelectionCache.h"
 #include "flashgg/MicroAOD/interface/MVAComputer.h"
 #include "flashgg/DataFormats/interface/DoubleHttHTagger.h"
 
-#include "PhysicsTools/TensorFlow/interface/TensorFlow.h"
+#include "flashgg/Taggers/interface/TensorFlowModelRegistry.h"
 
 #include <vector>
 #include <algorithm>
@@ -32,7 +33,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class DoubleHTagProducer : public EDProducer
+    class DoubleHTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -60,6 +61,10 @@ namespace flashgg {
         std::vector< std::string > systematicsLabels;
         std::map<std::string, float> ttHVars;
 
+        // leptons of each diphoton, shared by the jet systematics
+        SelectionCache<std::vector<edm::Ptr<flashgg::Muon> > > muonSelections_;
+        SelectionCache<std::vector<edm::Ptr<flashgg::Electron> > > electronSelections_;
+
         double minLeadPhoPt_, minSubleadPhoPt_;
         bool scalingPtCuts_, doPhotonId_, doMVAFlattening_, doCategorization_, dottHTagger_;
         double photonIDCut_;
@@ -133,8 +138,7 @@ namespace flashgg {
         std::vector<std::vector<double>> PL_VectorVar_;
         std::vector<double> x_mean_, x_std_, list_mean_, list_std_;
         FileInPath ttHWeightfileName_ ;
-        tensorflow::GraphDef* graphDef_ttH;
-        tensorflow::Session* session_ttH;
+        std::shared_ptr<const TensorFlowModel> model_ttH;
 
     };
 
@@ -271,8 +275,7 @@ namespace flashgg {
             x_std_ = iConfig.getParameter<std::vector<double>> ("ttHKiller_std");
             list_mean_ = iConfig.getParameter<std::vector<double>> ("ttHKiller_listmean");
             list_std_ = iConfig.getParameter<std::vector<double>> ("ttHKiller_liststd");
-            graphDef_ttH = tensorflow::loadGraphDef((ttHWeightfileName_.fullPath()).c_str());
-            session_ttH = tensorflow::createSession(graphDef_ttH);
+            model_ttH = TensorFlowModelRegistry::instance().get(ttHWeightfileName_.fullPath());
         }
 
        // produces<vector<DoubleHTag>>();
@@ -341,6 +344,8 @@ namespace flashgg {
         
     void DoubleHTagProducer::produce( Event &evt, const EventSetup & )
     {
+        muonSelections_.clear();
+        electronSelections_.clear();
 
         // update global variables
         globalVariablesComputer_.update(evt);
@@ -436,11 +441,16 @@ namespace flashgg {
             evt.getByToken( electronToken_, theElectrons );
             
 
+            // the jet systematics of the nominal diphotons select the same leptons
             if(theMuons->size()>0) {
-                Muons2018 = LeptonSelection2018::selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), TTHLeptonictag_MuonPtCut_, TTHLeptonictag_MuonEtaCut_, TTHLeptonictag_MuonIsoCut_, TTHLeptonictag_MuonPhotonDrCut_, 0);
+                Muons2018 = muonSelections_.get( dipho, theMuons.id(), [&]() {
+                    return LeptonSelection2018::selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), TTHLeptonictag_MuonPtCut_, TTHLeptonictag_MuonEtaCut_, TTHLeptonictag_MuonIsoCut_, TTHLeptonictag_MuonPhotonDrCut_, 0);
+                } );
             }
             if(theElectrons->size()>0) {
-               Electrons2018 = LeptonSelection2018::selectElectrons(theElectrons->ptrs(), dipho, TTHLeptonictag_ElePtCut_, TTHLeptonictag_EleEtaCuts_, TTHLeptonictag_ElePhotonDrCut_, TTHLeptonictag_ElePhotonZMassCut_, TTHLeptonictag_DeltaRTrkEle_, 0);
+               Electrons2018 = electronSelections_.get( dipho, theElectrons.id(), [&]() {
+                   return LeptonSelection2018::selectElectrons(theElectrons->ptrs(), dipho, TTHLeptonictag_ElePtCut_, TTHLeptonictag_EleEtaCuts_, TTHLeptonictag_ElePhotonDrCut_, TTHLeptonictag_ElePhotonZMassCut_, TTHLeptonictag_DeltaRTrkEle_, 0);
+               } );
             }
 
 
@@ -882,7 +892,7 @@ namespace flashgg {
         }
         std::vector<tensorflow::Tensor> outputs;
 
-        tensorflow::run(session_ttH, { {"input_1:0", PLinput}, {"input_2:0", HLFinput} }, { "dense_4/Sigmoid" }, &outputs);
+        model_ttH->run({ {"input_1:0", PLinput}, {"input_2:0", HLFinput} }, { "dense_4/Sigmoid" }, &outputs);
         //std::cout << "EvaluateNN result: " << outputs[0].matrix<float>()(0, 0) << std::endl;
         float NNscore = outputs[0].matrix<float>()(0, 0);
         return NNscore;
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -28,7 +28,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class StageOneCombinedTagProducer : public EDProducer
+    class StageOneCombinedTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -192,16 +192,16 @@ namespace flashgg {
                     std::cout << "tagcorig j1cadjust j2cadjust j1upadjust j2upadjust j1downadjust j2downadjust ";
                     std::cout << tagcorig << " " << j1cadjust << " "<< j2cadjust << " "<< j1upadjust << " "<< j2upadjust << " "<< j1downadjust << " "<< j2downadjust << std::endl;
                 }
-                for (auto it = stage1tag_obj.weightListBegin() ; it != stage1tag_obj.weightListEnd(); it++) {
-                    stage1tag_obj.setWeight(*it,stage1tag_obj.weight(*it) * j1cadjust * j2cadjust); 
+                for (auto id : stage1tag_obj.weightIds()) {
+                    stage1tag_obj.setWeightById(id,stage1tag_obj.weightById(id) * j1cadjust * j2cadjust); 
                 }
                 if (stage1tag_obj.VBFMVA().leadJet_ptr->hasWeight("UnmatchedPUWeightUp01sigma") ) {
                     stage1tag_obj.setWeight("UnmatchedPUWeightUp01sigma", stage1tag_obj.centralWeight() * j1upadjust * j2upadjust );
                     stage1tag_obj.setWeight("UnmatchedPUWeightDown01sigma", stage1tag_obj.centralWeight() * j1downadjust * j2downadjust );
                 }
                 if (false && systLabel_ == "") {
-                    for (auto it = stage1tag_obj.weightListBegin() ; it != stage1tag_obj.weightListEnd(); it++) {
-                        std::cout << "SCZ Weight Debug " << *it << " " << stage1tag_obj.weight(*it) << std::endl;
+                    for (auto &label : stage1tag_obj.weightLabels()) {
+                        std::cout << "SCZ Weight Debug " << label << " " << stage1tag_obj.weight(label) << std::endl;
                         
                     }                    
                 }
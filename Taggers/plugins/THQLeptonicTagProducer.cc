@@ -1,4 +1,4 @@
-﻿#include "FWCore/Framework/interface/EDProducer.h"
+﻿#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -83,7 +83,7 @@ public:
 };
 
 
-class THQLeptonicTagProducer : public EDProducer
+class THQLeptonicTagProducer : public edm::stream::EDProducer<>
 {
 
 public:
@@ -98,35 +98,6 @@ private:
 //    int  chooseCategory( float, float);
     int  chooseCategory( float );
     void produce( Event &, const EventSetup & ) override;
-    virtual void beginJob() override {
-        if(processId_.find("thq") != std::string::npos or processId_.find("thw") != std::string::npos) {
-            // CTCVWeightedVariables["photon1pt"] = new CTCVWeightedVariable("photon1pt" , "photon1pt" , 20 , 20 , 300 );
-            // CTCVWeightedVariables["photon2pt"] = new CTCVWeightedVariable("photon2pt" , "photon2pt" , 20 , 20 , 300 );
-            // CTCVWeightedVariables["diPhotonPt"] = new CTCVWeightedVariable("diPhotonPt" , "diPhotonPt" , 20 , 20 , 300 );
-            // CTCVWeightedVariables["diPhotonEta"] = new CTCVWeightedVariable("diPhotonEta" , "diPhotonEta" , 10 , 0 , 4 );
-            // CTCVWeightedVariables["diPhotonMVA"] = new CTCVWeightedVariable("diPhotonMVA" , "diPhotonMVA" , 20 , -1 , 1 );
-            // CTCVWeightedVariables["LeptonPt"] = new CTCVWeightedVariable("LeptonPt" , "LeptonPt" , 20 , 20 , 220 );
-            // CTCVWeightedVariables["LeptonEta"] = new CTCVWeightedVariable("LeptonPt" , "LeptonEta" , 5 , 0 , 2.5 );
-            // CTCVWeightedVariables["nJets"] = new CTCVWeightedVariable("nJets" , "nJets" , 5 , 0 , 5 );
-            // CTCVWeightedVariables["nbJets"] = new CTCVWeightedVariable("nbJets" , "nbJets" , 5 , 0 , 5 );
-            // CTCVWeightedVariables["MET"] = new CTCVWeightedVariable("MET" , "MET" , 10 , 30 , 230 );
-            // CTCVWeightedVariables["jPrimeEta"] = new CTCVWeightedVariable("jPrimeEta" , "jPrimeEta" , 5, 0 , 5 );
-        }
-    };
-
-    virtual void endJob() override {
-        // CTCVWeightedVariables["photon1pt"]->Write();
-        // CTCVWeightedVariables["photon2pt"]->Write();
-        // CTCVWeightedVariables["diPhotonPt"]->Write();
-        // CTCVWeightedVariables["diPhotonEta"]->Write();
-        // CTCVWeightedVariables["diPhotonMVA"]->Write();
-        // CTCVWeightedVariables["LeptonPt"]->Write();
-        // CTCVWeightedVariables["LeptonEta"]->Write();
-        // CTCVWeightedVariables["nJets"]->Write();
-        // CTCVWeightedVariables["nbJets"]->Write();
-        // CTCVWeightedVariables["MET"]->Write();
-        // CTCVWeightedVariables["jPrimeEta"]->Write();
-    };
 
     std::vector<edm::EDGetTokenT<View<flashgg::Jet> > > tokenJets_;
     EDGetTokenT<View<DiPhotonCandidate> > diPhotonToken_;
@@ -272,7 +243,7 @@ private:
     float MVAscore_tHqVsttHDNN;
 
     bool debug_=false;
-    TTH_DNN_Helper* dnn_ttH_vs_tH;
+    std::unique_ptr<TTH_DNN_Helper> dnn_ttH_vs_tH;
     struct GreaterByPt
     {
     public:
@@ -534,7 +505,7 @@ THQLeptonicTagProducer::THQLeptonicTagProducer( const ParameterSet &iConfig ) :
 
         thqLeptonicMva_tHqVsNonHiggsBkg->BookMVA( MVAMethod_.c_str() , MVAweight_tHqVsNonHiggsBkg_.fullPath() );
 
-        dnn_ttH_vs_tH = new TTH_DNN_Helper(tthVstHDNNfile_.fullPath());
+        dnn_ttH_vs_tH.reset(new TTH_DNN_Helper(tthVstHDNNfile_.fullPath()));
         dnn_ttH_vs_tH->SetInputShapes(23, 9, 8);
         dnn_ttH_vs_tH->SetPreprocessingSchemes(tthVstHDNN_global_mean_, tthVstHDNN_global_stddev_, tthVstHDNN_object_mean_, tthVstHDNN_object_stddev_);
 
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -16,6 +16,7 @@
 #include "flashgg/DataFormats/interface/Muon.h"
 
 #include "flashgg/Taggers/interface/LeptonSelection2018.h"
+#include "flashgg/Taggers/interface/SelectionCache.h"
 #include "flashgg/DataFormats/interface/Met.h"
 
 #include "DataFormats/Math/interface/deltaR.h"
@@ -40,7 +41,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class TTHHadronicTagProducer : public EDProducer
+    class TTHHadronicTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -51,6 +52,10 @@ namespace flashgg {
         int  computeStage1Kinematics( const TTHHadronicTag );
         int  chooseCategory_pt( float, float );
 
+        // leptons of each diphoton, shared by the systematics that keep the nominal diphotons
+        SelectionCache<std::vector<edm::Ptr<flashgg::Muon> > > muonSelections_;
+        SelectionCache<std::vector<edm::Ptr<flashgg::Electron> > > electronSelections_;
+
         std::vector<edm::EDGetTokenT<View<flashgg::Jet> > > tokenJets_;
         std::vector<std::vector<edm::EDGetTokenT<edm::View<flashgg::Jet>>>> jetTokens_;
         EDGetTokenT<View<DiPhotonCandidate> > diPhotonToken_;
@@ -224,8 +229,8 @@ namespace flashgg {
         vector<double> STXSPtBoundaries_pt5;
 
         BDT_resolvedTopTagger *topTagger;
-        TTH_DNN_Helper* dnn_dipho;
-        TTH_DNN_Helper* dnn_ttGG;
+        std::unique_ptr<TTH_DNN_Helper> dnn_dipho;
+        std::unique_ptr<TTH_DNN_Helper> dnn_ttGG;
 
         bool modifySystematicsWorkflow;
         std::vector<std::string> systematicsLabels;
@@ -571,8 +576,8 @@ namespace flashgg {
         if (useLargeMVAs) {
             topTagger = new BDT_resolvedTopTagger(topTaggerXMLfile_.fullPath());
 
-            dnn_dipho = new TTH_DNN_Helper(tthVsDiphoDNNfile_.fullPath());
-            dnn_ttGG  = new TTH_DNN_Helper(tthVsttGGDNNfile_.fullPath());
+            dnn_dipho.reset(new TTH_DNN_Helper(tthVsDiphoDNNfile_.fullPath()));
+            dnn_ttGG.reset(new TTH_DNN_Helper(tthVsttGGDNNfile_.fullPath()));
 
             dnn_dipho->SetInputShapes(18, 8, 8);
             dnn_ttGG->SetInputShapes(18, 8, 8);
@@ -661,6 +666,9 @@ namespace flashgg {
 
     void TTHHadronicTagProducer::produce( Event &evt, const EventSetup & )
     {
+        muonSelections_.clear();
+        electronSelections_.clear();
+
 
         //Handle<View<flashgg::Jet> > theJets;
         //evt.getByToken( thejetToken_, theJets );
@@ -793,9 +801,13 @@ namespace flashgg {
                 std::vector<edm::Ptr<flashgg::Electron> > Electrons;
 
                 if(theMuons->size()>0)
-                    Muons = selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), MuonPtCut_, MuonEtaCut_, MuonIsoCut_, MuonPhotonDrCut_, debug_);
+                    Muons = muonSelections_.get( dipho, theMuons.id(), [&]() {
+                        return selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), MuonPtCut_, MuonEtaCut_, MuonIsoCut_, MuonPhotonDrCut_, debug_);
+                    } );
                 if(theElectrons->size()>0)
-                    Electrons = selectElectrons(theElectrons->ptrs(), dipho, ElePtCut_, EleEtaCuts_, ElePhotonDrCut_, ElePhotonZMassCut_, DeltaRTrkEle_, debug_);
+                    Electrons = electronSelections_.get( dipho, theElectrons.id(), [&]() {
+                        return selectElectrons(theElectrons->ptrs(), dipho, ElePtCut_, EleEtaCuts_, ElePhotonDrCut_, ElePhotonZMassCut_, DeltaRTrkEle_, debug_);
+                    } );
 
                 if( (Muons.size() + Electrons.size()) != 0) continue;
 
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -19,6 +19,7 @@
 
 #include "DataFormats/TrackReco/interface/HitPattern.h"
 #include "flashgg/Taggers/interface/LeptonSelection2018.h"
+#include "flashgg/Taggers/interface/SelectionCache.h"
 
 #include "DataFormats/Math/interface/deltaR.h"
 
@@ -41,7 +42,7 @@ using namespace edm;
 
 
 namespace flashgg {
-    class TTHLeptonicTagProducer : public EDProducer
+    class TTHLeptonicTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -65,6 +66,11 @@ namespace flashgg {
             };
         };
         
+        // loose and tight leptons of each diphoton, shared by the systematics that keep the nominal diphotons
+        typedef std::pair<std::vector<edm::Ptr<flashgg::Muon> >, std::vector<edm::Ptr<flashgg::Muon> > > MuonSelection;
+        typedef std::pair<std::vector<edm::Ptr<flashgg::Electron> >, std::vector<edm::Ptr<flashgg::Electron> > > ElectronSelection;
+        SelectionCache<MuonSelection> muonSelections_;
+        SelectionCache<ElectronSelection> electronSelections_;
 
         std::vector<edm::EDGetTokenT<View<flashgg::Jet> > > tokenJets_;
         std::vector<std::vector<edm::EDGetTokenT<edm::View<flashgg::Jet>>>> jetTokens_;
@@ -226,8 +232,8 @@ namespace flashgg {
         float tthMvaVal_RunII_;
 
         BDT_resolvedTopTagger *topTagger;
-        TTH_DNN_Helper* dnn;
-        TTH_DNN_Helper* dnn_ttH_vs_tH;
+        std::unique_ptr<TTH_DNN_Helper> dnn;
+        std::unique_ptr<TTH_DNN_Helper> dnn_ttH_vs_tH;
 
         bool modifySystematicsWorkflow;
         std::vector<std::string> systematicsLabels;
@@ -637,11 +643,11 @@ namespace flashgg {
 
         if (useLargeMVAs) {
             topTagger = new BDT_resolvedTopTagger(topTaggerXMLfile_.fullPath());
-            dnn = new TTH_DNN_Helper(tthVsttGGDNNfile_.fullPath());
+            dnn.reset(new TTH_DNN_Helper(tthVsttGGDNNfile_.fullPath()));
             dnn->SetInputShapes(19, 9, 8);
             dnn->SetPreprocessingSchemes(tthVsttGGDNN_global_mean_, tthVsttGGDNN_global_stddev_, tthVsttGGDNN_object_mean_, tthVsttGGDNN_object_stddev_);
 
-            dnn_ttH_vs_tH = new TTH_DNN_Helper(tthVstHDNNfile_.fullPath());
+            dnn_ttH_vs_tH.reset(new TTH_DNN_Helper(tthVstHDNNfile_.fullPath()));
             dnn_ttH_vs_tH->SetInputShapes(23, 9, 8);
             dnn_ttH_vs_tH->SetPreprocessingSchemes(tthVstHDNN_global_mean_, tthVstHDNN_global_stddev_, tthVstHDNN_object_mean_, tthVstHDNN_object_stddev_);
         }
@@ -733,6 +739,9 @@ namespace flashgg {
 
     void TTHLeptonicTagProducer::produce( Event &evt, const EventSetup & )
     {
+        muonSelections_.clear();
+        electronSelections_.clear();
+
         //Handle<View<flashgg::Jet> > theJets;
         //evt.getByToken( thejetToken_, theJets );
         //const PtrVector<flashgg::Jet>& jetPointers = theJets->ptrVector();
@@ -905,12 +914,20 @@ namespace flashgg {
                 std::vector<int>    lepType;
 
                 if(theMuons->size()>0) {
-                    Muons = selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), MuonPtCut_, MuonEtaCut_, MuonIsoCut_, MuonPhotonDrCut_, debug_);
-                    MuonsTight = selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), MuonPtCut_, MuonEtaCut_, MuonIsoCut_, MuonPhotonDrCut_, debug_, 3);
+                    const MuonSelection &selected = muonSelections_.get( dipho, theMuons.id(), [&]() {
+                        return MuonSelection( selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), MuonPtCut_, MuonEtaCut_, MuonIsoCut_, MuonPhotonDrCut_, debug_),
+                                              selectMuons(theMuons->ptrs(), dipho, vertices->ptrs(), MuonPtCut_, MuonEtaCut_, MuonIsoCut_, MuonPhotonDrCut_, debug_, 3) );
+                    } );
+                    Muons = selected.first;
+                    MuonsTight = selected.second;
                 }
                 if(theElectrons->size()>0) {
-                    Electrons = selectElectrons(theElectrons->ptrs(), dipho, ElePtCut_, EleEtaCuts_, ElePhotonDrCut_, ElePhotonZMassCut_, DeltaRTrkEle_, debug_);
-                    ElectronsTight = selectElectrons(theElectrons->ptrs(), dipho, ElePtCut_, EleEtaCuts_, ElePhotonDrCut_, ElePhotonZMassCut_, DeltaRTrkEle_, debug_, 3);
+                    const ElectronSelection &selected = electronSelections_.get( dipho, theElectrons.id(), [&]() {
+                        return ElectronSelection( selectElectrons(theElectrons->ptrs(), dipho, ElePtCut_, EleEtaCuts_, ElePhotonDrCut_, ElePhotonZMassCut_, DeltaRTrkEle_, debug_),
+                                                  selectElectrons(theElectrons->ptrs(), dipho, ElePtCut_, EleEtaCuts_, ElePhotonDrCut_, ElePhotonZMassCut_, DeltaRTrkEle_, debug_, 3) );
+                    } );
+                    Electrons = selected.first;
+                    ElectronsTight = selected.second;
                 }
 
                 //If 2 same flavour leptons are found remove the pairs with mass compatible with a Z boson
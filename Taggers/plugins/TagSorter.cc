@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -47,7 +47,7 @@ namespace flashgg {
         }
     };
 
-    class TagSorter : public EDProducer
+    class TagSorter : public edm::stream::EDProducer<>
     {
 
     public:
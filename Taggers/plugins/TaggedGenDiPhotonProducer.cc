@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -25,7 +25,7 @@ using namespace edm;
 namespace flashgg {
 
 
-    class TaggedGenDiPhotonProducer : public EDProducer
+    class TaggedGenDiPhotonProducer : public edm::stream::EDProducer<>
     {
         typedef ClassNameClassifier<DiPhotonTagBase> classifier_t;
     public:
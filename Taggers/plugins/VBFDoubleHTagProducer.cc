@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -22,7 +22,7 @@
 #include "flashgg/MicroAOD/interface/MVAComputer.h"
 #include "flashgg/DataFormats/interface/DoubleHttHTagger.h"
 
-#include "PhysicsTools/TensorFlow/interface/TensorFlow.h"
+#include "flashgg/Taggers/interface/TensorFlowModelRegistry.h"
 
 #include <vector>
 #include <algorithm>
@@ -33,7 +33,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class VBFDoubleHTagProducer : public EDProducer
+    class VBFDoubleHTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -140,8 +140,7 @@ namespace flashgg {
         std::vector<std::vector<double>> PL_VectorVar_;
         std::vector<double> x_mean_, x_std_, list_mean_, list_std_;
         FileInPath ttHWeightfileName_ ;
-        tensorflow::GraphDef* graphDef_ttH;
-        tensorflow::Session* session_ttH;
+        std::shared_ptr<const TensorFlowModel> model_ttH;
         //double VBFMjjCut_, VBFJetEta_, VBFJetPt_ ;
 
     };
@@ -300,8 +299,7 @@ namespace flashgg {
             x_std_ = iConfig.getParameter<std::vector<double>> ("ttHKiller_std");
             list_mean_ = iConfig.getParameter<std::vector<double>> ("ttHKiller_listmean");
             list_std_ = iConfig.getParameter<std::vector<double>> ("ttHKiller_liststd");
-            graphDef_ttH = tensorflow::loadGraphDef((ttHWeightfileName_.fullPath()).c_str());
-            session_ttH = tensorflow::createSession(graphDef_ttH);
+            model_ttH = TensorFlowModelRegistry::instance().get(ttHWeightfileName_.fullPath());
         }
 
         // produces<vector<DoubleHTag>>();
@@ -1017,7 +1015,7 @@ namespace flashgg {
         }
         std::vector<tensorflow::Tensor> outputs;
 
-        tensorflow::run(session_ttH, { {"input_1:0", PLinput}, {"input_2:0", HLFinput} }, { "dense_4/Sigmoid" }, &outputs);
+        model_ttH->run({ {"input_1:0", PLinput}, {"input_2:0", HLFinput} }, { "dense_4/Sigmoid" }, &outputs);
         float NNscore = outputs[0].matrix<float>()(0, 0);
         return NNscore;
     }
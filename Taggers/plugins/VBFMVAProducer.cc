@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -28,7 +28,7 @@ using namespace edm;
 
 namespace flashgg {
     
-    class VBFMVAProducer : public EDProducer
+    class VBFMVAProducer : public edm::stream::EDProducer<>
     {
         
     public:
@@ -1,5 +1,5 @@
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -30,7 +30,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class VBFTagProducer : public EDProducer
+    class VBFTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -238,8 +238,8 @@ namespace flashgg {
                     std::cout << "tagcorig j1cadjust j2cadjust j1upadjust j2upadjust j1downadjust j2downadjust ";
                     std::cout << tagcorig << " " << j1cadjust << " "<< j2cadjust << " "<< j1upadjust << " "<< j2upadjust << " "<< j1downadjust << " "<< j2downadjust << std::endl;
                 }
-                for (auto it = tag_obj.weightListBegin() ; it != tag_obj.weightListEnd(); it++) {
-                    tag_obj.setWeight(*it,tag_obj.weight(*it) * j1cadjust * j2cadjust); 
+                for (auto id : tag_obj.weightIds()) {
+                    tag_obj.setWeightById(id,tag_obj.weightById(id) * j1cadjust * j2cadjust); 
                 }
                 if (tag_obj.VBFMVA().leadJet_ptr->hasWeight("UnmatchedPUWeightUp01sigma") ) {
                     tag_obj.setWeight("UnmatchedPUWeightUp01sigma", tag_obj.centralWeight() * j1upadjust * j2upadjust );
@@ -247,8 +247,8 @@ namespace flashgg {
                 }
 
                 if (false && systLabel_ == "") {
-                    for (auto it = tag_obj.weightListBegin() ; it != tag_obj.weightListEnd(); it++) {
-                        std::cout << "SCZ Weight Debug " << *it << " " << tag_obj.weight(*it) << std::endl;
+                    for (auto &label : tag_obj.weightLabels()) {
+                        std::cout << "SCZ Weight Debug " << label << " " << tag_obj.weight(label) << std::endl;
                         
                     }
                 }
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -33,7 +33,7 @@ typedef std::pair< edm::Ptr<flashgg::Jet>, edm::Ptr<flashgg::Jet> > jetptrpair;
 
 namespace flashgg {
 
-    class VHHadronicACTagProducer : public EDProducer
+    class VHHadronicACTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -32,7 +32,7 @@ typedef std::pair< edm::Ptr<flashgg::Jet>, edm::Ptr<flashgg::Jet> > jetptrpair;
 
 namespace flashgg {
 
-    class VHHadronicTagProducer : public EDProducer
+    class VHHadronicTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -29,7 +29,7 @@ using namespace edm;
 
 namespace flashgg {
 
-    class VHMetTagProducer : public EDProducer
+    class VHMetTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -25,7 +25,7 @@ using namespace edm;
 
 namespace flashgg {
     
-    class VHhadACDNNProducer : public EDProducer
+    class VHhadACDNNProducer : public edm::stream::EDProducer<>
     {
         
     public:
@@ -95,7 +95,10 @@ namespace flashgg {
         float sublPho_PToM_;
         
         std::map<std::string, double> dnnInputs;
-        std::map<std::string, double> dnnOutputs;
+
+        // per-event buffers: the DNN inputs of every candidate with a dijet, scored in one batch
+        std::vector<std::map<std::string, double> > dnnInputsBatch_;
+        std::vector<unsigned int> dnnResultIndices_;
 
     };
     
@@ -169,6 +172,8 @@ namespace flashgg {
         }
         
         std::unique_ptr<vector<VHhadACDNNResult> > vhHadAC_results( new vector<VHhadACDNNResult> );
+        dnnInputsBatch_.clear();
+        dnnResultIndices_.clear();
         for( unsigned int candIndex = 0; candIndex < diPhotons->size() ; candIndex++ ) {
             
             flashgg::VHhadACDNNResult mvares;
@@ -468,10 +473,9 @@ namespace flashgg {
                 dnnInputs["dijet_abs_dEta"] = dijet_abs_dEta_ ;
                 dnnInputs["cos_thetastar"] = cosThetaStar_ ;
                 dnnInputs["dijet_minDRJetPho"] = dijet_minDRJetPho_ ;
-                dnnOutputs = (*vhHadDNN_)( dnnInputs );
-                mvares.dnnvh_bkg = dnnOutputs[vhHadDNNOutputClasses_[0]];
-                mvares.dnnvh_sm = dnnOutputs[vhHadDNNOutputClasses_[1]];
-                mvares.dnnvh_bsm = dnnOutputs[vhHadDNNOutputClasses_[2]];
+                // scored with the other candidates of the event once the loop is done
+                dnnInputsBatch_.push_back( dnnInputs );
+                dnnResultIndices_.push_back( vhHadAC_results->size() );
 
             } else if( dijet_indices.first != -1 ) {
                 mvares.leadJet_ptr     = Jets[jetCollectionIndex]->ptrAt( dijet_indices.first );
@@ -532,6 +536,14 @@ namespace flashgg {
             
             vhHadAC_results->push_back( mvares );
         }
+
+        std::vector<std::map<std::string, double> > dnnOutputs = (*vhHadDNN_)( dnnInputsBatch_ );
+        for( unsigned int i = 0 ; i < dnnResultIndices_.size() ; i++ ) {
+            VHhadACDNNResult &mvares = ( *vhHadAC_results )[dnnResultIndices_[i]];
+            mvares.dnnvh_bkg = dnnOutputs[i][vhHadDNNOutputClasses_[0]];
+            mvares.dnnvh_sm = dnnOutputs[i][vhHadDNNOutputClasses_[1]];
+            mvares.dnnvh_bsm = dnnOutputs[i][vhHadDNNOutputClasses_[2]];
+        }
         evt.put( std::move( vhHadAC_results ) );
     }
 }
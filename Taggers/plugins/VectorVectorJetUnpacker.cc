@@ -1,7 +1,7 @@
 // VectorVectorJetUnpacker.cc
 // S. Zenz, July 2015
 
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -18,7 +18,7 @@ using namespace std;
 using namespace edm;
 
 namespace flashgg {
-    class VectorVectorJetUnpacker : public EDProducer
+    class VectorVectorJetUnpacker : public edm::stream::EDProducer<>
     {
 
     public:
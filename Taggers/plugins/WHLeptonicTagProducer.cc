@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -39,7 +39,7 @@ using namespace edm;
 
 
 namespace flashgg {
-    class WHLeptonicTagProducer : public EDProducer
+    class WHLeptonicTagProducer : public edm::stream::EDProducer<>
     {
 
     public:
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -17,11 +17,12 @@
 #include "DataFormats/Math/interface/deltaR.h"
 
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 
-#include "PhysicsTools/TensorFlow/interface/TensorFlow.h"
+#include "flashgg/Taggers/interface/TensorFlowModelRegistry.h"
 
 #include "DataFormats/Math/interface/LorentzVector.h"
 #include "TLorentzVector.h"
@@ -33,17 +34,37 @@ using namespace edm;
 
 namespace flashgg {
 
-    class bRegressionProducer : public EDProducer
+    class bRegressionProducer : public edm::stream::EDProducer<>
     {
 
     public:
         bRegressionProducer( const ParameterSet & );
         ~bRegressionProducer(){};
-        void InitJet();
-        void SetNNVectorVar();
-        std::vector<float> EvaluateNN();
     private:
+        // inputs of the regression that come from the jet userFloats/userInts: the same
+        // for a jet and its systematic variations, so they are read once per jet
+        struct JetInvariants {
+            float leadTrackPt;
+            float leptonPtRel;
+            float leptonDeltaR;
+            float softLepPtRelInv;
+            int isEle;
+            int isMu;
+            int isOther;
+            float withPtd;
+            float vtxPt;
+            float vtxMass;
+            float vtx3dL;
+            float vtxNtrk;
+            float vtx3deL;
+            float numDaughters_pt03;
+        };
+        static constexpr unsigned int nFeatures = 43;
+
         void produce( Event &, const EventSetup & ) override;
+        void ReadInvariants( const flashgg::Jet &, JetInvariants & ) const;
+        void SetNNVectorVar( const flashgg::Jet &, const JetInvariants &, float rho, float *features ) const;
+        void EvaluateNN( unsigned int first, unsigned int n );
         std::vector<edm::InputTag> inputTagJets_;
         std::vector<std::string> inputJetsNames_;
         std::vector<std::string> inputJetsSuffixes_;
@@ -52,59 +73,17 @@ namespace flashgg {
         double y_mean_;
         double y_std_;
         string year_;
+        unsigned int maxBatchSize_;
         std::vector<edm::EDGetTokenT<edm::View<flashgg::Jet> > > jetTokens_;
         std::vector< std::string > bregtags;
 
-        tensorflow::Session* session;
-        std::vector<float> NNvectorVar_; 
-        //add vector of mva for each jet
-
-        //mva variables
-        float Jet_pt ;
-        float Jet_eta ;
-        float rho ;
-        float Jet_mt ;
-        float Jet_leadTrackPt ;
-        float Jet_leptonPtRel ;
-        float Jet_leptonDeltaR ;
-        float Jet_neHEF ;
-        float Jet_neEmEF ;
-        float Jet_vtxPt ;
-        float Jet_vtxMass ;
-        float Jet_vtx3dL ;
-        float Jet_vtxNtrk ;
-        float Jet_vtx3deL ;
-        float Jet_numDaughters_pt03 ;
-        float Jet_energyRing_dR0_em_Jet_e ;
-        float Jet_energyRing_dR1_em_Jet_e ;
-        float Jet_energyRing_dR2_em_Jet_e ;
-        float Jet_energyRing_dR3_em_Jet_e ;
-        float Jet_energyRing_dR4_em_Jet_e ;
-        float Jet_energyRing_dR0_neut_Jet_e ;
-        float Jet_energyRing_dR1_neut_Jet_e ;
-        float Jet_energyRing_dR2_neut_Jet_e ;
-        float Jet_energyRing_dR3_neut_Jet_e ;
-        float Jet_energyRing_dR4_neut_Jet_e ;
-        float Jet_energyRing_dR0_ch_Jet_e ;
-        float Jet_energyRing_dR1_ch_Jet_e ;
-        float Jet_energyRing_dR2_ch_Jet_e ;
-        float Jet_energyRing_dR3_ch_Jet_e ;
-        float Jet_energyRing_dR4_ch_Jet_e ;
-        float Jet_energyRing_dR0_mu_Jet_e ;
-        float Jet_energyRing_dR1_mu_Jet_e ;
-        float Jet_energyRing_dR2_mu_Jet_e ;
-        float Jet_energyRing_dR3_mu_Jet_e ;
-        float Jet_energyRing_dR4_mu_Jet_e ;
-        float Jet_chHEF;//implement from here
-        float Jet_chEmEF;
-        float Jet_leptonPtRelInv;
-        int isEle;
-        int isMu;
-        int isOther;
-        float Jet_mass;
-        float Jet_withPtd;
-
-        
+        std::shared_ptr<const TensorFlowModel> model_;
+
+        // per-event buffers: one row of inputs and outputs per jet of all the collections
+        std::vector<float> NNvectorVar_;
+        std::vector<float> NNoutputs_;
+        std::vector<std::vector<JetInvariants> > invariants_; // per jet name, from the first suffix
+        std::vector<std::pair<unsigned int, unsigned int> > rows_; // (collection, jet) of each row
     };
 
 
@@ -115,7 +94,8 @@ namespace flashgg {
         bRegressionWeightfileName_( iConfig.getUntrackedParameter<std::string>("bRegressionWeightfile")),
         y_mean_(iConfig.getUntrackedParameter<double>("y_mean")),
         y_std_(iConfig.getUntrackedParameter<double>("y_std")),
-        year_(iConfig.getUntrackedParameter<std::string>("year"))
+        year_(iConfig.getUntrackedParameter<std::string>("year")),
+        maxBatchSize_(iConfig.getUntrackedParameter<unsigned int>("maxBatchSize", 0))
     {
         for (auto & suffix : inputJetsSuffixes_) {
             for (unsigned int i = 0; i < inputJetsNames_.size() ; i++) {
@@ -132,54 +112,9 @@ namespace flashgg {
         }
 
 
-        tensorflow::GraphDef* graphDef= tensorflow::loadGraphDef(bRegressionWeightfileName_.c_str());
-        session = tensorflow::createSession(graphDef);
-
-           
-
-        Jet_pt = 0.;
-        Jet_eta = 0.;
-        rho = 0.;
-        Jet_mt = 0.;
-        Jet_leadTrackPt = 0.;
-        Jet_leptonPtRel = 0.;
-        Jet_leptonDeltaR = 0.;
-        Jet_neHEF = 0.;
-        Jet_neEmEF = 0.;
-        Jet_vtxPt = 0.;
-        Jet_vtxMass = 0.;
-        Jet_vtx3dL = 0.;
-        Jet_vtxNtrk = 0.;
-        Jet_vtx3deL = 0.;
-        Jet_numDaughters_pt03 = 0;
-        Jet_energyRing_dR0_em_Jet_e = 0.;
-        Jet_energyRing_dR1_em_Jet_e = 0.;
-        Jet_energyRing_dR2_em_Jet_e = 0.;
-        Jet_energyRing_dR3_em_Jet_e = 0.;
-        Jet_energyRing_dR4_em_Jet_e = 0.;
-        Jet_energyRing_dR0_neut_Jet_e = 0.;
-        Jet_energyRing_dR1_neut_Jet_e = 0.;
-        Jet_energyRing_dR2_neut_Jet_e = 0.;
-        Jet_energyRing_dR3_neut_Jet_e = 0.;
-        Jet_energyRing_dR4_neut_Jet_e = 0.;
-        Jet_energyRing_dR0_ch_Jet_e = 0.;
-        Jet_energyRing_dR1_ch_Jet_e = 0.;
-        Jet_energyRing_dR2_ch_Jet_e = 0.;
-        Jet_energyRing_dR3_ch_Jet_e = 0.;
-        Jet_energyRing_dR4_ch_Jet_e = 0.;
-        Jet_energyRing_dR0_mu_Jet_e = 0.;
-        Jet_energyRing_dR1_mu_Jet_e = 0.;
-        Jet_energyRing_dR2_mu_Jet_e = 0.;
-        Jet_energyRing_dR3_mu_Jet_e = 0.;
-        Jet_energyRing_dR4_mu_Jet_e = 0.;
-        Jet_chHEF = 0.;
-        Jet_chEmEF = 0.;
-        Jet_leptonPtRelInv = 0.;
-        isEle = 0.;
-        isMu = 0.;
-        isOther = 0.;
-        Jet_mass = 0.;
-        Jet_withPtd = 0.;
+        model_ = TensorFlowModelRegistry::instance().get( bRegressionWeightfileName_ );
+
+        invariants_.resize( inputJetsNames_.size() );
 
         for (auto & bregtag : bregtags) {
             produces<vector<flashgg::Jet> > (bregtag);
@@ -190,139 +125,63 @@ namespace flashgg {
 
     void bRegressionProducer::produce( Event &evt, const EventSetup & )
     {
- 
-    for (unsigned int jet_col_idx = 0 ;jet_col_idx <jetTokens_.size()  ; jet_col_idx++) { // looping over 12 jet collections (associated to different vertecies) and all systematics
-    
-        // input jets
-       Handle<View<flashgg::Jet> > jets;
-       evt.getByToken( jetTokens_[jet_col_idx], jets );//gettting the ith jet collection (out of 12 vertecies)
-
-       unique_ptr<vector<flashgg::Jet> > jetColl( new vector<flashgg::Jet> );
-        for( unsigned int i = 0 ; i < jets->size() ; i++ ) {
-
-            InitJet();
-            
-            Ptr<flashgg::Jet> pjet = jets->ptrAt( i );
-            flashgg::Jet fjet = flashgg::Jet( *pjet );
-
-
-            //variables needed for regression
-            //you need to take uncorrected jet for variables
-            Jet_pt = fjet.correctedJet("Uncorrected").pt() ;
-            Jet_eta = fjet.eta() ;
-            Jet_leadTrackPt = fjet.userFloat("leadTrackPt");
-            edm::Handle<double> rhoHandle;
-            evt.getByToken( rhoToken_, rhoHandle );
-            const double rhoFixedGrd = *( rhoHandle.product() );
-            rho = rhoFixedGrd;
-            Jet_mt = sqrt(fjet.correctedJet("Uncorrected").energy()*fjet.correctedJet("Uncorrected").energy()-fjet.correctedJet("Uncorrected").pz()*fjet.correctedJet("Uncorrected").pz());
-
-            //this max probably not needed, it's just heppy
-            Jet_leptonPtRel = std::max(float(0.),fjet.userFloat("softLepPtRel"));
-            Jet_leptonDeltaR = std::max(float(0.),fjet.userFloat("softLepDr"));
-            Jet_neHEF = fjet.neutralHadronEnergyFraction();
-            Jet_neEmEF = fjet.neutralEmEnergyFraction();
-            Jet_chHEF = fjet.chargedHadronEnergyFraction();
-            Jet_chEmEF = fjet.chargedEmEnergyFraction();
-            Jet_leptonPtRelInv = fjet.userFloat("softLepPtRelInv")*Jet_pt/fjet.pt();
-            
-            int lepPdgID = fjet.userInt("softLepPdgId");
-            if (abs(lepPdgID)==13){
-                isMu=1; 
-            }else if (abs(lepPdgID)==11){
-                isEle=1;
-            }else{
-                isOther=1;
-            }
-            Jet_mass=fjet.correctedJet("Uncorrected").mass();
-            Jet_withPtd=fjet.userFloat("ptD");
-            
-            if(fjet.userFloat("nSecVertices")>0){
-//                float vertexX=fjet.userFloat("vtxPosX")-fjet.userFloat("vtxPx");//check if it's correct
-//                float vertexY=fjet.userFloat("vtxPosY")-fjet.userFloat("vtxPy");                
-//                Jet_vtxPt = sqrt(vertexX*vertexX+vertexY*vertexY);
-                Jet_vtxPt=sqrt(fjet.userFloat("vtxPx")*fjet.userFloat("vtxPx")+fjet.userFloat("vtxPy")*fjet.userFloat("vtxPy"));
-                Jet_vtxMass = std::max(float(0.),fjet.userFloat("vtxMass"));
-                Jet_vtx3dL = std::max(float(0.),fjet.userFloat("vtx3DVal"));
-                Jet_vtxNtrk = std::max(float(0.),fjet.userFloat("vtxNTracks"));
-                Jet_vtx3deL = std::max(float(0.),fjet.userFloat("vtx3DSig"));
-                if (Jet_vtx3deL!=0.) Jet_vtx3deL = Jet_vtx3dL/Jet_vtx3deL ;
-            }
-            if (fjet.emEnergies().size()>0){//since in order to save space we save this info only if the candidate has a minimum pt or eta
-                Jet_energyRing_dR0_em_Jet_e = fjet.emEnergies()[0]/fjet.correctedJet("Uncorrected").energy();//remember to divide by jet energy
-                Jet_energyRing_dR1_em_Jet_e = fjet.emEnergies()[1]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR2_em_Jet_e = fjet.emEnergies()[2]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR3_em_Jet_e = fjet.emEnergies()[3]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR4_em_Jet_e = fjet.emEnergies()[4]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR0_neut_Jet_e = fjet.neEnergies()[0]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR1_neut_Jet_e = fjet.neEnergies()[1]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR2_neut_Jet_e = fjet.neEnergies()[2]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR3_neut_Jet_e = fjet.neEnergies()[3]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR4_neut_Jet_e = fjet.neEnergies()[4]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR0_ch_Jet_e = fjet.chEnergies()[0]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR1_ch_Jet_e = fjet.chEnergies()[1]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR2_ch_Jet_e = fjet.chEnergies()[2]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR3_ch_Jet_e = fjet.chEnergies()[3]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR4_ch_Jet_e = fjet.chEnergies()[4]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR0_mu_Jet_e = fjet.muEnergies()[0]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR1_mu_Jet_e = fjet.muEnergies()[1]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR2_mu_Jet_e = fjet.muEnergies()[2]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR3_mu_Jet_e = fjet.muEnergies()[3]/fjet.correctedJet("Uncorrected").energy();
-                Jet_energyRing_dR4_mu_Jet_e = fjet.muEnergies()[4]/fjet.correctedJet("Uncorrected").energy();
+        edm::Handle<double> rhoHandle;
+        evt.getByToken( rhoToken_, rhoHandle );
+        const float rho = *( rhoHandle.product() );
+
+        // collect the inputs of all the jets of all the collections (one per vertex, times the
+        // systematic variations), so that the network is evaluated once per event
+        std::vector<unique_ptr<vector<flashgg::Jet> > > jetColls( jetTokens_.size() );
+        NNvectorVar_.clear();
+        rows_.clear();
+        for (unsigned int jet_col_idx = 0 ;jet_col_idx <jetTokens_.size()  ; jet_col_idx++) { // suffix-major: the first suffix comes first for each jet name
+
+            Handle<View<flashgg::Jet> > jets;
+            evt.getByToken( jetTokens_[jet_col_idx], jets );
+
+            unsigned int name_idx = jet_col_idx % inputJetsNames_.size();
+            bool reference = ( jet_col_idx < inputJetsNames_.size() );
+            auto &invariants = invariants_[name_idx];
+            if( reference ) { invariants.resize( jets->size() ); }
+            const vector<flashgg::Jet> *referenceJets = jetColls[name_idx].get();
+
+            jetColls[jet_col_idx].reset( new vector<flashgg::Jet> );
+            auto &jetColl = *jetColls[jet_col_idx];
+            jetColl.reserve( jets->size() );
+            for( unsigned int i = 0 ; i < jets->size() ; i++ ) {
+                jetColl.push_back( ( *jets )[i] );
+                const flashgg::Jet &fjet = jetColl.back();
+
+                // a systematic variation has the same jets as the first suffix, in the same order,
+                // unless a shift moved a jet across a selection threshold
+                JetInvariants own;
+                const JetInvariants *inv = &own;
+                if( reference ) {
+                    ReadInvariants( fjet, invariants[i] );
+                    inv = &invariants[i];
+                } else if( referenceJets != nullptr && referenceJets->size() == jets->size()
+                           && reco::deltaR2( fjet, ( *referenceJets )[i] ) < 1.e-6 ) {
+                    inv = &invariants[i];
+                } else {
+                    ReadInvariants( fjet, own );
+                }
+
+                NNvectorVar_.resize( NNvectorVar_.size() + nFeatures );
+                SetNNVectorVar( fjet, *inv, rho, &NNvectorVar_[NNvectorVar_.size() - nFeatures] );
+                rows_.emplace_back( jet_col_idx, i );
             }
-            Jet_numDaughters_pt03 = fjet.userInt("numDaug03");
-            
-            std::vector<float> bRegNN(3,-999);
-            
-
-            if(debug){
-                cout<<"Jet_pt :"<<Jet_pt <<endl;
-                cout<<"Jet_eta :"<<Jet_eta <<endl;
-                cout<<"rho :"<<rho <<endl;
-                cout<<"Jet_mt :"<<Jet_mt <<endl;
-                cout<<"Jet_leadTrackPt :"<<Jet_leadTrackPt <<endl;
-                cout<<"Jet_leptonPtRel :"<<Jet_leptonPtRel <<endl;
-                cout<<"Jet_leptonDeltaR :"<<Jet_leptonDeltaR <<endl;
-                cout<<"Jet_neHEF :"<<Jet_neHEF <<endl;
-                cout<<"Jet_neEmEF :"<<Jet_neEmEF <<endl;
-                cout<<"Jet_vtxPt :"<<Jet_vtxPt <<endl;
-                cout<<"Jet_vtxMass :"<<Jet_vtxMass <<endl;
-                cout<<"Jet_vtx3dL :"<<Jet_vtx3dL <<endl;
-                cout<<"Jet_vtxNtrk :"<<Jet_vtxNtrk <<endl;
-                cout<<"Jet_vtx3deL :"<<Jet_vtx3deL <<endl;
-                cout<<"Jet_numDaughters_pt03 :"<<Jet_numDaughters_pt03 <<endl;
-                cout<<"Jet_energyRing_dR0_em_Jet_e :"<<Jet_energyRing_dR0_em_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR1_em_Jet_e :"<<Jet_energyRing_dR1_em_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR2_em_Jet_e :"<<Jet_energyRing_dR2_em_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR3_em_Jet_e :"<<Jet_energyRing_dR3_em_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR4_em_Jet_e :"<<Jet_energyRing_dR4_em_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR0_neut_Jet_e :"<<Jet_energyRing_dR0_neut_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR1_neut_Jet_e :"<<Jet_energyRing_dR1_neut_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR2_neut_Jet_e :"<<Jet_energyRing_dR2_neut_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR3_neut_Jet_e :"<<Jet_energyRing_dR3_neut_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR4_neut_Jet_e :"<<Jet_energyRing_dR4_neut_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR0_ch_Jet_e :"<<Jet_energyRing_dR0_ch_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR1_ch_Jet_e :"<<Jet_energyRing_dR1_ch_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR2_ch_Jet_e :"<<Jet_energyRing_dR2_ch_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR3_ch_Jet_e :"<<Jet_energyRing_dR3_ch_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR4_ch_Jet_e :"<<Jet_energyRing_dR4_ch_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR0_mu_Jet_e :"<<Jet_energyRing_dR0_mu_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR1_mu_Jet_e :"<<Jet_energyRing_dR1_mu_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR2_mu_Jet_e :"<<Jet_energyRing_dR2_mu_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR3_mu_Jet_e :"<<Jet_energyRing_dR3_mu_Jet_e <<endl;
-                cout<<"Jet_energyRing_dR4_mu_Jet_e :"<<Jet_energyRing_dR4_mu_Jet_e <<endl;
-                cout<<"Jet_chHEF:"<<Jet_chHEF<<endl;
-                cout<<"Jet_chEmEF:"<<Jet_chEmEF<<endl;
-                cout<<"Jet_leptonPtRelInv:"<<Jet_leptonPtRelInv<<endl;
-                cout<<"isEle:"<<isEle<<endl;
-                cout<<"isMu:"<<isMu<<endl;
-                cout<<"isOther:"<<isOther<<endl;
-                cout<<"Jet_mass:"<<Jet_mass<<endl;
-                cout<<"Jet_withPtd:"<<Jet_withPtd<<endl;
-            }
-            SetNNVectorVar();
-            bRegNN = EvaluateNN();
-            NNvectorVar_.clear();
+        }
+
+        unsigned int nRows = rows_.size();
+        NNoutputs_.resize( 3 * nRows );
+        unsigned int batchSize = ( maxBatchSize_ > 0 ? maxBatchSize_ : nRows );
+        for( unsigned int first = 0 ; first < nRows ; first += batchSize ) {
+            EvaluateNN( first, std::min( batchSize, nRows - first ) );
+        }
+
+        for( unsigned int row = 0 ; row < nRows ; row++ ) {
+            flashgg::Jet &fjet = ( *jetColls[rows_[row].first] )[rows_[row].second];
+            const float *bRegNN = &NNoutputs_[3 * row];
 
             float corr=1., res=0.2;
             if (fjet.pt()<20) {//b-jet regression should not be applied to low-pt jets since not trained. just set a correction of 1
@@ -355,128 +214,107 @@ namespace flashgg {
                 std::cout<<"--------------------------------------------------------------"<<std::endl;
                 std::cout<<"--------------------------------------------------------------"<<std::endl;
             }
-            
+        }
+
+        for (unsigned int jet_col_idx = 0 ;jet_col_idx <jetTokens_.size()  ; jet_col_idx++) {
+            evt.put( std::move( jetColls[jet_col_idx] ),bregtags[jet_col_idx] );
+        }
+    }
 
-            jetColl->push_back( fjet );
+    void bRegressionProducer::ReadInvariants( const flashgg::Jet &fjet, JetInvariants &inv ) const
+    {
+        inv.leadTrackPt = fjet.userFloat("leadTrackPt");
+        //this max probably not needed, it's just heppy
+        inv.leptonPtRel = std::max(float(0.),fjet.userFloat("softLepPtRel"));
+        inv.leptonDeltaR = std::max(float(0.),fjet.userFloat("softLepDr"));
+        inv.softLepPtRelInv = fjet.userFloat("softLepPtRelInv");
+
+        int lepPdgID = fjet.userInt("softLepPdgId");
+        inv.isEle = inv.isMu = inv.isOther = 0;
+        if (abs(lepPdgID)==13){
+            inv.isMu=1; 
+        }else if (abs(lepPdgID)==11){
+            inv.isEle=1;
+        }else{
+            inv.isOther=1;
         }
-        evt.put( std::move( jetColl ),bregtags[jet_col_idx] );
+        inv.withPtd=fjet.userFloat("ptD");
+
+        inv.vtxPt = inv.vtxMass = inv.vtx3dL = inv.vtxNtrk = inv.vtx3deL = 0.;
+        if(fjet.userFloat("nSecVertices")>0){
+//            float vertexX=fjet.userFloat("vtxPosX")-fjet.userFloat("vtxPx");//check if it's correct
+//            float vertexY=fjet.userFloat("vtxPosY")-fjet.userFloat("vtxPy");                
+//            Jet_vtxPt = sqrt(vertexX*vertexX+vertexY*vertexY);
+            inv.vtxPt=sqrt(fjet.userFloat("vtxPx")*fjet.userFloat("vtxPx")+fjet.userFloat("vtxPy")*fjet.userFloat("vtxPy"));
+            inv.vtxMass = std::max(float(0.),fjet.userFloat("vtxMass"));
+            inv.vtx3dL = std::max(float(0.),fjet.userFloat("vtx3DVal"));
+            inv.vtxNtrk = std::max(float(0.),fjet.userFloat("vtxNTracks"));
+            inv.vtx3deL = std::max(float(0.),fjet.userFloat("vtx3DSig"));
+            if (inv.vtx3deL!=0.) inv.vtx3deL = inv.vtx3dL/inv.vtx3deL ;
         }
+        inv.numDaughters_pt03 = fjet.userInt("numDaug03");
     }
-    
-    void bRegressionProducer::InitJet(){
-        Jet_pt = 0.;
-        Jet_eta = 0.;
-        rho = 0.;
-        Jet_mt = 0.;
-        Jet_leadTrackPt = 0.;
-        Jet_leptonPtRel = 0.;
-        Jet_leptonDeltaR = 0.;
-        Jet_neHEF = 0.;
-        Jet_neEmEF = 0.;
-        Jet_vtxPt = 0.;
-        Jet_vtxMass = 0.;
-        Jet_vtx3dL = 0.;
-        Jet_vtxNtrk = 0.;
-        Jet_vtx3deL = 0.;
-        Jet_numDaughters_pt03 = 0;
-        Jet_energyRing_dR0_em_Jet_e = 0.;
-        Jet_energyRing_dR1_em_Jet_e = 0.;
-        Jet_energyRing_dR2_em_Jet_e = 0.;
-        Jet_energyRing_dR3_em_Jet_e = 0.;
-        Jet_energyRing_dR4_em_Jet_e = 0.;
-        Jet_energyRing_dR0_neut_Jet_e = 0.;
-        Jet_energyRing_dR1_neut_Jet_e = 0.;
-        Jet_energyRing_dR2_neut_Jet_e = 0.;
-        Jet_energyRing_dR3_neut_Jet_e = 0.;
-        Jet_energyRing_dR4_neut_Jet_e = 0.;
-        Jet_energyRing_dR0_ch_Jet_e = 0.;
-        Jet_energyRing_dR1_ch_Jet_e = 0.;
-        Jet_energyRing_dR2_ch_Jet_e = 0.;
-        Jet_energyRing_dR3_ch_Jet_e = 0.;
-        Jet_energyRing_dR4_ch_Jet_e = 0.;
-        Jet_energyRing_dR0_mu_Jet_e = 0.;
-        Jet_energyRing_dR1_mu_Jet_e = 0.;
-        Jet_energyRing_dR2_mu_Jet_e = 0.;
-        Jet_energyRing_dR3_mu_Jet_e = 0.;
-        Jet_energyRing_dR4_mu_Jet_e = 0.;
-        Jet_chHEF = 0.;//implement from here
-        Jet_chEmEF = 0.;
-        Jet_leptonPtRelInv = 0.;
-        isEle = 0;
-        isMu = 0;
-        isOther = 0;
-        Jet_mass = 0.;
-        Jet_withPtd = 0.;
-
-
-    }//end InitJet
-
-    void bRegressionProducer::SetNNVectorVar(){
-
-        NNvectorVar_.push_back(Jet_pt) ;//0
-        NNvectorVar_.push_back(Jet_eta) ;
-        NNvectorVar_.push_back(rho) ;
-        NNvectorVar_.push_back(Jet_mt) ;
-        NNvectorVar_.push_back(Jet_leadTrackPt) ;
-        NNvectorVar_.push_back(Jet_leptonPtRel) ;//5
-        NNvectorVar_.push_back(Jet_leptonDeltaR) ;
-        NNvectorVar_.push_back(Jet_neHEF) ;
-        NNvectorVar_.push_back(Jet_neEmEF) ;
-        NNvectorVar_.push_back(Jet_vtxPt) ;
-        NNvectorVar_.push_back(Jet_vtxMass) ;//10
-        NNvectorVar_.push_back(Jet_vtx3dL) ;
-        NNvectorVar_.push_back(Jet_vtxNtrk) ;
-        NNvectorVar_.push_back(Jet_vtx3deL) ;
-        NNvectorVar_.push_back(Jet_numDaughters_pt03) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR0_em_Jet_e) ;//15
-        NNvectorVar_.push_back(Jet_energyRing_dR1_em_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR2_em_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR3_em_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR4_em_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR0_neut_Jet_e) ;//20
-        NNvectorVar_.push_back(Jet_energyRing_dR1_neut_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR2_neut_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR3_neut_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR4_neut_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR0_ch_Jet_e) ;//25
-        NNvectorVar_.push_back(Jet_energyRing_dR1_ch_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR2_ch_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR3_ch_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR4_ch_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR0_mu_Jet_e) ;//30
-        NNvectorVar_.push_back(Jet_energyRing_dR1_mu_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR2_mu_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR3_mu_Jet_e) ;
-        NNvectorVar_.push_back(Jet_energyRing_dR4_mu_Jet_e) ;
-        NNvectorVar_.push_back(Jet_chHEF);//35
-        NNvectorVar_.push_back(Jet_chEmEF);
-        NNvectorVar_.push_back(Jet_leptonPtRelInv);
-        NNvectorVar_.push_back(isEle);
-        NNvectorVar_.push_back(isMu);
-        NNvectorVar_.push_back(isOther);//40
-        NNvectorVar_.push_back(Jet_mass);
-        NNvectorVar_.push_back(Jet_withPtd);
 
-        if(debug){
-            for (unsigned int i=0;i<NNvectorVar_.size();i++)
-                std::cout<<NNvectorVar_[i]<<" , ";
+    void bRegressionProducer::SetNNVectorVar( const flashgg::Jet &fjet, const JetInvariants &inv, float rho, float *features ) const
+    {
+        //you need to take uncorrected jet for variables
+        const pat::Jet uncorrected = fjet.correctedJet("Uncorrected");
+        const double energy = uncorrected.energy();
+
+        float Jet_pt = uncorrected.pt();
+        features[0] = Jet_pt;
+        features[1] = fjet.eta();
+        features[2] = rho;
+        features[3] = sqrt(energy*energy-uncorrected.pz()*uncorrected.pz());//Jet_mt
+        features[4] = inv.leadTrackPt;
+        features[5] = inv.leptonPtRel;
+        features[6] = inv.leptonDeltaR;
+        features[7] = fjet.neutralHadronEnergyFraction();
+        features[8] = fjet.neutralEmEnergyFraction();
+        features[9] = inv.vtxPt;
+        features[10] = inv.vtxMass;
+        features[11] = inv.vtx3dL;
+        features[12] = inv.vtxNtrk;
+        features[13] = inv.vtx3deL;
+        features[14] = inv.numDaughters_pt03;
+        //energy rings, divided by the jet energy; in order to save space they are stored only if the candidate has a minimum pt or eta
+        bool hasRings = ( fjet.emEnergies().size()>0 );
+        for( unsigned int ring = 0 ; ring < 5 ; ring++ ) {
+            features[15 + ring] = ( hasRings ? fjet.emEnergies()[ring]/energy : 0. );
+            features[20 + ring] = ( hasRings ? fjet.neEnergies()[ring]/energy : 0. );
+            features[25 + ring] = ( hasRings ? fjet.chEnergies()[ring]/energy : 0. );
+            features[30 + ring] = ( hasRings ? fjet.muEnergies()[ring]/energy : 0. );
         }
+        features[35] = fjet.chargedHadronEnergyFraction();
+        features[36] = fjet.chargedEmEnergyFraction();
+        features[37] = inv.softLepPtRelInv*Jet_pt/fjet.pt();//Jet_leptonPtRelInv
+        features[38] = inv.isEle;
+        features[39] = inv.isMu;
+        features[40] = inv.isOther;
+        features[41] = uncorrected.mass();
+        features[42] = inv.withPtd;
 
-    }
-    
-    std::vector<float> bRegressionProducer::EvaluateNN(){
-        unsigned int shape=NNvectorVar_.size();
-        std::vector<float> correction(3);//3 outputs, first value is mean and then other 2 quantiles
-        tensorflow::Tensor input(tensorflow::DT_FLOAT, {1,shape});
-        for (unsigned int i = 0; i < NNvectorVar_.size(); i++){
-            input.matrix<float>()(0,i) =  float(NNvectorVar_[i]);
+        if(debug){
+            for (unsigned int i=0;i<nFeatures;i++)
+                std::cout<<features[i]<<" , ";
+            std::cout<<std::endl;
         }
+    }
+
+    // evaluates rows [first, first+n) of NNvectorVar_ into NNoutputs_
+    void bRegressionProducer::EvaluateNN( unsigned int first, unsigned int n )
+    {
+        tensorflow::Tensor input(tensorflow::DT_FLOAT, {n,nFeatures});
+        std::copy( NNvectorVar_.begin() + first * nFeatures, NNvectorVar_.begin() + ( first + n ) * nFeatures, input.flat<float>().data() );
         std::vector<tensorflow::Tensor> outputs;
-        tensorflow::run(session, { { "ffwd_inp:0",input } }, { "ffwd_out/BiasAdd:0" }, &outputs);
-        correction[0] = outputs[0].matrix<float>()(0, 0);
-        correction[1] = outputs[0].matrix<float>()(0, 1);
-        correction[2] = outputs[0].matrix<float>()(0, 2);
-        return correction;
+        model_->run({ { "ffwd_inp:0",input } }, { "ffwd_out/BiasAdd:0" }, &outputs);
+        auto output = outputs[0].matrix<float>();
+        for( unsigned int row = 0 ; row < n ; row++ ) {
+            //3 outputs, first value is mean and then other 2 quantiles
+            for( unsigned int k = 0 ; k < 3 ; k++ ) {
+                NNoutputs_[3 * ( first + row ) + k] = output( row, k );
+            }
+        }
     }//end EvaluateNN
     
 }
@@ -18,8 +18,10 @@ diphotonDumpConfig = cms.PSet(
     dumpHistos = cms.untracked.bool(True),
     dumpWorkspace = cms.untracked.bool(False),
     dumpTrees = cms.untracked.bool(False),
+    dumpColumns = cms.untracked.bool(False), # one tree for all categories, see bin/columns_to_trees.cc
     
     quietRooFit = cms.untracked.bool(False),
+    compileExpressions = cms.untracked.bool(False), # translate variables to native code through cling, reflective fallback
     dumpGlobalVariables = cms.untracked.bool(True),
     globalVariables=globalVariables
 )
@@ -1,5 +1,6 @@
 import FWCore.ParameterSet.Config as cms
 from flashgg.MicroAOD.flashggJets_cfi import flashggUnpackedJets
+from flashgg.MicroAOD.flashggWeightLabels_cfi import flashggWeightLabels
 from flashgg.Taggers.flashggDiPhotonMVA_cfi import flashggDiPhotonMVA
 from flashgg.Taggers.flashggVBFMVA_cff import flashggVBFMVA,flashggVBFDiPhoDiJetMVA
 from flashgg.Taggers.flashggVHhadMVA_cff import flashggVHhadMVA
@@ -39,7 +40,8 @@ def flashggPrepareTagSequence(process, options):
     flashggTHQLeptonicTag.MVAweight_tHqVsttHBDT = cms.FileInPath(str(options['THQLeptonicTag']['MVAweights_VsttH']))
     flashggTHQLeptonicTag.MVAThreshold_tHqVsttHBDT = cms.double(options['THQLeptonicTag']['MVAThreshold_VsttH'])
 
-    flashggTagSequence = cms.Sequence(flashggDifferentialPhoIdInputsCorrection
+    flashggTagSequence = cms.Sequence(flashggWeightLabels
+                                      * flashggDifferentialPhoIdInputsCorrection
                                       * flashggPrefireDiPhotons
                                       * flashggPreselectedDiPhotons
                                       * flashggDiPhotonMVA
@@ -22,6 +22,7 @@ flashggbRegressionProducer= cms.EDProducer('flashggbRegressionProducer',
                                            bRegressionWeightfile= bRegressionWeightfile_str, 
                                            y_mean = y_mean_str ,
                                            y_std = y_std_str,
-                                           year = year_str
+                                           year = year_str,
+                                           maxBatchSize = cms.untracked.uint32(0) # jets per network evaluation, 0 = all the jets of the event at once
                                            )
 
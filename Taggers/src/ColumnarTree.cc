@@ -0,0 +1,206 @@
+#include "flashgg/Taggers/interface/ColumnarTree.h"
+#include "flashgg/Taggers/interface/GlobalVariablesDumper.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TBranch.h"
+#include "TObjArray.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace flashgg {
+
+    ColumnarTree::ColumnarTree( TTree *tree, TTree *dictionary, const std::string &weightName, int compression, long long clusterSize ) :
+        tree_( tree ),
+        dictionary_( dictionary ),
+        weightName_( weightName ),
+        compression_( compression ),
+        clusterSize_( clusterSize ),
+        booked_( false ),
+        hasGenWeight_( false ),
+        dumper_( -1 ), category_( -1 ), systLabel_( -1 ), subcat_( 0 ), candidate_( 0 ),
+        weight_( 0. ), genweight_( 0. ),
+        nPdfWeights_( 0 ), nAlphaSWeights_( 0 ), nScaleWeights_( 0 )
+    {
+        reservedNames_ = { "dumper", "category", "systLabel", "subcat", "candidate_id", "genweight",
+                           "nPdfWeights", "pdfWeights", "nAlphaSWeights", "alphaSWeights", "nScaleWeights", "scaleWeights"
+                         };
+        checkName( weightName_, "the weight" );
+        reservedNames_.insert( weightName_ );
+
+        tree_->Branch( "dumper", &dumper_, "dumper/I" );
+        tree_->Branch( "category", &category_, "category/I" );
+        tree_->Branch( "systLabel", &systLabel_, "systLabel/I" );
+        tree_->Branch( "subcat", &subcat_, "subcat/I" );
+        tree_->Branch( "candidate_id", &candidate_, "candidate_id/I" );
+        tree_->Branch( weightName_.c_str(), &weight_ );
+
+        dictionary_->Branch( "dumper", &dictDumper_, "dumper/I" );
+        dictionary_->Branch( "tree", &dictTree_ );
+        dictionary_->Branch( "category", &dictCategory_ );
+        dictionary_->Branch( "categoryIndex", &dictCategoryIndex_, "categoryIndex/I" );
+        dictionary_->Branch( "systLabel", &dictSystLabel_ );
+        dictionary_->Branch( "systLabelIndex", &dictSystLabelIndex_, "systLabelIndex/I" );
+        dictionary_->Branch( "subcat", &dictSubcat_, "subcat/I" );
+        dictionary_->Branch( "branches", &dictBranches_ );
+        dictionary_->Branch( "nPdfWeights", &dictNPdfWeights_, "nPdfWeights/I" );
+        dictionary_->Branch( "nAlphaSWeights", &dictNAlphaSWeights_, "nAlphaSWeights/I" );
+        dictionary_->Branch( "nScaleWeights", &dictNScaleWeights_, "nScaleWeights/I" );
+    }
+
+    void ColumnarTree::bookGlobalVariables( GlobalVariablesDumper *dumper, const std::map<std::string, std::string> &replacements )
+    {
+        int nbranches = tree_->GetListOfBranches()->GetEntries();
+        dumper->bookTreeVariables( tree_, replacements );
+        for( int ib = nbranches; ib < tree_->GetListOfBranches()->GetEntries(); ++ib ) {
+            std::string name = tree_->GetListOfBranches()->At( ib )->GetName();
+            checkName( name, "the global variables" );
+            globalNames_.push_back( name );
+        }
+    }
+
+    void ColumnarTree::checkName( const std::string &name, const std::string &owner ) const
+    {
+        if( reservedNames_.count( name ) || std::find( globalNames_.begin(), globalNames_.end(), name ) != globalNames_.end() ) {
+            throw cms::Exception( "Configuration" ) << "ColumnarTree: branch " << name << " of " << owner << " clashes with a branch of "
+                                                    << tree_->GetName() << " already in use";
+        }
+    }
+
+    int ColumnarTree::encode( std::map<std::string, int> &dictionary, const std::string &value )
+    {
+        auto it = dictionary.find( value );
+        if( it != dictionary.end() ) { return it->second; }
+        int index = dictionary.size();
+        dictionary.insert( std::make_pair( value, index ) );
+        return index;
+    }
+
+    int ColumnarTree::addDumper( const std::string &treeName, const std::string &category, const std::string &systLabel, int subcat,
+                                 const std::vector<std::string> &variables, bool genWeight, int nPdfWeights, int nAlphaSWeights, int nScaleWeights )
+    {
+        if( booked_ ) {
+            throw cms::Exception( "Configuration" ) << "ColumnarTree: cannot add dumper " << treeName << " after the first entry has been filled";
+        }
+        DumperInfo info;
+        info.category = encode( categories_, category );
+        info.systLabel = encode( systLabels_, systLabel );
+        info.subcat = subcat;
+        info.nPdfWeights = nPdfWeights;
+        info.nAlphaSWeights = nAlphaSWeights;
+        info.nScaleWeights = nScaleWeights;
+        for( auto &name : variables ) {
+            auto it = columnIndex_.find( name );
+            if( it == columnIndex_.end() ) {
+                checkName( name, treeName );
+                columns_.push_back( std::numeric_limits<float>::quiet_NaN() );
+                it = columnIndex_.insert( std::make_pair( name, columns_.size() - 1 ) ).first;
+                tree_->Branch( name.c_str(), &columns_.back() );
+            }
+            info.columns.push_back( it->second );
+        }
+        hasGenWeight_ = hasGenWeight_ || genWeight;
+        dumpers_.push_back( info );
+
+        // branch list of the corresponding per-category tree, in the CategoryDumper::bookTree order
+        dictBranches_.clear();
+        dictBranches_.push_back( "candidate_id" );
+        dictBranches_.push_back( weightName_ );
+        if( genWeight ) { dictBranches_.push_back( "genweight" ); }
+        dictBranches_.insert( dictBranches_.end(), variables.begin(), variables.end() );
+        dictBranches_.insert( dictBranches_.end(), globalNames_.begin(), globalNames_.end() );
+        dictDumper_ = dumpers_.size() - 1;
+        dictTree_ = treeName;
+        dictCategory_ = category;
+        dictCategoryIndex_ = info.category;
+        dictSystLabel_ = systLabel;
+        dictSystLabelIndex_ = info.systLabel;
+        dictSubcat_ = subcat;
+        dictNPdfWeights_ = nPdfWeights;
+        dictNAlphaSWeights_ = nAlphaSWeights;
+        dictNScaleWeights_ = nScaleWeights;
+        dictionary_->Fill();
+
+        return dictDumper_;
+    }
+
+    float *ColumnarTree::column( int idumper, size_t ivar )
+    {
+        return &columns_[dumpers_[idumper].columns[ivar]];
+    }
+
+    void ColumnarTree::book()
+    {
+        int maxPdfWeights = 0, maxAlphaSWeights = 0, maxScaleWeights = 0;
+        for( auto &info : dumpers_ ) {
+            maxPdfWeights = std::max( maxPdfWeights, info.nPdfWeights );
+            maxAlphaSWeights = std::max( maxAlphaSWeights, info.nAlphaSWeights );
+            maxScaleWeights = std::max( maxScaleWeights, info.nScaleWeights );
+        }
+        if( hasGenWeight_ ) { tree_->Branch( "genweight", &genweight_ ); }
+        if( maxPdfWeights > 0 ) {
+            pdfWeights_.resize( maxPdfWeights );
+            tree_->Branch( "nPdfWeights", &nPdfWeights_, "nPdfWeights/I" );
+            tree_->Branch( "pdfWeights", &pdfWeights_[0], "pdfWeights[nPdfWeights]/F" );
+        }
+        if( maxAlphaSWeights > 0 ) {
+            alphaSWeights_.resize( maxAlphaSWeights );
+            tree_->Branch( "nAlphaSWeights", &nAlphaSWeights_, "nAlphaSWeights/I" );
+            tree_->Branch( "alphaSWeights", &alphaSWeights_[0], "alphaSWeights[nAlphaSWeights]/F" );
+        }
+        if( maxScaleWeights > 0 ) {
+            scaleWeights_.resize( maxScaleWeights );
+            tree_->Branch( "nScaleWeights", &nScaleWeights_, "nScaleWeights/I" );
+            tree_->Branch( "scaleWeights", &scaleWeights_[0], "scaleWeights[nScaleWeights]/F" );
+        }
+        if( compression_ >= 0 ) {
+            TObjArray *branches = tree_->GetListOfBranches();
+            for( int ib = 0; ib < branches->GetEntries(); ++ib ) {
+                static_cast<TBranch *>( branches->At( ib ) )->SetCompressionSettings( compression_ );
+            }
+        }
+        if( clusterSize_ != 0 ) { tree_->SetAutoFlush( clusterSize_ ); }
+        booked_ = true;
+    }
+
+    void ColumnarTree::fill( int idumper, int candidate, float weight, float genweight, const std::vector<double> &pdfWeights )
+    {
+        if( ! booked_ ) { book(); }
+        auto &info = dumpers_[idumper];
+        dumper_ = idumper;
+        category_ = info.category;
+        systLabel_ = info.systLabel;
+        subcat_ = info.subcat;
+        candidate_ = candidate;
+        weight_ = weight;
+        genweight_ = genweight;
+        nPdfWeights_ = info.nPdfWeights;
+        nAlphaSWeights_ = info.nAlphaSWeights;
+        nScaleWeights_ = info.nScaleWeights;
+        if( nPdfWeights_ + nAlphaSWeights_ + nScaleWeights_ > 0 ) {
+            if( ( nPdfWeights_ + nAlphaSWeights_ + nScaleWeights_ ) != ( int )pdfWeights.size() ) {
+                throw cms::Exception( "Configuration" ) << " Specified number of pdfWeights (" << nPdfWeights_ << ") plus alphaSWeights (" << nAlphaSWeights_
+                                                        << ") plus scaleWeights (" << nScaleWeights_ << ") does not match length of pdfWeights Vector ("
+                                                        << pdfWeights.size() << ")." ;
+            }
+            // same layout as the CollectionDumper pdfWeights vector
+            auto first = pdfWeights.begin();
+            std::copy( first, first + nPdfWeights_, pdfWeights_.begin() );
+            first += nPdfWeights_;
+            std::copy( first, first + nAlphaSWeights_, alphaSWeights_.begin() );
+            first += nAlphaSWeights_;
+            std::copy( first, first + nScaleWeights_, scaleWeights_.begin() );
+        }
+        tree_->Fill();
+        for( auto icol : info.columns ) { columns_[icol] = std::numeric_limits<float>::quiet_NaN(); }
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
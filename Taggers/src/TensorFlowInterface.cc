@@ -8,8 +8,6 @@ TensorFlowInterface::TensorFlowInterface(const std::string & mvaFileName,
                                          const std::vector<double> & mvaInputVariables_mean,
                                          const std::vector<double> & mvaInputVariables_var)
   : mvaFileName_(mvaFileName)
-  , graphDef_(nullptr)
-  , session_(nullptr)
   , classes_(classes)
   , n_input_layer(0)
   , n_output_layer(0)
@@ -18,19 +16,16 @@ TensorFlowInterface::TensorFlowInterface(const std::string & mvaFileName,
   , mvaInputVariables_var_(mvaInputVariables_var)
   , isDEBUG_(false)
 {
-  // loading the model
-  tensorflow::SessionOptions options;
-  tensorflow::setThreading(options, 1, "no_threads");
-
-  graphDef_ = tensorflow::loadGraphDef(mvaFileName_);
-  session_ = tensorflow::createSession(graphDef_);
+  // loading the model, or sharing it if another module already did
+  model_ = flashgg::TensorFlowModelRegistry::instance().get(mvaFileName_);
+  const tensorflow::GraphDef * graphDef = &model_->graph();
   std::cout << "Loaded: " << mvaFileName_ << '\n';
 
   // getting elements to evaluate -- the number of the input/output layer deppends of how the model was exported
   int shape_variables = 0;
-  for(int idx_node = 0; idx_node < graphDef_->node_size(); idx_node++)
+  for(int idx_node = 0; idx_node < graphDef->node_size(); idx_node++)
   {
-    input_layer_name  = graphDef_->node(idx_node).name();
+    input_layer_name  = graphDef->node(idx_node).name();
     const bool is_input = boost::contains(input_layer_name, "_input");
     if(is_input)
     {
@@ -40,7 +35,7 @@ TensorFlowInterface::TensorFlowInterface(const std::string & mvaFileName,
         std::cout << "read input layer "<< input_layer_name << " " << n_input_layer << '\n';
       }
 
-      const auto & shape = graphDef_->node(idx_node).attr().at("shape").shape();
+      const auto & shape = graphDef->node(idx_node).attr().at("shape").shape();
       if(isDEBUG_)
       {
         std::cout << "read input layer shape  " << shape.dim_size() << '\n';
@@ -64,9 +59,9 @@ TensorFlowInterface::TensorFlowInterface(const std::string & mvaFileName,
   }
 
 //  int shape_classes = 0;
-  for (int idx_node = 0; idx_node < graphDef_->node_size(); idx_node++)
+  for (int idx_node = 0; idx_node < graphDef->node_size(); idx_node++)
   {
-    output_layer_name  = graphDef_->node(idx_node).name();
+    output_layer_name  = graphDef->node(idx_node).name();
     const bool is_output = boost::contains(output_layer_name, "/Softmax");
     if(is_output)
     {
@@ -76,7 +71,7 @@ TensorFlowInterface::TensorFlowInterface(const std::string & mvaFileName,
         std::cout << "read output layer "<< output_layer_name << " " << idx_node << '\n';
       }
 
-//      const auto & shape = graphDef_->node(idx_node-1).attr().at("shape").shape();
+//      const auto & shape = graphDef->node(idx_node-1).attr().at("shape").shape();
 //      std::cout << "read output layer shape  " << shape.dim_size() << '\n';
 //      shape_classes = static_cast<int>(shape.dim(0).size());
       break;
@@ -86,65 +81,78 @@ TensorFlowInterface::TensorFlowInterface(const std::string & mvaFileName,
 }
 
 TensorFlowInterface::~TensorFlowInterface()
-{
-  tensorflow::closeSession(session_);
-  delete session_;
-  delete graphDef_;
-}
+{}
 
 
 std::map<std::string, double>
 TensorFlowInterface::operator()(const std::map<std::string, double> & mvaInputs) const
 {
+  return (*this)(std::vector<std::map<std::string, double>>(1, mvaInputs))[0];
+}
+
+std::vector<std::map<std::string, double>>
+TensorFlowInterface::operator()(const std::vector<std::map<std::string, double>> & mvaInputsBatch) const
+{
+  std::vector<std::map<std::string, double>> mvaOutputsBatch;
+  const int nofCandidates = mvaInputsBatch.size();
+  if(nofCandidates == 0)
+  {
+    return mvaOutputsBatch;
+  }
 
   const int nofInputs = mvaInputVariables_.size();
-  tensorflow::Tensor inputs(tensorflow::DT_FLOAT, { 1, nofInputs});
+  tensorflow::Tensor inputs(tensorflow::DT_FLOAT, { nofCandidates, nofInputs});
 
   // the order of input variables should be the same as during the training
-  for(int idx_input = 0; idx_input < nofInputs; ++idx_input)
+  for(int idx_cand = 0; idx_cand < nofCandidates; ++idx_cand)
   {
-    if(mvaInputs.count(mvaInputVariables_[idx_input]))
+    const std::map<std::string, double> & mvaInputs = mvaInputsBatch[idx_cand];
+    for(int idx_input = 0; idx_input < nofInputs; ++idx_input)
     {
-      if(! mvaInputVariables_mean_.empty())
+      if(mvaInputs.count(mvaInputVariables_[idx_input]))
       {
-        inputs.matrix<float>()(0, idx_input) = (
-            static_cast<float>(mvaInputs.at(mvaInputVariables_[idx_input])) - mvaInputVariables_mean_[idx_input]
-          ) / mvaInputVariables_var_[idx_input];
-
-        if(isDEBUG_)
+        if(! mvaInputVariables_mean_.empty())
         {
-          std::cout << mvaInputVariables_[idx_input]
-            << " = " << mvaInputs.at(mvaInputVariables_[idx_input])
-            << " = " << mvaInputVariables_mean_[idx_input]
-            << " = " << mvaInputVariables_var_[idx_input]
-            << '\n'
-          ;
+          inputs.matrix<float>()(idx_cand, idx_input) = (
+              static_cast<float>(mvaInputs.at(mvaInputVariables_[idx_input])) - mvaInputVariables_mean_[idx_input]
+            ) / mvaInputVariables_var_[idx_input];
+
+          if(isDEBUG_)
+          {
+            std::cout << mvaInputVariables_[idx_input]
+              << " = " << mvaInputs.at(mvaInputVariables_[idx_input])
+              << " = " << mvaInputVariables_mean_[idx_input]
+              << " = " << mvaInputVariables_var_[idx_input]
+              << '\n'
+            ;
+          }
+        }
+        else
+        {
+          inputs.matrix<float>()(idx_cand, idx_input) = static_cast<float>(mvaInputs.at(mvaInputVariables_[idx_input]));
+          if(isDEBUG_)
+          {
+            std::cout << mvaInputVariables_[idx_input]  << " = " << mvaInputs.at(mvaInputVariables_[idx_input]) << '\n';
+          }
         }
       }
       else
       {
-        inputs.matrix<float>()(0, idx_input) = static_cast<float>(mvaInputs.at(mvaInputVariables_[idx_input]));
-        if(isDEBUG_)
-        {
-          std::cout << mvaInputVariables_[idx_input]  << " = " << mvaInputs.at(mvaInputVariables_[idx_input]) << '\n';
-        }
+        std::cout
+          << "Missing value for MVA input variable = '" << mvaInputVariables_[idx_input] << '\''
+          << std::endl;
       }
     }
-    else
-    {
-      std::cout
-        << "Missing value for MVA input variable = '" << mvaInputVariables_[idx_input] << '\''
-	<< std::endl;
-    }
   }
 
   // evaluation
-  const int node_count = graphDef_->node_size();
+  const tensorflow::GraphDef & graphDef = model_->graph();
+  const int node_count = graphDef.node_size();
   if (isDEBUG_)
   {
     for (int idx_node = 0; idx_node < node_count; ++idx_node)
     {
-      const auto node = graphDef_->node(idx_node);
+      const auto node = graphDef.node(idx_node);
       std::cout << "Names : " << node.name() << '\n';
     }
   }
@@ -153,24 +161,26 @@ TensorFlowInterface::operator()(const std::map<std::string, double> & mvaInputs)
   if(isDEBUG_)
   {
     std::cout
-      << "start run " << graphDef_->node(n_input_layer).name()
-      << " "          << graphDef_->node(n_output_layer).name()
+      << "start run " << graphDef.node(n_input_layer).name()
+      << " "          << graphDef.node(n_output_layer).name()
       << '\n'
     ;
   }
-  tensorflow::run(
-    session_,
-    { { graphDef_->node(n_input_layer).name(), inputs } },
-    { graphDef_->node(n_output_layer).name() },
+  model_->run(
+    { { graphDef.node(n_input_layer).name(), inputs } },
+    { graphDef.node(n_output_layer).name() },
     &outputs
   );
 
-  // store the output
-  std::map<std::string, double> mvaOutputs;
-  for(unsigned int idx_class = 0; idx_class < classes_.size(); idx_class++)
+  // store the output, one row per candidate
+  mvaOutputsBatch.resize(nofCandidates);
+  for(int idx_cand = 0; idx_cand < nofCandidates; ++idx_cand)
   {
-    mvaOutputs[classes_[idx_class]] = outputs[0].matrix<float>()(0, idx_class);
+    for(unsigned int idx_class = 0; idx_class < classes_.size(); idx_class++)
+    {
+      mvaOutputsBatch[idx_cand][classes_[idx_class]] = outputs[0].matrix<float>()(idx_cand, idx_class);
+    }
   }
 
-  return mvaOutputs;
+  return mvaOutputsBatch;
 }
@@ -0,0 +1,140 @@
+#include "flashgg/Taggers/interface/TensorFlowModelRegistry.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace flashgg {
+
+    namespace {
+        // FNV-1a over the file content: tells identical graphs apart from same-named ones, not a security hash
+        std::string fileChecksum( const std::string &path, size_t &fileSize )
+        {
+            std::ifstream in( path, std::ios::binary );
+            if( !in ) {
+                throw cms::Exception( "TensorFlowModelRegistry" ) << "cannot read model file " << path;
+            }
+            uint64_t hash = 14695981039346656037ULL;
+            fileSize = 0;
+            char buffer[65536];
+            while( in.read( buffer, sizeof( buffer ) ) || in.gcount() > 0 ) {
+                std::streamsize n = in.gcount();
+                for( std::streamsize i = 0 ; i < n ; i++ ) {
+                    hash ^= static_cast<unsigned char>( buffer[i] );
+                    hash *= 1099511628211ULL;
+                }
+                fileSize += n;
+            }
+            std::ostringstream out;
+            out << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+            return out.str();
+        }
+    }
+
+    TensorFlowModel::TensorFlowModel( const std::string &path, const std::string &checksum, size_t fileSize ) :
+        path_( path ), checksum_( checksum ), fileSize_( fileSize ), loadSeconds_( 0. ),
+        graph_( nullptr ), session_( nullptr ), nRuns_( 0 ), nRows_( 0 ), runNanoseconds_( 0 )
+    {
+        auto start = std::chrono::steady_clock::now();
+        graph_ = tensorflow::loadGraphDef( path_ );
+        session_ = tensorflow::createSession( graph_ );
+        loadSeconds_ = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+        std::ostringstream out;
+        out << "loaded ";
+        report( out );
+        edm::LogInfo( "TensorFlowModelRegistry" ) << out.str();
+    }
+
+    TensorFlowModel::~TensorFlowModel()
+    {
+        std::ostringstream out;
+        out << "released ";
+        report( out );
+        edm::LogInfo( "TensorFlowModelRegistry" ) << out.str();
+
+        tensorflow::closeSession( session_ );
+        delete graph_;
+    }
+
+    void TensorFlowModel::run( const std::vector<std::pair<std::string, tensorflow::Tensor> > &inputs,
+                               const std::vector<std::string> &outputNames,
+                               std::vector<tensorflow::Tensor> *outputs ) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        tensorflow::run( session_, inputs, outputNames, outputs );
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start );
+
+        nRuns_ += 1;
+        if( !inputs.empty() && inputs[0].second.dims() > 0 ) {
+            nRows_ += inputs[0].second.dim_size( 0 );
+        }
+        runNanoseconds_ += elapsed.count();
+    }
+
+    void TensorFlowModel::report( std::ostream &out ) const
+    {
+        unsigned long nRuns = nRuns_, nRows = nRows_;
+        double runMicroseconds = runNanoseconds_ * 1.e-3;
+        out << path_ << " [" << checksum_ << "]: "
+            << fileSize_ << " bytes on disk, " << graph_->ByteSizeLong() << " bytes of graph, "
+            << graph_->node_size() << " nodes, loaded in " << loadSeconds_ << " s; "
+            << nRuns << " runs over " << nRows << " rows";
+        if( nRuns > 0 ) {
+            out << ", " << runMicroseconds / nRuns << " us per run";
+        }
+        if( nRows > 0 ) {
+            out << ", " << runMicroseconds / nRows << " us per row";
+        }
+    }
+
+    TensorFlowModelRegistry &TensorFlowModelRegistry::instance()
+    {
+        static TensorFlowModelRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<const TensorFlowModel> TensorFlowModelRegistry::get( const std::string &path )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        auto byPath = byPath_.find( path );
+        if( byPath != byPath_.end() ) {
+            if( auto model = byPath->second.lock() ) { return model; }
+        }
+
+        size_t fileSize = 0;
+        std::string checksum = fileChecksum( path, fileSize );
+        std::shared_ptr<const TensorFlowModel> model = byChecksum_[checksum].lock();
+        if( !model ) {
+            model = std::make_shared<const TensorFlowModel>( path, checksum, fileSize );
+            byChecksum_[checksum] = model;
+        }
+        byPath_[path] = model;
+        return model;
+    }
+
+    void TensorFlowModelRegistry::report( std::ostream &out ) const
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        for( const auto &entry : byChecksum_ ) {
+            if( auto model = entry.second.lock() ) {
+                model->report( out );
+                out << std::endl;
+            }
+        }
+    }
+}
+
+// Local Variables:
+// mode:c++
+// indent-tabs-mode:nil
+// tab-width:4
+// c-basic-offset:4
+// End:
+// vim: tabstop=4 expandtab shiftwidth=4 softtabstop=4
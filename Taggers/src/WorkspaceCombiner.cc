@@ -8,7 +8,7 @@ using namespace RooFit;
 
 // ----------------------------------------------------------------------------------------------------
 
-WorkspaceCombiner::WorkspaceCombiner()
+WorkspaceCombiner::WorkspaceCombiner() : keepDataHistParts( false )
 {
 }
 
@@ -27,6 +27,11 @@ void WorkspaceCombiner::Init( string outputFileName_, vector<string> inputfiles_
     workspaceNames.clear();
     workspacePaths.clear();
     data.clear();
+    dataH.clear();
+    vars.clear();
+    dataNames.clear();
+    varNames.clear();
+    dataHParts.clear();
     trees.clear();
     histos.clear();
     treePaths.clear();
@@ -36,6 +41,79 @@ void WorkspaceCombiner::Init( string outputFileName_, vector<string> inputfiles_
 
     outputFileName = outputFileName_;
 
+    // next to the output, so that several merges can run in the same directory
+    string outputBase = outputFileName;
+    if( outputBase.size() > 5 && outputBase.compare( outputBase.size() - 5, 5, ".root" ) == 0 ) { outputBase.erase( outputBase.size() - 5 ); }
+    outputAux = outputBase + "_treesAndHistos.root";
+
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void WorkspaceCombiner::SetAuxFileName( string auxFileName_ )
+{
+    outputAux = auxFileName_;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+void WorkspaceCombiner::SetKeepDataHistParts( bool keep )
+{
+    keepDataHistParts = keep;
+}
+
+// ----------------------------------------------------------------------------------------------------
+
+// Suffix of the datahist parts kept by the intermediate merges: a marker no dumper uses,
+// followed by the zero-padded part index (at least DataHistPartDigits digits).
+// Names without that exact suffix are never altered.
+static const string DataHistPartMarker = "__haddWorkspacesPart";
+static const int DataHistPartDigits = 6;
+
+static string DataHistBaseName( const string &name )
+{
+    size_t pos = name.rfind( DataHistPartMarker );
+    if( pos == string::npos ) { return name; }
+    size_t digits = pos + DataHistPartMarker.size();
+    if( name.size() - digits < ( size_t )DataHistPartDigits ) { return name; }
+    if( name.find_first_not_of( "0123456789", digits ) != string::npos ) { return name; }
+    return name.substr( 0, pos );
+}
+
+void WorkspaceCombiner::AddDataSet( unsigned int w, RooDataSet *dataset )
+{
+    string name( dataset->GetName() );
+    if( data[w].find( name ) != data[w].end() ) {
+        data[w][name]->append( *dataset );
+    } else {
+        data[w].insert( std::pair<string, RooDataSet *>( name, ( RooDataSet * )dataset->Clone() ) );
+        dataNames[w].push_back( name );
+    }
+}
+
+void WorkspaceCombiner::AddDataHist( unsigned int w, RooDataHist *datahist )
+{
+    string name = DataHistBaseName( datahist->GetName() );
+    if( keepDataHistParts ) {
+        RooDataHist *part = ( RooDataHist * )datahist->Clone();
+        part->SetName( Form( "%s%s%0*u", name.c_str(), DataHistPartMarker.c_str(), DataHistPartDigits, ( unsigned int )dataHParts[w].size() ) );
+        dataHParts[w].push_back( part );
+    } else if( dataH[w].find( name ) != dataH[w].end() ) {
+        dataH[w][name]->add( *datahist );
+    } else {
+        RooDataHist *clone = ( RooDataHist * )datahist->Clone();
+        if( name != clone->GetName() ) { clone->SetName( name.c_str() ); }
+        dataH[w].insert( std::pair<string, RooDataHist *>( name, clone ) );
+    }
+}
+
+void WorkspaceCombiner::AddVar( unsigned int w, RooRealVar *datavar )
+{
+    string name( datavar->GetName() );
+    if( vars[w].find( name ) == vars[w].end() ) {
+        vars[w].insert( std::pair<string, RooRealVar * >( name, ( RooRealVar * )datavar->Clone() ) );
+        varNames[w].push_back( name );
+    }
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -76,23 +154,25 @@ void WorkspaceCombiner::GetWorkspaces( TDirectoryFile *tdfile )
             RooArgSet allVars = work->allVars();
             TIterator *vIter = allVars.createIterator();
             std::cout << " made allData" << std::endl;
-            std::unordered_map<string, RooDataSet *> allDataClone;
-            std::unordered_map<string, RooDataHist *> allDataHistClone;
-            std::unordered_map<string, RooRealVar *> allVarClone;
+            data.push_back( std::unordered_map<string, RooDataSet *>() );
+            dataH.push_back( std::unordered_map<string, RooDataHist *>() );
+            vars.push_back( std::unordered_map<string, RooRealVar *>() );
+            dataNames.push_back( vector<string>() );
+            varNames.push_back( vector<string>() );
+            dataHParts.push_back( vector<RooDataHist *>() );
+            unsigned int w = data.size() - 1;
             std::cout << " about to iterate over allData " << std::endl;
             for( std::list<RooAbsData *>::iterator it = allData.begin(); it != allData.end(); ++it ) {
                 RooDataSet *dataset = dynamic_cast<RooDataSet *>( *it );
                 if (dataset) {
-                    //                  allDataClone.push_back( ( RooDataSet * )dataset->Clone() );
-                    allDataClone[std::string(dataset->GetName())] = ( ( RooDataSet * )dataset->Clone() );
+                    AddDataSet( w, dataset );
                   std::cout << "pushing back dataset " << *dataset << std::endl;
                  }
             }
             for( std::list<RooAbsData *>::iterator it = allData.begin(); it != allData.end(); ++it ) {
                 RooDataHist *datahist = dynamic_cast<RooDataHist *>( *it );
                 if (datahist) {
-                    //                  allDataHistClone.push_back( ( RooDataHist * )datahist->Clone() );
-                    allDataHistClone[std::string(datahist->GetName())] = ( ( RooDataHist * )datahist->Clone() );
+                    AddDataHist( w, datahist );
                   std::cout << "pushing back dataHIST " << *datahist << std::endl;
 
                 }
@@ -100,15 +180,11 @@ void WorkspaceCombiner::GetWorkspaces( TDirectoryFile *tdfile )
             RooRealVar * datavar;
             while((datavar=(RooRealVar*)vIter->Next())) {
                 if (datavar) {
-                    //                allVarClone.push_back( ( RooRealVar * )datavar->Clone() );
-                    allVarClone[std::string(datavar->GetName())] = ( ( RooRealVar * )datavar->Clone() );
+                    AddVar( w, datavar );
                  std::cout << "pushing back dataVAR " << datavar->GetName() << std::endl;
                 }
             }
-            std::cout << " gonna push back allDataClone " << std::endl;
-            data.push_back( allDataClone );
-            dataH.push_back( allDataHistClone );
-            vars.push_back( allVarClone );
+            delete vIter;
             std::cout << " gonna push back work " << std::endl;
             workspaceNames.push_back( work->GetName() );
             string workpath = "";
@@ -164,82 +240,32 @@ void WorkspaceCombiner::MergeWorkspaces()
             std::list<RooAbsData *> allData = work->allData();
             //loop over datasets and datahists from file under consideration.
             for( std::list<RooAbsData *>::iterator it = allData.begin(); it != allData.end(); ++it ) {
-                //                unsigned int d = 0;
                 RooDataSet *dataset = dynamic_cast<RooDataSet *>( *it );
                 RooDataHist *datahist = dynamic_cast<RooDataHist *>( *it );
                 if ( dataset) std::cout << "   Dataset name: " << dataset->GetName() << std::endl;
                 if ( datahist) std::cout << "   DataHIST name: " << datahist->GetName() << std::endl;
                 
-                // loop through datasets
-                if (dataset){
-                    if( data[w].find(std::string(dataset->GetName())) != data[w].end() ) {
-                        
-                        //                    for( d = 0 ; d < data[w].size() ; d++ ) {
-                        //                        if( data[w][d]->GetName() == dataset->GetName() ) {
-                        //lC    if (dataset) 
-                        data[w][std::string(dataset->GetName())]->append( *dataset );
-                        //                            break;
-                        //                        }
-                    }
-                    //                    if( d == data[w].size() ) { // no match
-                    else{
-                        //                        data[w].push_back( ( RooDataSet * )dataset->Clone() );
-                        //                        std::map<std::string, RooDataSet *> temp_map;
-                        //                        temp_map[dataset->GetName()] = ( RooDataSet * )dataset->Clone();
-                        //                        data[w].push_back(  );
-                        data[w].insert( std::pair<string, RooDataSet *>(std::string(dataset->GetName()),( RooDataSet * )dataset->Clone() )  );
-                    }
-                }
-                /// do the same for dataHists
-                if (datahist){
-                    if( dataH[w].find( std::string(datahist->GetName()) ) != dataH[w].end() ) {
-                        
-                        //                    for( d = 0 ; d < dataH[w].size() ; d++ ) {
-                        //                        if( dataH[w][d]->GetName() == datahist->GetName() ) {
-                        dataH[w][std::string(datahist->GetName())]->add( *datahist );
-                        //                            break;
-                        //                        }
-                    }
-                    //                    if( d == dataH[w].size() ) { // no match
-                    else{
-                        //                        std::map<std::string, RooDataHist *> temp_map;
-                        //                        temp_map[datahist->GetName()] = ( RooDataHist * )datahist->Clone();
-                        dataH[w].insert( std::pair<string, RooDataHist*>(std::string(datahist->GetName()), ( RooDataHist * )datahist->Clone()) );
-                    }
-                    
-                }
-                //loop over RooRealVars (eg IntLumi) file under consideration.
-                //now do the same for RooRealVars
+                if (dataset) { AddDataSet( w, dataset ); }
+                if (datahist) { AddDataHist( w, datahist ); }
+            }
+            //now do the same for RooRealVars (eg IntLumi), once per workspace
+            if( ! allData.empty() ) {
                 RooArgSet allVars = work->allVars();
                 TIterator *vIter = allVars.createIterator();
                 RooRealVar * datavar;
                 while((datavar=(RooRealVar*)vIter->Next())) {
-                    if (datavar) {
-                        std::cout << "considering dataVAR " << datavar->GetName() << " w " << w <<" vars size " <<vars.size() << std::endl;
-                        if( vars[w].find( std::string(datavar->GetName()) ) !=  vars[w].end() ) {
-                            //       for( d = 0 ; d < vars[w].size() ; d++ ) {
-                            //           if( vars[w][d]->GetName() == datavar->GetName() ) {
-                            //////                            assert(vars[w][std::string(datavar->GetName())]->getVal() == datavar->getVal() );
-                            std::cout<<"found var"<<std::endl;
-                            //                            break;
-                            //                        }
-                        }
-                        //                        if( d == vars[w].size() ) { // no match
-                        else{
-                            //                            std::map<std::string, RooRealVar *> temp_map;
-                            //                            temp_map[datavar->GetName()] = ( RooRealVar * )datavar->Clone();
-                            vars[w].insert( std::pair<string, RooRealVar* >(std::string(datavar->GetName()), ( RooRealVar * )datavar->Clone()) );
-                        }
-                    }
+                    if (datavar) { AddVar( w, datavar ); }
                 }
-                
-                
+                delete vIter;
             }
+            // only one input workspace is kept in memory at a time
+            delete work;
         }
         cout << endl << "after workspaceNames loop" << endl << endl;
         
         
         file->Close();
+        delete file;
         
         cout << endl << "Finished Combining File - " << inputFileNames[f] << endl << endl;
         
@@ -256,8 +282,6 @@ TDirectoryFile *WorkspaceCombiner::MergeTreesAndHistograms()
         inputchain.append( inputFileNames[i] );
     }
 
-    outputAux = "outputTreesAndHistos.root";
-
     gSystem->Exec( Form( "hadd -f %s %s", outputAux.c_str(), inputchain.c_str() ) );
 
     TDirectoryFile *outputAuxFile = TFile::Open( outputAux.c_str() );
@@ -328,6 +352,23 @@ void WorkspaceCombiner::Save( bool doTreesAndHistograms )
     for( unsigned int w = 0; w < workspaceNames.size(); w++ ) {
         RooWorkspace *outputws = new RooWorkspace();
         outputws->SetName( workspaceNames[w].c_str() );
+        if( keepDataHistParts ) {
+            // intermediate output: everything is imported in the order it was first seen, so that
+            // the final merge sees the same sequence as a single merge of all the inputs
+            for( auto &name : varNames[w] ) {
+                outputws->import( *vars[w][name] );
+            }
+            for( auto &name : dataNames[w] ) {
+                outputws->import( *data[w][name] );
+                delete data[w][name];
+            }
+            for( auto part : dataHParts[w] ) {
+                outputws->import( *part );
+                delete part;
+            }
+            data[w].clear();
+            dataHParts[w].clear();
+        }
         // import datasets into workspace
         //        for( unsigned int d = 0; d < data[w].size(); d++ ) {
         for(std::unordered_map<std::string, RooDataSet *>::iterator m_it = data[w].begin(); m_it != data[w].end(); m_it++){
@@ -340,6 +381,9 @@ void WorkspaceCombiner::Save( bool doTreesAndHistograms )
                 std::cout << " doing an explicit import of " << m_it->first << " in WorkspaceCombiner::Save" << std::endl;
                 outputws->import( *(m_it->second) );
             }
+            // the workspace holds its own copy
+            delete m_it->second;
+            m_it->second = 0;
             //data[w][d]->Print();
         }
         // import datahists into workspace
@@ -353,6 +397,8 @@ void WorkspaceCombiner::Save( bool doTreesAndHistograms )
                 // std::cout << " doing an explicit import of dataHIST " << dataH[w][d]->GetName() << " in WorkspaceCombiner::Save" << std::endl;
                 outputws->import( *(m_it->second) );
             }
+            delete m_it->second;
+            m_it->second = 0;
             //data[w][d]->Print();
         }
         // import roorealvars into workspace
@@ -1,4 +1,4 @@
-#include "FWCore/Framework/interface/EDProducer.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -13,7 +13,7 @@
 
 namespace flashgg {
 
-    class PhotonFromDiPhotonProducer : public edm::EDProducer {
+    class PhotonFromDiPhotonProducer : public edm::stream::EDProducer<> {
         
     public:
         PhotonFromDiPhotonProducer(const edm::ParameterSet &);